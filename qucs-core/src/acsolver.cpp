@@ -95,7 +95,7 @@ int acsolver::solve (void) {
   swp->reset ();
   for (int i = 0; i < swp->getSize (); i++) {
     freq = swp->next ();
-    if (progress) logprogressbar (i, swp->getSize (), 40);
+    reportProgress (i, swp->getSize ());
 
 #if DEBUG && 0
     logprint (LOG_STATUS, "NOTIFY: %s: solving netlist for f = %e\n",
@@ -37,6 +37,9 @@
 #include "spsolver.h"
 #include "dcsolver.h"
 #include "parasweep.h"
+#include "montecarlo.h"
+#include "senssolver.h"
+#include "optimizer.h"
 #include "acsolver.h"
 #include "trsolver.h"
 #include "hbsolver.h"
@@ -37,6 +37,10 @@
 //#include <stdio.h>
 //#include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <unordered_map>
 
 #include "object.h"
 #include "complex.h"
@@ -46,9 +50,21 @@
 #include "dataset.h"
 #include "ptrlist.h"
 #include "analysis.h"
+#include "logging.h"
 
 namespace qucs {
 
+// Emit machine readable progress lines if non-zero.
+int analysis_status = 0;
+
+// File receiving the partial results, NULL if there is none.
+const char * analysis_partial = NULL;
+
+// Minimum time between two partial results files in seconds.
+#define PARTIAL_INTERVAL 1.0
+// Largest share of the run time spent writing partial results.
+#define PARTIAL_SHARE 0.1
+
 //Constructor. Creates an unnamed instance of the analysis class.
 analysis::analysis () : object () {
   data = NULL;
@@ -58,6 +74,8 @@ analysis::analysis () : object () {
   type = ANALYSIS_UNKNOWN;
   runs = 0;
   progress = true;
+  progressStart = 0;
+  progressLast = -1;
 }
 
 // Constructor creates a named instance of the analysis class.
@@ -69,6 +87,8 @@ analysis::analysis (const std::string &n) : object (n) {
   type = ANALYSIS_UNKNOWN;
   runs = 0;
   progress = true;
+  progressStart = 0;
+  progressLast = -1;
 }
 
 // Destructor deletes the analysis class object.
@@ -86,6 +106,8 @@ analysis::analysis (analysis & a) : object (a) {
   type = a.type;
   runs = a.runs;
   progress = a.progress;
+  progressStart = a.progressStart;
+  progressLast = a.progressLast;
 }
 
 /* This function adds the given analysis to the actions being
@@ -103,6 +125,14 @@ void analysis::delAnalysis (analysis * a) {
   }
 }
 
+/* The function passes the request to forget the solutions kept for
+   seeding on to the child analyses. */
+void analysis::resetSeeds (void) {
+  if (actions != nullptr)
+    for (auto *a : *actions)
+      a->resetSeeds ();
+}
+
 /* The following function creates a sweep object depending on the
    analysis's properties.  Supported sweep types are: linear,
    logarithmic, lists and constants. */
@@ -164,4 +194,79 @@ sweep * analysis::createSweep (const std::string& n) {
   d->add (z);
 }
 
+// Returns a monotonic time in seconds.
+static double analysis_clock (void) {
+  return std::chrono::duration<double> (
+    std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/* The function writes the complete vectors of the given dataset into
+   the partial results file and announces the vectors changed since
+   the last call.  The file is replaced at once, so that readers never
+   see a half written one. */
+static void analysis_write_partial (dataset * data) {
+  static dataset * last = NULL;
+  static double written = 0;  // end of the last write
+  static double interval = PARTIAL_INTERVAL;
+  static std::unordered_map<std::string, int> sizes;
+
+  double now = analysis_clock ();
+  if (data == last && now - written < interval) return;
+  if (data != last) sizes.clear ();
+  last = data;
+
+  // collect the vectors grown since the last call
+  std::string changed;
+  for (vector * v = data->getVariables (); v; v = (vector *) v->getNext ()) {
+    if (v->getDependencies () != NULL && !data->isComplete (v)) continue;
+    int & n = sizes[v->getName ()];
+    if (n == v->getSize ()) continue;
+    n = v->getSize ();
+    if (!changed.empty ()) changed += ",";
+    changed += v->getName ();
+  }
+  if (changed.empty ()) return;
+
+  std::string part = std::string (analysis_partial) + ".part";
+  FILE * f = fopen (part.c_str (), "w");
+  if (f == NULL) return;
+  data->printComplete (f);
+  fclose (f);
+#ifdef __MINGW32__
+  remove (analysis_partial);
+#endif
+  if (rename (part.c_str (), analysis_partial) == 0)
+    logprint (LOG_STATUS, "@partial vars=%s\n", changed.c_str ());
+
+  // the file grows with the run, so wait longer when writing got slow
+  written = analysis_clock ();
+  interval = std::max (PARTIAL_INTERVAL,
+		       (written - now) * (1 - PARTIAL_SHARE) / PARTIAL_SHARE);
+}
+
+/* Reports the progress of the analysis at the given point out of the
+   given number of points. */
+void analysis::reportProgress (int i, int n) {
+  if (progress) logprogressbar (i, n, 40);
+  if (!analysis_status) return;
+
+  // a status line for each percent
+  double now = analysis_clock ();
+  if (i == 0) {
+    progressStart = now;
+    progressLast = -1;
+  }
+  int percent = n > 0 ? i * 100 / n : 0;
+  if (percent != progressLast) {
+    progressLast = percent;
+    double eta = i > 0 ? (now - progressStart) * (n - i) / i : -1;
+    logprint (LOG_STATUS, "@progress name=%s index=%d count=%d eta=%.1f "
+	      "newton=%d top=%d\n", getName (), i, n, eta, getIterations (),
+	      progress ? 1 : 0);
+  }
+
+  // partial results
+  if (analysis_partial && data) analysis_write_partial (data);
+}
+
 } // namespace qucs
@@ -67,7 +67,8 @@ enum analysis_type
     ANALYSIS_HBALANCE,
     ANALYSIS_TRANSIENT,
     ANALYSIS_SPARAMETER,
-    ANALYSIS_E_TRANSIENT
+    ANALYSIS_E_TRANSIENT,
+    ANALYSIS_SENSITIVITY
 };
 
 /*! \class analysis
@@ -145,6 +146,41 @@ public:
         return 0;
     }
 
+    /*! \fn setSweepPoint
+    * \brief announces the next point of a parameter sweep
+    * \param sweep the parameter sweep driving this analysis
+    * \param v value of the swept parameter
+    * \param first true if this is the first point of the sweep
+    *
+    * Called by a parameter sweep before solving its child analyses.
+    * Solvers may use it to carry the solution of the previous sweep
+    * point forward.
+    */
+    virtual void setSweepPoint (analysis *, nr_double_t, bool)
+    {
+    }
+
+    /*! \fn resetSeeds
+    * \brief forgets the solutions kept for seeding the next solve
+    *
+    * Called before rerunning the analysis from scratch, e.g. for
+    * another candidate of an optimization.  The results then do not
+    * depend on the runs that came before.  The default passes the call
+    * on to the child analyses.
+    */
+    virtual void resetSeeds (void);
+
+    /*! \fn setSweepValue
+    * \brief sets the swept parameter to the given value
+    * \param v the new value of the swept parameter
+    *
+    * Implemented by parameter sweeps.  Allows child analyses to
+    * solve the netlist at intermediate parameter values.
+    */
+    virtual void setSweepValue (nr_double_t)
+    {
+    }
+
     /*! \fn isExternal
     * \brief informs whether this is an external sim
     *
@@ -267,6 +303,41 @@ public:
         progress = p;
     }
 
+    /*! \fn reportProgress
+     * \brief Reports the progress of the analysis
+     * \param i index of the current point
+     * \param n number of points
+     *
+     * Paints the progress bar if requested, emits a machine readable
+     * status line if enabled (see analysis_status) and writes the
+     * results obtained so far into the partial results file from time
+     * to time (see analysis_partial).
+     */
+    void reportProgress (int, int);
+
+    /*! \fn getIterations
+     * \brief Newton iterations of the last point
+     *
+     * Returns the number of Newton iterations needed for the last
+     * point, zero for non-iterative analyses.
+     */
+    virtual int getIterations (void)
+    {
+        return 0;
+    }
+
+    /*! \fn resetRuns
+     * \brief Forgets about previous runs
+     *
+     * Analyses save their independent variables during their first
+     * run only.  Resetting the runs allows solving the netlist once
+     * more into a new dataset.
+     */
+    void resetRuns (void)
+    {
+        runs = 0;
+    }
+
 protected:
     int runs;
     int type;
@@ -275,8 +346,16 @@ protected:
     environment * env;
     ptrlist<analysis> * actions;
     bool progress;
+    double progressStart;
+    int progressLast;
 };
 
+/* Emit machine readable progress lines if non-zero. */
+extern int analysis_status;
+
+/* Name of the file the partial results are written to, or NULL. */
+extern const char * analysis_partial;
+
 } // namespace qucs
 
 #endif /* __ANALYSIS_H__ */
@@ -32,6 +32,9 @@
 #include <cmath>
 #include <assert.h>
 #include <float.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 #include "logging.h"
 #include "strlist.h"
@@ -51,6 +54,90 @@ struct definition_t * definition_root = NULL;
 struct definition_t * subcircuit_root = NULL;
 environment * env_root = NULL;
 
+/* Hash indexes of the definition list currently being checked.  They
+   replace the linear list scans in the lookup functions below which
+   would otherwise make checking quadratic in the netlist size. */
+struct checker_index_t
+{
+    struct definition_t * root;
+    /* definitions by type and instance name, in list order */
+    std::unordered_map<std::string, std::vector<struct definition_t *> > defs;
+    /* first identifier value by definition type, key and identifier */
+    std::unordered_map<std::string, struct value_t *> vars;
+    /* node counts and nodeset definitions by node name */
+    bool nodesIndexed;
+    std::unordered_map<std::string, int> nodes;
+    std::unordered_map<std::string, std::vector<struct definition_t *> > nodesets;
+};
+static struct checker_index_t * checker_index = NULL;
+
+/* Returns the index key composed of the given strings. */
+static std::string checker_index_key (const char * a, const char * b,
+                                      const char * c = NULL)
+{
+    std::string key (a);
+    key += '\0';
+    key += b;
+    if (c != NULL)
+    {
+        key += '\0';
+        key += c;
+    }
+    return key;
+}
+
+/* Returns the index of the given definition list if available. */
+static struct checker_index_t * checker_get_index (struct definition_t * root)
+{
+    if (checker_index != NULL && checker_index->root == root)
+        return checker_index;
+    return NULL;
+}
+
+/* Creates the definition and variable indexes of the given definition
+   list. */
+static struct checker_index_t * checker_build_index (struct definition_t * root)
+{
+    struct checker_index_t * idx = new checker_index_t ();
+    idx->root = root;
+    idx->nodesIndexed = false;
+    for (struct definition_t * def = root; def != NULL; def = def->next)
+    {
+        idx->defs[checker_index_key (def->type, def->instance)].push_back (def);
+        for (struct pair_t * pair = def->pairs; pair != NULL; pair = pair->next)
+        {
+            if (pair->value->ident != NULL)
+            {
+                std::string key =
+                    checker_index_key (def->type, pair->key, pair->value->ident);
+                if (idx->vars.find (key) == idx->vars.end ())
+                    idx->vars[key] = pair->value;
+            }
+        }
+    }
+    return idx;
+}
+
+/* Creates the node indexes of the given index.  This must be done
+   once the nodeset definitions are marked. */
+static void checker_index_nodes (struct checker_index_t * idx)
+{
+    if (idx->nodesIndexed) return;
+    for (struct definition_t * def = idx->root; def != NULL; def = def->next)
+    {
+        if (!def->action && !def->nodeset)
+        {
+            for (struct node_t * node = def->nodes; node != NULL; node = node->next)
+                idx->nodes[node->node]++;
+        }
+        if (def->nodeset && def->nodes)
+        {
+            idx->nodesets[def->nodes->node].push_back (def);
+        }
+    }
+    idx->nodesIndexed = true;
+}
+
 /* The function counts the nodes in a definition line. */
 static int checker_count_nodes (struct definition_t * def)
 {
@@ -103,12 +190,105 @@ static int checker_is_property (struct define_t * available,
     return PROP_NONE;
 }
 
+/* Properties declaring the tolerance of a component property for the
+   Monte Carlo analysis, given as 'Prop.Tol' and 'Prop.Dist'. */
+static struct property_t checker_tolerances[] = {
+    { "Tol", PROP_REAL, { 0, PROP_NO_STR }, PROP_POS_RANGE },
+    { "Dist", PROP_STR, { PROP_NO_VAL, "gauss" },
+      PROP_RNG_STR2 ("gauss", "uniform") },
+    PROP_NO_PROP
+};
+
+/* Checks if the given property key declares the tolerance of a real
+   valued property of the given definition type.  Returns the
+   description of the tolerance property or NULL if not. */
+static struct property_t * checker_is_tolerance (struct define_t * available,
+                                                 const char * key)
+{
+    const char * dot = strrchr (key, '.');
+    if (dot == NULL || dot == key || available->action) return NULL;
+    for (int i = 0; PROP_IS_PROP (checker_tolerances[i]); i++)
+    {
+        if (strcmp (dot + 1, checker_tolerances[i].key)) continue;
+        char * base = strdup (key);
+        base[dot - key] = '\0';
+        int type = checker_is_property (available, base);
+        free (base);
+        if (type == PROP_REAL) return &checker_tolerances[i];
+    }
+    return NULL;
+}
+
+/* Properties declaring the variables and goals of an optimization,
+   given as 'Var.Min', 'Var.Max', 'Var.Init', 'Var.Type' and
+   'Result.Goal', 'Result.Value'. */
+static struct property_t checker_optimization[] = {
+    { "Min", PROP_REAL, { 0, PROP_NO_STR }, PROP_NO_RANGE },
+    { "Max", PROP_REAL, { 0, PROP_NO_STR }, PROP_NO_RANGE },
+    { "Init", PROP_REAL, { 0, PROP_NO_STR }, PROP_NO_RANGE },
+    { "Type", PROP_STR, { PROP_NO_VAL, "LIN_DOUBLE" }, PROP_NO_RANGE },
+    { "Goal", PROP_STR, { PROP_NO_VAL, "MIN" },
+      PROP_RNG_STR6 ("MIN", "MAX", "LE", "GE", "EQ", "MON") },
+    { "Value", PROP_REAL, { 0, PROP_NO_STR }, PROP_NO_RANGE },
+    PROP_NO_PROP
+};
+
+/* Checks if the given property key declares an optimization variable
+   or goal in an optimization.  Returns the description of the
+   property or NULL if not. */
+static struct property_t * checker_is_optimization (struct define_t * available,
+                                                    const char * key)
+{
+    const char * dot = strrchr (key, '.');
+    if (dot == NULL || dot == key || strcmp (available->type, "OPT"))
+        return NULL;
+    for (int i = 0; PROP_IS_PROP (checker_optimization[i]); i++)
+    {
+        if (!strcmp (dot + 1, checker_optimization[i].key))
+            return &checker_optimization[i];
+    }
+    return NULL;
+}
+
+/* Looks for the given identifier being an optimization variable.
+   Returns non-zero if so, zero otherwise. */
+static int checker_find_optvar (struct definition_t * root, const char * ident)
+{
+    size_t len = strlen (ident);
+    for (struct definition_t * def = root; def != NULL; def = def->next)
+    {
+        if (!def->action || strcmp (def->type, "OPT")) continue;
+        for (struct pair_t * pair = def->pairs; pair != NULL; pair = pair->next)
+        {
+            if (strncmp (pair->key, ident, len) || pair->key[len] != '.')
+                continue;
+            const char * suffix = pair->key + len + 1;
+            if (!strcmp (suffix, "Min") || !strcmp (suffix, "Max") ||
+                    !strcmp (suffix, "Init") || !strcmp (suffix, "Type"))
+                return 1;
+        }
+    }
+    return 0;
+}
+
 /* Counts the number of definitions given by the specified type and
    instance name in the definition list. */
 static int checker_count_definition (struct definition_t * root,
                                      const char * type, char * instance)
 {
     int count = 0;
+    struct checker_index_t * idx = checker_get_index (root);
+    if (idx != NULL)
+    {
+        auto it = idx->defs.find (checker_index_key (type, instance));
+        if (it == idx->defs.end ()) return 0;
+        for (struct definition_t * def : it->second)
+        {
+            if (++count > 1)
+                def->duplicate = 1;
+        }
+        return count;
+    }
     for (struct definition_t * def = root; def != NULL; def = def->next)
     {
         if (!strcmp (def->type, type) && !strcmp (def->instance, instance))
@@ -129,6 +309,13 @@ static struct value_t * checker_find_variable (struct definition_t * root,
         char * ident)
 {
     struct pair_t * pair;
+    struct checker_index_t * idx = checker_get_index (root);
+    if (idx != NULL)
+    {
+        if (ident == NULL) return NULL;
+        auto it = idx->vars.find (checker_index_key (type, key, ident));
+        return it != idx->vars.end () ? it->second : NULL;
+    }
     for (struct definition_t * def = root; def != NULL; def = def->next)
     {
         if (!strcmp (def->type, type))
@@ -266,8 +453,25 @@ static int checker_resolve_variable (struct definition_t * root,
             value->var = TAG_DOUBLE;
             found++;
         }
-        /* 2. find analysis in parameter sweeps */
-        if ((val = checker_find_variable (root, "SW", "Sim", value->ident)))
+        /* also find variable in optimizations */
+        else if (checker_find_optvar (root, value->ident))
+        {
+            /* add optimization variable to environment */
+            if (root->env && root->env->getVariable (value->ident) == NULL)
+            {
+                checker_add_variable (root->env, value->ident, TAG_DOUBLE, true);
+            }
+            value->var = TAG_DOUBLE;
+            found++;
+        }
+        /* 2. find analysis in parameter sweeps, Monte Carlo analyses and
+              optimizations, and result vector in Monte Carlo yield
+              specifications and sensitivity analyses */
+        if ((val = checker_find_variable (root, "SW", "Sim", value->ident)) ||
+                (val = checker_find_variable (root, "MC", "Sim", value->ident)) ||
+                (val = checker_find_variable (root, "OPT", "Sim", value->ident)) ||
+                (val = checker_find_variable (root, "MC", "Spec", value->ident)) ||
+                (val = checker_find_variable (root, "SENS", "Output", value->ident)))
         {
             found++;
         }
@@ -590,8 +794,10 @@ static int checker_validate_para_cycles (struct definition_t * root,
                 return ++errors;
             }
             deps->append (instance);
-            /* recurse into parameter sweeps */
-            if (!strcmp (def->type, "SW"))
+            /* recurse into parameter sweeps, Monte Carlo analyses and
+               optimizations */
+            if (!strcmp (def->type, "SW") || !strcmp (def->type, "MC") ||
+                    !strcmp (def->type, "OPT"))
             {
                 if ((val = checker_find_reference (def, "Sim")) != NULL)
                 {
@@ -612,8 +818,10 @@ static int checker_validate_para (struct definition_t * root)
     struct value_t * val;
     for (struct definition_t * def = root; def != NULL; def = def->next)
     {
-        /* find parameter sweep */
-        if (def->action == 1 && !strcmp (def->type, "SW"))
+        /* find parameter sweep, Monte Carlo analysis or optimization */
+        if (def->action == 1 && (!strcmp (def->type, "SW") ||
+                                 !strcmp (def->type, "MC") ||
+                                 !strcmp (def->type, "OPT")))
         {
             /* the 'Sim' property must be an identifier */
             if ((val = checker_validate_reference (def, "Sim")) == NULL)
@@ -931,6 +1139,13 @@ static int checker_count_nodes (struct definition_t * root, char * n)
 {
     int count = 0;
     struct node_t * node;
+    struct checker_index_t * idx = checker_get_index (root);
+    if (idx != NULL)
+    {
+        checker_index_nodes (idx);
+        auto it = idx->nodes.find (n);
+        return it != idx->nodes.end () ? it->second : 0;
+    }
     for (struct definition_t * def = root; def != NULL; def = def->next)
     {
         if (!def->action && !def->nodeset)
@@ -947,6 +1162,21 @@ static int checker_count_nodes (struct definition_t * root, char * n)
 static int checker_count_nodesets (struct definition_t * root, char * n)
 {
     int count = 0;
+    struct checker_index_t * idx = checker_get_index (root);
+    if (idx != NULL)
+    {
+        checker_index_nodes (idx);
+        auto it = idx->nodesets.find (n);
+        if (it == idx->nodesets.end ()) return 0;
+        for (struct definition_t * def : it->second)
+        {
+            if (!def->duplicate)
+            {
+                if (++count > 1) def->duplicate = 1;
+            }
+        }
+        return count;
+    }
     for (struct definition_t * def = root; def != NULL; def = def->next)
     {
         if (def->nodeset && !def->duplicate && def->nodes)
@@ -1797,6 +2027,11 @@ static int checker_validate_properties (struct definition_t * root,
     {
         /* check whether properties are either required or optional */
         int type = checker_is_property (available, pair->key);
+        struct property_t * extra = NULL;
+        if (type == PROP_NONE &&
+                ((extra = checker_is_tolerance (available, pair->key)) != NULL ||
+                 (extra = checker_is_optimization (available, pair->key)) != NULL))
+            type = extra->type;
         if (type == PROP_NONE)
         {
             if (strcmp (def->type, "Def"))
@@ -1815,7 +2050,12 @@ static int checker_validate_properties (struct definition_t * root,
             if (!checker_evaluate_scale (pair->value))
                 errors++;
             /* check whether properties are in range */
-            if (!checker_value_in_range (def->instance, available, pair))
+            if (extra != NULL)
+            {
+                errors += checker_value_in_prop_range (def->instance, available,
+                                                       pair, extra);
+            }
+            else if (!checker_value_in_range (def->instance, available, pair))
             {
                 errors++;
             }
@@ -2025,6 +2265,10 @@ static int netlist_checker_intern (struct definition_t * root)
     struct define_t * available;
     int n, errors = 0;
 
+    /* index the definition list */
+    struct checker_index_t * saved = checker_index;
+    checker_index = checker_build_index (root);
+
     /* go through all definitions */
     for (def = root; def != NULL; def = def->next)
     {
@@ -2090,6 +2334,9 @@ static int netlist_checker_intern (struct definition_t * root)
     errors += checker_validate_subcircuits (root);
     /* check nodeset definitions */
     errors += checker_validate_nodesets (root);
+
+    delete checker_index;
+    checker_index = saved;
     return errors;
 }
 
@@ -266,33 +266,34 @@ void circuit::allocMatrixN (int sources) {
   MatrixN = new nr_complex_t[(size + sources) * (size + sources)];
 }
 
-/* Allocates the matrix memory for the MNA matrices. */
+/* Allocates the matrix memory for the MNA matrices.  All matrices
+   and vectors are placed into a single contiguous block. */
 void circuit::allocMatrixMNA (void) {
   freeMatrixMNA ();
   if (size > 0) {
-    MatrixY = new nr_complex_t[size * size];
-    VectorI = new nr_complex_t[size];
-    VectorV = new nr_complex_t[size];
+    int n = size * size + 2 * size;
+    if (vsources > 0)
+      n += 2 * vsources * size + vsources * vsources + 2 * vsources;
+    nr_complex_t * block = new nr_complex_t[n];
+    MatrixY = block; block += size * size;
+    VectorI = block; block += size;
+    VectorV = block; block += size;
     if (vsources > 0) {
-      MatrixB = new nr_complex_t[vsources * size];
-      MatrixC = new nr_complex_t[vsources * size];
-      MatrixD = new nr_complex_t[vsources * vsources];
-      VectorE = new nr_complex_t[vsources];
-      VectorJ = new nr_complex_t[vsources];
+      MatrixB = block; block += vsources * size;
+      MatrixC = block; block += vsources * size;
+      MatrixD = block; block += vsources * vsources;
+      VectorE = block; block += vsources;
+      VectorJ = block;
     }
   }
 }
 
-/* Free()'s all memory used by the MNA matrices. */
+/* Free()'s all memory used by the MNA matrices.  The block is owned
+   by the Y-matrix pointer. */
 void circuit::freeMatrixMNA (void) {
-  if (MatrixY) { delete[] MatrixY; MatrixY = NULL; }
-  if (MatrixB) { delete[] MatrixB; MatrixB = NULL; }
-  if (MatrixC) { delete[] MatrixC; MatrixC = NULL; }
-  if (MatrixD) { delete[] MatrixD; MatrixD = NULL; }
-  if (VectorE) { delete[] VectorE; VectorE = NULL; }
-  if (VectorI) { delete[] VectorI; VectorI = NULL; }
-  if (VectorV) { delete[] VectorV; VectorV = NULL; }
-  if (VectorJ) { delete[] VectorJ; VectorJ = NULL; }
+  if (MatrixY) { delete[] MatrixY; }
+  MatrixY = MatrixB = MatrixC = MatrixD = NULL;
+  VectorE = VectorI = VectorV = VectorJ = NULL;
 }
 
 /* This function sets the name and port number of one of the circuit's
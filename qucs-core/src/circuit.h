@@ -60,6 +60,7 @@
 
 #include "integrator.h"
 #include "valuelist.h"
+#include "mempool.h"
 
 namespace qucs {
 
@@ -109,6 +110,7 @@ class circuit : public object, public integrator
   circuit (int);
   circuit (const circuit &);
   virtual ~circuit ();
+  MEMPOOL_OPERATORS
 
   // functionality to be overloaded by real, derived circuit element
   // implementations
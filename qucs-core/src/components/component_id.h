@@ -188,6 +188,9 @@ enum circuit_type {
   // external interface components
   CIR_ECVS,
 
+  // reduced order models
+  CIR_ROM,
+
 };
 
 } // namespace qucs
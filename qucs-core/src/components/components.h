@@ -39,6 +39,7 @@
 #include "tee.h"
 #include "cross.h"
 #include "itrafo.h"
+#include "rom.h"
 
 #include "resistor.h"
 #include "capacitor.h"
@@ -31,6 +31,7 @@
 #include "poly.h"
 #include "spline.h"
 #include "interpolator.h"
+#include "datacache.h"
 #include "ifile.h"
 
 using namespace qucs;
@@ -44,10 +45,10 @@ ifile::ifile () : circuit (2) {
   inter = NULL;
 }
 
-// Destructor deletes ifile object from memory.
+// Destructor deletes ifile object from memory.  The dataset and the
+// interpolator are owned by the data cache.
 ifile::~ifile () {
-  delete data;
-  delete inter;
+  datacache::release (data);
 }
 
 void ifile::prepare (void) {
@@ -76,9 +77,9 @@ void ifile::prepare (void) {
   const char * file = getPropertyString ("File");
   if (data == NULL) {
     if (strlen (file) > 4 && !strcasecmp (&file[strlen (file) - 4], ".dat"))
-      data = dataset::load (file);
+      data = datacache::load (file, dataset::load);
     else
-      data = dataset::load_csv (file);
+      data = datacache::load (file, dataset::load_csv);
     if (data != NULL) {
       // check number of variables / dependencies defined by that file
       if (data->countVariables () != 1 || data->countDependencies () != 1) {
@@ -89,9 +90,8 @@ void ifile::prepare (void) {
       }
       qucs::vector * is = data->getVariables();    // current
       qucs::vector * ts = data->getDependencies(); // time
-      inter = new interpolator ();
-      inter->rvectors (is, ts);
-      inter->prepare (interpolType, dataType);
+      inter = datacache::getInterpolator (is, ts, true, interpolType,
+					  dataType, DATA_RECTANGULAR);
     }
   }
 }
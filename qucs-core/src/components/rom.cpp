@@ -0,0 +1,114 @@
+/*
+ * rom.cpp - reduced order model class implementation
+ *
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "component.h"
+#include "rom.h"
+
+using namespace qucs;
+
+/* The reduced order model of a linear subnetwork is described by its
+   conductance matrix G, its capacitance matrix C and its (normalized)
+   noise current correlation matrix N.  The first nodes of the circuit
+   are the ports of the original subnetwork, the remaining ones are
+   internal nodes representing the reduced states. */
+rom::rom (int nodes) : circuit (nodes) {
+  type = CIR_ROM;
+  setISource (true);
+}
+
+// Passes the model matrices to the circuit.
+void rom::setModel (matrix g, matrix c, matrix n) {
+  G = g;
+  C = c;
+  N = n;
+}
+
+void rom::initSP (void) {
+  allocMatrixS ();
+}
+
+void rom::calcSP (nr_double_t frequency) {
+  nr_complex_t s = nr_complex_t (0, 2.0 * pi * frequency);
+  setMatrixS (ytos (G + C * s));
+}
+
+void rom::calcNoiseSP (nr_double_t) {
+  setMatrixN (cytocs (N * z0, getMatrixS ()));
+}
+
+void rom::initDC (void) {
+  setVoltageSources (0);
+  allocMatrixMNA ();
+}
+
+void rom::calcDC (void) {
+  setMatrixY (G);
+}
+
+void rom::initAC (void) {
+  initDC ();
+}
+
+void rom::calcAC (nr_double_t frequency) {
+  nr_complex_t s = nr_complex_t (0, 2.0 * pi * frequency);
+  setMatrixY (G + C * s);
+}
+
+void rom::calcNoiseAC (nr_double_t) {
+  setMatrixN (N);
+}
+
+void rom::initTR (void) {
+  setStates (2 * getSize ());
+  initDC ();
+}
+
+/* Each node carries the charge of its row of the capacitance matrix.
+   The charge is integrated and its dependency on the node voltages is
+   stamped into the Jacobian. */
+void rom::calcTR (nr_double_t) {
+  int r, c, n = getSize ();
+  calcDC ();
+  clearI ();
+  for (r = 0; r < n; r++) {
+    nr_double_t q = 0;
+    for (c = 0; c < n; c++) q += real (C (r, c)) * real (getV (c));
+    transientCapacitanceQ (2 * r, r, q);
+    for (c = 0; c < n; c++) {
+      nr_double_t cap = real (C (r, c));
+      if (cap != 0.0) transientCapacitanceC (r, c, cap, real (getV (c)));
+    }
+  }
+}
+
+void rom::initHB (void) {
+  initDC ();
+}
+
+void rom::calcHB (nr_double_t frequency) {
+  calcAC (frequency);
+}
@@ -0,0 +1,51 @@
+/*
+ * rom.h - reduced order model class definitions
+ *
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __ROM_H__
+#define __ROM_H__
+
+class rom : public qucs::circuit
+{
+ public:
+  rom (int);
+  void setModel (qucs::matrix, qucs::matrix, qucs::matrix);
+  void initSP (void);
+  void calcSP (nr_double_t);
+  void calcNoiseSP (nr_double_t);
+  void initDC (void);
+  void calcDC (void);
+  void initAC (void);
+  void calcAC (nr_double_t);
+  void calcNoiseAC (nr_double_t);
+  void initTR (void);
+  void calcTR (nr_double_t);
+  void initHB (void);
+  void calcHB (nr_double_t);
+
+ private:
+  qucs::matrix G;
+  qucs::matrix C;
+  qucs::matrix N;
+};
+
+#endif /* __ROM_H__ */
@@ -33,6 +33,7 @@
 #include "poly.h"
 #include "spline.h"
 #include "interpolator.h"
+#include "datacache.h"
 #include "spfile.h"
 
 using namespace qucs;
@@ -43,11 +44,13 @@ spfile_vector::spfile_vector () {
   isreal = 1;
   inter = NULL;
   r = c = 0;
+  owned = 0;
 }
 
-// Destructor for S-parameter file vector.
+// Destructor for S-parameter file vector.  The interpolator is owned
+// by the data cache, the data vector only if created by the instance.
 spfile_vector::~spfile_vector () {
-  delete inter;
+  if (owned) delete v;
 }
 
 // Passes vectors and their data types to the S-parameter file vector.
@@ -56,15 +59,7 @@ void spfile_vector::prepare (qucs::vector * _v, qucs::vector * _f,
   v = _v;
   f = _f;
   isreal = _isreal;
-  inter = new interpolator ();
-  if (isreal) {
-    inter->rvectors (v, f);
-    inter->prepare (it, REPEAT_NO, dt | DATA_REAL);
-  }
-  else {
-    inter->cvectors (v, f);
-    inter->prepare (it, REPEAT_NO, dt | DATA_COMPLEX);
-  }
+  inter = datacache::getInterpolator (v, f, isreal, it, REPEAT_NO, dt);
 }
 
 // Returns interpolated data.
@@ -75,11 +70,27 @@ nr_complex_t spfile_vector::interpolate (nr_double_t x) {
     return inter->cinterpolate (x);
 }
 
+/* Returns the index pointer into the frequency vector for the given
+   value.  It is valid for all vectors sharing the same frequency
+   vector. */
+int spfile_vector::locate (nr_double_t x) {
+  return inter->locate (x);
+}
+
+// Returns interpolated data using a previously located index.
+nr_complex_t spfile_vector::interpolate (nr_double_t x, int idx) {
+  if (isreal)
+    return inter->rinterpolate (x, idx);
+  else
+    return inter->cinterpolate (x, idx);
+}
+
 // Constructor creates an empty and unnamed instance of the spfile class.
 spfile::spfile () : circuit () {
   data = NULL;
   sfreq = nfreq = NULL;
   spara = FMIN = SOPT = RN = NULL;
+  table = NULL;
   interpolType = dataType = 0;
   type = CIR_SPFILE;
   setVariableSized (true);
@@ -91,13 +102,13 @@ spfile::~spfile () {
   delete RN;
   delete FMIN;
   delete SOPT;
+  datacache::release (data);
 #if DEBUG && 0
   if (data) {
     data->setFile ("spfile.dat");
     data->print ();
   }
 #endif
-  delete data;
 }
 
 void spfile::calcSP (nr_double_t frequency) {
@@ -111,15 +122,23 @@ void spfile::calcSP (nr_double_t frequency) {
 
 /* This function returns the S-parameter matrix of the circuit for the
    given frequency.  It uses interpolation for frequency points which
-   are not part of the original touchstone file. */
+   are not part of the original touchstone file.  The result is
+   tabulated and reused for repeated requests of the same frequency,
+   e.g. during nested parameter sweeps. */
 matrix spfile::getInterpolMatrixS (nr_double_t frequency) {
 
-  // first interpolate the matrix values
+  // lookup frequency in table
+  std::map<nr_double_t, matrix>::iterator it = table->s.find (frequency);
+  if (it != table->s.end ()) return it->second;
+
+  // first interpolate the matrix values, all entries share the same
+  // frequency vector, thus the lookup is done once
   matrix s (getSize () - 1);
+  int idx = spara[0].locate (frequency);
   for (int r = 0; r < getSize () - 1; r++) {
     for (int c = 0; c < getSize () - 1; c++) {
       int i = r * getSize () + c;
-      s.set (r, c, spara[i].interpolate (frequency));
+      s.set (r, c, spara[i].interpolate (frequency, idx));
     }
   }
 
@@ -138,6 +157,7 @@ matrix spfile::getInterpolMatrixS (nr_double_t frequency) {
     s = gtos (s);
     break;
   }
+  table->s[frequency] = s;
   return s;
 }
 
@@ -148,12 +168,22 @@ void spfile::calcNoiseSP (nr_double_t frequency) {
 }
 
 matrix spfile::calcMatrixCs (nr_double_t frequency) {
-  // set interpolated noise correlation matrix
-  nr_double_t r = real (RN->interpolate (frequency));
-  nr_double_t f = real (FMIN->interpolate (frequency));
-  nr_complex_t g = SOPT->interpolate (frequency);
   matrix s = getInterpolMatrixS (frequency);
-  matrix n = correlationMatrix (f, g, r, s);
+  matrix n;
+  // lookup noise correlation matrix in table
+  std::map<nr_double_t, matrix>::iterator it = table->n.find (frequency);
+  if (it != table->n.end ()) {
+    n = it->second;
+  }
+  else {
+    // set interpolated noise correlation matrix
+    int idx = RN->locate (frequency);
+    nr_double_t r = real (RN->interpolate (frequency, idx));
+    nr_double_t f = real (FMIN->interpolate (frequency, idx));
+    nr_complex_t g = SOPT->interpolate (frequency, idx);
+    n = correlationMatrix (f, g, r, s);
+    table->n[frequency] = n;
+  }
   matrix c = expandNoiseMatrix (n, expandSParaMatrix (s));
   return c;
 }
@@ -308,7 +338,7 @@ void spfile::prepare (void) {
 
   // load S-parameter file
   const char * file = getPropertyString ("File");
-  if (data == NULL) data = dataset::load_touchstone (file);
+  if (data == NULL) data = datacache::load (file, dataset::load_touchstone);
   if (data != NULL) {
     // determine the number of ports defined by that file
     int ports = (int) std::sqrt ((double) data->countVariables ());
@@ -317,6 +347,15 @@ void spfile::prepare (void) {
 	// find matrix vector entries in touchstone dataset
 	createIndex ();
       }
+      if (table == NULL) {
+	// use the frequency table shared by equal instances
+	std::string key = std::string ("spfile:") + itype + ":" + dtype;
+	table = (spfile_table *) datacache::getTable (data, key);
+	if (table == NULL) {
+	  table = new spfile_table ();
+	  datacache::setTable (data, key, table);
+	}
+      }
       if (sfreq == NULL) {
 	logprint (LOG_ERROR, "ERROR: file `%s' contains no `frequency' "
 		  "vector\n", file);
@@ -338,7 +377,7 @@ void spfile::initSP (void) {
 }
 
 /* The function creates an additional data vector for the given matrix
-   entry and adds it to the dataset. */
+   entry.  It is owned by the instance since the dataset is shared. */
 void spfile::createVector (int r, int c) {
   int i = r * getSize () + c;
   spara[i].r = r;
@@ -347,8 +386,9 @@ void spfile::createVector (int r, int c) {
 			       sfreq->getSize ());
   v->setDependencies (new strlist ());
   v->getDependencies()->add (sfreq->getName ());
-  data->addVariable (v);
+  if (spara[i].owned) delete spara[i].v;
   spara[i].v = v;
+  spara[i].owned = 1;
 }
 
 /* This function goes through the dataset stored within the original
@@ -503,7 +543,15 @@ void spfile::calcAC (nr_double_t frequency) {
   // calculate interpolated S-parameters
   calcSP (frequency);
   // convert S-parameters to Y-parameters
-  setMatrixY (stoy (getMatrixS ()));
+  std::map<nr_double_t, matrix>::iterator it = table->y.find (frequency);
+  if (it != table->y.end ()) {
+    setMatrixY (it->second);
+  }
+  else {
+    matrix y = stoy (getMatrixS ());
+    table->y[frequency] = y;
+    setMatrixY (y);
+  }
 }
 
 void spfile::calcNoiseAC (nr_double_t frequency) {
@@ -25,6 +25,11 @@
 #ifndef __SPFILE_H__
 #define __SPFILE_H__
 
+#include <map>
+#include <string>
+
+#include "datacache.h"
+
 namespace qucs {
   class vector;
   class matvec;
@@ -41,6 +46,8 @@ class spfile_vector
  public:
   void prepare (qucs::vector *, qucs::vector *, bool, int, int);
   nr_complex_t interpolate (nr_double_t);
+  nr_complex_t interpolate (nr_double_t, int);
+  int locate (nr_double_t);
 
  public:
   qucs::vector * v;
@@ -49,6 +56,18 @@ class spfile_vector
   qucs::interpolator * inter;
   int r;
   int c;
+  int owned; // vector created by the instance
+};
+
+/* Tabulated per-frequency data shared by all S-parameter file
+   instances referring to the same file and interpolation settings.
+   It is attached to the dataset in the data cache. */
+class spfile_table : public qucs::datacache_table
+{
+ public:
+  std::map<nr_double_t, qucs::matrix> s; // converted S-parameters
+  std::map<nr_double_t, qucs::matrix> y; // expanded Y-parameters
+  std::map<nr_double_t, qucs::matrix> n; // noise correlation matrices
 };
 
 class spfile : public qucs::circuit
@@ -85,6 +104,7 @@ class spfile : public qucs::circuit
   spfile_vector * RN;
   spfile_vector * FMIN;
   spfile_vector * SOPT;
+  spfile_table * table;
   char paraType;
   int  dataType;
   int  interpolType;
@@ -32,6 +32,7 @@
 #include "poly.h"
 #include "spline.h"
 #include "interpolator.h"
+#include "datacache.h"
 #include "vfile.h"
 
 using namespace qucs;
@@ -46,10 +47,10 @@ vfile::vfile () : circuit (2) {
   inter = NULL;
 }
 
-// Destructor deletes vfile object from memory.
+// Destructor deletes vfile object from memory.  The dataset and the
+// interpolator are owned by the data cache.
 vfile::~vfile () {
-  delete data;
-  delete inter;
+  datacache::release (data);
 }
 
 void vfile::prepare (void) {
@@ -78,9 +79,9 @@ void vfile::prepare (void) {
   const char * file = getPropertyString ("File");
   if (data == NULL) {
     if (strlen (file) > 4 && !strcasecmp (&file[strlen (file) - 4], ".dat"))
-      data = dataset::load (file);
+      data = datacache::load (file, dataset::load);
     else
-      data = dataset::load_csv (file);
+      data = datacache::load (file, dataset::load_csv);
     if (data != NULL) {
       // check number of variables / dependencies defined by that file
       if (data->countVariables () != 1 || data->countDependencies () != 1) {
@@ -91,9 +92,8 @@ void vfile::prepare (void) {
       }
       qucs::vector * vs = data->getVariables();    // voltage
       qucs::vector * ts = data->getDependencies(); // time
-      inter = new interpolator ();
-      inter->rvectors (vs, ts);
-      inter->prepare (interpolType, dataType);
+      inter = datacache::getInterpolator (vs, ts, true, interpolType,
+					  dataType, DATA_RECTANGULAR);
     }
   }
 }
@@ -34,6 +34,8 @@
 #include <assert.h>
 #include <float.h>
 #include <ctype.h>
+#include <string>
+#include <unordered_map>
 
 #include "check_vcd.h"
 
@@ -45,168 +47,280 @@
 #define VCD_INCLUDE_RANGE 0
 #define VCD_TIMEVAR "dtime"
 
+// Memory used for buffering value changes (in bytes).
+#define VCD_MEMORY   (32 * 1024 * 1024)
+#define VCD_MINCHUNK 256          // initial buffer size of a stream
+#define VCD_MAXCHUNK (256 * 1024) // largest buffer size of a stream
+
 // Global variables.
 struct vcd_file * vcd = NULL;
 int vcd_errors = 0;
 int vcd_freehdl = 1;
 int vcd_correct = 0;
-struct vcd_set * vcd_sets = NULL;
 struct dataset_variable * dataset_root = NULL;
 
-/* The function looks through all variable definitions in all scopes
-   to find the given reference code. */
-static struct vcd_vardef *
-vcd_find_code (struct vcd_scope * root, char * code) {
-  struct vcd_scope * scope;
-  for (scope = root; scope; scope = scope->next) {
-    struct vcd_vardef * var;
-    for (var = scope->vardefs; var; var = var->next) {
-      if (!strcmp (var->code, code))
-	return var;
-    }
-    // search in sub-scopes
-    if ((var = vcd_find_code (scope->scopes, code)) != NULL)
-      return var;
-  }
-  return NULL;
+/* The value changes are not kept in memory.  Each identifier code owns
+   a stream of records (set index, value) which are buffered and, once
+   the buffer is full, appended as a chunk to a temporary file.  The
+   dataset producer reads the streams back one by one.  Thus the memory
+   usage depends on the number of variables only.  Buffers of busy
+   streams grow as long as memory is left, thus these are spilled and
+   read back in a few large chunks. */
+
+// A chunk of a stream in the temporary file.
+struct vcd_chunk {
+  long offset;  // file position
+  int size;     // size in bytes
+  struct vcd_chunk * next;
+};
+
+// A stream of value changes.
+struct vcd_stream {
+  long set;                  // set index of the last record
+  long first;                // set index of the first record
+  int isreal;                // indicates type of the last value
+  int fill;                  // used bytes of the buffer
+  int capacity;              // size of the buffer
+  char * buffer;             // the buffer
+  struct vcd_chunk * chunks; // spilled chunks
+  struct vcd_chunk * last;   // last spilled chunk
+};
+
+// Local state of the streaming checker.
+static std::unordered_map<std::string, struct vcd_stream *> vcd_codes;
+static struct vcd_stream * vcd_times = NULL;
+static FILE * vcd_spill = NULL;
+static long vcd_spilled = 0; // size of the temporary file
+static long vcd_memory = 0;  // memory used by the buffers
+static long vcd_nsets = 0;
+static double vcd_lasttime = 0;
+
+// Creates an empty stream with the given buffer size.
+static struct vcd_stream * vcd_create_stream (int capacity) {
+  struct vcd_stream * s =
+    (struct vcd_stream *) calloc (1, sizeof (struct vcd_stream));
+  s->set = s->first = -1;
+  s->capacity = capacity;
+  s->buffer = (char *) malloc (capacity);
+  vcd_memory += capacity;
+  return s;
 }
 
-// Free's the given VCD change.
-static void vcd_free_change (struct vcd_change * vc) {
-  free (vc->code);
-  free (vc->value);
-  free (vc);
+// Free's the given stream.
+static void vcd_free_stream (struct vcd_stream * s) {
+  struct vcd_chunk * c, * cnext;
+  for (c = s->chunks; c; c = cnext) {
+    cnext = c->next;
+    free (c);
+  }
+  vcd_memory -= s->capacity;
+  free (s->buffer);
+  free (s);
 }
 
-// Free's the given VCD changeset.
-static void vcd_free_changeset (struct vcd_changeset * cs) {
-  struct vcd_change * vc, * vnext;
-  for (vc = cs->changes; vc; vc = vnext) {
-    vnext = vc->next;
-    vcd_free_change (vc);
+/* Appends the given data as a chunk to the temporary file.  The file
+   is written sequentially while parsing and read only afterwards, thus
+   its size gives the position of the chunk. */
+static void vcd_spill_chunk (struct vcd_stream * s, char * data, int len) {
+  if (vcd_spill == NULL && (vcd_spill = tmpfile ()) == NULL) {
+    fprintf (stderr, "vcd error, cannot create temporary file\n");
+    exit (-1);
   }
-  free (cs);
+  struct vcd_chunk * c =
+    (struct vcd_chunk *) calloc (1, sizeof (struct vcd_chunk));
+  c->offset = vcd_spilled;
+  c->size = len;
+  if (fwrite (data, 1, len, vcd_spill) != (size_t) len) {
+    fprintf (stderr, "vcd error, cannot write temporary file\n");
+    exit (-1);
+  }
+  vcd_spilled += len;
+  if (s->last) s->last->next = c;
+  else s->chunks = c;
+  s->last = c;
 }
 
-#if VCD_FAST
+/* Appends a record to the stream.  A full buffer is doubled while
+   memory is left, otherwise it is spilled.  Records are never split
+   across chunks, records larger than the buffer form a chunk on their
+   own. */
+static void vcd_stream_write (struct vcd_stream * s, long set, int isreal,
+			      const char * value) {
+  int len = sizeof (long) + 1 + strlen (value) + 1;
+  if (s->fill + len > s->capacity && s->capacity < VCD_MAXCHUNK &&
+      vcd_memory + s->capacity <= VCD_MEMORY) {
+    vcd_memory += s->capacity;
+    s->capacity *= 2;
+    s->buffer = (char *) realloc (s->buffer, s->capacity);
+  }
+  if (s->fill + len > s->capacity && s->fill > 0) {
+    vcd_spill_chunk (s, s->buffer, s->fill);
+    s->fill = 0;
+  }
+  char * rec = s->buffer + s->fill, * large = NULL;
+  if (len > s->capacity) rec = large = (char *) malloc (len);
+  memcpy (rec, &set, sizeof (long));
+  rec[sizeof (long)] = isreal ? 1 : 0;
+  strcpy (rec + sizeof (long) + 1, value);
+  if (large) {
+    vcd_spill_chunk (s, large, len);
+    free (large);
+  } else {
+    s->fill += len;
+  }
+  if (s->first < 0) s->first = set;
+  s->set = set;
+  s->isreal = isreal;
+}
 
-/* Returns changes sets in the list's order itself. */
-static struct vcd_changeset *
-vcd_find_firstset_fast (struct vcd_changeset * root) {
-  static struct vcd_changeset * last = root;
-  struct vcd_changeset * result = NULL;
-  result = last;
-  if (last) last = last->next;
-  return result;
+// Reader for the records of a stream.
+struct vcd_reader {
+  struct vcd_stream * stream;
+  struct vcd_chunk * chunk; // next chunk to read
+  char * data;              // current data
+  int len, pos;             // size and position in current data
+  char * buffer;            // buffer for chunks read from file
+  int size;                 // size of that buffer
+  int done;                 // in-memory buffer reached
+};
+
+// Starts reading the given stream.
+static void vcd_reader_init (struct vcd_reader * r, struct vcd_stream * s) {
+  memset (r, 0, sizeof (struct vcd_reader));
+  r->stream = s;
+  r->chunk = s->chunks;
 }
 
-/* Reverses the given change set and returns the pointer to the new
-   root change set. */
-static struct vcd_changeset *
-vcd_reverse_changesets (struct vcd_changeset * root) {
-  struct vcd_changeset * cs = NULL;
-  while (root != NULL) {
-    struct vcd_changeset * next = root->next;
-    root->next = cs;
-    cs = root;
-    root = next;
+/* Reads the next record of a stream.  Returns zero if there are no
+   more records. */
+static int vcd_reader_next (struct vcd_reader * r, long * set, int * isreal,
+			    char ** value) {
+  while (r->pos >= r->len) {
+    if (r->chunk != NULL) {
+      struct vcd_chunk * c = r->chunk;
+      if (c->size > r->size) {
+	r->size = c->size;
+	r->buffer = (char *) realloc (r->buffer, r->size);
+      }
+      fseek (vcd_spill, c->offset, SEEK_SET);
+      if (fread (r->buffer, 1, c->size, vcd_spill) != (size_t) c->size) {
+	fprintf (stderr, "vcd error, cannot read temporary file\n");
+	exit (-1);
+      }
+      r->data = r->buffer;
+      r->len = c->size;
+      r->pos = 0;
+      r->chunk = c->next;
+    } else if (!r->done) {
+      r->data = r->stream->buffer;
+      r->len = r->stream->fill;
+      r->pos = 0;
+      r->done = 1;
+    } else {
+      return 0;
+    }
   }
-  return cs;
+  char * rec = r->data + r->pos;
+  memcpy (set, rec, sizeof (long));
+  *isreal = rec[sizeof (long)];
+  *value = rec + sizeof (long) + 1;
+  r->pos += sizeof (long) + 1 + strlen (*value) + 1;
+  return 1;
 }
 
-#else
+// Finishes reading a stream.
+static void vcd_reader_free (struct vcd_reader * r) {
+  free (r->buffer);
+}
+
+// Counts the variable definitions in all scopes.
+static int vcd_count_vardefs (struct vcd_scope * root) {
+  int n = 0;
+  for (struct vcd_scope * scope = root; scope; scope = scope->next) {
+    for (struct vcd_vardef * var = scope->vardefs; var; var = var->next) n++;
+    n += vcd_count_vardefs (scope->scopes);
+  }
+  return n;
+}
 
-/* Returns the change set with the smallest time stamp which is yet
-   unprocessed.  It is based upon the fact that the list is in reverse
-   order. */
-static struct vcd_changeset *
-vcd_find_firstset (struct vcd_changeset * root) {
-  struct vcd_changeset * cs, * result = NULL;
-  double Min = root ? root->t : 0;
-  for (cs = root; cs; cs = cs->next) {
-    if (!cs->done && cs->t <= Min) {
-      Min = cs->t;
-      result = cs;
+// Creates a stream for each identifier code found in the scopes.
+static void vcd_create_streams (struct vcd_scope * root, int capacity) {
+  for (struct vcd_scope * scope = root; scope; scope = scope->next) {
+    for (struct vcd_vardef * var = scope->vardefs; var; var = var->next) {
+      if (vcd_codes.find (var->code) == vcd_codes.end ())
+	vcd_codes[var->code] = vcd_create_stream (capacity);
     }
+    vcd_create_streams (scope->scopes, capacity);
   }
-  return result;
 }
 
-#endif
+/* Once the definitions are complete, the function creates the hash
+   of identifier codes.  The streams start with small buffers, the
+   remaining memory goes to the busy ones. */
+static void vcd_prepare_streams (void) {
+  int n = vcd_count_vardefs (vcd->scopes) + 1;
+  vcd_codes.reserve (n);
+  vcd_create_streams (vcd->scopes, VCD_MINCHUNK);
+  vcd_times = vcd_create_stream (VCD_MINCHUNK);
+}
 
-/* Looks for the a variable name in the given list of variables. */
-static struct vcd_variable *
-vcd_find_variable (struct vcd_variable * root, struct vcd_vardef * var) {
-  for (struct vcd_variable * vv = root; vv; vv = vv->next) {
-    if (!strcmp (vv->code, var->code))
-      return vv;
+// Free's the given list of VCD changes.
+static void vcd_free_changes (struct vcd_change * vc) {
+  struct vcd_change * vnext;
+  for (; vc; vc = vnext) {
+    vnext = vc->next;
+    free (vc->code);
+    free (vc->value);
+    free (vc);
   }
-  return NULL;
 }
 
-/* The function sorts the given VCD changesets.  For this it creates a
-   new list of VCD sets.  Changesets with the same timestamp are
-   merged appropriately. */
-static void vcd_sort_changesets (struct vcd_changeset * root) {
-  struct vcd_changeset * cs;
-  struct vcd_set * vs, * current = NULL;
-  struct vcd_change * vc;
-  struct vcd_variable * vv;
-
-#if VCD_FAST
-  // for fast lookup, need to reverse list
-  root = vcd_reverse_changesets (root);
-#endif
+/* The function starts a new VCD set with the given time stamp unless
+   the time stamp equals the one of the current set. */
+static void vcd_start_set (double t) {
+  if (vcd_times == NULL) vcd_prepare_streams ();
+  if (vcd_nsets > 0 && t == vcd_lasttime) return;
+  if (vcd_nsets > 0 && t < vcd_lasttime) {
+    fprintf (stderr, "vcd notice, time stamp %g in line %d is less than "
+	     "the previous one\n", t, vcd_lineno);
+  }
+  // apply timestamp transformation
+  char txt[64];
+  sprintf (txt, "%+.11e", t * vcd->t * vcd->scale);
+  vcd_stream_write (vcd_times, vcd_nsets, 1, txt);
+  vcd_lasttime = t;
+  vcd_nsets++;
+}
 
-  // as long as there are still changesets unprocessed
-#if VCD_FAST
-  while ((cs = vcd_find_firstset_fast (root)) != NULL) {
-#else
-  while ((cs = vcd_find_firstset (root)) != NULL) {
-#endif
-    // create set if necessary
-    if (current == NULL || current->t != cs->t) {
-      vs = (struct vcd_set *) calloc (1, sizeof (struct vcd_set));
-      vs->t = cs->t;
-      // chain the list of sets
-      if (!current)
-	vcd_sets = vs;
-      else
-	current->next = vs;
-      current = vs;
+/* Passes the given value changes into the streams of the current VCD
+   set and free's them. */
+void vcd_process_changes (struct vcd_change * changes) {
+  if (vcd_nsets == 0) vcd_start_set (0);
+  long set = vcd_nsets - 1;
+  for (struct vcd_change * vc = changes; vc; vc = vc->next) {
+    auto it = vcd_codes.find (vc->code);
+    if (it == vcd_codes.end ()) {
+      fprintf (stderr, "vcd error, no such variable reference `%s' "
+	       "found\n", vc->code);
+      vcd_errors++;
+      continue;
     }
-
-    // go through list of value changes
-    for (vc = cs->changes; vc; vc = vc->next) {
-      vv = vcd_find_variable (current->variables, vc->var);
-      if (vv != NULL) {
-	// duplicate value change
-	vv->value = vc->value;
-	vv->isreal = vc->isreal;
-	if (current->t > 0) { // due to a $dumpvars before
-	  fprintf (stderr, "vcd notice, duplicate value change at t = %g of "
-		   "variable `%s'\n", current->t, vc->var->ident);
-	}
-      }
-      else {
-	// add variable to set
-	vv = (struct vcd_variable *) calloc (1, sizeof (struct vcd_variable));
-	vv->ident = vc->var->ident;
-	vv->type = vc->var->type;
-	vv->value = vc->value;
-	vv->isreal = vc->isreal;
-	vv->code = vc->code;
-	vv->next = current->variables;
-	current->variables = vv;
-      }
+    struct vcd_stream * s = it->second;
+    if (s->set == set && vcd_lasttime > 0) { // due to a $dumpvars before
+      fprintf (stderr, "vcd notice, duplicate value change at t = %g of "
+	       "variable `%s'\n", vcd_lasttime, vc->code);
     }
-#ifndef VCD_FAST
-    // changeset processed
-    cs->done = 1;
-#else
-    //vcd_free_changeset (cs);
-#endif
+    vcd_stream_write (s, set, vc->isreal, vc->value);
   }
+  vcd_free_changes (changes);
+}
+
+/* The function processes a VCD changeset as soon as it has been
+   parsed.  Changesets with the same timestamp are merged. */
+void vcd_process_changeset (struct vcd_changeset * cs) {
+  vcd_start_set (cs->t);
+  vcd_process_changes (cs->changes);
+  free (cs);
 }
 
 /* Predends the scope identifiers in front of a variable identfier. */
@@ -303,134 +417,61 @@ vcd_create_variable (struct vcd_vardef * var) {
   return ds;
 }
 
-/* Based on the value in the given VCD variable and the size (in bits)
-   the function returns a nicely formatted value for the dataset. */
-static char * vcd_create_value (struct vcd_variable * vv, int size) {
-  int i, len = strlen (vv->value);
+/* Based on the given value, the type of the VCD variable and its size
+   (in bits) the function returns a nicely formatted value for the
+   dataset. */
+static char * vcd_create_value (const char * val, int type, int size) {
+  int i, len = strlen (val);
   char * value;
 
-  if (vv->type == VAR_REAL) {
+  if (type == VAR_REAL) {
     // a real
     char txt[64];
-    double val = strtod (vv->value, NULL);
-    sprintf (txt, "%+.11e", val);
+    sprintf (txt, "%+.11e", strtod (val, NULL));
     value = strdup (txt);
-  } else if (vv->type == VAR_INTEGER) {
+  } else if (type == VAR_INTEGER) {
     // an integer
     char txt[64];
-    long val = 0, bit, i = strlen (vv->value) - 1;
+    long v = 0, bit, i = len - 1;
     for (bit = 1; i >= 0; i--, bit <<= 1) {
-      if (vv->value[i] == '1')
-	val |= bit;
-      else if (vv->value[i] == '0')
-	val &= ~bit;
+      if (val[i] == '1')
+	v |= bit;
+      else if (val[i] == '0')
+	v &= ~bit;
     }
-    sprintf (txt, "%+ld", val);
+    sprintf (txt, "%+ld", v);
     value = strdup (txt);
-    vv->isreal = 1;
-  } else if (size == len) {
+  } else if (size <= len) {
     // already good
-    value = strdup (vv->value);
+    value = strdup (val);
   } else {
     // fill left extending values for vectors
     value = (char *) calloc (1, size + 1);
     char fill;
-    fill = (vv->value[0] == '1') ? '0' : vv->value[0];
+    fill = (val[0] == '1') ? '0' : val[0];
     for (i = 0; i < size - len; i++) value[i] = fill;
-    strcpy (&value[i], vv->value);
+    strcpy (&value[i], val);
   }
   return value;
 }
 
-/* The function creates a full dataset variable for the given VCD
-   variable. */
+/* The function creates the dataset variable for the given VCD
+   variable.  Its values are produced from the stream of the variable's
+   identifier code later on. */
 static struct dataset_variable *
 vcd_create_dataset (struct vcd_vardef * var) {
-  struct dataset_variable * ds;
-  struct dataset_value * dv, * current = NULL;
-  struct vcd_set * vs;
-  struct vcd_variable * vv;
-  char * currentval = NULL;
-  int found;
-
-  ds = vcd_create_variable (var);
-
-  // go through all VCD sets
-  for (vs = vcd_sets; vs; vs = vs->next) {
-    found = 0;
-    // through all variables in the set
-    for (vv = vs->variables; vv; vv = vv->next) {
-      if (!strcmp (vv->code, var->code)) {
-	// found the variable in the set
-	dv = (struct dataset_value *)
-	  calloc (1, sizeof (struct dataset_value));
-	dv->value = vcd_create_value (vv, var->size);
-	// get value attribute
-	ds->isreal = vv->isreal;
-	// chain the list of values
-	if (!current)
-	  ds->values = dv;
-	else
-	  current->next = dv;
-	current = dv;
-	// save current value of the variable
-	currentval = dv->value;
-	found++;
-	break;
-      }
-    }
-    if (!found) {
-      // variable did not occur in the current VCD set
-      if (!currentval) {
-	// no initial value given
-	fprintf (stderr, "vcd error, variable `%s' has no initial value\n",
-		 ds->ident);
-	vcd_errors++;
-      } else {
-	// else: apply previous value
-	dv = (struct dataset_value *)
-	  calloc (1, sizeof (struct dataset_value));
-	dv->value = strdup (currentval);
-	// chain the list
-	if (!current)
-	  ds->values = dv;
-	else
-	  current->next = dv;
-	current = dv;
-      }
-    }
-  }
-  return ds;
-}
-
-/* The function creates the independent (timestamps) variable.  It
-   passes through all VCD changesets and collects the simulation
-   times. */
-static struct dataset_variable * vcd_create_indep (const char * name) {
-  struct dataset_variable * ds;
-  struct dataset_value * dv, * current = NULL;
-  struct vcd_set * vs;
-
-  // create dataset
-  ds = (struct dataset_variable *)
-    calloc (1, sizeof (struct dataset_variable));
-  ds->ident = strdup (name);
-  ds->output = 1;
-
-  // go through all VCD sets
-  for (vs = vcd_sets; vs; vs = vs->next) {
-    dv = (struct dataset_value *) calloc (1, sizeof (struct dataset_value));
-    ds->size++;
-    // apply timestamp transformation
-    char txt[64];
-    sprintf (txt, "%+.11e", vs->t * vcd->t * vcd->scale);
-    dv->value = strdup (txt);
-    // chain the list
-    if (!current)
-      ds->values = dv;
-    else
-      current->next = dv;
-    current = dv;
+  struct dataset_variable * ds = vcd_create_variable (var);
+  struct vcd_stream * s = vcd_codes[var->code];
+  ds->stream = s;
+  ds->vartype = var->type;
+  ds->bits = var->size;
+  ds->size = vcd_nsets;
+  ds->isreal = s->isreal || var->type == VAR_INTEGER;
+  if (vcd_nsets > 0 && s->first != 0) {
+    // no initial value given
+    fprintf (stderr, "vcd error, variable `%s' has no initial value\n",
+	     ds->ident);
+    vcd_errors++;
   }
   return ds;
 }
@@ -461,68 +502,69 @@ static void vcd_prepare_datasets (void) {
   // the dependent variables
   vcd_prepare_variable_datasets (vcd->scopes);
   // the independent variable
-  data = vcd_create_indep (VCD_TIMEVAR);
+  data = (struct dataset_variable *)
+    calloc (1, sizeof (struct dataset_variable));
+  data->ident = strdup (VCD_TIMEVAR);
+  data->output = 1;
   data->type = DATA_INDEPENDENT;
+  data->size = vcd_nsets;
+  data->stream = vcd_times;
+  data->vartype = VAR_REAL;
   data->next = dataset_root;
   dataset_root = data;
 }
 
-#if VCD_DEBUG
-// Debugging: Prints the VCD sets.
-static void vcd_print_sets (void) {
-  struct vcd_changeset * vs;
-  struct vcd_change * vv;
-  for (vs = vcd->changesets; vs; vs = vs->next) {
-    fprintf (stderr, "--- t => %g\n", vs->t);
-    for (vv = vs->changes; vv; vv = vv->next) {
-      fprintf (stderr, "%s\t => %s\n", vv->value, vv->var->ident);
+/* The function writes the values of the given dataset variable, one
+   per VCD set.  Variables keep their value until the next change, the
+   last change within a set is the valid one. */
+void vcd_print_values (FILE * out, struct dataset_variable * ds) {
+  struct vcd_reader r;
+  long set = -1, k;
+  int isreal, pending = 0;
+  char * value, * current = NULL;
+
+  if (ds->stream == NULL) return;
+  vcd_reader_init (&r, ds->stream);
+  pending = vcd_reader_next (&r, &set, &isreal, &value);
+  for (k = 0; k < ds->size; k++) {
+    // apply all changes of the current set
+    while (pending && set == k) {
+      free (current);
+      current = (ds->type == DATA_INDEPENDENT) ? strdup (value) :
+	vcd_create_value (value, ds->vartype, ds->bits);
+      pending = vcd_reader_next (&r, &set, &isreal, &value);
     }
+    if (current != NULL) fprintf (out, "  %s\n", current);
   }
+  free (current);
+  vcd_reader_free (&r);
 }
 
+#if VCD_DEBUG
 // Debugging: Prints the generate data sets.
 static void vcd_dataset_print (void) {
   struct dataset_variable * ds;
-  struct dataset_value * dv;
   for (ds = dataset_root; ds; ds = ds->next) {
     fprintf (stderr, "\n%s%s => %s\n",
 	     ds->type == DATA_INDEPENDENT ? "in" : "",
 	     ds->type == DATA_UNKNOWN ? "xxx" : "dep", ds->ident);
-    for (dv = ds->values; dv; dv = dv->next) {
-      fprintf (stderr, "  %s\n", dv->value);
-    }
+    vcd_print_values (stderr, ds);
   }
 }
 #endif /* VCD_DEBUG */
 
-/* This function is the overall VCD data checker.  It returns zero on
-   success, non-zero otherwise. */
+/* This function is the overall VCD data checker.  The value changes
+   have already been passed into the streams while parsing.  It returns
+   zero on success, non-zero otherwise. */
 int vcd_checker (void) {
 
-  // de-reference each value change identfier code
-  struct vcd_changeset * changeset;
-  for (changeset = vcd->changesets; changeset; changeset = changeset->next) {
-    struct vcd_change * change;
-    for (change = changeset->changes; change; change = change->next) {
-      change->var = vcd_find_code (vcd->scopes, change->code);
-      if (change->var == NULL) {
-	fprintf (stderr, "vcd error, no such variable reference `%s' "
-		 "found\n", change->code);
-	vcd_errors++;
-      }
-    }
-  }
-
+  if (vcd_times == NULL) vcd_prepare_streams ();
   if (vcd_errors) return -1;
 
-  // sort the VCD changesets
-  vcd_sort_changesets (vcd->changesets);
-
   // create the outgoing datasets
   vcd_prepare_datasets ();
 
 #if VCD_DEBUG
-  vcd_print_sets ();
   vcd_dataset_print ();
 #endif /* VCD_DEBUG */
 
@@ -551,26 +593,21 @@ static void vcd_free_scope (struct vcd_scope * root) {
 // Free's the given VCD file.
 static void vcd_free_file (struct vcd_file * vcd) {
   vcd_free_scope (vcd->scopes);
-  struct vcd_changeset * cs, * cnext;
-  for (cs = vcd->changesets; cs; cs = cnext) {
-    cnext = cs->next;
-    vcd_free_changeset (cs);
-  }
   free (vcd);
 }
 
-// Free's the given set of VCD changes.
-static void vcd_free_set (struct vcd_set * root) {
-  struct vcd_set * vs, * snext;
-  for (vs = root; vs; vs = snext) {
-    snext = vs->next;
-    struct vcd_variable * vv, * vnext;
-    for (vv = vs->variables; vv; vv = vnext) {
-      vnext = vv->next;
-      free (vv);
-    }
-    free (vs);
-  }
+// Free's the streams and the temporary file.
+static void vcd_free_streams (void) {
+  for (auto & it : vcd_codes) vcd_free_stream (it.second);
+  vcd_codes.clear ();
+  if (vcd_times) vcd_free_stream (vcd_times);
+  vcd_times = NULL;
+  if (vcd_spill) fclose (vcd_spill);
+  vcd_spill = NULL;
+  vcd_spilled = 0;
+  vcd_memory = 0;
+  vcd_nsets = 0;
+  vcd_lasttime = 0;
 }
 
 // Free's the given dataset list.
@@ -595,8 +632,7 @@ void vcd_destroy (void) {
   vcd_errors = 0;
   vcd_free_file (vcd);
   vcd = NULL;
-  vcd_free_set (vcd_sets);
-  vcd_sets = NULL;
+  vcd_free_streams ();
   vcd_free_dataset (dataset_root);
   dataset_root = NULL;
 }
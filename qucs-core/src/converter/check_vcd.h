@@ -32,7 +32,6 @@ extern FILE * vcd_in;
 
 /* Useful defines. */
 #define VCD_NOSCOPE "noscope"
-#define VCD_FAST 1
 
 __BEGIN_DECLS
 
@@ -49,6 +48,9 @@ int  vcd_lex (void);
 int  vcd_lex_destroy (void);
 void vcd_destroy (void);
 void vcd_init (void);
+void vcd_process_changeset (struct vcd_changeset *);
+void vcd_process_changes (struct vcd_change *);
+void vcd_print_values (FILE *, struct dataset_variable *);
 
 __END_DECLS
 
@@ -124,9 +126,6 @@ struct vcd_change {
 struct vcd_changeset {
   double t;                    // time stamp
   struct vcd_change * changes; // list of VCD changes 
-#ifndef VCD_FAST
-  int done;                    // flag for the checker
-#endif
   struct vcd_changeset * next;
 };
 
@@ -136,26 +135,6 @@ struct vcd_file {
   double scale;                      // time unit factor
   struct vcd_scope * scopes;         // scopes
   struct vcd_scope * currentscope;   // the current scope
-  struct vcd_changeset * changesets; // change sets
-};
-
-/* Checker specific data structures. */
-
-// A VCD variable.
-struct vcd_variable {
-  char * code;  // identifier code, references 'var'
-  char * ident; // variable identifer
-  char * value; // the value
-  int isreal;   // indicates type of value
-  int type;     // variable type
-  struct vcd_variable * next;
-};
-
-// A VCD change set.
-struct vcd_set {
-  double t;                        // time stamp
-  struct vcd_variable * variables; // list of VCD variables
-  struct vcd_set * next;
 };
 
 /* Qucs dataset specific data structures. */
@@ -182,6 +161,9 @@ struct dataset_variable {
   char * dependencies;           // variable dependencies (if dependent)
   int isreal;                    // indicates type of values
   struct dataset_value * values; // list of values
+  struct vcd_stream * stream;    // streamed values (if any)
+  int vartype;                   // type of the VCD variable
+  int bits;                      // size of the VCD variable in bits
   struct dataset_variable * next;
 };
 
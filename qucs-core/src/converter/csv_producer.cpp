@@ -33,6 +33,7 @@
 #include "dataset.h"
 
 #include "csv_producer.h"
+#include "data_writer.h"
 
 using namespace qucs;
 
@@ -55,6 +56,39 @@ struct csv_data {
 #define csv_crlf "\r\n"
 #endif
 
+/* Printing context passed to the row formatter. */
+struct csv_rows {
+  struct csv_data * data; // variable and dependency structures
+  int vectors;            // number of vectors
+  const char * sep;       // value separator
+  int seplen;             // length of separator
+};
+
+/* Formats a single row of CSV data into the given buffer. */
+static int csv_print_row (char * buf, int k, void * ctx) {
+  struct csv_rows * rows = (struct csv_rows *) ctx;
+  struct csv_data * data = rows->data;
+  char * p = buf;
+  for (int i = 0; i < rows->vectors; i++) {
+    nr_complex_t c = data[i].v->get ((k / data[i].skip) % data[i].len);
+    p += data_format (p, (double) real (c), 1);
+    if (data[i].type == 'c') {
+      memcpy (p, rows->sep, rows->seplen);
+      p += rows->seplen;
+      p += data_format (p, (double) imag (c), 1);
+    }
+    if (i != rows->vectors - 1) {
+      memcpy (p, rows->sep, rows->seplen);
+      p += rows->seplen;
+    }
+    else {
+      memcpy (p, csv_crlf, sizeof (csv_crlf) - 1);
+      p += sizeof (csv_crlf) - 1;
+    }
+  }
+  return p - buf;
+}
+
 /* The CSV data printer. */
 void csv_print (struct csv_data * data, int vectors, const char * sep) {
 
@@ -73,19 +107,13 @@ void csv_print (struct csv_data * data, int vectors, const char * sep) {
   }
 
   // print data
-  for (int k = 0; k < len; k++) {
-    for (int i = 0; i < vectors; i++) {
-      if (data[i].type == 'c')
-	fprintf (csv_out, "%+." "20" "e%s%+." "20" "e",
-		 (double) real (data[i].v->get (data[i].idx)), sep,
-		 (double) imag (data[i].v->get (data[i].idx)));
-      else
-	fprintf (csv_out, "%+." "20" "e",
-		 (double) real (data[i].v->get (data[i].idx)));
-      fprintf (csv_out, "%s", i != vectors - 1 ? sep : csv_crlf);
-      data[i].idx = ((k + 1) / data[i].skip) % data[i].len;
-    }
-  }
+  struct csv_rows rows;
+  rows.data = data;
+  rows.vectors = vectors;
+  rows.sep = sep;
+  rows.seplen = strlen (sep);
+  int rowsize = vectors * 2 * (DATA_FORMAT_MAX + rows.seplen) + 2;
+  data_write_rows (csv_out, len, rowsize, csv_print_row, &rows);
 }
 
 /* This is the overall CSV producer. */
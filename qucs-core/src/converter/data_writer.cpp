@@ -0,0 +1,369 @@
+/*
+ * data_writer.cpp - fast textual data output
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <thread>
+
+#include "data_writer.h"
+
+/* Global variables. */
+int data_jobs = 1; // number of threads formatting the output
+
+// Number of rows formatted at once by each thread.
+#define DATA_BLOCK_ROWS 4096
+
+/* The floating point numbers are converted using the Grisu2 algorithm
+   by Florian Loitsch ("Printing Floating-Point Numbers Quickly and
+   Accurately with Integers", PLDI 2010).  It produces the shortest
+   digit string which reads back to the same double in nearly all
+   cases, and a correctly round-tripping one in all others, using
+   64-bit integer arithmetic only. */
+
+// A floating point number f * 2^e with a 64-bit significand.
+struct data_fp {
+  uint64_t f;
+  int e;
+};
+
+static inline data_fp data_fp_sub (data_fp x, data_fp y) {
+  data_fp r = { x.f - y.f, x.e };
+  return r;
+}
+
+// Multiplies two numbers rounding the 128-bit product to 64 bits.
+static inline data_fp data_fp_mul (data_fp x, data_fp y) {
+  uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFFu;
+  uint64_t c = y.f >> 32, d = y.f & 0xFFFFFFFFu;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t t = (bd >> 32) + (ad & 0xFFFFFFFFu) + (bc & 0xFFFFFFFFu);
+  t += 1U << 31; // rounding
+  data_fp r = { ac + (ad >> 32) + (bc >> 32) + (t >> 32), x.e + y.e + 64 };
+  return r;
+}
+
+static inline data_fp data_fp_normalize (data_fp x) {
+  while ((x.f >> 63) == 0) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+/* Cached powers of ten c = f * 2^e approximating 10^k for every 8th
+   decimal exponent covering the range of doubles. */
+struct data_pow10 {
+  uint64_t f;
+  int e;
+  int k;
+};
+
+static const data_pow10 data_cached_pow10[] = {
+  { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+  { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+  { 0xBE5691EF416BD60CULL, -1007, -284 },
+  { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+  { 0xD3515C2831559A83ULL,  -954, -268 },
+  { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+  { 0xEA9C227723EE8BCBULL,  -901, -252 },
+  { 0xAECC49914078536DULL,  -874, -244 },
+  { 0x823C12795DB6CE57ULL,  -847, -236 },
+  { 0xC21094364DFB5637ULL,  -821, -228 },
+  { 0x9096EA6F3848984FULL,  -794, -220 },
+  { 0xD77485CB25823AC7ULL,  -768, -212 },
+  { 0xA086CFCD97BF97F4ULL,  -741, -204 },
+  { 0xEF340A98172AACE5ULL,  -715, -196 },
+  { 0xB23867FB2A35B28EULL,  -688, -188 },
+  { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+  { 0xC5DD44271AD3CDBAULL,  -635, -172 },
+  { 0x936B9FCEBB25C996ULL,  -608, -164 },
+  { 0xDBAC6C247D62A584ULL,  -582, -156 },
+  { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+  { 0xF3E2F893DEC3F126ULL,  -529, -140 },
+  { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+  { 0x87625F056C7C4A8BULL,  -475, -124 },
+  { 0xC9BCFF6034C13053ULL,  -449, -116 },
+  { 0x964E858C91BA2655ULL,  -422, -108 },
+  { 0xDFF9772470297EBDULL,  -396, -100 },
+  { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },
+  { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+  { 0xB94470938FA89BCFULL,  -316,  -76 },
+  { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+  { 0xCDB02555653131B6ULL,  -263,  -60 },
+  { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+  { 0xE45C10C42A2B3B06ULL,  -210,  -44 },
+  { 0xAA242499697392D3ULL,  -183,  -36 },
+  { 0xFD87B5F28300CA0EULL,  -157,  -28 },
+  { 0xBCE5086492111AEBULL,  -130,  -20 },
+  { 0x8CBCCC096F5088CCULL,  -103,  -12 },
+  { 0xD1B71758E219652CULL,   -77,   -4 },
+  { 0x9C40000000000000ULL,   -50,    4 },
+  { 0xE8D4A51000000000ULL,   -24,   12 },
+  { 0xAD78EBC5AC620000ULL,     3,   20 },
+  { 0x813F3978F8940984ULL,    30,   28 },
+  { 0xC097CE7BC90715B3ULL,    56,   36 },
+  { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+  { 0xD5D238A4ABE98068ULL,   109,   52 },
+  { 0x9F4F2726179A2245ULL,   136,   60 },
+  { 0xED63A231D4C4FB27ULL,   162,   68 },
+  { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+  { 0x83C7088E1AAB65DBULL,   216,   84 },
+  { 0xC45D1DF942711D9AULL,   242,   92 },
+  { 0x924D692CA61BE758ULL,   269,  100 },
+  { 0xDA01EE641A708DEAULL,   295,  108 },
+  { 0xA26DA3999AEF774AULL,   322,  116 },
+  { 0xF209787BB47D6B85ULL,   348,  124 },
+  { 0xB454E4A179DD1877ULL,   375,  132 },
+  { 0x865B86925B9BC5C2ULL,   402,  140 },
+  { 0xC83553C5C8965D3DULL,   428,  148 },
+  { 0x952AB45CFA97A0B3ULL,   455,  156 },
+  { 0xDE469FBD99A05FE3ULL,   481,  164 },
+  { 0xA59BC234DB398C25ULL,   508,  172 },
+  { 0xF6C69A72A3989F5CULL,   534,  180 },
+  { 0xB7DCBF5354E9BECEULL,   561,  188 },
+  { 0x88FCF317F22241E2ULL,   588,  196 },
+  { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+  { 0x98165AF37B2153DFULL,   641,  212 },
+  { 0xE2A0B5DC971F303AULL,   667,  220 },
+  { 0xA8D9D1535CE3B396ULL,   694,  228 },
+  { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+  { 0xBB764C4CA7A44410ULL,   747,  244 },
+  { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+  { 0xD01FEF10A657842CULL,   800,  260 },
+  { 0x9B10A4E5E9913129ULL,   827,  268 },
+  { 0xE7109BFBA19C0C9DULL,   853,  276 },
+  { 0xAC2820D9623BF429ULL,   880,  284 },
+  { 0x80444B5E7AA7CF85ULL,   907,  292 },
+  { 0xBF21E44003ACDD2DULL,   933,  300 },
+  { 0x8E679C2F5E44FF8FULL,   960,  308 },
+  { 0xD433179D9C8CB841ULL,   986,  316 },
+  { 0x9E19DB92B4E31BA9ULL,  1013,  324 },
+};
+
+/* Returns the cached power of ten which scales a number with the
+   given binary exponent into the range 2^-60 ... 2^-32. */
+static const data_pow10 & data_cached_power (int e) {
+  int f = -60 - e - 1;
+  int k = (f * 78913) / (1 << 18) + (f > 0);
+  int i = (300 + k + 7) / 8;
+  return data_cached_pow10[i];
+}
+
+// Returns the number of decimal digits of n and the largest power below.
+static inline int data_largest_pow10 (uint32_t n, uint32_t & p) {
+  int k = 10;
+  for (p = 1000000000; k > 1 && n < p; k--) p /= 10;
+  return k;
+}
+
+// Moves the last digit towards the exact value while still in range.
+static inline void data_round (char * buf, int len, uint64_t dist,
+			       uint64_t delta, uint64_t rest, uint64_t ten) {
+  while (rest < dist && delta - rest >= ten &&
+	 (rest + ten < dist || dist - rest > rest + ten - dist)) {
+    buf[len - 1]--;
+    rest += ten;
+  }
+}
+
+/* Generates the digits of the given value and the decimal exponent
+   of the last digit.  Any digit string in the interval [lo, hi] reads
+   back to the given value. */
+static int data_grisu2 (char * buf, int & exp10, double val) {
+  uint64_t bits;
+  memcpy (&bits, &val, sizeof (bits));
+  uint64_t F = bits & ((UINT64_C (1) << 52) - 1);
+  int E = (int) (bits >> 52) & 0x7FF;
+
+  // value and its boundaries
+  data_fp v;
+  if (E == 0) {
+    v.f = F;
+    v.e = 1 - 1075;
+  } else {
+    v.f = F | (UINT64_C (1) << 52);
+    v.e = E - 1075;
+  }
+  data_fp hi = { 2 * v.f + 1, v.e - 1 };
+  data_fp lo;
+  if (F == 0 && E > 1) {
+    lo.f = 4 * v.f - 1;
+    lo.e = v.e - 2;
+  } else {
+    lo.f = 2 * v.f - 1;
+    lo.e = v.e - 1;
+  }
+  hi = data_fp_normalize (hi);
+  lo.f <<= lo.e - hi.e;
+  lo.e = hi.e;
+  v = data_fp_normalize (v);
+
+  // scale into the range suitable for digit generation
+  const data_pow10 & c = data_cached_power (hi.e);
+  data_fp cp = { c.f, c.e };
+  data_fp w = data_fp_mul (v, cp);
+  data_fp wlo = data_fp_mul (lo, cp);
+  data_fp whi = data_fp_mul (hi, cp);
+  wlo.f++;
+  whi.f--;
+  exp10 = -c.k;
+
+  // integral digits
+  uint64_t delta = data_fp_sub (whi, wlo).f;
+  uint64_t dist = data_fp_sub (whi, w).f;
+  int shift = -whi.e;
+  uint64_t one = UINT64_C (1) << shift;
+  uint32_t p1 = (uint32_t) (whi.f >> shift);
+  uint64_t p2 = whi.f & (one - 1);
+  uint32_t p10;
+  int len = 0;
+  int n = data_largest_pow10 (p1, p10);
+  while (n > 0) {
+    buf[len++] = (char) ('0' + p1 / p10);
+    p1 %= p10;
+    n--;
+    uint64_t rest = ((uint64_t) p1 << shift) + p2;
+    if (rest <= delta) {
+      exp10 += n;
+      data_round (buf, len, dist, delta, rest, (uint64_t) p10 << shift);
+      return len;
+    }
+    p10 /= 10;
+  }
+
+  // fractional digits
+  int m = 0;
+  for (;;) {
+    p2 *= 10;
+    buf[len++] = (char) ('0' + (p2 >> shift));
+    p2 &= one - 1;
+    m++;
+    delta *= 10;
+    dist *= 10;
+    if (p2 <= delta) break;
+  }
+  exp10 -= m;
+  data_round (buf, len, dist, delta, p2, one);
+  return len;
+}
+
+/* Formats the given value in exponential notation like printf()'s %e
+   but with the shortest digit string reading back to the same value.
+   Writes at most DATA_FORMAT_MAX characters including the trailing
+   zero and returns the number of characters written. */
+int data_format (char * buf, double val, int plus) {
+  char * p = buf;
+  if (std::signbit (val))
+    *p++ = '-';
+  else if (plus)
+    *p++ = '+';
+  if (std::isnan (val) || std::isinf (val)) {
+    strcpy (p, std::isnan (val) ? "nan" : "inf");
+    return p - buf + 3;
+  }
+
+  char digits[20];
+  int len = 1, exp10 = 0;
+  if (val == 0.0)
+    digits[0] = '0';
+  else
+    len = data_grisu2 (digits, exp10, std::fabs (val));
+  exp10 += len - 1;
+
+  // mantissa
+  *p++ = digits[0];
+  if (len > 1) {
+    *p++ = '.';
+    memcpy (p, digits + 1, len - 1);
+    p += len - 1;
+  }
+  // exponent with at least two digits
+  *p++ = 'e';
+  if (exp10 < 0) {
+    *p++ = '-';
+    exp10 = -exp10;
+  } else {
+    *p++ = '+';
+  }
+  if (exp10 >= 100) {
+    *p++ = (char) ('0' + exp10 / 100);
+    exp10 %= 100;
+  }
+  *p++ = (char) ('0' + exp10 / 10);
+  *p++ = (char) ('0' + exp10 % 10);
+  *p = '\0';
+  return p - buf;
+}
+
+// Formats a range of rows into the given buffer.
+static size_t data_format_rows (char * buf, int from, int to,
+				data_row_t func, void * ctx) {
+  char * p = buf;
+  for (int r = from; r < to; r++) p += func (p, r, ctx);
+  return p - buf;
+}
+
+/* Writes the given number of rows to the output stream.  Each row is
+   produced by the callback which must not write more than the given
+   number of characters.  The rows are formatted in blocks which are
+   distributed to the number of threads given by data_jobs, and
+   written in order. */
+void data_write_rows (FILE * out, int rows, int rowsize,
+		      data_row_t func, void * ctx) {
+  int jobs = data_jobs > 1 ? data_jobs : 1;
+  std::vector<char> buf ((size_t) jobs * DATA_BLOCK_ROWS * rowsize + 1);
+  std::vector<size_t> len (jobs);
+
+  for (int r = 0; r < rows; r += jobs * DATA_BLOCK_ROWS) {
+    int blocks = (rows - r + DATA_BLOCK_ROWS - 1) / DATA_BLOCK_ROWS;
+    if (blocks > jobs) blocks = jobs;
+    std::vector<std::thread> threads;
+    for (int j = blocks - 1; j >= 0; j--) {
+      int from = r + j * DATA_BLOCK_ROWS;
+      int to = from + DATA_BLOCK_ROWS < rows ? from + DATA_BLOCK_ROWS : rows;
+      char * b = &buf[(size_t) j * DATA_BLOCK_ROWS * rowsize];
+      if (j > 0) {
+	try {
+	  threads.push_back (std::thread ([=, &len] () {
+		len[j] = data_format_rows (b, from, to, func, ctx);
+	      }));
+	  continue;
+	}
+	catch (...) {
+	  // no more threads available, do it ourselves
+	}
+      }
+      len[j] = data_format_rows (b, from, to, func, ctx);
+    }
+    for (size_t t = 0; t < threads.size (); t++) threads[t].join ();
+    for (int j = 0; j < blocks; j++)
+      fwrite (&buf[(size_t) j * DATA_BLOCK_ROWS * rowsize], 1, len[j], out);
+  }
+}
@@ -0,0 +1,46 @@
+/*
+ * data_writer.h - fast textual data output definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __DATA_WRITER_H__
+#define __DATA_WRITER_H__
+
+#include <stdio.h>
+
+/* Maximum number of characters written by data_format(). */
+#define DATA_FORMAT_MAX 32
+
+/* Maximum number of threads formatting the output data. */
+#define DATA_MAX_JOBS 64
+
+/* Externalize variables. */
+extern int data_jobs;
+
+/* Callback formatting the given row into the buffer.  Returns the
+   number of characters written. */
+typedef int (* data_row_t) (char * buf, int row, void * ctx);
+
+/* Available functions of the data writer. */
+int data_format (char * buf, double val, int plus = 0);
+void data_write_rows (FILE * out, int rows, int rowsize,
+		      data_row_t func, void * ctx);
+
+#endif /* __DATA_WRITER_H__ */
@@ -38,6 +38,7 @@
 #include "constants.h"
 
 #include <cstdint>
+#include <vector>
 
 using namespace qucs;
 
@@ -95,38 +96,32 @@ static void matlab_header (int32_t rows, int32_t cols, const char * name) {
 
 // Writes a Matlab v4 vector.
 static void matlab_vector (::vector * v) {
-  int n;
+  int n, size = v->getSize ();
+  std::vector<nr_double_t> buf (size);
 
   // real part
-  for (n = 0; n < v->getSize (); n++) {
-    nr_double_t r = real (v->get (n));
-    fwrite (&r, sizeof (nr_double_t), 1, matlab_out);
-  }
+  for (n = 0; n < size; n++) buf[n] = real (v->get (n));
+  fwrite (buf.data (), sizeof (nr_double_t), size, matlab_out);
   // imaginary part
-  for (n = 0; n < v->getSize (); n++) {
-    nr_double_t i = imag (v->get (n));
-    fwrite (&i, sizeof (nr_double_t), 1, matlab_out);
-  }
+  for (n = 0; n < size; n++) buf[n] = imag (v->get (n));
+  fwrite (buf.data (), sizeof (nr_double_t), size, matlab_out);
 }
 
 // Writes a Matlab v4 matrix.
 static void matlab_matrix (matrix * m) {
-  int r, c;
+  int r, c, n;
+  std::vector<nr_double_t> buf (m->getRows () * m->getCols ());
 
   // real part
-  for (c = 0; c < m->getCols (); c++) {
-    for (r = 0; r < m->getRows (); r++) {
-      nr_double_t re = real (m->get (r, c));
-      fwrite (&re, sizeof (nr_double_t), 1, matlab_out);
-    }
+  for (n = 0, c = 0; c < m->getCols (); c++) {
+    for (r = 0; r < m->getRows (); r++) buf[n++] = real (m->get (r, c));
   }
+  fwrite (buf.data (), sizeof (nr_double_t), n, matlab_out);
   // imaginary part
-  for (c = 0; c < m->getCols (); c++) {
-    for (r = 0; r < m->getRows (); r++) {
-      nr_double_t im = imag (m->get (r, c));
-      fwrite (&im, sizeof (nr_double_t), 1, matlab_out);
-    }
+  for (n = 0, c = 0; c < m->getCols (); c++) {
+    for (r = 0; r < m->getRows (); r++) buf[n++] = imag (m->get (r, c));
   }
+  fwrite (buf.data (), sizeof (nr_double_t), n, matlab_out);
 }
 
 // Saves a dataset vector into a Matlab file.
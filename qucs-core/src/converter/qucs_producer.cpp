@@ -395,6 +395,7 @@ void qucsdata_producer_vcd (void) {
     for (dv = ds->values; dv; dv = dv->next) {
       fprintf (qucs_out, "  %s\n", dv->value);
     }
+    vcd_print_values (qucs_out, ds);
     if (ds->type == DATA_INDEPENDENT)
       fprintf (qucs_out, "</indep>\n");
     else if (ds->type == DATA_DEPENDENT)
@@ -27,6 +27,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <errno.h>
@@ -45,6 +46,7 @@
 #include "csv_producer.h"
 #include "touchstone_producer.h"
 #include "matlab_producer.h"
+#include "data_writer.h"
 #include "dataset.h"
 
 using namespace qucs;
@@ -142,6 +144,7 @@ int main (int argc, char ** argv) {
 	"  -g  GNDNODE     replace ground node\n"
 	"  -d  DATANAME    data variable specification\n"
 	"  -c, --correct   enable node correction\n"
+	"  -j  JOBS        number of threads formatting the output data (1-64)\n"
   "\nFORMAT: The input - output format pair should be one of the following:\n"
   "  inputformat - outputformat\n"
   "  spice       - qucs\n"
@@ -182,6 +185,16 @@ int main (int argc, char ** argv) {
     else if (!strcmp (argv[i], "-c") || !strcmp (argv[i], "--correct")) {
       vcd_correct = 1;
     }
+    else if (!strcmp (argv[i], "-j")) {
+      char * end = NULL;
+      long jobs = argv[++i] ? strtol (argv[i], &end, 10) : 0;
+      if (end == argv[i] || *end != '\0' || jobs < 1 || jobs > DATA_MAX_JOBS) {
+	fprintf (stderr, "invalid number of jobs `%s' (1 to %d)\n",
+		 argv[i] ? argv[i] : "not given", DATA_MAX_JOBS);
+	return -1;
+      }
+      data_jobs = jobs;
+    }
   }
 
   // check input/output formats
@@ -271,9 +284,19 @@ int vcd2qucs (struct actionset_t * action, char * infile, char * outfile) {
   return 0;
 }
 
-// Qucs dataset to CSV conversion.
-int qucs2csv (struct actionset_t * action, char * infile, char * outfile) {
+/* Loads the Qucs dataset into the global dataset used by the
+   producers.  Files are read by the fast dataset loader if possible,
+   the dataset parser is used otherwise. */
+static int qucsdata_load (char * infile) {
   int ret = 0;
+  if (infile && (qucs_data = dataset::load_fast (infile)) != NULL) {
+    if (dataset_check (qucs_data) != 0) {
+      delete qucs_data;
+      qucs_data = NULL;
+      return -1;
+    }
+    return 0;
+  }
   if ((dataset_in = open_file (infile, "r")) == NULL) {
     ret = -1;
   } else if (dataset_parse () != 0) {
@@ -290,7 +313,13 @@ int qucs2csv (struct actionset_t * action, char * infile, char * outfile) {
   dataset_lex_destroy ();
   if (dataset_in)
     fclose (dataset_in);
-  if (ret)
+  return ret;
+}
+
+// Qucs dataset to CSV conversion.
+int qucs2csv (struct actionset_t * action, char * infile, char * outfile) {
+  int ret = 0;
+  if (qucsdata_load (infile) != 0)
     return -1;
 
   if ((csv_out = open_file (outfile, "w")) == NULL)
@@ -311,23 +340,7 @@ int qucs2csv (struct actionset_t * action, char * infile, char * outfile) {
 // Qucs dataset to Touchstone conversion.
 int qucs2touch (struct actionset_t * action, char * infile, char * outfile) {
   int ret = 0;
-  if ((dataset_in = open_file (infile, "r")) == NULL) {
-    ret = -1;
-  } else if (dataset_parse () != 0) {
-    ret = -1;
-  } else if (dataset_result == NULL) {
-    ret = -1;
-  } else if (dataset_check (dataset_result) != 0) {
-    delete dataset_result;
-    dataset_result = NULL;
-    ret = -1;
-  }
-  qucs_data = dataset_result;
-  dataset_result = NULL;
-  dataset_lex_destroy ();
-  if (dataset_in)
-    fclose (dataset_in);
-  if (ret)
+  if (qucsdata_load (infile) != 0)
     return -1;
 
   if ((touchstone_out = open_file (outfile, "w")) == NULL)
@@ -343,23 +356,7 @@ int qucs2touch (struct actionset_t * action, char * infile, char * outfile) {
 // Qucs dataset to Matlab conversion.
 int qucs2mat (struct actionset_t * action, char * infile, char * outfile) {
   int ret = 0;
-  if ((dataset_in = open_file (infile, "r")) == NULL) {
-    ret = -1;
-  } else if (dataset_parse () != 0) {
-    ret = -1;
-  } else if (dataset_result == NULL) {
-    ret = -1;
-  } else if (dataset_check (dataset_result) != 0) {
-    delete dataset_result;
-    dataset_result = NULL;
-    ret = -1;
-  }
-  qucs_data = dataset_result;
-  dataset_result = NULL;
-  dataset_lex_destroy ();
-  if (dataset_in)
-    fclose (dataset_in);
-  if (ret)
+  if (qucsdata_load (infile) != 0)
     return -1;
 
   if ((matlab_out = open_file (outfile, "wb")) == NULL)
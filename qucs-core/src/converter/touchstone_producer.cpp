@@ -33,6 +33,7 @@
 #include <string.h>
 
 #include "touchstone_producer.h"
+#include "data_writer.h"
 #include "matrix.h"
 #include "matvec.h"
 #include "constants.h"
@@ -64,6 +65,36 @@ touchstone_data;
 #define touchstone_crlf "\r\n"
 #endif
 
+/* Appends the given string to the buffer. */
+static inline char * touchstone_puts (char * p, const char * str) {
+  while (*str) *p++ = *str++;
+  return p;
+}
+
+/* Appends a space separated data value to the buffer. */
+static inline char * touchstone_value (char * p, nr_double_t val) {
+  *p++ = ' ';
+  return p + data_format (p, (double) val, 1);
+}
+
+/* Indentation of continuation lines. */
+static const char * touchstone_indent = "      " "                    ";
+
+/* Formats a single line of noise data into the given buffer. */
+static int touchstone_print_noise_row (char * buf, int i, void *) {
+  char * p = buf;
+  nr_double_t f = real (touchstone_data.vf->get (i));
+  p += data_format (p, (double) f);
+  p = touchstone_value (p,
+    10.0 * std::log10 (real (touchstone_data.fmin->get (i))));
+  p = touchstone_value (p, abs (touchstone_data.sopt->get (i)));
+  p = touchstone_value (p, rad2deg (arg (touchstone_data.sopt->get (i))));
+  p = touchstone_value (p, real (touchstone_data.rn->get (i)) /
+			touchstone_data.resistance);
+  p = touchstone_puts (p, touchstone_crlf);
+  return p - buf;
+}
+
 /* The Touchstone noise data printer. */
 void touchstone_print_noise (void) {
   if (touchstone_data.vf != NULL && touchstone_data.sopt != NULL &&
@@ -71,20 +102,48 @@ void touchstone_print_noise (void) {
     // blank line separator
     fprintf (touchstone_out, touchstone_crlf);
     // noise data
-    for (int i = 0; i < touchstone_data.vf->getSize (); i++) {
-      nr_double_t f = real (touchstone_data.vf->get (i));
-      fprintf (touchstone_out, "%." "20" "e"
-	       " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e"
-	       touchstone_crlf, f,
-	       10.0 * std::log10 (real (touchstone_data.fmin->get (i))),
-	       abs (touchstone_data.sopt->get (i)),
-	       rad2deg (arg (touchstone_data.sopt->get (i))),
-	       real (touchstone_data.rn->get (i)) /
-	       touchstone_data.resistance);
+    data_write_rows (touchstone_out, touchstone_data.vf->getSize (),
+		     5 * (DATA_FORMAT_MAX + 1) + 2,
+		     touchstone_print_noise_row, NULL);
+  }
+}
+
+/* Formats the data of a single frequency into the given buffer. */
+static int touchstone_print_row (char * buf, int i, void *) {
+  char * p = buf;
+  matrix S = touchstone_data.mv->get (i);
+  nr_double_t f = real (touchstone_data.vd->get (i));
+  p += data_format (p, (double) f);
+  // two-port file
+  if (touchstone_data.ports == 2) {
+    p = touchstone_value (p, real (S(0,0)));
+    p = touchstone_value (p, imag (S(0,0)));
+    p = touchstone_value (p, real (S(1,0)));
+    p = touchstone_value (p, imag (S(1,0)));
+    p = touchstone_value (p, real (S(0,1)));
+    p = touchstone_value (p, imag (S(0,1)));
+    p = touchstone_value (p, real (S(1,1)));
+    p = touchstone_value (p, imag (S(1,1)));
+    p = touchstone_puts (p, touchstone_crlf);
+  }
+  // one-port, three-port and above files, four entries per line
+  else {
+    int cs = S.getCols ();
+    int rs = S.getRows ();
+    for (int r = 0; r < rs; r++) {
+      if (r >= 1)
+	p = touchstone_puts (p, touchstone_indent);
+      for (int c = 0; c < cs; c++) {
+	if (c > 1 && (c & 3) == 0)
+	  p = touchstone_puts (p, touchstone_indent);
+	p = touchstone_value (p, real (S(r,c)));
+	p = touchstone_value (p, imag (S(r,c)));
+	if ((c > 1 && (c & 3) == 3) || (c == cs - 1))
+	  p = touchstone_puts (p, touchstone_crlf);
+      }
     }
   }
+  return p - buf;
 }
 
 /* The Touchstone data printer. */
@@ -93,85 +152,12 @@ void touchstone_print (void) {
   fprintf (touchstone_out, "# %s %c %s R %g" touchstone_crlf,
 	   "HZ", touchstone_data.parameter, touchstone_data.format,
 	   touchstone_data.resistance);
-  // one-port file
-  if (touchstone_data.ports == 1) {
-    for (int i = 0; i < touchstone_data.vd->getSize (); i++) {
-      matrix S = touchstone_data.mv->get (i);
-      nr_double_t f = real (touchstone_data.vd->get (i));
-      fprintf (touchstone_out, "%." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       touchstone_crlf, f, real (S(0,0)), imag (S(0,0)));
-    }
-  }
-  // two-port file
-  else if (touchstone_data.ports == 2) {
-    for (int i = 0; i < touchstone_data.vd->getSize (); i++) {
-      matrix S = touchstone_data.mv->get (i);
-      nr_double_t f = real (touchstone_data.vd->get (i));
-      fprintf (touchstone_out, "%." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       touchstone_crlf, f,
-	       real (S(0,0)), imag (S(0,0)),
-	       real (S(1,0)), imag (S(1,0)),
-	       real (S(0,1)), imag (S(0,1)),
-	       real (S(1,1)), imag (S(1,1)));
-    }
-  }
-  // three-port file
-  else if (touchstone_data.ports == 3) {
-    for (int i = 0; i < touchstone_data.vd->getSize (); i++) {
-      matrix S = touchstone_data.mv->get (i);
-      nr_double_t f = real (touchstone_data.vd->get (i));
-      fprintf (touchstone_out, "%." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       touchstone_crlf "      %"  "20" "s"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       touchstone_crlf "      %"  "20" "s"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       " %+." "20" "e" " %+." "20" "e"
-	       touchstone_crlf,
-	       f,
-	       real (S(0,0)), imag (S(0,0)),
-	       real (S(0,1)), imag (S(0,1)),
-	       real (S(0,2)), imag (S(0,2)), " ",
-	       real (S(1,0)), imag (S(1,0)),
-	       real (S(1,1)), imag (S(1,1)),
-	       real (S(1,2)), imag (S(1,2)), " ",
-	       real (S(2,0)), imag (S(2,0)),
-	       real (S(2,1)), imag (S(2,1)),
-	       real (S(2,2)), imag (S(2,2)));
-    }
-  }
-  // four-port and above files
-  else if (touchstone_data.ports >= 4) {
-    for (int i = 0; i < touchstone_data.vd->getSize (); i++) {
-      matrix S = touchstone_data.mv->get (i);
-      nr_double_t f = real (touchstone_data.vd->get (i));
-      int cs = S.getCols ();
-      int rs = S.getRows ();
-      fprintf (touchstone_out, "%." "20" "e", f);
-      for (int r = 0; r < rs; r++) {
-	if (r >= 1)
-	  fprintf (touchstone_out, "      %"  "20" "s", " ");
-	for (int c = 0; c < cs; c++) {
-	  if (c > 1 && (c & 3) == 0)
-	    fprintf (touchstone_out, "      %"  "20" "s", " ");
-	  fprintf (touchstone_out, " %+." "20" "e" " %+." "20" "e",
-		   real (S(r,c)), imag (S(r,c)));
-	  if ((c > 1 && (c & 3) == 3) || (c == cs - 1))
-	    fprintf (touchstone_out, touchstone_crlf);
-	}
-      }
-    }
-  }
+  // frequency points
+  int n = touchstone_data.ports;
+  int rowsize = DATA_FORMAT_MAX + n * n * 2 * (DATA_FORMAT_MAX + 1) +
+    (n * (n + 3) / 4 + 1) * (strlen (touchstone_indent) + 2);
+  data_write_rows (touchstone_out, touchstone_data.vd->getSize (), rowsize,
+		   touchstone_print_row, NULL);
 }
 
 /* The function finds an appropriate S-parameters or other parameter
@@ -0,0 +1,250 @@
+/*
+ * datacache.cpp - data file registry class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "object.h"
+#include "vector.h"
+#include "dataset.h"
+#include "poly.h"
+#include "spline.h"
+#include "interpolator.h"
+#include "datacache.h"
+
+namespace qucs {
+
+// Registry entry of a loaded data file.
+struct datacache_entry {
+  time_t mtime;
+  dataset * data;
+};
+
+// Key of a prepared interpolator.
+typedef std::tuple<qucs::vector *, qucs::vector *, bool, int, int, int>
+  interpolator_key;
+
+// Loaded data files indexed by loader and canonical path name.
+static std::map<std::pair<dataset_loader_t, std::string>,
+		datacache_entry> files;
+// Datasets not registered anymore (replaced by a reload or loaded
+// without a file), still referenced by components.
+static std::set<dataset *> stale;
+// Number of components referring to each dataset.
+static std::map<dataset *, int> refs;
+// Prepared interpolators indexed by vectors and interpolation type.
+static std::map<interpolator_key, interpolator *> interpolators;
+// Tables of the users of each dataset indexed by their names.
+static std::map<dataset *, std::map<std::string, datacache_table *> > tables;
+
+/* Returns the canonical path name of the given file.  If it cannot
+   be resolved the name is returned as is. */
+static std::string canonicalPath (const char * file) {
+#ifdef __MINGW32__
+  char path[_MAX_PATH];
+  if (_fullpath (path, file, _MAX_PATH) != NULL)
+    return std::string (path);
+#else
+  char * path = realpath (file, NULL);
+  if (path != NULL) {
+    std::string res (path);
+    free (path);
+    return res;
+  }
+#endif
+  return std::string (file);
+}
+
+/* This function returns the dataset read from the given file using
+   the given loader.  The file is parsed on the first request only,
+   subsequent requests for the same (unmodified) file return the
+   shared dataset.  On failure NULL is returned and the loader emits
+   appropriate error messages.  Each successful call must be matched
+   by a call to release(). */
+dataset * datacache::load (const char * file, dataset_loader_t loader) {
+  struct stat st;
+  if (stat (file, &st) != 0) {
+    // let the loader report the error, it is not cached in any case
+    dataset * data = loader (file);
+    if (data != NULL) {
+      stale.insert (data);
+      refs[data] = 1;
+    }
+    return data;
+  }
+
+  std::pair<dataset_loader_t, std::string> key (loader, canonicalPath (file));
+  std::map<std::pair<dataset_loader_t, std::string>, datacache_entry>::iterator
+    it = files.find (key);
+  if (it != files.end ()) {
+    if (it->second.mtime == st.st_mtime) {
+      refs[it->second.data]++;
+      return it->second.data;
+    }
+    // file has been modified, keep old dataset alive while in use
+    dataset * old = it->second.data;
+    files.erase (it);
+    if (refs[old] > 0)
+      stale.insert (old);
+    else
+      drop (old);
+  }
+
+  dataset * data = loader (file);
+  if (data != NULL) {
+    datacache_entry entry;
+    entry.mtime = st.st_mtime;
+    entry.data = data;
+    files[key] = entry;
+    refs[data] = 1;
+  }
+  return data;
+}
+
+/* The function tells the registry that a component does not use the
+   given dataset (as returned by load()) anymore.  Datasets not being
+   registered anymore are deleted together with their interpolators
+   once they are unused. */
+void datacache::release (dataset * data) {
+  std::map<dataset *, int>::iterator it = refs.find (data);
+  if (it == refs.end ()) return;
+  if (--it->second > 0) return;
+  if (stale.erase (data) > 0) drop (data);
+}
+
+/* Deletes the given dataset, the interpolators prepared on its vectors
+   and the tables attached to it. */
+void datacache::drop (dataset * data) {
+  std::set<qucs::vector *> vecs;
+  qucs::vector * v;
+  for (v = data->getDependencies (); v; v = (qucs::vector *) v->getNext ())
+    vecs.insert (v);
+  for (v = data->getVariables (); v; v = (qucs::vector *) v->getNext ())
+    vecs.insert (v);
+  std::map<interpolator_key, interpolator *>::iterator it;
+  for (it = interpolators.begin (); it != interpolators.end ();) {
+    if (vecs.count (std::get<0> (it->first))) {
+      delete it->second;
+      interpolators.erase (it++);
+    }
+    else ++it;
+  }
+  std::map<dataset *, std::map<std::string, datacache_table *> >::iterator
+    dt = tables.find (data);
+  if (dt != tables.end ()) {
+    std::map<std::string, datacache_table *>::iterator tt;
+    for (tt = dt->second.begin (); tt != dt->second.end (); ++tt)
+      delete tt->second;
+    tables.erase (dt);
+  }
+  refs.erase (data);
+  delete data;
+}
+
+/* The function returns an interpolator prepared for the given data
+   vectors, data kind (real or complex), interpolation, repetition
+   and domain type.  Interpolators are shared as well, thus their
+   tables are set up once per dataset. */
+interpolator * datacache::getInterpolator (qucs::vector * y, qucs::vector * x,
+					   bool isreal, int interpol,
+					   int repeat, int domain) {
+  interpolator_key key (y, x, isreal, interpol, repeat, domain);
+  std::map<interpolator_key, interpolator *>::iterator it =
+    interpolators.find (key);
+  if (it != interpolators.end ())
+    return it->second;
+
+  interpolator * inter = new interpolator ();
+  if (isreal) {
+    inter->rvectors (y, x);
+    inter->prepare (interpol, repeat, domain | DATA_REAL);
+  }
+  else {
+    inter->cvectors (y, x);
+    inter->prepare (interpol, repeat, domain | DATA_COMPLEX);
+  }
+  interpolators[key] = inter;
+  return inter;
+}
+
+/* The function returns the table of the given name attached to the
+   given dataset (as returned by load()) or NULL if there is none yet.
+   The table lives as long as the dataset, thus it is dropped when the
+   file is reloaded. */
+datacache_table * datacache::getTable (dataset * data,
+				       const std::string & name) {
+  std::map<dataset *, std::map<std::string, datacache_table *> >::iterator
+    dt = tables.find (data);
+  if (dt == tables.end ()) return NULL;
+  std::map<std::string, datacache_table *>::iterator tt =
+    dt->second.find (name);
+  return tt != dt->second.end () ? tt->second : NULL;
+}
+
+/* Attaches the given table under the given name to the dataset.  The
+   cache takes ownership of the table. */
+void datacache::setTable (dataset * data, const std::string & name,
+			  datacache_table * table) {
+  datacache_table * & t = tables[data][name];
+  if (t != table) delete t;
+  t = table;
+}
+
+/* Deletes all datasets, interpolators and tables held by the registry.
+   Any component still referring to them must not be used anymore. */
+void datacache::clear (void) {
+  std::map<interpolator_key, interpolator *>::iterator it;
+  for (it = interpolators.begin (); it != interpolators.end (); ++it)
+    delete it->second;
+  interpolators.clear ();
+  std::map<dataset *, std::map<std::string, datacache_table *> >::iterator
+    dt;
+  for (dt = tables.begin (); dt != tables.end (); ++dt) {
+    std::map<std::string, datacache_table *>::iterator tt;
+    for (tt = dt->second.begin (); tt != dt->second.end (); ++tt)
+      delete tt->second;
+  }
+  tables.clear ();
+  std::map<std::pair<dataset_loader_t, std::string>, datacache_entry>::iterator
+    ft;
+  for (ft = files.begin (); ft != files.end (); ++ft)
+    delete ft->second.data;
+  files.clear ();
+  std::set<dataset *>::iterator st;
+  for (st = stale.begin (); st != stale.end (); ++st)
+    delete *st;
+  stale.clear ();
+  refs.clear ();
+}
+
+} // namespace qucs
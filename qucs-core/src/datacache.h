@@ -0,0 +1,72 @@
+/*
+ * datacache.h - data file registry class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __DATACACHE_H__
+#define __DATACACHE_H__
+
+#include <string>
+
+namespace qucs {
+
+class vector;
+class dataset;
+class interpolator;
+
+// Type of the dataset::load() family of functions.
+typedef dataset * (* dataset_loader_t) (const char *);
+
+/* Base class of data derived from a cached dataset by its users, e.g.
+   tabulated values.  Tables are owned by the cache and deleted together
+   with their dataset. */
+class datacache_table
+{
+ public:
+  virtual ~datacache_table () { }
+};
+
+/* The data cache is a process wide registry of datasets read from
+   files.  Each file is parsed once per loader and the resulting
+   dataset (as well as interpolators prepared on its vectors) is
+   shared by all components referring to it.  Entries are keyed by the
+   canonical path name and reloaded if the modification time of the
+   file changes.  Returned objects are owned by the cache and must be
+   treated read-only by the caller, who releases the dataset when done
+   with it.  Tables attached to a dataset (see getTable()) may be
+   modified, they are shared by all users of the dataset. */
+class datacache
+{
+ public:
+  static dataset * load (const char *, dataset_loader_t);
+  static void release (dataset *);
+  static interpolator * getInterpolator (qucs::vector *, qucs::vector *,
+					 bool, int, int, int);
+  static datacache_table * getTable (dataset *, const std::string &);
+  static void setTable (dataset *, const std::string &, datacache_table *);
+  static void clear (void);
+
+ private:
+  static void drop (dataset *);
+};
+
+} // namespace qucs
+
+#endif /* __DATACACHE_H__ */
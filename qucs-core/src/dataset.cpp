@@ -341,6 +341,15 @@ void dataset::print (void) {
     }
   }
 
+  print (f);
+
+  // close file if necessary
+  if (file) fclose (f);
+}
+
+// Prints the dataset representation into the given stream.
+void dataset::print (FILE * f) {
+
   // print header
   fprintf (f, "<Qucs Dataset " PACKAGE_VERSION ">\n");
 
@@ -356,9 +365,36 @@ void dataset::print (void) {
     else
       printDependency (v, f);
   }
+}
 
-  // close file if necessary
-  if (file) fclose (f);
+/* The function returns true if the given dependent vector holds a
+   value for each combination of its dependencies' values.  While an
+   analysis is running this is not the case for the vectors being
+   filled. */
+bool dataset::isComplete (vector * v) {
+  int size = 1;
+  for (strlistiterator it (v->getDependencies ()); *it; ++it) {
+    vector * d = findDependency (*it);
+    if (d == NULL) return false;
+    size *= d->getSize ();
+  }
+  return size == v->getSize ();
+}
+
+/* Prints the dataset like print() does, but omits the dependent
+   vectors which are not complete yet.  This way the results of a
+   running analysis can be read by the usual dataset loaders. */
+void dataset::printComplete (FILE * f) {
+  fprintf (f, "<Qucs Dataset " PACKAGE_VERSION ">\n");
+  for (vector * d = dependencies; d != NULL; d = (vector *) d->getNext ()) {
+    printDependency (d, f);
+  }
+  for (vector * v = variables; v != NULL; v = (vector *) v->getNext ()) {
+    if (v->getDependencies () == NULL)
+      printDependency (v, f);
+    else if (isComplete (v))
+      printVariable (v, f);
+  }
 }
 
 /* Prints the given vector as independent dataset vector into the
@@ -406,13 +442,14 @@ void dataset::printData (vector * v, FILE * f) {
   }
 }
 
-/* This static function read a full dataset from the given file and
-   returns it.  On failure the function emits appropriate error
-   messages and returns NULL. */
-dataset * dataset::load (const char * file) {
+/* This static function reads a dataset from the given file using the
+   grammar based parser.  On failure the function emits appropriate
+   error messages and returns NULL. */
+dataset * dataset::load_grammar (const char * file) {
   FILE * f;
   if ((f = fopen (file, "r")) == NULL) {
-    logprint (LOG_ERROR, "error loading `%s': %s\n", file, strerror (errno));
+    logprint (LOG_ERROR, "error loading `%s': %s\n", file,
+	      strerror (errno));
     return NULL;
   }
   dataset_in = f;
@@ -421,19 +458,31 @@ dataset * dataset::load (const char * file) {
     fclose (f);
     return NULL;
   }
-  if (dataset_result != NULL) {
-    if (dataset_check (dataset_result) != 0) {
-      fclose (f);
-      delete dataset_result;
-      return NULL;
-    }
-  }
   fclose (f);
   dataset_lex_destroy ();
-  dataset_result->setFile (file);
   return dataset_result;
 }
 
+/* This static function read a full dataset from the given file and
+   returns it.  Datasets are loaded by the fast loader if possible,
+   otherwise by the grammar based parser.  On failure the function
+   emits appropriate error messages and returns NULL. */
+dataset * dataset::load (const char * file) {
+  dataset * data;
+  if ((data = load_fast (file)) == NULL) {
+    if ((data = load_grammar (file)) == NULL)
+      return NULL;
+  }
+  if (data != NULL) {
+    if (dataset_check (data) != 0) {
+      delete data;
+      return NULL;
+    }
+  }
+  data->setFile (file);
+  return data;
+}
+
 /* This static function read a full dataset from the given touchstone
    file and returns it.  On failure the function emits appropriate
    error messages and returns NULL. */
@@ -54,6 +54,9 @@ class dataset : public object
   char * getFile (void);
   void setFile (const char *);
   void print (void);
+  void print (FILE *);
+  void printComplete (FILE *);
+  bool isComplete (qucs::vector *);
   void printData (qucs::vector *, FILE *);
   void printDependency (qucs::vector *, FILE *);
   void printVariable (qucs::vector *, FILE *);
@@ -65,6 +68,8 @@ class dataset : public object
   int isVariable (qucs::vector *);
   qucs::vector * findOrigin (char *);
   static dataset * load (const char *);
+  static dataset * load_fast (const char *);
+  static dataset * load_grammar (const char *);
   static dataset * load_touchstone (const char *);
   static dataset * load_csv (const char *);
   static dataset * load_citi (const char *);
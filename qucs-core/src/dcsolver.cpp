@@ -27,7 +27,17 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
 
+#if HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include "logging.h"
 #include "object.h"
 #include "complex.h"
 #include "circuit.h"
@@ -37,11 +47,18 @@
 #include "nasolver.h"
 #include "dcsolver.h"
 
+// Maximum number of failed sweep step subdivisions.
+#define DC_SWEEP_CUTS 8
+
 namespace qucs {
 
+const char * dcsolver::cacheDir = NULL;
+
 // Constructor creates an unnamed instance of the dcsolver class.
 dcsolver::dcsolver () : nasolver<nr_double_t> () {
   saveOPs = 0;
+  cached = 0;
+  modified = 0;
   type = ANALYSIS_DC;
   setDescription ("DC");
 }
@@ -49,6 +66,8 @@ dcsolver::dcsolver () : nasolver<nr_double_t> () {
 // Constructor creates a named instance of the dcsolver class.
 dcsolver::dcsolver (char * n) : nasolver<nr_double_t> (n) {
   saveOPs = 0;
+  cached = 0;
+  modified = 0;
   type = ANALYSIS_DC;
   setDescription ("DC");
 }
@@ -61,6 +80,8 @@ dcsolver::~dcsolver () {
    based on the given dcsolver object. */
 dcsolver::dcsolver (dcsolver & o) : nasolver<nr_double_t> (o) {
   saveOPs = o.saveOPs;
+  cached = 0;
+  modified = 0;
 }
 
 /* This is the DC netlist solver.  It prepares the circuit list and
@@ -69,6 +90,22 @@ int dcsolver::solve (void) {
   // fetch simulation properties
   saveOPs |= !strcmp (getPropertyString ("saveOPs"), "yes") ? SAVE_OPS : 0;
   saveOPs |= !strcmp (getPropertyString ("saveAll"), "yes") ? SAVE_ALL : 0;
+
+  // find the operating point
+  solveOperatingPoint ();
+
+  // save results and cleanup the solver
+  saveOperatingPoints ();
+  saveResults ("V", "I", saveOPs);
+
+  solve_post ();
+  return 0;
+}
+
+/* Finds the operating point of the netlist.  The function leaves the
+   node list and the solution vector of the solver in place and
+   returns zero on success. */
+int dcsolver::solveOperatingPoint (void) {
   const char * const solver = getPropertyString ("Solver");
 
   // initialize node voltages, first guess for non-linear circuits and
@@ -117,15 +154,30 @@ int dcsolver::solve (void) {
   }
   preferred = convHelper;
 
+  // seed the non-linear solver by the solution of the previous sweep
+  // point or by a cached operating point
+  int warm = 0, converged = 0;
+  if (subnet->isNonLinear ()) {
+    if (sweepSeed ())
+      converged = !solveSeeded () || !refineSweep ();
+    else
+      warm = loadCache ();
+  }
+
   if (!subnet->isNonLinear ()) {
     // Start the linear solver.
     convHelper = CONV_None;
     error = solve_linear ();
   }
-  else do {
+  else if (!converged) do {
     // Run the DC solver once.
     try_running () {
       applyNodeset ();
+      if (warm) {
+	recallSolution ();
+	if (xprev != NULL) *xprev = *x;
+	saveSolution ();
+      }
       error = solve_nonlinear ();
 #if DEBUG
       if (!error) {
@@ -135,11 +187,22 @@ int dcsolver::solve (void) {
       }
 #endif /* DEBUG */
       if (!error) retry = -1;
+      if (!error) converged = 1;
     }
     // Appropriate exception handling.
     catch_exception () {
     case EXCEPTION_NO_CONVERGENCE:
       pop_exception ();
+      if (warm) {
+	// the cached operating point did not help, start from scratch
+	logprint (LOG_ERROR, "WARNING: %s: cached operating point failed, "
+		  "restarting %s analysis\n", getName (),
+		  getDescription ().c_str());
+	warm = 0;
+	retry++;
+	restart ();
+	break;
+      }
       if (preferred == helpers[fallback] && preferred) fallback++;
       convHelper = helpers[fallback++];
       if (convHelper != -1) {
@@ -161,12 +224,16 @@ int dcsolver::solve (void) {
     }
   } while (retry != -1);
 
-  // save results and cleanup the solver
-  saveOperatingPoints ();
-  saveResults ("V", "I", saveOPs);
-
-  solve_post ();
-  return 0;
+  // remember the converged operating point, the cache is written by
+  // cleanup() once the analysis is done
+  if (converged) {
+    storeSweepPoint ();
+    if (cacheDir != NULL) {
+      storeSolution ();
+      cached = modified = 1;
+    }
+  }
+  return subnet->isNonLinear () ? !converged : error;
 }
 
 /* Goes through the list of circuit objects and runs its calcDC()
@@ -205,6 +272,183 @@ void dcsolver::saveOperatingPoints (void) {
   }
 }
 
+/* Drops the solutions kept for seeding, the operating point cache is
+   read again on the next solve. */
+void dcsolver::resetSeeds (void) {
+  nasolver<nr_double_t>::resetSeeds ();
+  cached = 0;
+}
+
+/* Runs the non-linear solver once starting at the stored solution.
+   The function returns zero on convergence. */
+int dcsolver::solveSeeded (void) {
+  int error = 0;
+  try_running () {
+    applyNodeset ();
+    recallSolution ();
+    if (xprev != NULL) *xprev = *x;
+    saveSolution ();
+    error = solve_nonlinear ();
+  }
+  catch_exception () {
+  case EXCEPTION_NO_CONVERGENCE:
+    pop_exception ();
+    restart ();
+    error = -1;
+    break;
+  default:
+    estack.print ();
+    error++;
+    break;
+  }
+  return error;
+}
+
+/* If the solver does not converge at a sweep point starting at the
+   (extrapolated) previous solution, the sweep step is subdivided.  The
+   netlist is solved at intermediate values of the swept parameter, each
+   one seeded by its predecessors, and the step is widened again after
+   each success.  The function returns zero if the actual sweep point
+   has been reached.  Otherwise the netlist is prepared for the actual
+   sweep point again. */
+int dcsolver::refineSweep (void) {
+  nr_double_t target = sweepValue, start = sweepValues[0];
+  nr_double_t step = (target - start) / 2;
+  int cuts = 1;
+
+  while (start != target && cuts <= DC_SWEEP_CUTS) {
+    nr_double_t v = target;
+    if (std::fabs (target - start) > std::fabs (step)) v = start + step;
+#if DEBUG
+    logprint (LOG_STATUS, "NOTIFY: %s: refining sweep step, solving "
+	      "at %g\n", getName (), (double) v);
+#endif
+    sweepParent->setSweepValue (v);
+    sweepValue = v;
+    solve_post ();
+    init ();
+    solve_pre ();
+    sweepSeed ();
+    if (!solveSeeded ()) {
+      if (v != target) storeSweepPoint ();
+      start = v;
+      step *= 2;
+    }
+    else {
+      step /= 2;
+      cuts++;
+    }
+  }
+  if (start == target) return 0;
+
+  // give up and go back to the actual sweep point
+  logprint (LOG_ERROR, "WARNING: %s: sweep step refinement failed at %g\n",
+	    getName (), (double) target);
+  sweepParent->setSweepValue (target);
+  sweepValue = target;
+  solve_post ();
+  init ();
+  solve_pre ();
+  return -1;
+}
+
+/* The function returns the name of the cache file for the current
+   netlist.  The file name is a hash of the analysis name and the
+   netlist topology, i.e. the names and types of the circuits and their
+   node connections.  Parameter values do not contribute, thus slightly
+   modified netlists share their operating point. */
+std::string dcsolver::cacheFile (void) {
+  std::vector<std::string> lines;
+  circuit * root = subnet->getRoot ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    std::string line = std::to_string (c->getType ()) + " " + c->getName ();
+    for (int i = 0; i < c->getSize (); i++)
+      line += std::string (" ") + c->getNode(i)->getName ();
+    lines.push_back (line);
+  }
+  std::sort (lines.begin (), lines.end ());
+  lines.insert (lines.begin (), getName ());
+
+  // 64-bit FNV-1a hash
+  unsigned long long hash = 14695981039346656037ULL;
+  for (auto & line : lines) {
+    for (unsigned char ch : line + "\n") {
+      hash ^= ch;
+      hash *= 1099511628211ULL;
+    }
+  }
+  char name[32];
+  sprintf (name, "%016llx.dcop", hash);
+  return std::string (cacheDir) + "/" + name;
+}
+
+/* Reads a previously stored operating point of the netlist from the
+   cache.  Returns non-zero if an operating point is available.  Once
+   the netlist has been solved, the latest solution is used instead. */
+int dcsolver::loadCache (void) {
+  if (cacheDir == NULL) return 0;
+  if (cached) return !solution.empty ();
+  cached = 1;
+  solution.clear ();
+
+  FILE * f = fopen (cacheFile ().c_str (), "r");
+  if (f == NULL) return 0;
+  char name[256];
+  int current;
+  double value;
+  while (fscanf (f, "%255s %d %lf", name, &current, &value) == 3) {
+    nr_double_t v = value;
+    naentry<nr_double_t> entry (v, current);
+    solution.insert ({{ name, entry }});
+  }
+  fclose (f);
+  logprint (LOG_STATUS, "NOTIFY: %s: using cached operating point of %d "
+	    "values\n", getName (), (int) solution.size ());
+  return !solution.empty ();
+}
+
+/* Saves the latest converged operating point (node voltages and branch
+   currents) into the cache.  The file is written aside and renamed, so
+   other simulations reading the cache never see a partial one. */
+void dcsolver::storeCache (void) {
+  if (cacheDir == NULL || !modified) return;
+  modified = 0;
+
+  std::string file = cacheFile ();
+  std::string part = file;
+#if HAVE_UNISTD_H
+  part += "." + std::to_string ((long) getpid ());
+#endif
+  part += ".part";
+  FILE * f = fopen (part.c_str (), "w");
+  if (f == NULL) {
+    logprint (LOG_ERROR, "WARNING: %s: cannot write operating point cache "
+	      "`%s'\n", getName (), file.c_str ());
+    return;
+  }
+  for (auto & it : solution) {
+    fprintf (f, "%s %d %.17g\n", it.first.c_str (), it.second.current,
+	     (double) it.second.value);
+  }
+  int error = fclose (f);
+#ifdef __MINGW32__
+  if (!error) remove (file.c_str ());
+#endif
+  if (error || rename (part.c_str (), file.c_str ()) != 0) {
+    logprint (LOG_ERROR, "WARNING: %s: cannot write operating point cache "
+	      "`%s'\n", getName (), file.c_str ());
+    remove (part.c_str ());
+  }
+}
+
+/* Writes the operating point cache once the analysis (including all
+   sweep points) is done.  Worker processes of parallel sweeps never
+   get here, only the main process writes the cache. */
+int dcsolver::cleanup (void) {
+  storeCache ();
+  return 0;
+}
+
 // properties
 PROP_REQ [] = {
   PROP_NO_PROP };
@@ -220,6 +464,8 @@ PROP_OPT [] = {
     PROP_RNG_STR6 ("none", "SourceStepping", "gMinStepping",
 		   "LineSearch", "Attenuation", "SteepestDescent") },
   { "Solver", PROP_STR, { PROP_NO_VAL, "CroutLU" }, PROP_RNG_SOL },
+  { "sweepSeed", PROP_STR, { PROP_NO_VAL, "constant" },
+    PROP_RNG_STR4 ("none", "constant", "linear", "quadratic") },
   PROP_NO_PROP };
 struct define_t dcsolver::anadef =
   { "DC", 0, PROP_ACTION, PROP_NO_SUBSTRATE, PROP_LINEAR, PROP_DEF };
@@ -37,13 +37,30 @@ class dcsolver : public nasolver<nr_double_t>
   dcsolver (dcsolver &);
   ~dcsolver ();
   int  solve (void);
+  int  cleanup (void);
   static void calc (dcsolver *);
   void init (void);
   void restart (void);
   void saveOperatingPoints (void);
+  void resetSeeds (void);
+
+  // Directory of the operating point cache (or NULL if disabled).
+  static const char * cacheDir;
+
+ protected:
+  int  solveOperatingPoint (void);
+
+ private:
+  int  solveSeeded (void);
+  int  refineSweep (void);
+  std::string cacheFile (void);
+  int  loadCache (void);
+  void storeCache (void);
 
  private:
   int saveOPs;
+  int cached;
+  int modified;
 };
 
 } // namespace qucs
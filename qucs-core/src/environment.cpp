@@ -188,11 +188,13 @@ int environment::equationChecker (const int noundefined) const {
   return checkee->check (noundefined);
 }
 
-// The function runs the equation solver for this environment.
-int environment::equationSolver (dataset * const data) {
+// The function runs the equation solver for this environment, for
+// the given results only if a list is passed.
+int environment::equationSolver (dataset * const data,
+				 strlist * const only) {
   checkee->setDefinitions (defs);
   solvee->setEquations (checkee->getEquations ());
-  int err = solvee->solve (data);
+  int err = solvee->solve (data, only);
   checkee->setEquations (solvee->getEquations ());
   return err;
 }
@@ -207,6 +209,14 @@ void environment::equationSolver (void) {
   checkee->setEquations (solvee->getEquations ());
 }
 
+/* The function removes the equations created for the dataset passed
+   to the equation solver previously.  This is required before the
+   dataset gets deleted. */
+void environment::dropDataset (void) {
+  solvee->dropDataset ();
+  checkee->setEquations (solvee->getEquations ());
+}
+
 
 /* The function solves the equations of the current environment object
    as well as these of its children, updates the variables and passes
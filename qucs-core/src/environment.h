@@ -76,9 +76,10 @@ class environment
   void setSolver (eqn::solver * s) { solvee = s; }
   eqn::solver * getSolver (void) { return solvee; }
   int equationChecker (const int noundefined = 1) const;
-  int equationSolver (dataset * const);
+  int equationSolver (dataset * const, strlist * const only = NULL);
   int runSolver (void);
   void equationSolver (void);
+  void dropDataset (void);
 
   // subcircuit specific
   qucs::vector getVector (const char * const) const ;
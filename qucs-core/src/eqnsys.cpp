@@ -157,6 +157,9 @@ void eqnsys<nr_type_t>::solve (void) {
   case ALGO_LU_SUBSTITUTION_DOOLITTLE:
     substitute_lu_doolittle ();
     break;
+  case ALGO_LU_SUBSTITUTION_CROUT_TRANSPOSED:
+    substitute_lu_crout_transposed ();
+    break;
   case ALGO_JACOBI: case ALGO_GAUSS_SEIDEL:
     solve_iterative ();
     break;
@@ -477,6 +480,35 @@ void eqnsys<nr_type_t>::substitute_lu_crout (void) {
   }
 }
 
+/*! The function solves the transposed equation system A^T X = B
+   using the LU decomposed matrix (Crout's definition).  Thus the
+   adjoint system can be solved without decomposing the transposed
+   matrix once again. */
+template <class nr_type_t>
+void eqnsys<nr_type_t>::substitute_lu_crout_transposed (void) {
+  nr_type_t f;
+  int i, c;
+
+  // forward substitution in order to solve U^T Y = B
+  for (i = 0; i < N; i++) {
+    f = B_(i);
+    for (c = 0; c < i; c++) f -= A_(c, i) * X_(c);
+    // remember that the Uii diagonal are ones only in Crout's definition
+    X_(i) = f;
+  }
+
+  // backward substitution in order to solve L^T X = Y
+  for (i = N - 1; i >= 0; i--) {
+    f = X_(i);
+    for (c = i + 1; c < N; c++) f -= A_(c, i) * X_(c);
+    X_(i) = f / A_(i, i);
+  }
+
+  // finally undo the row exchanges
+  tvector<nr_type_t> Y = *X;
+  for (i = 0; i < N; i++) X_(rMap[i]) = Y (i);
+}
+
 /*! The function is used in order to run the forward and backward
    substitutions using the LU decomposed matrix (Doolittle's
    definition - Lii are ones).  This function is here because of
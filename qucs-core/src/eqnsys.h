@@ -47,6 +47,7 @@ enum algo_type {
   ALGO_SV_DECOMPOSITION           = 0x1000,
   // testing
   ALGO_QR_DECOMPOSITION_2         = 0x2000,
+  ALGO_LU_SUBSTITUTION_CROUT_TRANSPOSED = 0x4000,
 };
 
 //! Definition of pivoting strategies.
@@ -101,6 +102,7 @@ class eqnsys
   void factorize_lu_doolittle (void);
   void substitute_lu_crout (void);
   void substitute_lu_doolittle (void);
+  void substitute_lu_crout_transposed (void);
   void solve_qr (void);
   void solve_qr_ls (void);
   void solve_qrh (void);
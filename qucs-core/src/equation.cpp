@@ -2032,6 +2032,29 @@ qucs::vector * solver::dataVector (node * eqn)
     return v;
 }
 
+/* The function removes the equations put into the equation set by
+   checkinDataset() and the generated ones.  It is necessary before
+   the dataset gets deleted and the solver is run on another one. */
+void solver::dropDataset (void)
+{
+    node * eqn, * next, * prev = NULL;
+    for (eqn = equations; eqn != NULL; eqn = next)
+    {
+        next = eqn->getNext ();
+        char * instance = eqn->getInstance ();
+        if (instance == NULL || !strcmp (instance, "#generated"))
+        {
+            if (prev)
+                prev->setNext (next);
+            else
+                equations = next;
+            delete eqn;
+        }
+        else prev = eqn;
+    }
+    data = NULL;
+}
+
 /* This function collects the data vectors in a dataset and appends
    these to the list of equation node inside the equation solver. */
 void solver::checkinDataset (void)
@@ -2330,7 +2353,7 @@ void solver::checkoutDataset (void)
     {
 
         // skip variables which don't need to be exported
-        if (!eqn->output) continue;
+        if (!eqn->output || eqn->skip) continue;
 
         // is the equation result already in the dataset ?
         if (!findEquationResult (eqn))
@@ -2404,10 +2427,37 @@ int solver::findEquationResult (node * eqn)
     return 0;
 }
 
+/* This function marks all equations to be skipped by the evaluation
+   except the ones giving the listed results and the ones these depend
+   on. */
+void solver::skipEquations (strlist * results)
+{
+    strlist * needed = new strlist (*results);
+    int found;
+    foreach_equation (eqn) eqn->skip = 1;
+    do
+    {
+        found = 0;
+        foreach_equation (eqn)
+        {
+            if (eqn->skip && needed->contains (eqn->result))
+            {
+                eqn->skip = 0;
+                needed->add (eqn->getDependencies ());
+                found++;
+            }
+        }
+    }
+    while (found);
+    delete needed;
+}
+
 /* This function is called in order to run the equation checker and
    the solver.  The optional dataset passed to the function receives
-   the results of the calculations. */
-int solver::solve (dataset * data)
+   the results of the calculations.  If the list 'only' is given, just
+   the equations giving these results are solved and equations which
+   cannot be solved with the dataset are no error. */
+int solver::solve (dataset * data, strlist * only)
 {
     // load additional dataset equations
     setData (data);
@@ -2415,15 +2465,20 @@ int solver::solve (dataset * data)
     // put these into the checker
     checkee->setEquations (equations);
     // and check
-    if (checkee->check (data ? 1 : 0) != 0)
+    if (checkee->check (data && !only ? 1 : 0) != 0)
     {
         return -1;
     }
     equations = checkee->getEquations ();
+    if (only) skipEquations (only);
     // finally evaluate equations
     evaluate ();
     // put results into the dataset
     checkoutDataset ();
+    if (only)
+    {
+        foreach_equation (eqn) eqn->skip = 0;
+    }
     return 0;
 }
 
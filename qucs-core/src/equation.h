@@ -30,6 +30,7 @@
 #include "vector.h"
 #include "matrix.h"
 #include "matvec.h"
+#include "mempool.h"
 
 struct definition_t;
 
@@ -66,6 +67,7 @@ public:
   node (int);
   node (const node &);
   virtual ~node ();
+  MEMPOOL_OPERATORS
   node * getNext (void) { return next; }
   void setNext (node * n) { next = n; }
   int count (void);
@@ -337,6 +339,7 @@ public:
   qucs::vector * dataVector (node *);
   void checkinDataset (void);
   void checkoutDataset (void);
+  void dropDataset (void);
   static int dataSize (constant *);
   int getDependencySize (strlist *, int);
   int getDataSize (char *);
@@ -346,7 +349,8 @@ public:
   void findMatrixVectors (qucs::vector *);
   char * isMatrixVector (char *, int&, int&);
   int findEquationResult (node *);
-  int solve (dataset *);
+  void skipEquations (strlist *);
+  int solve (dataset *, strlist * only = NULL);
 
 public:
   node * equations;
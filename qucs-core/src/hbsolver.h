@@ -126,7 +126,6 @@ class hbsolver : public analysis
   tvector<nr_complex_t> * x;
   tvector<nr_complex_t> * vs;
 
-  int runs;
   int lnfreqs;
   int nlfreqs;
   int nnlvsrcs;
@@ -239,6 +239,7 @@ void input::factory (void) {
       o = (object *) c;
       c->setName (def->instance);
       c->setNonLinear (def->nonlinear != 0);
+      defs[def->instance] = def->define;
       c->setSubcircuit (def->subcircuit == nullptr ? "" : def->subcircuit);
 
       // change size (number of ports) of variable sized components
@@ -322,6 +323,163 @@ void input::assignDefaultProperties (object * obj, struct define_t * def) {
   }
 }
 
+/* The function looks up the definition of the given property in the
+   list of required and optional properties of a component type. */
+static struct property_t * input_find_property (struct define_t * def,
+						const char * key) {
+  for (int i = 0; PROP_IS_PROP (def->required[i]); i++)
+    if (!strcmp (def->required[i].key, key)) return &def->required[i];
+  for (int i = 0; PROP_IS_PROP (def->optional[i]); i++)
+    if (!strcmp (def->optional[i].key, key)) return &def->optional[i];
+  return NULL;
+}
+
+/* This function assigns the given textual value to a property of a
+   circuit instance.  The value is either a number, the name of a
+   variable in the instance's environment or a string.  If the
+   definition of the circuit type is given, the value is checked
+   against the allowed range, otherwise it must fit the type of the
+   existing property.  Returns zero on success. */
+int input::assignProperty (circuit * c, struct define_t * def,
+			   const char * key, const char * val) {
+  struct property_t * prop = def ? input_find_property (def, key) : NULL;
+  properties & props = c->getProperties ();
+  properties::iterator it = props.find (key);
+  if ((def && prop == NULL) || (!def && it == props.end ())) {
+    logprint (LOG_ERROR, "no such property `%s' in `%s'\n",
+	      key, c->getName ());
+    return -1;
+  }
+
+  // does the property need a value or an identifier ?
+  bool isval = prop ? PROP_IS_VAL (*prop) :
+    it->second.getType () != PROPERTY_STR;
+  char * end;
+  nr_double_t d = strtod (val, &end);
+  variable * v = c->getEnv () ? c->getEnv()->getVariable (val) : NULL;
+
+  if (isval && *val != '\0' && *end == '\0') {
+    // a plain value, check its range
+    if (prop && PROP_HAS_RANGE (*prop)) {
+      int rerror = 0;
+      if (prop->range.il == '[' &&  (d < prop->range.l)) rerror++;
+      if (prop->range.il == ']' && !(d > prop->range.l)) rerror++;
+      if (prop->range.ih == '[' && !(d < prop->range.h)) rerror++;
+      if (prop->range.ih == ']' &&  (d > prop->range.h)) rerror++;
+      if (rerror) {
+	logprint (LOG_ERROR, "value of `%s' (%g) is out of range "
+		  "`%c%g,%g%c' in `%s'\n", key, (double) d, prop->range.il,
+		  (double) prop->range.l, (double) prop->range.h,
+		  prop->range.ih, c->getName ());
+	return -1;
+      }
+    }
+    c->setProperty (key, d);
+  }
+  else if (isval && v != NULL && v->getType () == VAR_CONSTANT) {
+    // a variable reference, changes with the equations
+    c->setProperty (key, v);
+  }
+  else if (isval) {
+    logprint (LOG_ERROR, "value of `%s' (%s) needs to be a value or a "
+	      "variable in `%s'\n", key, val, c->getName ());
+    return -1;
+  }
+  else {
+    // a string, check the list of allowed ones
+    if (prop && PROP_HAS_STR (*prop)) {
+      int found = 0;
+      for (int i = 0; prop->range.str[i]; i++)
+	if (!strcmp (prop->range.str[i], val)) found++;
+      if (!found) {
+	logprint (LOG_ERROR, "value of `%s' (%s) is not allowed in `%s'\n",
+		  key, val, c->getName ());
+	return -1;
+      }
+    }
+    c->setProperty (key, val);
+  }
+  props[key].setDefault (false);
+  return 0;
+}
+
+/* The function creates a circuit of the given type and inserts it
+   into the netlist previously built by netlist().  The properties are
+   given as 'Key=Value' strings, optional ones not given get their
+   default values.  Nothing else of the netlist is touched, the
+   solvers number nodes and sources on each run anyway.  Returns zero
+   on success. */
+int input::addInstance (const char * type, const char * name,
+			const std::vector<std::string> & nodes,
+			const std::vector<std::string> & props) {
+  module * m = module::modules.get ((char *) type);
+  struct define_t * def = m ? m->definition : NULL;
+  if (def == NULL || def->action || def->substrate || m->circreate == NULL) {
+    logprint (LOG_ERROR, "no such circuit type `%s'\n", type);
+    return -1;
+  }
+  if (subnet->findCircuit (name) != NULL) {
+    logprint (LOG_ERROR, "circuit instance `%s' already defined\n", name);
+    return -1;
+  }
+  int n = nodes.size ();
+  if ((def->nodes == PROP_NODES && n < 1) ||
+      (def->nodes != PROP_NODES && def->nodes != n)) {
+    logprint (LOG_ERROR, "%d node(s) given in `%s:%s'\n", n, type, name);
+    return -1;
+  }
+
+  circuit * c = m->circreate ();
+  c->setName (name);
+  c->setNonLinear (def->nonlinear != 0);
+  c->setEnv (env);
+  if (c->isVariableSized ()) c->setSize (n);
+  for (int i = 0; i < n && i < c->getSize (); i++)
+    c->setNode (i, nodes[i]);
+
+  // apply the given properties
+  int errors = 0;
+  for (auto & p : props) {
+    size_t eq = p.find ('=');
+    if (eq == std::string::npos) {
+      logprint (LOG_ERROR, "invalid property `%s' in `%s:%s'\n",
+		p.c_str (), type, name);
+      errors++;
+      continue;
+    }
+    std::string key = p.substr (0, eq);
+    errors += assignProperty (c, def, key.c_str (),
+			      p.substr (eq + 1).c_str ()) ? 1 : 0;
+  }
+  for (int i = 0; PROP_IS_PROP (def->required[i]); i++) {
+    if (!c->hasProperty (def->required[i].key)) {
+      logprint (LOG_ERROR, "required property `%s' not found in `%s:%s'\n",
+		def->required[i].key, type, name);
+      errors++;
+    }
+  }
+  if (errors) {
+    delete c;
+    return -1;
+  }
+  assignDefaultProperties (c, def);
+  subnet->insertCircuit (c);
+  defs[name] = def;
+  return 0;
+}
+
+/* This function changes a single property of the given circuit
+   instance of the netlist previously built by netlist().  The value
+   is checked against the definition of the instance's type just like
+   the properties given to addInstance().  Returns zero on success. */
+int input::changeInstance (const char * name, const char * key,
+			   const char * val) {
+  circuit * c = subnet ? subnet->findInstance (name) : NULL;
+  if (c == NULL) return -1;
+  std::map<std::string, struct define_t *>::iterator it = defs.find (name);
+  return assignProperty (c, it != defs.end () ? it->second : NULL, key, val);
+}
+
 // The function creates components specified by the type of component.
 circuit * input::createCircuit (char * type) {
   module * m;
@@ -25,6 +25,10 @@
 #ifndef __INPUT_H__
 #define __INPUT_H__
 
+#include <map>
+#include <string>
+#include <vector>
+
 namespace qucs {
 
 class net;
@@ -49,11 +53,20 @@ class input : public object
   void setEnv (environment * e) { env = e; }
   static void assignDefaultProperties (object *, struct define_t *);
   static qucs::vector * createVector (struct value_t *);
+  int  addInstance (const char *, const char *,
+		    const std::vector<std::string> &,
+		    const std::vector<std::string> &);
+  int  changeInstance (const char *, const char *, const char *);
+
+ private:
+  static int assignProperty (circuit *, struct define_t *,
+			     const char *, const char *);
 
  private:
   FILE * fd;
   net * subnet;
   environment * env;
+  std::map<std::string, struct define_t *> defs; // of the instances
 };
 
 // externalize global variable
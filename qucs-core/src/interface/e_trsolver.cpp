@@ -894,24 +894,27 @@ int e_trsolver::getNodeV (char * label, nr_double_t& nodeV)
     }
     else
     {
-      nodeV = x->get(r);
+      // the reference node is not part of the solution vector
+      nodeV = r > 0 ? x->get (r - 1) : 0;
       return 0;
     }
 }
 
-/* Get the voltage reported by a voltage probe */
-int e_trsolver::getVProbeV (char * probename, nr_double_t& probeV)
+/* Looks up the circuit of the given type by name.  Subcircuit
+   elements are prefixed with the subcircuit hierarchy they are in.
+   Returns NULL if there is no such circuit. */
+circuit * e_trsolver::findCircuit (int type, char * name)
 {
     // string to hold the full name of the circuit
     std::string fullname;
 
     // check for NULL name
-    if (probename)
+    if (name)
     {
         circuit * root = subnet->getRoot ();
         for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ())
         {
-            if (c->getType () == CIR_VPROBE) {
+            if (c->getType () == type) {
 
                 fullname.clear ();
 
@@ -925,107 +928,172 @@ int e_trsolver::getVProbeV (char * probename, nr_double_t& probeV)
                 }
 
                 // append the user supplied name to search for
-                fullname.append (probename);
+                fullname.append (name);
 
-                // Check if it is the desired voltage source
+                // Check if it is the desired circuit
                 if (strcmp (fullname.c_str(), c->getName ()) == 0)
                 {
-                    // Saves the real and imaginary voltages in the probe to the
-                    // named variables Vr and Vi
-                    c->saveOperatingPoints ();
-                    // We are only interested in the real part for transient
-                    // analysis
-                    probeV = c->getOperatingPoint ("Vr");
-
-                    return 0;
+                    return c;
                 }
             }
         }
     }
+    return NULL;
+}
+
+/* Get the voltage reported by a voltage probe */
+int e_trsolver::getVProbeV (char * probename, nr_double_t& probeV)
+{
+    circuit * c = findCircuit (CIR_VPROBE, probename);
+
+    if (c)
+    {
+        // Saves the real and imaginary voltages in the probe to the
+        // named variables Vr and Vi
+        c->saveOperatingPoints ();
+        // We are only interested in the real part for transient
+        // analysis
+        probeV = c->getOperatingPoint ("Vr");
+
+        return 0;
+    }
     return -1;
 }
 
 /* Get the current reported by a current probe */
 int e_trsolver::getIProbeI (char * probename, nr_double_t& probeI)
 {
-    // string to hold the full name of the circuit
-    std::string fullname;
+    circuit * c = findCircuit (CIR_IPROBE, probename);
 
-    // check for NULL name
-    if (probename)
+    if (c)
     {
-        circuit * root = subnet->getRoot ();
-        for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ())
-        {
-            if (c->getType () == CIR_IPROBE) {
+        // Get the current reported by the probe
+        probeI = real (x->get (c->getVoltageSource () + getN ()));
 
-                fullname.clear ();
-
-                // Subcircuit elements top level name is the
-                // subcircuit type (the base name of the subcircuit
-                // file)
-                if (!c->getSubcircuit ().empty())
-                {
-                    fullname.append (c->getSubcircuit ());
-                    fullname.append (".");
-                }
-
-                // append the user supplied name to search for
-                fullname.append (probename);
+        return 0;
+    }
+    return -1;
+}
 
-                // Check if it is the desired voltage source
-                if (strcmp (fullname.c_str(), c->getName ()) == 0)
-                {
-                    // Get the current reported by the probe
-                    probeI = real (x->get (c->getVoltageSource () + getN ()));
+int e_trsolver::setECVSVoltage(char * ecvsname, nr_double_t V)
+{
+    circuit * c = findCircuit (CIR_ECVS, ecvsname);
 
-                    return 0;
-                }
-            }
-        }
+    if (c)
+    {
+        // Set the voltage to the desired value
+        c->setProperty("U", V);
+        return 0;
     }
     return -1;
 }
 
-int e_trsolver::setECVSVoltage(char * ecvsname, nr_double_t V)
+/* Resolves the named quantity of the given type into an index into
+   the handle list.  Returns -1 if there is no such quantity. */
+int e_trsolver::getHandle (int type, char * name)
 {
-    // string to hold the full name of the circuit
-    std::string fullname;
+    if (!name) return -1;
 
-    // check for NULL name
-    if (ecvsname)
+    // hand out the same handle for the same quantity
+    for (std::size_t i = 0; i < handles.size (); i++)
     {
-        circuit * root = subnet->getRoot ();
-        for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ())
-        {
-            // examine only ECVS elements
-            if (c->getType () == CIR_ECVS) {
+        if (handles[i].type == type && handles[i].name == name)
+            return i;
+    }
 
-                fullname.clear ();
+    etr_handle h;
+    h.type = type;
+    h.index = -1;
+    h.c = NULL;
+    h.p = NULL;
+    h.name = name;
 
-                // Subcircuit elements top level name is the
-                // subcircuit type (the base name of the subcircuit
-                // file)
-                if (!c->getSubcircuit ().empty())
-                {
-                    fullname.append (c->getSubcircuit ());
-                    fullname.append (".");
-                }
+    switch (type)
+    {
+    case ETR_HANDLE_NODE:
+    {
+        int r = nlist->getNodeNr (name);
+        if (r == -1) return -1;
+        // the reference node keeps index -1 and reads as zero
+        h.index = r - 1;
+        break;
+    }
+    case ETR_HANDLE_VPROBE:
+        if (!(h.c = findCircuit (CIR_VPROBE, name))) return -1;
+        break;
+    case ETR_HANDLE_IPROBE:
+        if (!(h.c = findCircuit (CIR_IPROBE, name))) return -1;
+        h.index = h.c->getVoltageSource () + getN ();
+        break;
+    case ETR_HANDLE_ECVS:
+    {
+        if (!(h.c = findCircuit (CIR_ECVS, name))) return -1;
+        // make sure the property exists, the properties container
+        // keeps its address stable from now on
+        h.c->setProperty ("U", h.c->getPropertyDouble ("U"));
+        h.p = &h.c->getProperties ().find ("U")->second;
+        break;
+    }
+    default:
+        return -1;
+    }
 
-                // append the user supplied name to search for
-                fullname.append (ecvsname);
+    handles.push_back (h);
+    return handles.size () - 1;
+}
 
-                // Check if it is the desired voltage source
-                if (strcmp (fullname.c_str(), c->getName ()) == 0)
-                {
-                    // Set the voltage to the desired value
-                    c->setProperty("U", V);
-                    return 0;
-                }
-            }
+/* Copies the current values of the quantities referred to by the
+   given handles.  Returns -1 if any of the handles is invalid. */
+int e_trsolver::getValues (int n, const int * h, double * values)
+{
+    int nh = handles.size ();
+    nr_double_t * data = x->getData ();
+
+    for (int i = 0; i < n; i++)
+    {
+        if (h[i] < 0 || h[i] >= nh) return -1;
+        etr_handle & e = handles[h[i]];
+
+        switch (e.type)
+        {
+        case ETR_HANDLE_NODE:
+        case ETR_HANDLE_IPROBE:
+            values[i] = e.index >= 0 ? data[e.index] : 0;
+            break;
+        case ETR_HANDLE_VPROBE:
+            values[i] = real (e.c->getV (NODE_1) - e.c->getV (NODE_2));
+            break;
+        case ETR_HANDLE_ECVS:
+            values[i] = e.p->getDouble ();
+            break;
         }
     }
-    return -1;
+    return 0;
+}
+
+/* Sets the voltages of the ecvs components referred to by the given
+   handles.  Returns -1 if any of the handles is invalid. */
+int e_trsolver::setValues (int n, const int * h, const double * values)
+{
+    int nh = handles.size ();
+
+    // validate first so that either all or no voltages are set
+    for (int i = 0; i < n; i++)
+    {
+        if (h[i] < 0 || h[i] >= nh || handles[h[i]].type != ETR_HANDLE_ECVS)
+            return -1;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        handles[h[i]].p->set (values[i]);
+    }
+    return 0;
+}
+
+nr_double_t * e_trsolver::getSolutionData (void)
+{
+    return x->getData ();
 }
 
 void e_trsolver::updateExternalInterpTime(nr_double_t t)
@@ -1073,6 +1141,11 @@ void e_trsolver::getJacData(int r, int c, nr_double_t& data)
     data = A->get(r,c);
 }
 
+nr_double_t * e_trsolver::getJacData (void)
+{
+    return A->getData ();
+}
+
 // properties
 PROP_REQ [] =
 {
@@ -1099,6 +1172,8 @@ PROP_OPT [] =
     { "Solver", PROP_STR, { PROP_NO_VAL, "CroutLU" }, PROP_RNG_SOL },
     { "relaxTSR", PROP_STR, { PROP_NO_VAL, "no" }, PROP_RNG_YESNO },
     { "initialDC", PROP_STR, { PROP_NO_VAL, "yes" }, PROP_RNG_YESNO },
+    { "sweepSeed", PROP_STR, { PROP_NO_VAL, "constant" },
+      PROP_RNG_STR4 ("none", "constant", "linear", "quadratic") },
     PROP_NO_PROP
 };
 struct define_t e_trsolver::anadef =
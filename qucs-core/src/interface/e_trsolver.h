@@ -37,9 +37,12 @@
 #include "qucs_interface.h"
 #include "trsolver.h"
 #include <vector>
+#include <string>
 
 namespace qucs {
 
+class property;
+
 /**
   * \class e_trsolver
   *
@@ -148,6 +151,60 @@ public:
       */
     int getIProbeI (char * probename, nr_double_t& probeI);
 
+    /** \brief Resolves a named quantity into a handle
+      * \param type One of the ETR_HANDLE_* quantity types
+      * \param name Pointer to character array containing the name
+      * \return The handle, or -1 if no such quantity exists
+      *
+      * This method performs the name search of getNodeV, getVProbeV,
+      * getIProbeI or setECVSVoltage once and returns an integer handle
+      * which can subsequently be passed to getValues and setValues.
+      * Handles remain valid for the lifetime of the solver, requesting
+      * the same quantity twice returns the same handle.
+      */
+    int getHandle (int type, char * name);
+
+    /** \brief Obtains the values of a set of quantities
+      * \param n Number of handles in \a handles
+      * \param handles Array of handles returned by getHandle
+      * \param values Array of at least \a n values to be filled
+      * \return Integer flag reporting success or failure
+      *
+      * Node voltages, probe voltages and probe currents are read
+      * directly from the solution vector. Reading an ecvs handle
+      * returns the voltage currently set. Returns 0 on success and -1
+      * if any of the handles is invalid.
+      */
+    int getValues (int n, const int * handles, double * values);
+
+    /** \brief Sets the voltages of a set of ecvs components
+      * \param n Number of handles in \a handles
+      * \param handles Array of ecvs handles returned by getHandle
+      * \param values Array of \a n new voltages
+      * \return Integer flag reporting success or failure
+      *
+      * Returns 0 on success and -1 if any of the handles is invalid
+      * or does not refer to an ecvs component.
+      */
+    int setValues (int n, const int * handles, const double * values);
+
+    /** \brief Returns a pointer to the solution vector
+      *
+      * The vector holds getN () node voltages followed by getM ()
+      * branch currents and is updated in place by every step. No
+      * copy is made, the pointer is valid until the solver is
+      * destroyed or re-initialised.
+      */
+    nr_double_t * getSolutionData (void);
+
+    /** \brief Returns a pointer to the Jacobian matrix data
+      *
+      * The getJacRows () by getJacCols () matrix is stored row by
+      * row. No copy is made, the pointer is valid until the solver
+      * is destroyed or re-initialised.
+      */
+    nr_double_t * getJacData (void);
+
     // debugging functions
     void debug (void);
     void printx (void);
@@ -205,6 +262,20 @@ private:
     void restoreSolution (void);
     void copySolution (tvector<nr_double_t> * [8], tvector<nr_double_t> * [8]);
     void fillLastSolution (tvector<nr_double_t> * );
+
+    // Handle based access
+
+    // circuit of the given type and (subcircuit relative) name
+    circuit * findCircuit (int type, char * name);
+    // a resolved quantity
+    struct etr_handle {
+        int type;           // one of the ETR_HANDLE_* types
+        int index;          // index into the solution vector
+        circuit * c;        // the circuit for probes and ecvs
+        property * p;       // the voltage property of an ecvs
+        std::string name;   // the name it was resolved from
+    };
+    std::vector<etr_handle> handles;
 };
 
 } // namespace qucs
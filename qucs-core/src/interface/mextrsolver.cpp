@@ -373,12 +373,17 @@ void mextrsolver::getJac(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prh
     // get a pointer to the start of the actual output data array
     outpointer = mxGetPr (plhs[0]);
 
-    // copy the jacobian matrix data into the matlab matrix
+    // copy the jacobian matrix data into the matlab matrix, the
+    // view is stored row by row while matlab expects columns
+    const double * jac = qtr.getJacData ();
     for(int c = 0; c < jcols; c++)
     {
         for(int r = 0; r < jrows; r++)
         {
-            qtr.getJacData(r, c, outpointer[(c*jrows)+r]);
+            if (jac)
+                outpointer[(c*jrows)+r] = jac[(r*jcols)+c];
+            else
+                qtr.getJacData(r, c, outpointer[(c*jrows)+r]);
         }
     }
 
@@ -354,6 +354,41 @@ int trsolver_interface::getIProbeI (char * probename, double& probeI)
     }
 }
 
+int trsolver_interface::getHandle (int type, char * name)
+{
+    if (etr) return etr->getHandle (type, name);
+    else return -2;
+}
+
+int trsolver_interface::getValues (int n, const int * handles, double * values)
+{
+    if (etr) return etr->getValues (n, handles, values);
+    else return -2;
+}
+
+int trsolver_interface::setValues (int n, const int * handles, const double * values)
+{
+    if (etr) return etr->setValues (n, handles, values);
+    else return -2;
+}
+
+const double * trsolver_interface::getSolutionData (void)
+{
+    // a view is only possible if no conversion is required
+    if (etr && sizeof (nr_double_t) == sizeof (double))
+        return (const double *) etr->getSolutionData ();
+    else
+        return NULL;
+}
+
+const double * trsolver_interface::getJacData (void)
+{
+    if (etr && sizeof (nr_double_t) == sizeof (double))
+        return (const double *) etr->getJacData ();
+    else
+        return NULL;
+}
+
 //void trsolver_interface::debug (void)
 //{
 //    if (etr) etr->debug ();
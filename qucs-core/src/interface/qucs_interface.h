@@ -95,6 +95,12 @@ protected:
 
 enum ETR_MODE { ETR_MODE_ASYNC, ETR_MODE_SYNC };
 
+/// Types of quantities accessible through handles
+enum ETR_HANDLE_TYPE { ETR_HANDLE_NODE,
+                       ETR_HANDLE_VPROBE,
+                       ETR_HANDLE_IPROBE,
+                       ETR_HANDLE_ECVS };
+
 /** \class trsolver_interface
   * \brief subclass for interfacing to the Qucs transient circuit solvers.
   *
@@ -201,6 +207,57 @@ public:
       */
     int getIProbeI (char * probename, double& probeI);
 
+    /** \brief Resolves a named quantity into a handle
+      * \param type One of the ETR_HANDLE_* quantity types
+      * \param name Pointer to character array containing the name
+      * \return The handle, or -1 if no such quantity exists
+      *
+      * Node, probe and ecvs names are searched for once, in the same
+      * way as by getNodeV, getVProbeV, getIProbeI and setECVSVoltage.
+      * The returned handle can be used with getValues and setValues
+      * during every step without further name lookups.
+      */
+    int getHandle (int type, char * name);
+
+    /** \brief Obtains the values of the quantities referred to by handles
+      * \param n Number of handles in \a handles
+      * \param handles Array of handles returned by getHandle
+      * \param values Array of at least \a n doubles to be filled
+      * \return Integer flag reporting success or failure
+      *
+      * Returns 0 on success and -1 if any of the handles is invalid.
+      */
+    int getValues (int n, const int * handles, double * values);
+
+    /** \brief Sets the voltages of the ecvs components referred to by handles
+      * \param n Number of handles in \a handles
+      * \param handles Array of ecvs handles returned by getHandle
+      * \param values Array of \a n new voltages
+      * \return Integer flag reporting success or failure
+      *
+      * Returns 0 on success and -1 if any of the handles is invalid.
+      * No voltage is changed in that case.
+      */
+    int setValues (int n, const int * handles, const double * values);
+
+    /** \brief Returns a read-only view of the solution vector
+      *
+      * The getN () node voltages are followed by the getM () branch
+      * currents. The data is updated in place by every step. Returns
+      * NULL if the solver does not compute in double precision, use
+      * getsolution in this case.
+      */
+    const double * getSolutionData (void);
+
+    /** \brief Returns a read-only view of the Jacobian matrix
+      *
+      * The getJacRows () by getJacCols () matrix is stored row by
+      * row and updated in place by every step. Returns NULL if the
+      * solver does not compute in double precision, use getJacData
+      * in this case.
+      */
+    const double * getJacData (void);
+
     /** \brief Sets pointer to function used to print messages during a sim
       * \param printing function to be used by e_trsolver
       *
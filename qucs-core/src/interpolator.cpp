@@ -44,7 +44,7 @@ interpolator::interpolator () {
   rsp = isp = NULL;
   rx = ry = NULL;
   cy = NULL;
-  repeat = dataType = interpolType = length = 0;
+  repeat = dataType = interpolType = length = cursor = 0;
   duration = 0.0;
 }
 
@@ -63,6 +63,7 @@ void interpolator::cleanup (void) {
   if (rx) { free (rx); rx = NULL; }
   if (ry) { free (ry); ry = NULL; }
   if (cy) { free (cy); cy = NULL; }
+  cursor = 0;
 }
 
 // Pass real interpolation datapoints as pointers.
@@ -80,6 +81,7 @@ void interpolator::vectors (nr_double_t * y, nr_double_t * x, int len) {
 
   dataType = (DATA_REAL & DATA_MASK_TYPE);
   length = len;
+  cursor = 0;
 }
 
 // Pass real interpolation datapoints as vectors.
@@ -239,6 +241,59 @@ int interpolator::findIndex_old (nr_double_t x) {
   return idx;
 }
 
+/* The function performs a hunting search on the ascending sorted
+   x-vector starting at the index found by the previous lookup.  The
+   search interval is expanded in exponentially growing steps until it
+   brackets the given value and is then bisected.  The result is
+   identical to findIndex(), but steadily advancing (or receding)
+   lookups as done in transient analysis and frequency sweeps cost
+   amortized constant time. */
+int interpolator::huntIndex (nr_double_t x) {
+  int lo, hi, av, step = 1;
+
+  // cursor is out of scope, fall back to plain binary search
+  if (cursor < 0 || cursor >= length)
+    return cursor = findIndex (x);
+
+  if (x >= rx[cursor]) {
+    // hunt upwards: rx[lo] <= x
+    lo = cursor;
+    for (;;) {
+      hi = lo + step;
+      if (hi >= length) { hi = length; break; }
+      if (x < rx[hi]) break;
+      lo = hi;
+      step <<= 1;
+    }
+  }
+  else {
+    // hunt downwards: x < rx[hi]
+    hi = cursor;
+    for (;;) {
+      lo = hi - step;
+      if (lo <= 0) {
+	lo = 0;
+	// value is below the x-vectors scope
+	if (!(x >= rx[0])) return cursor = 0;
+	break;
+      }
+      if (x >= rx[lo]) break;
+      hi = lo;
+      step <<= 1;
+    }
+  }
+
+  // bisect the bracketing interval rx[lo] <= x < rx[hi]
+  while (hi - lo > 1) {
+    av = lo + ((hi - lo) / 2);
+    if (x >= rx[av])
+      lo = av;
+    else
+      hi = av;
+  }
+  return cursor = lo;
+}
+
 /* Computes simple linear interpolation value for the given values. */
 nr_double_t interpolator::linear (nr_double_t x,
 				  nr_double_t x1, nr_double_t x2,
@@ -265,11 +320,29 @@ nr_complex_t interpolator::clinear (nr_double_t x, int idx) {
   return nr_complex_t (r, i);
 }
 
+/* Returns the left-hand-side index pointer into the x-vector for the
+   given value.  The index can be passed to rinterpolate() or
+   cinterpolate() of any interpolator sharing the same x-vector and
+   interpolation type, thus a single lookup serves a whole set of
+   dependent data vectors. */
+int interpolator::locate (nr_double_t x) {
+  if (length <= 1 || !(interpolType & (INTERPOL_LINEAR | INTERPOL_HOLD)))
+    return 0;
+  if (repeat & REPEAT_YES)
+    x = x - std::floor (x / duration) * duration;
+  return huntIndex (x);
+}
+
 /* This function interpolates for real values.  Returns the linear
    interpolation of the real y-vector for the given value in the
    x-vector. */
 nr_double_t interpolator::rinterpolate (nr_double_t x) {
-  int idx = -1;
+  return rinterpolate (x, locate (x));
+}
+
+/* The function interpolates for real values using the index pointer
+   previously obtained by locate(). */
+nr_double_t interpolator::rinterpolate (nr_double_t x, int idx) {
   nr_double_t res = 0.0;
 
   // no chance to interpolate
@@ -286,7 +359,6 @@ nr_double_t interpolator::rinterpolate (nr_double_t x) {
 
   // linear interpolation
   if (interpolType & INTERPOL_LINEAR) {
-    idx = findIndex (x);
     // dependency variable in scope or beyond
     if (x == rx[idx])
       res = ry[idx];
@@ -302,8 +374,6 @@ nr_double_t interpolator::rinterpolate (nr_double_t x) {
     res = rsp->evaluate (x).f0;
   }
   else if (interpolType & INTERPOL_HOLD) {
-    // find appropriate dependency index
-    idx = findIndex (x);
     res = ry[idx];
   }
   return res;
@@ -313,7 +383,12 @@ nr_double_t interpolator::rinterpolate (nr_double_t x) {
    interpolation of the real y-vector for the given value in the
    x-vector. */
 nr_complex_t interpolator::cinterpolate (nr_double_t x) {
-  int idx = -1;
+  return cinterpolate (x, locate (x));
+}
+
+/* The function interpolates for complex values using the index
+   pointer previously obtained by locate(). */
+nr_complex_t interpolator::cinterpolate (nr_double_t x, int idx) {
   nr_complex_t res = 0.0;
 
   // no chance to interpolate
@@ -330,7 +405,6 @@ nr_complex_t interpolator::cinterpolate (nr_double_t x) {
 
   // linear interpolation
   if (interpolType & INTERPOL_LINEAR) {
-    idx = findIndex (x);
     // dependency variable in scope or beyond
     if (x == rx[idx])
       res = cy[idx];
@@ -348,8 +422,6 @@ nr_complex_t interpolator::cinterpolate (nr_double_t x) {
     res = nr_complex_t (r, i);
   }
   else if (interpolType & INTERPOL_HOLD) {
-    // find appropriate dependency index
-    idx = findIndex (x);
     res = cy[idx];
   }
 
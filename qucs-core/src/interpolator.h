@@ -55,9 +55,13 @@ class interpolator
   void prepare (int, int, int domain = DATA_RECTANGULAR);
   nr_double_t rinterpolate (nr_double_t);
   nr_complex_t cinterpolate (nr_double_t);
+  int locate (nr_double_t);
+  nr_double_t rinterpolate (nr_double_t, int);
+  nr_complex_t cinterpolate (nr_double_t, int);
 
 private:
   int findIndex (nr_double_t);
+  int huntIndex (nr_double_t);
   int findIndex_old (nr_double_t);
   nr_double_t linear (nr_double_t,
 		      nr_double_t, nr_double_t, nr_double_t, nr_double_t);
@@ -70,6 +74,7 @@ private:
   int interpolType;
   int repeat;
   int length;
+  int cursor;
   nr_double_t * rx;
   nr_double_t * ry;
   nr_double_t duration;
@@ -0,0 +1,516 @@
+/*
+ * load_dataset.cpp - fast dataset file loader
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+/* The loader in this file handles the common case of large datasets
+   written by qucsator itself.  Instead of passing each value through
+   the lexer and the parser it maps the file, locates the variable
+   blocks by their tags and converts the value lists in chunks on
+   several threads.  Whenever the file contains anything unexpected
+   the loader gives up silently and the grammar based parser is used
+   instead, which also produces the appropriate error messages. */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#if HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "complex.h"
+#include "object.h"
+#include "strlist.h"
+#include "vector.h"
+#include "dataset.h"
+
+// Files below this size are converted on the calling thread only.
+#define LOAD_PARALLEL_SIZE (1 << 20)
+// Approximate size of a chunk of values converted at once.
+#define LOAD_CHUNK_SIZE    (1 << 20)
+// Maximum number of converting threads.
+#define LOAD_MAX_THREADS   8
+
+namespace qucs {
+
+/* A read-only view of the file contents, either mapped into memory
+   or read into a private buffer. */
+struct load_file {
+  const char * data;
+  size_t size;
+  bool mapped;
+  char * buffer;
+};
+
+// Makes the contents of the given file available in memory.
+static bool load_open (const char * file, load_file & f) {
+  f.data = NULL;
+  f.size = 0;
+  f.mapped = false;
+  f.buffer = NULL;
+#if HAVE_SYS_MMAN_H
+  int fd = open (file, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || st.st_size == 0) {
+    close (fd);
+    return false;
+  }
+  void * p = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (p == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+  madvise (p, st.st_size, MADV_SEQUENTIAL);
+#endif
+  f.data = (const char *) p;
+  f.size = st.st_size;
+  f.mapped = true;
+  return true;
+#else
+  FILE * fp;
+  if ((fp = fopen (file, "rb")) == NULL) return false;
+  fseek (fp, 0, SEEK_END);
+  long len = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+  if (len <= 0 || (f.buffer = (char *) malloc (len)) == NULL) {
+    fclose (fp);
+    return false;
+  }
+  if (fread (f.buffer, 1, len, fp) != (size_t) len) {
+    free (f.buffer);
+    fclose (fp);
+    return false;
+  }
+  fclose (fp);
+  f.data = f.buffer;
+  f.size = len;
+  return true;
+#endif
+}
+
+// Releases the file contents.
+static void load_close (load_file & f) {
+#if HAVE_SYS_MMAN_H
+  if (f.mapped) munmap ((void *) f.data, f.size);
+#endif
+  free (f.buffer);
+}
+
+// Exact powers of ten representable as doubles.
+static const double load_pow10[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Converts the unsigned floating point number at the given position
+   as accepted by the dataset lexer.  Numbers with at most 19
+   significant digits, a mantissa below 2^53 and a decimal exponent
+   up to 22 are converted exactly using a single multiplication or
+   division.  All other numbers are passed to strtod().  Returns the
+   position after the number or NULL if there is no valid number. */
+static const char * load_number (const char * p, const char * end,
+				 double & val) {
+  const char * start = p;
+  uint64_t m = 0;
+  int digits = 0, exp10 = 0;
+  bool exact = true, any = false;
+
+  // integral part
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (digits < 19) {
+      m = m * 10 + (*p - '0');
+      if (m) digits++;
+    } else {
+      exp10++;
+      exact = false;
+    }
+    any = true;
+    p++;
+  }
+  // fractional part, needs at least one digit
+  if (p < end && *p == '.') {
+    p++;
+    if (p >= end || *p < '0' || *p > '9') return NULL;
+    while (p < end && *p >= '0' && *p <= '9') {
+      if (digits < 19) {
+	m = m * 10 + (*p - '0');
+	if (m) digits++;
+	exp10--;
+      } else {
+	exact = false;
+      }
+      p++;
+    }
+    any = true;
+  }
+  if (!any) return NULL;
+  // exponent, needs at least one digit
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool neg = false;
+    if (p < end && (*p == '+' || *p == '-')) neg = (*p++ == '-');
+    if (p >= end || *p < '0' || *p > '9') return NULL;
+    int e = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+      if (e < 100000) e = e * 10 + (*p - '0');
+      p++;
+    }
+    exp10 += neg ? -e : e;
+  }
+
+  if (exact && m < ((uint64_t) 1 << 53) && exp10 >= -22 && exp10 <= 22) {
+    val = (double) m;
+    if (exp10 > 0)
+      val *= load_pow10[exp10];
+    else if (exp10 < 0)
+      val /= load_pow10[-exp10];
+  }
+  else {
+    char buf[128];
+    size_t len = p - start;
+    if (len >= sizeof (buf)) {
+      std::string s (start, len);
+      val = strtod (s.c_str (), NULL);
+    } else {
+      memcpy (buf, start, len);
+      buf[len] = '\0';
+      val = strtod (buf, NULL);
+    }
+  }
+  return p;
+}
+
+// Parses an optional sign followed by an unsigned number.
+static const char * load_signed (const char * p, const char * end,
+				 double & val) {
+  bool neg = false;
+  if (p < end && (*p == '+' || *p == '-')) neg = (*p++ == '-');
+  if ((p = load_number (p, end, val)) != NULL && neg) val = -val;
+  return p;
+}
+
+/* Converts all the values in the given text range and appends them
+   to the given list.  Returns false if the text contains anything
+   the fast loader does not understand. */
+static bool load_values (const char * p, const char * end,
+			 std::vector<nr_complex_t> & vals) {
+  double re, im;
+  while (p < end) {
+    char c = *p;
+    if (c == ' ' || c == '\t' || c == '\n') {
+      p++;
+      continue;
+    }
+    if (c == '\r') {
+      // only allowed as part of a line end
+      if (p + 1 >= end || p[1] != '\n') return false;
+      p++;
+      continue;
+    }
+    if (c == '#') {
+      while (p < end && *p != '\n') p++;
+      continue;
+    }
+    bool neg = false;
+    const char * s = p;
+    if (c == '+' || c == '-') neg = (*s++ == '-');
+    if (s < end && (*s == 'i' || *s == 'j')) {
+      // imaginary value
+      if ((p = load_number (s + 1, end, im)) == NULL) return false;
+      vals.push_back (nr_complex_t (0.0, neg ? -im : im));
+    }
+    else {
+      // real or complex value
+      if ((p = load_signed (p, end, re)) == NULL) return false;
+      if (p + 1 < end && (*p == '+' || *p == '-') &&
+	  (p[1] == 'i' || p[1] == 'j')) {
+	neg = (*p == '-');
+	if ((p = load_number (p + 2, end, im)) == NULL) return false;
+	vals.push_back (nr_complex_t (re, neg ? -im : im));
+      }
+      else {
+	vals.push_back (nr_complex_t (re, 0.0));
+      }
+    }
+    // values must be separated by spaces, line ends or comments
+    if (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' &&
+	*p != '#')
+      return false;
+  }
+  return true;
+}
+
+// Checks whether the given character may be part of an identifier.
+static inline bool load_ident (char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+    (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '[' ||
+    c == ']' || c == ',';
+}
+
+/* Checks whether the given word is an identifier as accepted by the
+   dataset lexer, i.e. it starts with a letter or underscore, its
+   dot separated parts are not empty and a part starting with a digit
+   contains no brackets or commas.  The keywords are excluded. */
+static bool load_name (const std::string & word) {
+  const char * p = word.c_str ();
+  if (word == "dep" || word == "indep") return false;
+  if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_'))
+    return false;
+  bool digit = false;
+  for (p++; *p; p++) {
+    if (*p == '.') {
+      char c = p[1];
+      digit = (c >= '0' && c <= '9');
+      if (!digit && !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		      c == '_'))
+	return false;
+    }
+    else if (!load_ident (*p))
+      return false;
+    else if (digit && (*p == '[' || *p == ']' || *p == ','))
+      return false;
+  }
+  return true;
+}
+
+/* Splits the contents of a tag into its words.  Returns false if
+   there are any characters not expected in a tag. */
+static bool load_tag (const char * p, const char * end,
+		      std::vector<std::string> & words) {
+  words.clear ();
+  while (p < end) {
+    if (*p == ' ' || *p == '\t') {
+      p++;
+      continue;
+    }
+    const char * s = p;
+    if (*p == '/') p++;
+    while (p < end && load_ident (*p)) p++;
+    if (p == s || (p < end && *p != ' ' && *p != '\t')) return false;
+    words.push_back (std::string (s, p - s));
+  }
+  return true;
+}
+
+// Skips spaces, line ends and comments between variable blocks.
+static const char * load_skip (const char * p, const char * end) {
+  while (p < end) {
+    if (*p == ' ' || *p == '\t' || *p == '\n')
+      p++;
+    else if (*p == '\r' && p + 1 < end && p[1] == '\n')
+      p += 2;
+    else if (*p == '#')
+      while (p < end && *p != '\n') p++;
+    else
+      break;
+  }
+  return p;
+}
+
+// A variable block found in the file.
+struct load_block {
+  bool indep;
+  std::vector<std::string> words;
+  const char * begin;
+  const char * end;
+};
+
+// A range of values to be converted, always starting at a line.
+struct load_task {
+  int block;
+  const char * begin;
+  const char * end;
+  std::vector<nr_complex_t> vals;
+  bool ok;
+};
+
+/* Locates the variable blocks of the dataset in file order.  Returns
+   false if the file layout is unexpected. */
+static bool load_blocks (const char * p, const char * end,
+			 std::vector<load_block> & blocks) {
+  static const char version[] = "<Qucs Dataset ";
+  size_t len = sizeof (version) - 1;
+  if ((size_t) (end - p) < len || memcmp (p, version, len)) return false;
+  // version number and the end of the line
+  p += len;
+  for (int i = 0; i < 3; i++) {
+    if (i > 0 && (p >= end || *p++ != '.')) return false;
+    if (p >= end || *p < '0' || *p > '9') return false;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+  }
+  if (p >= end || *p++ != '>') return false;
+  while (p < end && (*p == ' ' || *p == '\t')) p++;
+  if (p < end && *p == '\r') p++;
+  if (p >= end || *p != '\n') return false;
+
+  std::vector<std::string> words;
+  while ((p = load_skip (p, end)) < end) {
+    if (*p != '<') return false;
+    const char * t = p + 1;
+    if ((p = (const char *) memchr (t, '>', end - t)) == NULL) return false;
+    if (memchr (t, '\n', p - t) || !load_tag (t, p, words)) return false;
+    p++;
+
+    bool indep;
+    if (words.size () == 3 && words[0] == "indep") {
+      const char * n = words[2].c_str ();
+      if (*n == '+' || *n == '-') n++;
+      if (!*n || strspn (n, "0123456789") != strlen (n)) return false;
+      indep = true;
+    }
+    else if (words.size () >= 2 && words[0] == "dep")
+      indep = false;
+    else
+      return false;
+    // variable and dependency names
+    for (size_t i = 1; i < words.size (); i++)
+      if (!(indep && i == 2) && !load_name (words[i])) return false;
+
+    // the values end at the next tag which must close the block
+    const char * b = p;
+    if ((p = (const char *) memchr (b, '<', end - b)) == NULL) return false;
+    const char * e = p;
+    t = p + 1;
+    if ((p = (const char *) memchr (t, '>', end - t)) == NULL) return false;
+    std::vector<std::string> close;
+    if (!load_tag (t, p, close) || close.size () != 1 ||
+	close[0] != (indep ? "/indep" : "/dep"))
+      return false;
+    p++;
+
+    load_block blk = { indep, words, b, e };
+    blocks.push_back (blk);
+  }
+  return true;
+}
+
+/* This static function reads a dataset from the given file using the
+   fast loader.  It returns NULL without any message if the file
+   cannot be handled this way, the caller is expected to fall back to
+   the grammar based parser then. */
+dataset * dataset::load_fast (const char * file) {
+  load_file f;
+  if (!load_open (file, f)) return NULL;
+
+  std::vector<load_block> blocks;
+  if (!load_blocks (f.data, f.data + f.size, blocks)) {
+    load_close (f);
+    return NULL;
+  }
+
+  // split the value lists into chunks at line boundaries
+  std::vector<load_task> tasks;
+  for (size_t i = 0; i < blocks.size (); i++) {
+    const char * p = blocks[i].begin, * e = blocks[i].end;
+    do {
+      const char * q = e;
+      if ((size_t) (e - p) > LOAD_CHUNK_SIZE) {
+	q = (const char *) memchr (p + LOAD_CHUNK_SIZE, '\n',
+				   e - p - LOAD_CHUNK_SIZE);
+	q = q ? q + 1 : e;
+      }
+      load_task task;
+      task.block = i;
+      task.begin = p;
+      task.end = q;
+      task.ok = false;
+      tasks.push_back (task);
+      p = q;
+    } while (p < e);
+  }
+
+  // convert the chunks, on several threads for larger files
+  std::atomic<size_t> next (0);
+  auto worker = [&tasks, &next] () {
+    size_t n;
+    while ((n = next++) < tasks.size ()) {
+      load_task & t = tasks[n];
+      t.vals.reserve ((t.end - t.begin) / 24 + 1);
+      t.ok = load_values (t.begin, t.end, t.vals);
+    }
+  };
+  unsigned int nthreads = 1;
+  if (f.size >= LOAD_PARALLEL_SIZE) {
+    nthreads = std::thread::hardware_concurrency ();
+    nthreads = std::max (1U, std::min (nthreads, (unsigned) LOAD_MAX_THREADS));
+    nthreads = std::min (nthreads, (unsigned) tasks.size ());
+  }
+  std::vector<std::thread> threads;
+  try {
+    for (unsigned int i = 1; i < nthreads; i++)
+      threads.push_back (std::thread (worker));
+  }
+  catch (...) {
+    // no more threads available, continue with the ones we have
+  }
+  worker ();
+  for (size_t i = 0; i < threads.size (); i++) threads[i].join ();
+  load_close (f);
+
+  // check whether all chunks could be converted
+  for (size_t t = 0; t < tasks.size (); t++)
+    if (!tasks[t].ok) return NULL;
+
+  // create the vectors sized to the number of values in their chunks
+  dataset * data = new dataset ();
+  for (size_t i = 0, t = 0; i < blocks.size (); i++) {
+    load_block & b = blocks[i];
+    size_t n = 0, k = t;
+    for (; k < tasks.size () && tasks[k].block == (int) i; k++)
+      n += tasks[k].vals.size ();
+    vector * v = new vector (n);
+    for (n = 0; t < k; t++) {
+      std::vector<nr_complex_t> & vals = tasks[t].vals;
+      for (size_t j = 0; j < vals.size (); j++) v->set (vals[j], n++);
+      std::vector<nr_complex_t> ().swap (vals);
+    }
+    v->setName (b.words[1].c_str ());
+    if (b.indep) {
+      v->setRequested (strtol (b.words[2].c_str (), NULL, 10));
+      data->appendDependency (v);
+    }
+    else {
+      strlist * deps = new strlist ();
+      for (size_t j = 2; j < b.words.size (); j++)
+	deps->append (b.words[j].c_str ());
+      v->setDependencies (deps);
+      data->appendVariable (v);
+    }
+  }
+  return data;
+}
+
+} // namespace qucs
@@ -0,0 +1,234 @@
+/*
+ * mempool.cpp - memory pool class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <new>
+#include <mutex>
+
+#if HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#elif defined (__MINGW32__)
+# include <malloc.h>
+#endif
+
+#include "mempool.h"
+
+namespace qucs {
+
+// Free list entry overlaid on unused blocks.
+struct mempool_block {
+  struct mempool_block * next;
+};
+
+/* Header of each chunk, blocks of a single size class follow at the
+   next aligned address.  Chunks are aligned to their size, thus the
+   chunk of a block is found by masking its address. */
+struct mempool_chunk {
+  struct mempool_chunk * prev;  // neighbours in the list of chunks
+  struct mempool_chunk * next;  // having free blocks
+  struct mempool_block * free;  // recycled blocks
+  char * top;                   // first block never handed out
+  size_t size;                  // block size
+  size_t live;                  // blocks handed out
+  bool listed;                  // in the list of its size class
+};
+#define MEMPOOL_HEADER \
+  ((sizeof (struct mempool_chunk) + MEMPOOL_ALIGN - 1) & ~(MEMPOOL_ALIGN - 1))
+
+// Pool state.
+static std::mutex lock;
+static struct mempool_chunk * partial[MEMPOOL_CLASSES];
+static size_t inuse = 0;
+static size_t total = 0;
+
+#if HAVE_SYS_MMAN_H
+// Mapped chunks not handed out yet.
+static char * fresh = NULL;
+static char * freshEnd = NULL;
+#endif
+
+/* Allocates a chunk aligned to its size.  Mapping the memory directly
+   avoids the alignment padding of the heap and gives it back to the
+   system immediately when the chunk is freed. */
+static struct mempool_chunk * newChunk (void) {
+  void * p;
+#if HAVE_SYS_MMAN_H
+  if (fresh == freshEnd) {
+    // map a batch of chunks and trim it to an aligned address
+    size_t n = MEMPOOL_BATCH * MEMPOOL_CHUNK;
+    char * m = (char *) mmap (NULL, n + MEMPOOL_CHUNK, PROT_READ | PROT_WRITE,
+			      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == (char *) MAP_FAILED) return NULL;
+    char * a = (char *) (((uintptr_t) m + MEMPOOL_CHUNK - 1) &
+			 ~(uintptr_t) (MEMPOOL_CHUNK - 1));
+    if (a > m) munmap (m, a - m);
+    if (a < m + MEMPOOL_CHUNK) munmap (a + n, m + MEMPOOL_CHUNK - a);
+    fresh = a;
+    freshEnd = a + n;
+  }
+  p = fresh;
+  fresh += MEMPOOL_CHUNK;
+#elif defined (__MINGW32__)
+  p = _aligned_malloc (MEMPOOL_CHUNK, MEMPOOL_CHUNK);
+#else
+  if (posix_memalign (&p, MEMPOOL_CHUNK, MEMPOOL_CHUNK) != 0) p = NULL;
+#endif
+  return (struct mempool_chunk *) p;
+}
+
+// Gives the given chunk back to the system.
+static void freeChunk (struct mempool_chunk * k) {
+#if HAVE_SYS_MMAN_H
+  munmap (k, MEMPOOL_CHUNK);
+#elif defined (__MINGW32__)
+  _aligned_free (k);
+#else
+  ::free (k);
+#endif
+  total -= MEMPOOL_CHUNK;
+}
+
+// Returns the chunk the given block was carved from.
+static struct mempool_chunk * chunkOf (void * p) {
+  return (struct mempool_chunk *) ((uintptr_t) p & ~(uintptr_t)
+				   (MEMPOOL_CHUNK - 1));
+}
+
+// Puts the given chunk in front of the list of its size class.
+static void linkChunk (struct mempool_chunk * k, size_t c) {
+  k->prev = NULL;
+  k->next = partial[c];
+  if (partial[c]) partial[c]->prev = k;
+  partial[c] = k;
+  k->listed = true;
+}
+
+// Removes the given chunk from the list of its size class.
+static void unlinkChunk (struct mempool_chunk * k, size_t c) {
+  if (k->prev) k->prev->next = k->next;
+  else partial[c] = k->next;
+  if (k->next) k->next->prev = k->prev;
+  k->listed = false;
+}
+
+/* Returns a block of memory of at least the given size.  Throws
+   std::bad_alloc if no memory is available. */
+void * mempool::alloc (size_t n) {
+  if (n == 0) n = 1;
+  if (n > MEMPOOL_MAXSIZE) {
+    void * p = ::malloc (n);
+    if (p == NULL) throw std::bad_alloc ();
+    return p;
+  }
+  size_t c = (n - 1) / MEMPOOL_ALIGN;
+  size_t size = (c + 1) * MEMPOOL_ALIGN;
+  std::lock_guard<std::mutex> guard (lock);
+  // start a new chunk if no chunk of this size has free blocks
+  struct mempool_chunk * k = partial[c];
+  if (k == NULL) {
+    if ((k = newChunk ()) == NULL) throw std::bad_alloc ();
+    k->free = NULL;
+    k->top = (char *) k + MEMPOOL_HEADER;
+    k->size = size;
+    k->live = 0;
+    linkChunk (k, c);
+    total += MEMPOOL_CHUNK;
+  }
+  // recycle a block or carve a new one
+  void * p;
+  if (k->free != NULL) {
+    p = k->free;
+    k->free = k->free->next;
+  }
+  else {
+    p = k->top;
+    k->top += size;
+  }
+  k->live++;
+  if (k->free == NULL && k->top + size > (char *) k + MEMPOOL_CHUNK)
+    unlinkChunk (k, c);
+  inuse += size;
+  return p;
+}
+
+/* Returns the given block of the given size (as passed to alloc()) to
+   the pool.  A chunk without any block in use is given back to the
+   system unless it is the last one of its size class. */
+void mempool::free (void * p, size_t n) {
+  if (p == NULL) return;
+  if (n == 0) n = 1;
+  if (n > MEMPOOL_MAXSIZE) {
+    ::free (p);
+    return;
+  }
+  size_t c = (n - 1) / MEMPOOL_ALIGN;
+  std::lock_guard<std::mutex> guard (lock);
+  struct mempool_chunk * k = chunkOf (p);
+  struct mempool_block * b = (struct mempool_block *) p;
+  b->next = k->free;
+  k->free = b;
+  k->live--;
+  inuse -= k->size;
+  if (!k->listed)
+    linkChunk (k, c);
+  else if (k->live == 0 && (k->prev || k->next)) {
+    unlinkChunk (k, c);
+    freeChunk (k);
+  }
+}
+
+/* Gives all chunks back to the system at once.  This is done only if
+   no pooled object is alive anymore. */
+void mempool::release (void) {
+  std::lock_guard<std::mutex> guard (lock);
+  if (inuse != 0) return;
+  for (int c = 0; c < MEMPOOL_CLASSES; c++) {
+    while (partial[c]) {
+      struct mempool_chunk * k = partial[c];
+      unlinkChunk (k, c);
+      freeChunk (k);
+    }
+  }
+#if HAVE_SYS_MMAN_H
+  if (fresh != freshEnd) munmap (fresh, freshEnd - fresh);
+  fresh = freshEnd = NULL;
+#endif
+}
+
+// Returns the number of bytes handed out in pooled blocks.
+size_t mempool::used (void) {
+  std::lock_guard<std::mutex> guard (lock);
+  return inuse;
+}
+
+// Returns the number of bytes reserved by the pool.
+size_t mempool::reserved (void) {
+  std::lock_guard<std::mutex> guard (lock);
+  return total;
+}
+
+} // namespace qucs
@@ -0,0 +1,72 @@
+/*
+ * mempool.h - memory pool class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __MEMPOOL_H__
+#define __MEMPOOL_H__
+
+#include <stddef.h>
+
+/* Class specific allocation operators routing the objects of a class
+   (and of the classes derived from it) through the memory pool.  The
+   size passed to the delete operators requires a virtual destructor
+   for polymorphic classes. */
+#define MEMPOOL_OPERATORS \
+  static void * operator new (size_t n) { \
+    return qucs::mempool::alloc (n); } \
+  static void operator delete (void * p, size_t n) { \
+    qucs::mempool::free (p, n); } \
+  static void * operator new[] (size_t n) { \
+    return qucs::mempool::alloc (n); } \
+  static void operator delete[] (void * p, size_t n) { \
+    qucs::mempool::free (p, n); }
+
+namespace qucs {
+
+// Granularity and upper limit of pooled block sizes, the latter covers
+// the built-in components (up to 840 bytes on 64-bit hosts).
+#define MEMPOOL_ALIGN   16
+#define MEMPOOL_MAXSIZE 1024
+#define MEMPOOL_CLASSES (MEMPOOL_MAXSIZE / MEMPOOL_ALIGN)
+// Size of the chunks the blocks are carved from, and the number of
+// chunks requested from the system at once.
+#define MEMPOOL_CHUNK   (64 * 1024)
+#define MEMPOOL_BATCH   16
+
+/* The memory pool serves the many small objects created during
+   netlist construction and equation evaluation (circuits, nodes,
+   equation nodes, string lists).  Each size class carves its blocks
+   from its own large chunks and recycles them through per chunk free
+   lists.  Chunks are given back to the system once all their blocks
+   are free.  Larger requests are passed to the system allocator. */
+class mempool
+{
+ public:
+  static void * alloc (size_t);
+  static void free (void *, size_t);
+  static void release (void);
+  static size_t used (void);
+  static size_t reserved (void);
+};
+
+} // namespace qucs
+
+#endif /* __MEMPOOL_H__ */
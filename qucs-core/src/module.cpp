@@ -304,6 +304,9 @@ void module::registerModules (void) {
   REGISTER_ANALYSIS (trsolver);
   REGISTER_ANALYSIS (hbsolver);
   REGISTER_ANALYSIS (parasweep);
+  REGISTER_ANALYSIS (montecarlo);
+  REGISTER_ANALYSIS (senssolver);
+  REGISTER_ANALYSIS (optimizer);
   REGISTER_ANALYSIS (e_trsolver);
 }
 
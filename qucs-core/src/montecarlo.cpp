@@ -0,0 +1,642 @@
+/*
+ * montecarlo.cpp - Monte Carlo analysis class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+/* The Monte Carlo analysis runs its child analyses for a number of
+   trials, each with randomly varied component properties.  The
+   tolerances are declared on the components next to the property
+   they apply to, e.g.
+
+     R:R1 _net0 _net1 R="50 Ohm" R.Tol="0.05" R.Dist="uniform"
+
+   'Tol' is the relative tolerance.  For the uniform distribution it
+   is the maximum deviation.  For the (default) gaussian distribution
+   it is the 3-sigma deviation.
+
+   Every trial draws its random numbers from its own stream, derived
+   from the seed, the trial number and the property name only.  The
+   varied values of a trial are therefore the same regardless of the
+   netlist order, the number of tolerances and the trials run before.
+   The variation scales the evaluated value of a property, which stays
+   bound to its variable or equation.
+
+   The trials are independent and shared among 'Workers' processes
+   (all processors by default), each running on its own copy of the
+   netlist.  The results are merged in the order of the trials.
+
+   For each result vector of the child analyses the mean value and
+   standard deviation over all trials are computed on the fly and
+   saved as 'name.mean' and 'name.sigma'.  If a specification is
+   given, the yield is saved as well.  With 'Save' set to "no" the
+   results of the single trials are dropped after each trial. */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+
+#if HAVE_FORK && HAVE_SYS_WAIT_H
+# include <unistd.h>
+# include <sys/wait.h>
+# define MC_WORKERS 1
+#endif
+
+#include "logging.h"
+#include "complex.h"
+#include "object.h"
+#include "vector.h"
+#include "strlist.h"
+#include "dataset.h"
+#include "net.h"
+#include "netdefs.h"
+#include "ptrlist.h"
+#include "circuit.h"
+#include "analysis.h"
+#include "montecarlo.h"
+
+namespace qucs {
+
+// Constructor creates an unnamed instance of the montecarlo class.
+montecarlo::montecarlo () : analysis () {
+  type = ANALYSIS_SWEEP;
+}
+
+// Constructor creates a named instance of the montecarlo class.
+montecarlo::montecarlo (char * n) : analysis (n) {
+  type = ANALYSIS_SWEEP;
+}
+
+// Destructor deletes the montecarlo class object.
+montecarlo::~montecarlo () {
+}
+
+/* The copy constructor creates a new instance of the montecarlo class
+   based on the given montecarlo object. */
+montecarlo::montecarlo (montecarlo & m) : analysis (m) {
+  targets = m.targets;
+  trial = m.trial;
+}
+
+// Finalizes a 64-bit hash value (splitmix64).
+static inline uint64_t mc_mix (uint64_t z) {
+  z = (z ^ (z >> 30)) * UINT64_C (0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C (0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+// Hashes the given string (FNV-1a).
+static uint64_t mc_hash (const std::string & s) {
+  uint64_t h = UINT64_C (0xcbf29ce484222325);
+  for (size_t i = 0; i < s.size (); i++) {
+    h ^= (unsigned char) s[i];
+    h *= UINT64_C (0x100000001b3);
+  }
+  return h;
+}
+
+/* Returns the n-th uniformly distributed random number in [0,1) of
+   the stream given by the property key and the trial number. */
+nr_double_t montecarlo::uniform (uint64_t key, int t, int n) {
+  uint64_t seed = (uint64_t) getPropertyInteger ("Seed");
+  uint64_t z = mc_mix (seed + UINT64_C (0x9e3779b97f4a7c15));
+  z = mc_mix (z ^ key);
+  z = mc_mix (z + (uint64_t) t * UINT64_C (0x9e3779b97f4a7c15));
+  z = mc_mix (z + (uint64_t) n);
+  return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Returns a normally distributed random number of the stream given by
+   the property key and the trial number (Box-Muller transform). */
+nr_double_t montecarlo::gauss (uint64_t key, int t) {
+  nr_double_t u1 = 1.0 - uniform (key, t, 0);
+  nr_double_t u2 = uniform (key, t, 1);
+  return std::sqrt (-2.0 * std::log (u1)) * std::cos (2.0 * pi * u2);
+}
+
+/* Initializes the Monte Carlo analysis.  Collects the toleranced
+   component properties of the netlist. */
+int montecarlo::initialize (void) {
+  static const char suffix[] = ".Tol";
+  size_t len = sizeof (suffix) - 1;
+
+  trial = std::string (getName ()) + ".trial";
+  targets.clear ();
+  for (circuit * c = subnet->getRoot (); c != NULL; c = c->getNext ()) {
+    properties & props = c->getProperties ();
+    for (auto it = props.begin (); it != props.end (); ++it) {
+      const std::string & key = it->first;
+      if (key.size () <= len || key.compare (key.size () - len, len, suffix))
+	continue;
+      std::string name = key.substr (0, key.size () - len);
+      auto p = props.find (name);
+      if (p == props.end ()) continue;
+      mctarget t;
+      t.c = c;
+      t.name = name;
+      t.prop = &p->second;
+      t.tol = it->second.getDouble ();
+      const char * dist = c->getPropertyString (name + ".Dist");
+      t.gauss = dist == NULL || strcmp (dist, "uniform");
+      t.key = mc_hash (std::string (c->getName ()) + "." + name);
+      t.save = NULL;
+      targets.push_back (t);
+    }
+  }
+  if (targets.empty ()) {
+    logprint (LOG_ERROR, "WARNING: %s: no toleranced component properties "
+	      "found\n", getName ());
+  }
+
+  // also run initialize functionality for all children
+  if (actions != nullptr) {
+    for (auto *a : *actions) {
+      a->initialize ();
+      a->setProgress (false);
+    }
+  }
+  return 0;
+}
+
+/* Cleans the Monte Carlo analysis up. */
+int montecarlo::cleanup (void) {
+  restore ();
+  targets.clear ();
+  stats.clear ();
+
+  // also run cleanup functionality for all children
+  if (actions != nullptr)
+    for (auto *a : *actions)
+      a->cleanup ();
+
+  return 0;
+}
+
+/* Applies the randomly varied property values of the given trial. */
+void montecarlo::sample (int t) {
+  for (auto & tg : targets) {
+    nr_double_t d;
+    if (tg.gauss)
+      d = gauss (tg.key, t) * tg.tol / 3.0;
+    else
+      d = (2.0 * uniform (tg.key, t, 0) - 1.0) * tg.tol;
+    tg.prop->setFactor (1.0 + d);
+  }
+}
+
+/* Restores the nominal values of the varied properties. */
+void montecarlo::restore (void) {
+  for (auto & tg : targets) tg.prop->setFactor (1.0);
+}
+
+/* Saves the trial number and the varied property values. */
+void montecarlo::saveResults (int t) {
+  qucs::vector * v;
+  if ((v = data->findDependency (trial.c_str ())) == NULL) {
+    v = new qucs::vector (trial);
+    v->setOrigin (getName ());
+    data->addDependency (v);
+  }
+  v->add (t + 1);
+  for (auto & tg : targets) {
+    if (tg.save == NULL) {
+      std::string n = std::string (getName ()) + "." + tg.c->getName () +
+	"." + tg.name;
+      tg.save = new qucs::vector (n);
+      tg.save->setDependencies (new strlist ());
+      tg.save->getDependencies()->add (trial.c_str ());
+      tg.save->setOrigin (getName ());
+      data->addVariable (tg.save);
+    }
+    tg.save->add (tg.prop->getDouble ());
+  }
+}
+
+/* Feeds the results of the last trial into the statistics.  Returns
+   non-zero if the specification has been met. */
+int montecarlo::collect (void) {
+  bool save = !strcmp (getPropertyString ("Save"), "yes");
+  const char * spec = isPropertyGiven ("Spec") ?
+    getPropertyString ("Spec") : NULL;
+  nr_double_t lo = getPropertyDouble ("Min");
+  nr_double_t hi = getPropertyDouble ("Max");
+  bool minGiven = isPropertyGiven ("Min");
+  bool maxGiven = isPropertyGiven ("Max");
+  int pass = 1;
+
+  ptrlist<analysis> * lastorder = subnet->findLastOrderChildren (this);
+  qucs::vector * v, * next;
+  for (v = data->getVariables (); v != NULL; v = next) {
+    next = (qucs::vector *) v->getNext ();
+    const char * origin = v->getOrigin ();
+    if (origin == NULL || created.count (v->getName ())) continue;
+    bool child = false;
+    for (auto *a : *lastorder)
+      if (!strcmp (a->getName (), origin)) child = true;
+    if (!child) continue;
+
+    // first trial of the vector
+    auto it = stats.find (v->getName ());
+    if (it == stats.end ()) {
+      mcstat s;
+      s.origin = origin;
+      s.size = 0;
+      s.n = 0;
+      strlist * deps = v->getDependencies ();
+      for (int i = 0; deps && i < deps->length (); i++)
+	if (trial != deps->get (i)) s.deps.push_back (deps->get (i));
+      it = stats.insert (std::make_pair (std::string (v->getName ()), s)).first;
+    }
+    mcstat & s = it->second;
+
+    // running mean and deviation of each value (Welford)
+    int count = v->getSize () - s.size;
+    if (s.n == 0) {
+      s.mean.assign (count, 0.0);
+      s.m2.assign (count, 0.0);
+    }
+    if ((int) s.mean.size () == count) {
+      s.n++;
+      for (int j = 0; j < count; j++) {
+	nr_complex_t x = v->get (s.size + j);
+	nr_complex_t d = x - s.mean[j];
+	s.mean[j] += d / (nr_double_t) s.n;
+	s.m2[j] += real (conj (d) * (x - s.mean[j]));
+      }
+    }
+    else {
+      logprint (LOG_ERROR, "WARNING: %s: varying number of values in `%s', "
+		"statistics skipped\n", getName (), v->getName ());
+    }
+
+    // check the specification
+    if (spec && !strcmp (spec, v->getName ())) {
+      for (int j = 0; j < count; j++) {
+	nr_complex_t x = v->get (s.size + j);
+	nr_double_t y = imag (x) == 0.0 ? real (x) : abs (x);
+	if ((minGiven && y < lo) || (maxGiven && y > hi)) pass = 0;
+      }
+    }
+
+    // keep or drop the results of the trial
+    if (save) {
+      s.size = v->getSize ();
+      strlist * deps = v->getDependencies ();
+      if (deps == NULL) {
+	deps = new strlist ();
+	v->setDependencies (deps);
+      }
+      if (!deps->contains (trial.c_str ())) deps->append (trial.c_str ());
+    }
+    else {
+      data->delVariable (v);
+    }
+  }
+  return pass;
+}
+
+/* Saves the statistics of all result vectors and the yield. */
+void montecarlo::saveStatistics (int passed) {
+  for (auto & it : stats) {
+    mcstat & s = it.second;
+    if (s.n == 0) continue;
+    const char * suffix[] = { ".mean", ".sigma" };
+    for (int k = 0; k < 2; k++) {
+      std::string n = it.first + suffix[k];
+      qucs::vector * v;
+      if ((v = data->findVariable (n)) == NULL) {
+	v = new qucs::vector (n);
+	if (!s.deps.empty ()) {
+	  v->setDependencies (new strlist ());
+	  for (auto & d : s.deps) v->getDependencies()->append (d.c_str ());
+	}
+	v->setOrigin (s.origin.c_str ());
+	data->addVariable (v);
+	created.insert (n);
+      }
+      for (size_t j = 0; j < s.mean.size (); j++) {
+	if (k == 0)
+	  v->add (s.mean[j]);
+	else
+	  v->add (s.n > 1 ? std::sqrt (s.m2[j] / (s.n - 1)) : 0.0);
+      }
+    }
+  }
+
+  // yield against the specification
+  if (isPropertyGiven ("Spec")) {
+    auto it = stats.find (getPropertyString ("Spec"));
+    if (it == stats.end ()) {
+      logprint (LOG_ERROR, "WARNING: %s: no such result `%s' for the yield "
+		"specification\n", getName (), getPropertyString ("Spec"));
+      return;
+    }
+    std::string n = std::string (getName ()) + ".yield";
+    qucs::vector * v;
+    if ((v = data->findVariable (n)) == NULL) {
+      v = new qucs::vector (n);
+      v->setOrigin (it->second.origin.c_str ());
+      data->addVariable (v);
+      created.insert (n);
+    }
+    v->add ((nr_double_t) passed / getPropertyInteger ("Trials"));
+  }
+}
+
+/* Runs the trials from 'first' up to (excluding) 'last'.  Returns the
+   number of trials meeting the specification. */
+int montecarlo::runTrials (int first, int last, int & err) {
+  int passed = 0;
+  for (int t = first; t < last; t++) {
+    // report progress
+    reportProgress (t - first, last - first);
+    // vary the toleranced properties
+    sample (t);
+#if DEBUG
+    logprint (LOG_STATUS, "NOTIFY: %s: running netlist for trial %d\n",
+	      getName (), t + 1);
+#endif
+    for (auto *a : *actions) err |= a->solve ();
+    passed += collect ();
+  }
+  restore ();
+  return passed;
+}
+
+/* Returns the number of processes the given trials are shared by. */
+int montecarlo::workers (int trials) {
+#if MC_WORKERS
+  int n = getPropertyInteger ("Workers");
+  if (n <= 0) n = std::thread::hardware_concurrency ();
+  return std::max (1, std::min (n, trials));
+#else
+  return 1;
+#endif
+}
+
+// Writes raw values into the stream of a worker.
+template <class T>
+static void mc_put (FILE * f, const T * p, int n) {
+  if (n > 0) fwrite (p, sizeof (T), n, f);
+}
+
+static void mc_put (FILE * f, int n) {
+  mc_put (f, &n, 1);
+}
+
+static void mc_put (FILE * f, const std::string & s) {
+  mc_put (f, (int) s.size ());
+  mc_put (f, s.data (), s.size ());
+}
+
+// Reads raw values from the stream of a worker.
+template <class T>
+static bool mc_get (FILE * f, T * p, int n) {
+  return n <= 0 || fread (p, sizeof (T), n, f) == (size_t) n;
+}
+
+static bool mc_get (FILE * f, int & n) {
+  return mc_get (f, &n, 1);
+}
+
+static bool mc_get (FILE * f, std::string & s) {
+  int n;
+  if (!mc_get (f, n) || n < 0) return false;
+  s.resize (n);
+  return mc_get (f, &s[0], n);
+}
+
+/* Starts a worker process running the trials from 'first' up to
+   (excluding) 'last'.  Returns the stream its results are read from,
+   or NULL if no process could be started. */
+FILE * montecarlo::spawn (int first, int last, int & pid) {
+#if MC_WORKERS
+  int fd[2];
+  if (pipe (fd) != 0) return NULL;
+  fflush (NULL);
+  if ((pid = fork ()) < 0) {
+    close (fd[0]);
+    close (fd[1]);
+    return NULL;
+  }
+  if (pid > 0) {
+    close (fd[1]);
+    return fdopen (fd[0], "rb");
+  }
+
+  // the worker, the parent reports progress and partial results
+  close (fd[0]);
+  FILE * f = fdopen (fd[1], "wb");
+  progress = false;
+  analysis_status = 0;
+  analysis_partial = NULL;
+  std::map<std::string, int> base;
+  for (auto & it : stats) base[it.first] = it.second.size;
+  int err = 0;
+  int passed = runTrials (first, last, err);
+
+  // send the statistics and the saved values of the trials
+  mc_put (f, err);
+  mc_put (f, passed);
+  mc_put (f, (int) stats.size ());
+  for (auto & it : stats) {
+    mcstat & s = it.second;
+    mc_put (f, it.first);
+    mc_put (f, s.origin);
+    mc_put (f, (int) s.deps.size ());
+    for (auto & d : s.deps) mc_put (f, d);
+    mc_put (f, s.n);
+    mc_put (f, (int) s.mean.size ());
+    mc_put (f, s.mean.data (), s.mean.size ());
+    mc_put (f, s.m2.data (), s.m2.size ());
+    qucs::vector * v = data->findVariable (it.first);
+    int from = base.count (it.first) ? base[it.first] : 0;
+    int count = v && v->getSize () > from ? v->getSize () - from : 0;
+    mc_put (f, count);
+    for (int j = 0; j < count; j++) {
+      nr_complex_t x = v->get (from + j);
+      mc_put (f, &x, 1);
+    }
+  }
+  fclose (f);
+  _exit (0);
+#else
+  (void) first;
+  (void) last;
+  (void) pid;
+  return NULL;
+#endif
+}
+
+/* Merges the results sent by a worker into the statistics and the
+   saved result vectors.  Returns the number of trials meeting the
+   specification, or -1 if the results are incomplete. */
+int montecarlo::receive (FILE * f, int & err) {
+  int werr, passed, n;
+  if (!mc_get (f, werr) || !mc_get (f, passed) || !mc_get (f, n))
+    return -1;
+  err |= werr;
+  bool save = !strcmp (getPropertyString ("Save"), "yes");
+  for (int i = 0; i < n; i++) {
+    mcstat w;
+    std::string name;
+    int ndeps, size, count;
+    if (!mc_get (f, name) || !mc_get (f, w.origin) || !mc_get (f, ndeps))
+      return -1;
+    w.deps.resize (ndeps > 0 ? ndeps : 0);
+    for (auto & d : w.deps) if (!mc_get (f, d)) return -1;
+    if (!mc_get (f, w.n) || !mc_get (f, size) || size < 0) return -1;
+    w.mean.resize (size);
+    w.m2.resize (size);
+    if (!mc_get (f, w.mean.data (), size) || !mc_get (f, w.m2.data (), size))
+      return -1;
+    if (!mc_get (f, count) || count < 0) return -1;
+    std::vector<nr_complex_t> values (count);
+    if (!mc_get (f, values.data (), count)) return -1;
+
+    // combine mean and deviation of both parts (Chan et al.)
+    auto it = stats.find (name);
+    if (it == stats.end ()) {
+      w.size = 0;
+      w.n = 0;
+      it = stats.insert (std::make_pair (name, w)).first;
+    }
+    mcstat & s = it->second;
+    if (s.n == 0) {
+      s.n = w.n;
+      s.mean = w.mean;
+      s.m2 = w.m2;
+    }
+    else if (w.n > 0 && s.mean.size () == w.mean.size ()) {
+      nr_double_t na = s.n, nb = w.n, nn = na + nb;
+      for (size_t j = 0; j < s.mean.size (); j++) {
+	nr_complex_t d = w.mean[j] - s.mean[j];
+	s.mean[j] += d * nb / nn;
+	s.m2[j] += w.m2[j] + norm (d) * na * nb / nn;
+      }
+      s.n += w.n;
+    }
+    else if (w.n > 0) {
+      logprint (LOG_ERROR, "WARNING: %s: varying number of values in `%s', "
+		"statistics skipped\n", getName (), name.c_str ());
+    }
+
+    // append the saved values of the trials
+    if (save && count > 0) {
+      qucs::vector * v;
+      if ((v = data->findVariable (name)) == NULL) {
+	v = new qucs::vector (name);
+	v->setDependencies (new strlist ());
+	for (auto & d : s.deps) v->getDependencies()->append (d.c_str ());
+	v->getDependencies()->append (trial.c_str ());
+	v->setOrigin (s.origin.c_str ());
+	data->addVariable (v);
+      }
+      for (auto & x : values) v->add (x);
+      s.size = v->getSize ();
+    }
+  }
+  return passed;
+}
+
+/* This is the Monte Carlo analysis solver. */
+int montecarlo::solve (void) {
+  int err = 0;
+  runs++;
+
+  int trials = getPropertyInteger ("Trials");
+  bool save = !strcmp (getPropertyString ("Save"), "yes");
+  int passed = 0;
+
+  // statistics start over for each run
+  for (auto & it : stats) {
+    it.second.n = 0;
+    it.second.mean.clear ();
+    it.second.m2.clear ();
+  }
+
+  // save the varied values of all trials
+  if (runs == 1 && save) {
+    for (int t = 0; t < trials; t++) {
+      sample (t);
+      saveResults (t);
+    }
+    restore ();
+  }
+
+  // share the trials among the worker processes, the first part is
+  // run by this process and so is any part no process is left for
+  int n = workers (trials);
+  std::vector<FILE *> streams (n, (FILE *) NULL);
+  std::vector<int> pids (n, 0);
+  for (int i = 1; i < n; i++) {
+    streams[i] = spawn (trials * i / n, trials * (i + 1) / n, pids[i]);
+    if (streams[i] == NULL) break;
+  }
+
+  // collect the results in the order of the trials
+  for (int i = 0; i < n; i++) {
+    if (streams[i] == NULL) {
+      passed += runTrials (trials * i / n, trials * (i + 1) / n, err);
+      continue;
+    }
+    int p = receive (streams[i], err);
+    fclose (streams[i]);
+#if MC_WORKERS
+    int status;
+    waitpid (pids[i], &status, 0);
+#endif
+    if (p < 0) {
+      logprint (LOG_ERROR, "ERROR: %s: worker process %d failed\n",
+		getName (), i);
+      err++;
+    }
+    else passed += p;
+  }
+  saveStatistics (passed);
+
+  // clear progress bar
+  if (progress) logprogressclear (40);
+  return err;
+}
+
+// properties
+PROP_REQ [] = {
+  { "Sim", PROP_STR, { PROP_NO_VAL, "DC1" }, PROP_NO_RANGE },
+  PROP_NO_PROP };
+PROP_OPT [] = {
+  { "Trials", PROP_INT, { 100, PROP_NO_STR }, PROP_MIN_VAL (1) },
+  { "Seed", PROP_INT, { 1, PROP_NO_STR }, PROP_POS_RANGE },
+  { "Workers", PROP_INT, { 0, PROP_NO_STR }, PROP_POS_RANGE },
+  { "Save", PROP_STR, { PROP_NO_VAL, "yes" }, PROP_RNG_YESNO },
+  { "Spec", PROP_STR, { PROP_NO_VAL, "none" }, PROP_NO_RANGE },
+  { "Min", PROP_REAL, { 0, PROP_NO_STR }, PROP_NO_RANGE },
+  { "Max", PROP_REAL, { 0, PROP_NO_STR }, PROP_NO_RANGE },
+  PROP_NO_PROP };
+struct define_t montecarlo::anadef =
+  { "MC", 0, PROP_ACTION, PROP_NO_SUBSTRATE, PROP_LINEAR, PROP_DEF };
+
+} // namespace qucs
@@ -0,0 +1,93 @@
+/*
+ * montecarlo.h - Monte Carlo analysis class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __MONTECARLO_H__
+#define __MONTECARLO_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+namespace qucs {
+
+class analysis;
+class circuit;
+class property;
+
+/* A component property varied by the Monte Carlo analysis. */
+struct mctarget {
+  circuit * c;          // component carrying the property
+  std::string name;     // name of the varied property
+  property * prop;      // the varied property itself
+  nr_double_t tol;      // relative tolerance
+  bool gauss;           // gaussian or uniform distribution
+  uint64_t key;         // hash of the full property name
+  vector * save;        // sampled values
+};
+
+/* Streaming statistics of a single result vector. */
+struct mcstat {
+  std::string origin;              // analysis producing the vector
+  std::vector<std::string> deps;   // dependencies besides the trials
+  int size;                        // values consumed so far
+  int n;                           // number of trials
+  std::vector<nr_complex_t> mean;  // running mean
+  std::vector<nr_double_t> m2;     // sum of squared deviations
+};
+
+class montecarlo : public analysis
+{
+ public:
+  ACREATOR (montecarlo);
+  montecarlo (char *);
+  montecarlo (montecarlo &);
+  ~montecarlo ();
+  int  initialize (void);
+  int  solve (void);
+  int  cleanup (void);
+
+ private:
+  void sample (int);
+  void restore (void);
+  void saveResults (int);
+  int  collect (void);
+  int  runTrials (int, int, int &);
+  int  workers (int);
+  FILE * spawn (int, int, int &);
+  int  receive (FILE *, int &);
+  void saveStatistics (int);
+  nr_double_t uniform (uint64_t, int, int);
+  nr_double_t gauss (uint64_t, int);
+
+ private:
+  std::vector<mctarget> targets;
+  std::map<std::string, mcstat> stats;
+  std::set<std::string> created;
+  std::string trial;
+};
+
+} // namespace qucs
+
+#endif /* __MONTECARLO_H__ */
@@ -36,6 +36,7 @@
 #include <float.h>
 #include <assert.h>
 #include <limits>
+#include <algorithm>
 
 #include "logging.h"
 #include "complex.h"
@@ -74,6 +75,8 @@ nasolver<nr_type_t>::nasolver () : analysis ()
     eqnAlgo = ALGO_LU_DECOMPOSITION;
     updateMatrix = 1;
     gMin = srcFactor = 0;
+    sweepParent = NULL;
+    sweepValue = 0;
     eqns = new eqnsys<nr_type_t> ();
 }
 
@@ -90,6 +93,8 @@ nasolver<nr_type_t>::nasolver (const std::string &n) : analysis (n)
     eqnAlgo = ALGO_LU_DECOMPOSITION;
     updateMatrix = 1;
     gMin = srcFactor = 0;
+    sweepParent = NULL;
+    sweepValue = 0;
     eqns = new eqnsys<nr_type_t> ();
 }
 
@@ -131,6 +136,8 @@ nasolver<nr_type_t>::nasolver (nasolver & o) : analysis (o)
     srcFactor = o.srcFactor;
     eqns = new eqnsys<nr_type_t> (*(o.eqns));
     solution = nasolution<nr_type_t> (o.solution);
+    sweepParent = NULL;
+    sweepValue = 0;
 }
 
 /* The function runs the nodal analysis solver once, reports errors if
@@ -1312,6 +1319,99 @@ void nasolver<nr_type_t>::recallSolution (void)
     }
 }
 
+/* The function is called by a parameter sweep before each of its
+   points.  The solutions of previous points are dropped when a new
+   sweep starts. */
+template <class nr_type_t>
+void nasolver<nr_type_t>::setSweepPoint (analysis * sweep, nr_double_t v,
+                                         bool first)
+{
+    sweepParent = sweep;
+    sweepValue = v;
+    if (first)
+    {
+        sweepSolutions.clear ();
+        sweepValues.clear ();
+    }
+}
+
+/* The function drops the solutions of previous sweep points, thus the
+   next solve starts from scratch. */
+template <class nr_type_t>
+void nasolver<nr_type_t>::resetSeeds (void)
+{
+    sweepSolutions.clear ();
+    sweepValues.clear ();
+    solution.clear ();
+}
+
+/* This function puts an initial guess for the current sweep point into
+   the stored solution.  Depending on the "sweepSeed" property the
+   solution of the previous sweep point is either used as is or
+   extrapolated (polynomially) from the last two or three points.  The
+   function returns non-zero if a guess is available. */
+template <class nr_type_t>
+int nasolver<nr_type_t>::sweepSeed (void)
+{
+    if (sweepParent == NULL || sweepSolutions.empty ()) return 0;
+    const char * const seed = getPropertyString ("sweepSeed");
+    int order = 0;
+    if (!strcmp (seed, "none"))
+        return 0;
+    else if (!strcmp (seed, "linear"))
+        order = 1;
+    else if (!strcmp (seed, "quadratic"))
+        order = 2;
+    int k = std::min (order + 1, (int) sweepSolutions.size ());
+
+    // Lagrange weights of the previous points at the current point
+    nr_double_t w[3];
+    for (int j = 0; j < k; j++)
+    {
+        w[j] = 1;
+        for (int i = 0; i < k; i++)
+        {
+            if (i == j) continue;
+            nr_double_t d = sweepValues[j] - sweepValues[i];
+            if (d == 0) { k = 1; w[0] = 1; break; }
+            w[j] *= (sweepValue - sweepValues[i]) / d;
+        }
+        if (k == 1) break;
+    }
+
+    solution = sweepSolutions[0];
+    for (auto & it : solution)
+    {
+        nr_type_t v = w[0] * it.second.value;
+        int j;
+        for (j = 1; j < k; j++)
+        {
+            auto na = sweepSolutions[j].find (it.first);
+            if (na == sweepSolutions[j].end () ||
+                (*na).second.current != it.second.current) break;
+            v += w[j] * (*na).second.value;
+        }
+        if (j == k) it.second.value = v;
+    }
+    return 1;
+}
+
+/* The function saves the converged solution of the current sweep point
+   for the subsequent points. */
+template <class nr_type_t>
+void nasolver<nr_type_t>::storeSweepPoint (void)
+{
+    if (sweepParent == NULL) return;
+    storeSolution ();
+    sweepSolutions.insert (sweepSolutions.begin (), solution);
+    sweepValues.insert (sweepValues.begin (), sweepValue);
+    if (sweepSolutions.size () > 3)
+    {
+        sweepSolutions.pop_back ();
+        sweepValues.pop_back ();
+    }
+}
+
 /* This function saves the results of a single solve() functionality
    into the output dataset. */
 template <class nr_type_t>
@@ -25,6 +25,8 @@
 #ifndef __NASOLVER_H__
 #define __NASOLVER_H__
 
+#include <vector>
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #else
@@ -69,6 +71,7 @@ public:
     void solve_post (void);
     void setDescription (const std::string &n) { desc = n; }
     std::string getDescription (void) const { return desc; }
+    int getIterations (void) { return iterations; }
     void saveResults (const std::string &, const std::string &, int, qucs::vector * f = NULL);
     typedef void (* calculate_func_t) (nasolver<nr_type_t> *);
     void setCalculation (calculate_func_t f) { calculate_func = f; }
@@ -77,6 +80,8 @@ public:
         if (calculate_func) (*calculate_func) (this);
     }
     const char * getHelperDescription (void);
+    void setSweepPoint (analysis *, nr_double_t, bool);
+    void resetSeeds (void);
 
     //interface convenience functions
     /// Returns the number of node voltages in the circuit.
@@ -101,9 +106,11 @@ protected:
     void storeSolution (void);
     void recallSolution (void);
     int  checkConvergence (void);
+    int  sweepSeed (void);
+    void storeSweepPoint (void);
+    void assignVoltageSources (void);
 
 private:
-    void assignVoltageSources (void);
     void createGMatrix (void);
     void createBMatrix (void);
     void createCMatrix (void);
@@ -127,6 +134,11 @@ protected:
     tvector<nr_type_t> * x;
     tvector<nr_type_t> * xprev;
     tvector<nr_type_t> * zprev;
+    nasolution<nr_type_t> solution;
+    analysis * sweepParent;
+    nr_double_t sweepValue;
+    std::vector< nasolution<nr_type_t> > sweepSolutions;
+    std::vector<nr_double_t> sweepValues;
     tmatrix<nr_type_t> * A;
     tmatrix<nr_type_t> * C;
     int iterations;
@@ -143,7 +155,6 @@ private:
     nr_double_t reltol;
     nr_double_t abstol;
     nr_double_t vntol;
-    nasolution<nr_type_t> solution;
 
 private:
 
@@ -62,6 +62,7 @@ net::net () : object () {
   orgacts = new ptrlist<analysis> ();
   env = NULL;
   nset = NULL;
+  nindex = NULL;
   srcFactor = 1;
 }
 
@@ -74,6 +75,7 @@ net::net (const std::string &n) : object (n) {
   orgacts = new ptrlist<analysis> ();
   env = NULL;
   nset = NULL;
+  nindex = NULL;
   srcFactor = 1;
 }
 
@@ -94,6 +96,7 @@ net::~net () {
   delete orgacts;
   // delete nodeset
   delNodeset ();
+  dropNodeIndex ();
   delete actions;
 }
 
@@ -107,6 +110,7 @@ net::net (net & n) : object (n) {
   orgacts = new ptrlist<analysis> ();
   env = n.env;
   nset = NULL;
+  nindex = NULL;
   srcFactor = 1;
 }
 
@@ -126,6 +130,14 @@ void net::insertCircuit (circuit * c) {
   c->setEnabled (1);
   c->setNet (this);
 
+  // put nodes in front of the node index
+  if (nindex) {
+    for (int i = c->getSize () - 1; i >= 0; i--) {
+      node * n = c->getNode (i);
+      (*nindex)[n->getName ()].push_front (n);
+    }
+  }
+
   /* handle AC power sources as s-parameter ports if it is not part of
      a subcircuit */
   if (c->getType () == CIR_PAC && c->getSubcircuit ().empty()) {
@@ -146,6 +158,18 @@ void net::removeCircuit (circuit * c, int dropping) {
   assert (containsCircuit (c));
 #endif
 
+  // remove nodes from the node index
+  if (nindex) {
+    for (int i = 0; i < c->getSize (); i++) {
+      node * n = c->getNode (i);
+      nodeindex::iterator it = nindex->find (n->getName ());
+      if (it != nindex->end ()) {
+	it->second.remove (n);
+	if (it->second.empty ()) nindex->erase (it);
+      }
+    }
+  }
+
   // adjust the circuit chain appropriately
   if (c == root) {
     root = (circuit *) c->getNext ();
@@ -182,6 +206,68 @@ int net::containsCircuit (circuit * cand) {
   return 0;
 }
 
+/* The function returns the circuit with the given instance name or
+   NULL if there is no such circuit in the netlist. */
+circuit * net::findCircuit (const std::string &n) {
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ())
+    if (n == c->getName ()) return c;
+  return NULL;
+}
+
+/* The function returns the named circuit if it may be changed by the
+   instance commands, i.e. if it is part of the original netlist and
+   not the ground or a helper circuit inserted by a solver.  Otherwise
+   it emits an error and returns NULL. */
+circuit * net::findInstance (const std::string &n) {
+  circuit * c = findCircuit (n);
+  if (c == NULL || !c->isOriginal ()) {
+    logprint (LOG_ERROR, "no such circuit instance `%s'\n", n.c_str ());
+    return NULL;
+  }
+  if (c->getType () == CIR_GROUND) {
+    logprint (LOG_ERROR, "cannot change the ground `%s'\n", n.c_str ());
+    return NULL;
+  }
+  return c;
+}
+
+/* This function removes the circuit with the given instance name from
+   the netlist and deletes it.  The node voltage and branch current
+   indices are assigned by the solvers for each run, thus nothing else
+   needs to be adjusted.  Returns zero on success. */
+int net::removeInstance (const std::string &n) {
+  circuit * c = findInstance (n);
+  if (c == NULL) return -1;
+  removeCircuit (c, 0);
+  delete c;
+  return 0;
+}
+
+/* The function connects the given port of the named circuit to
+   another node.  The node index is updated if there is one.  Returns
+   zero on success. */
+int net::rewireInstance (const std::string &n, int port,
+			 const std::string &to) {
+  circuit * c = findInstance (n);
+  if (c == NULL) return -1;
+  if (port < 0 || port >= c->getSize ()) {
+    logprint (LOG_ERROR, "no port %d in circuit instance `%s'\n",
+	      port, n.c_str ());
+    return -1;
+  }
+  node * nd = c->getNode (port);
+  if (nindex) {
+    nodeindex::iterator it = nindex->find (nd->getName ());
+    if (it != nindex->end ()) {
+      it->second.remove (nd);
+      if (it->second.empty ()) nindex->erase (it);
+    }
+    (*nindex)[to].push_back (nd);
+  }
+  c->setNode (port, to);
+  return 0;
+}
+
 /* This function prepends the given analysis to the list of registered
    analyses. */
 void net::insertAnalysis (analysis * a) {
@@ -237,13 +323,7 @@ dataset * net::runAnalysis (int &err) {
   dataset * out = new dataset ();
 
   // apply some data to all analyses
-  for (auto *a : *actions) {
-    if (!a->isExternal ())
-    {
-      a->setNet (this);
-      a->setData (out);
-    }
-  }
+  setActionData (actions, out);
 
   // re-order analyses
   orderAnalysis ();
@@ -426,6 +506,19 @@ node * net::findConnectedCircuitNode (node * n) {
   const char * _name = n->getName ();
   node * _node;
 
+  // lookup the node index if available
+  if (nindex) {
+    nodeindex::iterator it = nindex->find (_name);
+    if (it == nindex->end ()) return NULL;
+    for (std::list<node *>::iterator ni = it->second.begin ();
+	 ni != it->second.end (); ++ni) {
+      _node = *ni;
+      // skip signal circuits
+      if (_node != n && !_node->getCircuit()->getPort ()) return _node;
+    }
+    return NULL;
+  }
+
   // through the list of circuit objects
   for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
     // skip signal circuits
@@ -451,6 +544,17 @@ node * net::findConnectedNode (node * n) {
   const char * _name = n->getName ();
   node * _node;
 
+  // lookup the node index if available
+  if (nindex) {
+    nodeindex::iterator it = nindex->find (_name);
+    if (it == nindex->end ()) return NULL;
+    for (std::list<node *>::iterator ni = it->second.begin ();
+	 ni != it->second.end (); ++ni) {
+      if (*ni != n) return *ni;
+    }
+    return NULL;
+  }
+
   for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
     for (int i = 0; i < c->getSize (); i++) {
       _node = c->getNode (i);
@@ -464,6 +568,27 @@ node * net::findConnectedNode (node * n) {
   return NULL;
 }
 
+/* The function creates an index of all circuit nodes by name, making
+   the above node lookups constant time.  The index is kept up to date
+   when inserting and removing circuits, but must be rebuilt after
+   renaming nodes of circuits in the list. */
+void net::buildNodeIndex (void) {
+  dropNodeIndex ();
+  nindex = new nodeindex ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    for (int i = 0; i < c->getSize (); i++) {
+      node * n = c->getNode (i);
+      (*nindex)[n->getName ()].push_back (n);
+    }
+  }
+}
+
+// Deletes the node index.
+void net::dropNodeIndex (void) {
+  delete nindex;
+  nindex = NULL;
+}
+
 // Rename the given circuit and mark it as being a reduced one.
 void net::reducedCircuit (circuit * c) {
   char n[32];
@@ -565,6 +690,24 @@ void net::setActionNetAll(net  * subnet)
     a->setNet(subnet);
 }
 
+/* Applies the netlist and the given output dataset to the analyses
+   in the list and to their sub-analyses.  Once the analyses have been
+   ordered by a previous run the sub-analyses are not in the netlist's
+   list anymore. */
+void net::setActionData (ptrlist<analysis> * alist, dataset * out)
+{
+  if (alist == nullptr) return;
+  for (auto *a : *alist) {
+    if (!a->isExternal ())
+    {
+      a->setNet (this);
+      a->setData (out);
+      a->resetRuns ();
+      setActionData (a->getAnalysis (), out);
+    }
+  }
+}
+
 
 #if DEBUG
 // DEBUG function: Lists the netlist.
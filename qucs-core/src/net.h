@@ -26,6 +26,8 @@
 #define __NET_H__
 
 #include <string>
+#include <list>
+#include <unordered_map>
 #include "ptrlist.h"
 
 namespace qucs {
@@ -38,6 +40,10 @@ class analysis;
 class dataset;
 class environment;
 
+/* Index of circuit nodes by node name.  The nodes of each name are
+   kept in the order of the circuit list. */
+typedef std::unordered_map<std::string, std::list<node *> > nodeindex;
+
 
 class net : public object
 {
@@ -51,11 +57,17 @@ class net : public object
   void insertCircuit (circuit *);
   void removeCircuit (circuit *, int dropping = 1);
   int  containsCircuit (circuit *);
+  circuit * findCircuit (const std::string &);
+  circuit * findInstance (const std::string &);
+  int  removeInstance (const std::string &);
+  int  rewireInstance (const std::string &, int, const std::string &);
   int  checkCircuitChain (void);
   void list (void);
   void reducedCircuit (circuit *);
   node * findConnectedNode (node *);
   node * findConnectedCircuitNode (node *);
+  void buildNodeIndex (void);
+  void dropNodeIndex (void);
   void insertedCircuit (circuit *);
   void insertedNode (node *);
   void insertAnalysis (analysis *);
@@ -89,9 +101,11 @@ class net : public object
   void setSrcFactor (nr_double_t f) { srcFactor = f; }
   nr_double_t getSrcFactor (void) { return srcFactor; }
   void setActionNetAll(net *);
+  void setActionData (ptrlist<analysis> *, dataset *);
 
  private:
   nodeset * nset;
+  nodeindex * nindex;
   circuit * drop;
   circuit * root;
   ptrlist<analysis> * actions;
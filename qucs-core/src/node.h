@@ -25,6 +25,8 @@
 #ifndef __NODE_H__
 #define __NODE_H__
 
+#include "mempool.h"
+
 namespace qucs {
 
 class circuit;
@@ -36,6 +38,7 @@ class node : public object
   node () : object (), nNode(0), port(0), internal(0), _circuit(nullptr) {};
   //! Constructor creates a named instance of the node class.
   node (char * const n) : object (n), nNode(0), port(0), internal(0), _circuit(nullptr) {};
+  MEMPOOL_OPERATORS
   //! Sets the unique number of this node
   void setNode (const int n) { this->nNode = n ; };
   //! Returns the unique number of this node.
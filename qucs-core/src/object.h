@@ -79,6 +79,8 @@ class object
   bool hasProperty (const std::string &n) const ;
   bool isPropertyGiven (const std::string &n) const;
   int  countProperties (void) const;
+  //! Returns the properties of the object.
+  properties & getProperties (void) { return props; }
   const char *
     propertyList (void) const;
 
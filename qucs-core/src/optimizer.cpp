@@ -0,0 +1,819 @@
+/*
+ * optimizer.cpp - optimization class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+/* The optimization runs its child analyses repeatedly while adjusting
+   a set of variables until the goals for the results are met best.
+   The variables and goals are declared on the optimization itself,
+   e.g.
+
+     .OPT:Opt1 Sim="DC1" R1_val.Min="100" R1_val.Max="10k" \
+       R1_val.Init="1k" out.V.Goal="EQ" out.V.Value="2.5"
+
+   The variables are used in the netlist like parameter sweep
+   variables.  The goals name result vectors of the child analyses or
+   equations depending on them, these equations are solved on the
+   results of each evaluation.  A goal not found in the results at the
+   initial values is an error.
+   'MIN' and 'MAX' minimize or maximize the result, 'LE', 'GE' and
+   'EQ' constrain it with respect to the given value and 'MON' just
+   records it.  For results with more than one value the worst one
+   counts.  The cost is the sum of the minimized results plus the sum
+   of the relative constraint violations weighted by 'Penalty'.
+
+   A variable is searched on a linear scale by default.  With
+   'Var.Type' set to "LOG_DOUBLE" it is searched on a logarithmic
+   scale, "LIN_INT" and "LOG_INT" round it to integers and "E3" up to
+   "E192" to the values of the standard series.
+
+   The netlist stays parsed and set up during the whole optimization,
+   each evaluation only updates the variables in the environment and
+   reruns the child analyses.  The search is a differential evolution
+   with the strategy 'Method' (DE/rand/1/bin by default), the usual
+   population size 'Population', differential weight 'F' and
+   crossover probability 'CR'.  It stops after 'Iterations'
+   generations or once the costs of the population differ by less
+   than 'Tolerance'.  Finally the child analyses are run once more
+   with the best variables found, their results are saved along with
+   the variables and the cost.
+
+   The members of a generation are independent of each other.  They
+   are shared among 'Workers' processes (all processors by default),
+   each evaluating them on its own copy of the netlist. */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+#include <set>
+#include <thread>
+
+#if HAVE_FORK && HAVE_SYS_WAIT_H
+# include <signal.h>
+# include <unistd.h>
+# include <sys/wait.h>
+# define OPT_WORKERS 1
+#endif
+
+#include "logging.h"
+#include "complex.h"
+#include "object.h"
+#include "vector.h"
+#include "strlist.h"
+#include "dataset.h"
+#include "net.h"
+#include "netdefs.h"
+#include "ptrlist.h"
+#include "analysis.h"
+#include "variable.h"
+#include "environment.h"
+#include "optimizer.h"
+
+using namespace qucs::eqn;
+
+namespace qucs {
+
+// Cost of evaluations which failed.
+#define OPT_COST_FAIL 1e300
+
+/* Differential evolution strategies, numbered as in ASCO.  The first
+   five use exponential crossover, the others binomial crossover. */
+static const char * opt_methods[] = {
+  "DE/best/1/exp", "DE/rand/1/exp", "DE/rand-to-best/1/exp",
+  "DE/best/2/exp", "DE/rand/2/exp", "DE/best/1/bin", "DE/rand/1/bin",
+  "DE/rand-to-best/1/bin", "DE/best/2/bin", "DE/rand/2/bin", NULL };
+
+// Number of random members used by the mutation of each strategy.
+static const int opt_randoms[] = { 2, 3, 2, 4, 5 };
+
+// Values of the E24 series, the E12, E6 and E3 series are subsets.
+static const nr_double_t opt_e24[] = {
+  1.0, 1.1, 1.2, 1.3, 1.5, 1.6, 1.8, 2.0, 2.2, 2.4, 2.7, 3.0,
+  3.3, 3.6, 3.9, 4.3, 4.7, 5.1, 5.6, 6.2, 6.8, 7.5, 8.2, 9.1 };
+
+/* Returns the i-th value of the E series with n values per decade.
+   The series from E48 on follow the formula, with a single
+   exception in E192. */
+static nr_double_t opt_series_value (int i, int n) {
+  if (n <= 24) return opt_e24[i * 24 / n];
+  if (n == 192 && i == 185) return 9.2;
+  return std::round (100 * std::pow (10.0, (nr_double_t) i / n)) / 100;
+}
+
+// Rounds the given positive value to the nearest value of an E series.
+static nr_double_t opt_series (nr_double_t x, int n) {
+  nr_double_t e = std::pow (10.0, std::floor (std::log10 (x)));
+  nr_double_t m = x / e, best = 10.0;
+  for (int i = 0; i < n; i++) {
+    nr_double_t v = opt_series_value (i, n);
+    if (std::fabs (std::log (m / v)) < std::fabs (std::log (m / best)))
+      best = v;
+  }
+  return best * e;
+}
+
+// Constructor creates an unnamed instance of the optimizer class.
+optimizer::optimizer () : analysis () {
+  type = ANALYSIS_SWEEP;
+  method = 6;
+  evaluations = 0;
+}
+
+// Constructor creates a named instance of the optimizer class.
+optimizer::optimizer (char * n) : analysis (n) {
+  type = ANALYSIS_SWEEP;
+  method = 6;
+  evaluations = 0;
+}
+
+// Destructor deletes the optimizer class object.
+optimizer::~optimizer () {
+}
+
+/* The copy constructor creates a new instance of the optimizer class
+   based on the given optimizer object. */
+optimizer::optimizer (optimizer & o) : analysis (o) {
+  vars = o.vars;
+  goals = o.goals;
+  method = o.method;
+  evaluations = 0;
+}
+
+// Short macro in order to obtain the correct equation node.
+#define E(equ) ((eqn::node *) (equ))
+
+/* Initializes the optimization.  Collects the variables and goals
+   and puts the variables into the environment. */
+int optimizer::initialize (void) {
+  static const char * types[] = { "MIN", "MAX", "LE", "GE", "EQ", "MON" };
+  int err = 0;
+
+  vars.clear ();
+  goals.clear ();
+  properties & props = getProperties ();
+  for (auto it = props.begin (); it != props.end (); ++it) {
+    const std::string & key = it->first;
+    size_t dot = key.rfind ('.');
+    if (dot == std::string::npos || dot == 0) continue;
+    std::string name = key.substr (0, dot);
+    std::string suffix = key.substr (dot + 1);
+
+    if (suffix == "Goal") {
+      optgoal g;
+      g.name = name;
+      g.type = OPT_GOAL_MIN;
+      for (int i = 0; i < 6; i++)
+	if (!strcmp (it->second.getString (), types[i])) g.type = i;
+      auto v = props.find (name + ".Value");
+      g.value = v != props.end () ? v->second.getDouble () : 0;
+      goals.push_back (g);
+    }
+    else if (suffix == "Min") {
+      optvar v;
+      v.name = name;
+      v.min = it->second.getDouble ();
+      auto p = props.find (name + ".Max");
+      if (p == props.end ()) {
+	logprint (LOG_ERROR, "ERROR: %s: no upper bound `%s.Max' given\n",
+		  getName (), name.c_str ());
+	err++;
+	continue;
+      }
+      v.max = p->second.getDouble ();
+      p = props.find (name + ".Init");
+      v.hasInit = p != props.end ();
+      v.init = v.hasInit ? p->second.getDouble () : (v.min + v.max) / 2;
+      if (v.min >= v.max) {
+	logprint (LOG_ERROR, "ERROR: %s: invalid range [%g,%g] of `%s'\n",
+		  getName (), (double) v.min, (double) v.max, name.c_str ());
+	err++;
+	continue;
+      }
+
+      // the type of the variable gives the scale of the search
+      p = props.find (name + ".Type");
+      const char * type = p != props.end () ? p->second.getString () :
+	"LIN_DOUBLE";
+      v.series = 0;
+      if (!strcmp (type, "LIN_DOUBLE"))
+	v.type = OPT_VAR_LIN_DOUBLE;
+      else if (!strcmp (type, "LOG_DOUBLE"))
+	v.type = OPT_VAR_LOG_DOUBLE;
+      else if (!strcmp (type, "LIN_INT"))
+	v.type = OPT_VAR_LIN_INT;
+      else if (!strcmp (type, "LOG_INT"))
+	v.type = OPT_VAR_LOG_INT;
+      else if (type[0] == 'E' && strchr ("123456789", type[1])) {
+	v.type = OPT_VAR_SERIES;
+	v.series = atoi (type + 1);
+      }
+      else v.type = -1;
+      if (v.type == OPT_VAR_SERIES && v.series != 3 && v.series != 6 &&
+	  v.series != 12 && v.series != 24 && v.series != 48 &&
+	  v.series != 96 && v.series != 192)
+	v.type = -1;
+      if (v.type < 0) {
+	logprint (LOG_ERROR, "ERROR: %s: invalid type `%s' of `%s'\n",
+		  getName (), type, name.c_str ());
+	err++;
+	continue;
+      }
+      if (v.type != OPT_VAR_LIN_DOUBLE && v.type != OPT_VAR_LIN_INT) {
+	if (v.min <= 0) {
+	  logprint (LOG_ERROR, "ERROR: %s: logarithmic range [%g,%g] of `%s' "
+		    "must be positive\n", getName (), (double) v.min,
+		    (double) v.max, name.c_str ());
+	  err++;
+	  continue;
+	}
+	v.lo = std::log (v.min);
+	v.hi = std::log (v.max);
+      }
+      else {
+	v.lo = v.min;
+	v.hi = v.max;
+      }
+      v.eqn = NULL;
+      v.save = NULL;
+      vars.push_back (v);
+    }
+    else if (suffix == "Max" || suffix == "Init" || suffix == "Type") {
+      if (props.find (name + ".Min") == props.end ()) {
+	logprint (LOG_ERROR, "ERROR: %s: no lower bound `%s.Min' given\n",
+		  getName (), name.c_str ());
+	err++;
+      }
+    }
+  }
+
+  // keep the order independent of the property storage
+  std::sort (vars.begin (), vars.end (),
+	     [](const optvar & a, const optvar & b) { return a.name < b.name; });
+  std::sort (goals.begin (), goals.end (),
+	     [](const optgoal & a, const optgoal & b) { return a.name < b.name; });
+
+  if (vars.empty ()) {
+    logprint (LOG_ERROR, "ERROR: %s: no optimization variables given\n",
+	      getName ());
+    err++;
+  }
+  if (goals.empty ()) {
+    logprint (LOG_ERROR, "WARNING: %s: no optimization goals given\n",
+	      getName ());
+  }
+
+  // the strategy of the differential evolution
+  const char * m = getPropertyString ("Method");
+  for (method = 0; opt_methods[method]; method++)
+    if (!strcmp (opt_methods[method], m)) break;
+  if (opt_methods[method] == NULL) {
+    logprint (LOG_ERROR, "ERROR: %s: unknown method `%s'\n", getName (), m);
+    method = 6;
+    err++;
+  }
+  if (getPropertyInteger ("Population") <= opt_randoms[method % 5]) {
+    logprint (LOG_ERROR, "ERROR: %s: method `%s' needs a population of "
+	      "at least %d\n", getName (), m, opt_randoms[method % 5] + 1);
+    err++;
+  }
+
+  // put the variables into the environment and equation checker
+  for (auto & v : vars) {
+    const char * n = v.name.c_str ();
+    if (env->getVariable (n) == NULL) {
+      variable * var = new variable (n);
+      var->setConstant (new constant (TAG_DOUBLE));
+      env->addVariable (var);
+    }
+    if (!env->getChecker()->containsVariable (n)) {
+      v.eqn = env->getChecker()->addDouble ("#optimization", n, v.init);
+    }
+    env->setDoubleConstant (n, v.init);
+    env->setDouble (n, v.init);
+  }
+
+  // also run initialize functionality for all children
+  if (actions != nullptr) {
+    for (auto *a : *actions) {
+      a->initialize ();
+      a->setProgress (false);
+    }
+  }
+  return err;
+}
+
+/* Cleans the optimization up. */
+int optimizer::cleanup (void) {
+
+  // remove additional equations from equation checker
+  for (auto & v : vars) {
+    if (v.eqn) {
+      env->getChecker()->dropEquation (E (v.eqn));
+      delete E (v.eqn);
+      v.eqn = NULL;
+    }
+  }
+
+  // also run cleanup functionality for all children
+  if (actions != nullptr)
+    for (auto *a : *actions)
+      a->cleanup ();
+
+  return 0;
+}
+
+// Returns a uniformly distributed random number in [0,1).
+nr_double_t optimizer::random (void) {
+  return std::uniform_real_distribution<nr_double_t> (0, 1) (rng);
+}
+
+/* Returns the value of the given variable at the given coordinate of
+   the search. */
+nr_double_t optimizer::value (const optvar & v, nr_double_t u) {
+  switch (v.type) {
+  case OPT_VAR_LOG_DOUBLE:
+    return std::exp (u);
+  case OPT_VAR_LIN_INT:
+    return std::round (u);
+  case OPT_VAR_LOG_INT:
+    return std::round (std::exp (u));
+  case OPT_VAR_SERIES:
+    return opt_series (std::exp (u), v.series);
+  }
+  return u;
+}
+
+/* Sets the variables to the values at the given coordinates in the
+   environment and the equation checker and runs the equation
+   solver. */
+void optimizer::setValues (const std::vector<nr_double_t> & x) {
+  for (size_t i = 0; i < vars.size (); i++) {
+    nr_double_t d = value (vars[i], x[i]);
+    env->setDoubleConstant (vars[i].name.c_str (), d);
+    env->setDouble (vars[i].name.c_str (), d);
+  }
+  env->runSolver ();
+}
+
+/* Computes the cost of the results of the last run of the child
+   analyses.  The equations the goals depend on are solved first and
+   their results dropped afterwards.  Returns non-zero if a goal
+   cannot be found. */
+int optimizer::cost (nr_double_t & c) {
+  int err = 0;
+  nr_double_t obj = 0, viol = 0;
+
+  // remember the vectors present before solving the equations
+  std::set<qucs::vector *> keep;
+  qucs::vector * v, * next;
+  for (v = data->getDependencies (); v != NULL; v = (qucs::vector *) v->getNext ())
+    keep.insert (v);
+  for (v = data->getVariables (); v != NULL; v = (qucs::vector *) v->getNext ())
+    keep.insert (v);
+  strlist names;
+  for (auto & g : goals) names.add (g.name.c_str ());
+  env->equationSolver (data, &names);
+
+  for (auto & g : goals) {
+    v = data->findVariable (g.name);
+    if (v == NULL) v = data->findDependency (g.name.c_str ());
+    if (v == NULL || v->getSize () == 0) {
+      missing = g.name;
+      err = -1;
+      continue;
+    }
+    // worst case values of the result
+    nr_double_t lo = 0, hi = 0, dev = 0;
+    for (int j = 0; j < v->getSize (); j++) {
+      nr_complex_t x = v->get (j);
+      nr_double_t y = imag (x) == 0.0 ? real (x) : abs (x);
+      if (j == 0 || y < lo) lo = y;
+      if (j == 0 || y > hi) hi = y;
+      dev = std::max (dev, (nr_double_t) std::fabs (y - g.value));
+    }
+    nr_double_t scale = g.value != 0 ? std::fabs (g.value) : 1;
+    switch (g.type) {
+    case OPT_GOAL_MIN:
+      obj += hi;
+      break;
+    case OPT_GOAL_MAX:
+      obj -= lo;
+      break;
+    case OPT_GOAL_LE:
+      viol += std::max ((nr_double_t) 0, hi - g.value) / scale;
+      break;
+    case OPT_GOAL_GE:
+      viol += std::max ((nr_double_t) 0, g.value - lo) / scale;
+      break;
+    case OPT_GOAL_EQ:
+      viol += dev / scale;
+      break;
+    }
+  }
+
+  // drop the equation results
+  env->dropDataset ();
+  for (v = data->getDependencies (); v != NULL; v = next) {
+    next = (qucs::vector *) v->getNext ();
+    if (!keep.count (v)) data->delDependency (v);
+  }
+  for (v = data->getVariables (); v != NULL; v = next) {
+    next = (qucs::vector *) v->getNext ();
+    if (!keep.count (v)) data->delVariable (v);
+  }
+
+  c = err ? OPT_COST_FAIL : obj + getPropertyDouble ("Penalty") * viol;
+  return err;
+}
+
+/* Removes the results of the last run of the child analyses. */
+void optimizer::dropResults (void) {
+  ptrlist<analysis> * lastorder = subnet->findLastOrderChildren (this);
+  qucs::vector * v, * next;
+  for (v = data->getVariables (); v != NULL; v = next) {
+    next = (qucs::vector *) v->getNext ();
+    const char * origin = v->getOrigin ();
+    if (origin == NULL) continue;
+    for (auto *a : *lastorder) {
+      if (!strcmp (a->getName (), origin)) {
+	data->delVariable (v);
+	break;
+      }
+    }
+  }
+}
+
+/* Runs the child analyses for the given variable values and returns
+   the cost of the results.  The solvers start from scratch, thus the
+   cost does not depend on the members evaluated before. */
+nr_double_t optimizer::evaluate (const std::vector<nr_double_t> & x) {
+  int err = 0;
+  nr_double_t c = OPT_COST_FAIL;
+  evaluations++;
+  setValues (x);
+  resetSeeds ();
+  for (auto *a : *actions) err |= a->solve ();
+  if (!err) cost (c);
+  dropResults ();
+  return c;
+}
+
+/* Saves the optimized variable values and the final cost. */
+void optimizer::saveResults (const std::vector<nr_double_t> & x,
+			     nr_double_t c) {
+  for (size_t i = 0; i < vars.size (); i++) {
+    optvar & v = vars[i];
+    if (v.save == NULL) {
+      v.save = new qucs::vector (std::string (getName ()) + "." + v.name);
+      v.save->setOrigin (getName ());
+      data->addVariable (v.save);
+    }
+    v.save->add (value (v, x[i]));
+  }
+  std::string n = std::string (getName ()) + ".cost";
+  qucs::vector * v;
+  if ((v = data->findVariable (n)) == NULL) {
+    v = new qucs::vector (n);
+    v->setOrigin (getName ());
+    data->addVariable (v);
+  }
+  v->add (c);
+}
+
+/* Starts the given number of worker processes, each keeping its own
+   copy of the netlist and evaluating the members sent to it. */
+void optimizer::startWorkers (int n) {
+#if OPT_WORKERS
+  // a failing worker must not terminate the optimization
+  signal (SIGPIPE, SIG_IGN);
+  for (int i = 0; i < n; i++) {
+    int to[2], from[2];
+    if (pipe (to) != 0) break;
+    if (pipe (from) != 0) {
+      close (to[0]);
+      close (to[1]);
+      break;
+    }
+    fflush (NULL);
+    int pid = fork ();
+    if (pid < 0) {
+      close (to[0]);
+      close (to[1]);
+      close (from[0]);
+      close (from[1]);
+      break;
+    }
+    if (pid == 0) {
+      // the worker, the parent reports progress
+      close (to[1]);
+      close (from[0]);
+      for (auto & w : workers) {
+	fclose (w.to);
+	fclose (w.from);
+      }
+      progress = false;
+      analysis_status = 0;
+      analysis_partial = NULL;
+      FILE * in = fdopen (to[0], "rb");
+      FILE * out = fdopen (from[1], "wb");
+      serve (in, out);
+      fclose (in);
+      fclose (out);
+      _exit (0);
+    }
+    close (to[0]);
+    close (from[1]);
+    optworker w;
+    w.pid = pid;
+    w.to = fdopen (to[1], "wb");
+    w.from = fdopen (from[0], "rb");
+    workers.push_back (w);
+  }
+#else
+  (void) n;
+#endif
+}
+
+/* Stops the worker processes. */
+void optimizer::stopWorkers (void) {
+#if OPT_WORKERS
+  for (auto & w : workers) {
+    if (w.to == NULL) continue;
+    int n = 0;
+    fwrite (&n, sizeof (int), 1, w.to);
+    fclose (w.to);
+    fclose (w.from);
+    int status;
+    waitpid (w.pid, &status, 0);
+  }
+  workers.clear ();
+  signal (SIGPIPE, SIG_DFL);
+#endif
+}
+
+/* Evaluates the members sent by the optimization and sends back their
+   costs, until the member count zero is received. */
+void optimizer::serve (FILE * in, FILE * out) {
+  int n, nv = vars.size ();
+  while (fread (&n, sizeof (int), 1, in) == 1 && n > 0) {
+    std::vector<nr_double_t> x (n * nv), c (n);
+    if (fread (x.data (), sizeof (nr_double_t), n * nv, in) !=
+	(size_t) (n * nv))
+      return;
+    for (int i = 0; i < n; i++)
+      c[i] = evaluate (std::vector<nr_double_t> (x.begin () + i * nv,
+						 x.begin () + (i + 1) * nv));
+    fwrite (c.data (), sizeof (nr_double_t), n, out);
+    fflush (out);
+  }
+}
+
+/* Evaluates the given members and stores their costs.  The members
+   are shared among the worker processes and this one. */
+void optimizer::evaluate (const std::vector< std::vector<nr_double_t> > & x,
+			  std::vector<nr_double_t> & c) {
+  int np = x.size (), nv = vars.size (), nw = workers.size () + 1;
+
+  // send the members to the workers
+  for (int w = 1; w < nw; w++) {
+    optworker & wk = workers[w - 1];
+    int first = np * w / nw, n = np * (w + 1) / nw - first;
+    if (wk.to == NULL || n == 0) continue;
+    fwrite (&n, sizeof (int), 1, wk.to);
+    for (int i = first; i < first + n; i++)
+      fwrite (x[i].data (), sizeof (nr_double_t), nv, wk.to);
+    fflush (wk.to);
+  }
+
+  // evaluate the own part meanwhile, then collect the costs
+  for (int i = 0; i < np / nw; i++) c[i] = evaluate (x[i]);
+  for (int w = 1; w < nw; w++) {
+    optworker & wk = workers[w - 1];
+    int first = np * w / nw, n = np * (w + 1) / nw - first;
+    if (wk.to != NULL && n > 0) {
+      if (fread (&c[first], sizeof (nr_double_t), n, wk.from) ==
+	  (size_t) n) {
+	evaluations += n;
+	continue;
+      }
+      // evaluate the part here from now on
+      logprint (LOG_ERROR, "WARNING: %s: worker process %d failed\n",
+		getName (), w);
+      fclose (wk.to);
+      fclose (wk.from);
+      wk.to = wk.from = NULL;
+    }
+    for (int i = first; i < first + n; i++) c[i] = evaluate (x[i]);
+  }
+}
+
+/* Computes the mutant of the given member of the population by the
+   strategy of the optimization and crosses it over with the member
+   into the trial vector. */
+void optimizer::mutate (const std::vector< std::vector<nr_double_t> > & pop,
+			int i, int best, std::vector<nr_double_t> & trial) {
+  int np = pop.size (), nv = vars.size ();
+  nr_double_t F = getPropertyDouble ("F");
+  nr_double_t CR = getPropertyDouble ("CR");
+
+  // pick distinct members other than the current one
+  int r[5], nr = opt_randoms[method % 5];
+  for (int j = 0; j < nr; j++) {
+    bool used;
+    do {
+      r[j] = rng () % np;
+      used = r[j] == i;
+      for (int k = 0; k < j; k++) used = used || r[j] == r[k];
+    } while (used);
+  }
+
+  // the mutant
+  std::vector<nr_double_t> v (nv);
+  for (int k = 0; k < nv; k++) {
+    switch (method % 5) {
+    case 0: // best/1
+      v[k] = pop[best][k] + F * (pop[r[0]][k] - pop[r[1]][k]);
+      break;
+    case 1: // rand/1
+      v[k] = pop[r[0]][k] + F * (pop[r[1]][k] - pop[r[2]][k]);
+      break;
+    case 2: // rand-to-best/1
+      v[k] = pop[i][k] + F * (pop[best][k] - pop[i][k]) +
+	F * (pop[r[0]][k] - pop[r[1]][k]);
+      break;
+    case 3: // best/2
+      v[k] = pop[best][k] + F * (pop[r[0]][k] + pop[r[1]][k] -
+				 pop[r[2]][k] - pop[r[3]][k]);
+      break;
+    case 4: // rand/2
+      v[k] = pop[r[4]][k] + F * (pop[r[0]][k] + pop[r[1]][k] -
+				 pop[r[2]][k] - pop[r[3]][k]);
+      break;
+    }
+  }
+
+  // exponential or binomial crossover
+  trial = pop[i];
+  int k = rng () % nv;
+  if (method < 5) {
+    int n = 0;
+    do {
+      trial[k] = v[k];
+      k = (k + 1) % nv;
+    } while (++n < nv && random () < CR);
+  }
+  else {
+    for (int j = 0; j < nv; j++)
+      if (j == k || random () < CR) trial[j] = v[j];
+  }
+
+  // resample coordinates outside the bounds
+  for (int j = 0; j < nv; j++) {
+    optvar & o = vars[j];
+    if (trial[j] < o.lo || trial[j] > o.hi)
+      trial[j] = o.lo + random () * (o.hi - o.lo);
+  }
+}
+
+/* This is the optimization solver. */
+int optimizer::solve (void) {
+  int err = 0;
+  runs++;
+
+  int nv = vars.size ();
+  int np = getPropertyInteger ("Population");
+  int iterations = getPropertyInteger ("Iterations");
+  nr_double_t tol = getPropertyDouble ("Tolerance");
+  if (nv == 0) return -1;
+
+  rng.seed (getPropertyInteger ("Seed"));
+  evaluations = 0;
+
+  // initial population, the first member at the initial values
+  std::vector< std::vector<nr_double_t> > pop (np);
+  std::vector<nr_double_t> costs (np);
+  for (int i = 0; i < np; i++) {
+    pop[i].resize (nv);
+    for (int k = 0; k < nv; k++) {
+      optvar & v = vars[k];
+      if (i > 0)
+	pop[i][k] = v.lo + random () * (v.hi - v.lo);
+      else if (v.type == OPT_VAR_LIN_DOUBLE || v.type == OPT_VAR_LIN_INT)
+	pop[i][k] = v.init;
+      else
+	pop[i][k] = std::log (v.init > 0 ? v.init : v.min);
+    }
+  }
+
+  // all goals must be found in the results at the initial values
+  setValues (pop[0]);
+  resetSeeds ();
+  for (auto *a : *actions) err |= a->solve ();
+  if (!err && cost (costs[0]) != 0) {
+    logprint (LOG_ERROR, "ERROR: %s: no such result `%s' for the "
+	      "optimization goal\n", getName (), missing.c_str ());
+    dropResults ();
+    return -1;
+  }
+  dropResults ();
+  err = 0;
+
+  // the members of a generation are evaluated in parallel
+#if OPT_WORKERS
+  int nw = getPropertyInteger ("Workers");
+  if (nw <= 0) nw = std::thread::hardware_concurrency ();
+  startWorkers (std::min (nw, np) - 1);
+#endif
+  evaluate (pop, costs);
+
+  std::vector< std::vector<nr_double_t> > trials (np);
+  std::vector<nr_double_t> tcosts (np);
+  for (int g = 0; g < iterations; g++) {
+    // report progress
+    reportProgress (g, iterations);
+
+    // the trial vectors of the whole generation
+    int best = std::min_element (costs.begin (), costs.end ()) -
+      costs.begin ();
+    for (int i = 0; i < np; i++) mutate (pop, i, best, trials[i]);
+    evaluate (trials, tcosts);
+
+    // selection
+    for (int i = 0; i < np; i++) {
+      if (tcosts[i] <= costs[i]) {
+	pop[i] = trials[i];
+	costs[i] = tcosts[i];
+      }
+    }
+
+    // stop once the population has converged
+    nr_double_t lo = *std::min_element (costs.begin (), costs.end ());
+    nr_double_t hi = *std::max_element (costs.begin (), costs.end ());
+#if DEBUG
+    logprint (LOG_STATUS, "NOTIFY: %s: generation %d, best cost %g\n",
+	      getName (), g + 1, (double) lo);
+#endif
+    if (hi - lo < tol) break;
+  }
+  stopWorkers ();
+
+  // run the child analyses with the best variables found
+  int best = std::min_element (costs.begin (), costs.end ()) - costs.begin ();
+  nr_double_t c = OPT_COST_FAIL;
+  setValues (pop[best]);
+  resetSeeds ();
+  for (auto *a : *actions) err |= a->solve ();
+  if (!err) err = cost (c);
+  saveResults (pop[best], c);
+#if DEBUG
+  logprint (LOG_STATUS, "NOTIFY: %s: %d evaluations, final cost %g\n",
+	    getName (), evaluations, (double) c);
+#endif
+
+  // clear progress bar
+  if (progress) logprogressclear (40);
+  return err;
+}
+
+// properties
+PROP_REQ [] = {
+  { "Sim", PROP_STR, { PROP_NO_VAL, "DC1" }, PROP_NO_RANGE },
+  PROP_NO_PROP };
+PROP_OPT [] = {
+  { "Iterations", PROP_INT, { 50, PROP_NO_STR }, PROP_MIN_VAL (1) },
+  { "Population", PROP_INT, { 20, PROP_NO_STR }, PROP_MIN_VAL (4) },
+  { "F", PROP_REAL, { 0.85, PROP_NO_STR }, PROP_RNGXI (0, 2) },
+  { "CR", PROP_REAL, { 0.9, PROP_NO_STR }, PROP_RNGII (0, 1) },
+  { "Seed", PROP_INT, { 1, PROP_NO_STR }, PROP_POS_RANGE },
+  { "Method", PROP_STR, { PROP_NO_VAL, "DE/rand/1/bin" }, PROP_NO_RANGE },
+  { "Workers", PROP_INT, { 0, PROP_NO_STR }, PROP_POS_RANGE },
+  { "Tolerance", PROP_REAL, { 1e-6, PROP_NO_STR }, PROP_POS_RANGE },
+  { "Penalty", PROP_REAL, { 100, PROP_NO_STR }, PROP_POS_RANGE },
+  PROP_NO_PROP };
+struct define_t optimizer::anadef =
+  { "OPT", 0, PROP_ACTION, PROP_NO_SUBSTRATE, PROP_LINEAR, PROP_DEF };
+
+} // namespace qucs
@@ -0,0 +1,121 @@
+/*
+ * optimizer.h - optimization class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __OPTIMIZER_H__
+#define __OPTIMIZER_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <random>
+
+namespace qucs {
+
+class analysis;
+
+/* Types of optimization variables. */
+enum optvar_type {
+  OPT_VAR_LIN_DOUBLE,
+  OPT_VAR_LOG_DOUBLE,
+  OPT_VAR_LIN_INT,
+  OPT_VAR_LOG_INT,
+  OPT_VAR_SERIES
+};
+
+/* A variable adjusted by the optimization. */
+struct optvar {
+  std::string name;     // name of the variable
+  nr_double_t min;      // lower bound
+  nr_double_t max;      // upper bound
+  nr_double_t init;     // initial value
+  bool hasInit;         // initial value given
+  int type;             // one of the OPT_VAR_* types
+  int series;           // values per decade of E series
+  nr_double_t lo, hi;   // bounds of the searched coordinate
+  void * eqn;           // equation added for the variable
+  vector * save;        // optimized value
+};
+
+/* Types of optimization goals. */
+enum optgoal_type {
+  OPT_GOAL_MIN,
+  OPT_GOAL_MAX,
+  OPT_GOAL_LE,
+  OPT_GOAL_GE,
+  OPT_GOAL_EQ,
+  OPT_GOAL_MON
+};
+
+/* A process evaluating members of the population. */
+struct optworker {
+  int pid;              // process id
+  FILE * to;            // stream of the members to evaluate
+  FILE * from;          // stream of their costs
+};
+
+/* A goal for a result vector of the optimization. */
+struct optgoal {
+  std::string name;     // name of the result vector
+  int type;             // one of the OPT_GOAL_* types
+  nr_double_t value;    // target value
+};
+
+class optimizer : public analysis
+{
+ public:
+  ACREATOR (optimizer);
+  optimizer (char *);
+  optimizer (optimizer &);
+  ~optimizer ();
+  int  initialize (void);
+  int  solve (void);
+  int  cleanup (void);
+
+ private:
+  nr_double_t value (const optvar &, nr_double_t);
+  void setValues (const std::vector<nr_double_t> &);
+  nr_double_t evaluate (const std::vector<nr_double_t> &);
+  void evaluate (const std::vector< std::vector<nr_double_t> > &,
+		 std::vector<nr_double_t> &);
+  void mutate (const std::vector< std::vector<nr_double_t> > &, int, int,
+	       std::vector<nr_double_t> &);
+  void startWorkers (int);
+  void stopWorkers (void);
+  void serve (FILE *, FILE *);
+  int cost (nr_double_t &);
+  void dropResults (void);
+  void saveResults (const std::vector<nr_double_t> &, nr_double_t);
+  nr_double_t random (void);
+
+ private:
+  std::vector<optvar> vars;
+  std::vector<optgoal> goals;
+  std::string missing;
+  std::vector<optworker> workers;
+  std::mt19937 rng;
+  int method;
+  int evaluations;
+};
+
+} // namespace qucs
+
+#endif /* __OPTIMIZER_H__ */
@@ -154,12 +154,10 @@ int parasweep::solve (void) {
   for (int i = 0; i < swp->getSize (); i++) {
     // obtain next sweep point
     nr_double_t v = swp->next ();
-    // display progress bar if requested
-    if (progress) logprogressbar (i, swp->getSize (), 40);
+    // report progress
+    reportProgress (i, swp->getSize ());
     // update environment and equation checker, then run solver
-    env->setDoubleConstant (n, v);
-    env->setDouble (n, v);
-    env->runSolver ();
+    setSweepValue (v);
     // save results (swept parameter values)
     if (runs == 1) saveResults ();
 #if DEBUG
@@ -167,6 +165,7 @@ int parasweep::solve (void) {
 	      getName (), n, v);
 #endif
     for (auto *a : *actions) {
+      a->setSweepPoint (this, v, i == 0);
       err |= a->solve ();
       // assign variable dataset dependencies to last order analyses
       ptrlist<analysis> * lastorder = subnet->findLastOrderChildren (this);
@@ -179,6 +178,15 @@ int parasweep::solve (void) {
   return err;
 }
 
+/* Sets the swept parameter to the given value in the environment and
+   the equation checker and runs the equation solver. */
+void parasweep::setSweepValue (nr_double_t v) {
+  const char * const n = getPropertyString ("Param");
+  env->setDoubleConstant (n, v);
+  env->setDouble (n, v);
+  env->runSolver ();
+}
+
 /* This function saves the results of a single solve() functionality
    into the output dataset. */
 void parasweep::saveResults (void) {
@@ -42,6 +42,7 @@ class parasweep : public analysis
   int  solve (void);
   int  cleanup (void);
   void saveResults (void);
+  void setSweepValue (nr_double_t);
 
  private:
   variable * var;
@@ -0,0 +1,397 @@
+/*
+ * prima.cpp - model order reduction class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+
+#include "logging.h"
+#include "complex.h"
+#include "matrix.h"
+#include "object.h"
+#include "node.h"
+#include "circuit.h"
+#include "net.h"
+#include "nodeset.h"
+#include "tvector.h"
+#include "tmatrix.h"
+#include "eqnsys.h"
+#include "constants.h"
+#include "prima.h"
+#include "components/component_id.h"
+#include "components/rom.h"
+
+/* Reduction parameters. */
+#define PRIMA_MOMENTS  4     // number of matched block moments
+#define PRIMA_MAXSIZE  2000  // largest subnetwork (dense decomposition)
+#define PRIMA_GMIN     1e-12 // conductance of each node to ground
+#define PRIMA_DEFLATE  1e-10 // relative size of deflated vectors
+#define PRIMA_FREQ     1e9   // frequency of the error estimate
+
+namespace qucs {
+
+// A single entry of a sparse matrix.
+struct prima_entry {
+  int r, c;
+  nr_double_t v;
+};
+
+typedef std::vector<prima_entry> prima_matrix;
+typedef std::vector< tvector<nr_double_t> > prima_basis;
+
+// Constructor creates an instance of the prima class for the netlist.
+prima::prima (net * n) {
+  subnet = n;
+  moments = PRIMA_MOMENTS;
+  count = 0;
+}
+
+// Destructor deletes the prima class object.
+prima::~prima () {
+}
+
+/* Adds the entries of a two-terminal element with the given value to
+   the sparse matrix.  Negative indices denote the ground node. */
+static void prima_stamp (prima_matrix & m, int a, int b, nr_double_t v) {
+  if (a >= 0) m.push_back ({ a, a, +v });
+  if (b >= 0) m.push_back ({ b, b, +v });
+  if (a >= 0 && b >= 0) {
+    m.push_back ({ a, b, -v });
+    m.push_back ({ b, a, -v });
+  }
+}
+
+// Checks whether the given property is a constant value.
+static bool prima_constant (circuit * c, const char * prop) {
+  const char * ref = c->getPropertyReference (prop);
+  return ref == NULL || *ref == '\0';
+}
+
+// Returns the temperature scaled resistance of a resistor.
+static nr_double_t prima_resistance (circuit * c) {
+  nr_double_t R  = c->getPropertyDouble ("R");
+  nr_double_t DT = c->getPropertyDouble ("Temp") -
+    c->getPropertyDouble ("Tnom");
+  nr_double_t Tc1 = c->getPropertyDouble ("Tc1");
+  nr_double_t Tc2 = c->getPropertyDouble ("Tc2");
+  return R * (1 + DT * (Tc1 + Tc2 * DT));
+}
+
+/* This function orthonormalizes the given vector against the basis
+   (modified Gram-Schmidt, applied twice) and appends it.  Vectors
+   linearly depending on the basis are deflated and the function
+   returns false then. */
+static bool prima_append (prima_basis & V, tvector<nr_double_t> w) {
+  nr_double_t n0 = std::sqrt (norm (w)), h;
+  int i, k, n = w.size ();
+  if (n0 <= 0) return false;
+  for (int pass = 0; pass < 2; pass++) {
+    for (k = 0; k < (int) V.size (); k++) {
+      for (h = 0, i = 0; i < n; i++) h += V[k](i) * w(i);
+      for (i = 0; i < n; i++) w(i) -= h * V[k](i);
+    }
+  }
+  h = std::sqrt (norm (w));
+  if (h <= PRIMA_DEFLATE * n0) return false;
+  for (i = 0; i < n; i++) w(i) /= h;
+  V.push_back (w);
+  return true;
+}
+
+/* Projects the sparse matrix onto the reduced space.  The projection
+   keeps the first p (port) unknowns and maps the remaining internal
+   unknowns onto the given basis of size q. */
+static matrix prima_project (prima_matrix & m, prima_basis & V, int p, int q) {
+  matrix r (p + q);
+  for (auto & e : m) {
+    int k, l;
+    if (e.r < p && e.c < p) {
+      r (e.r, e.c) += e.v;
+    }
+    else if (e.r < p) {
+      for (l = 0; l < q; l++) r (e.r, p + l) += e.v * V[l](e.c - p);
+    }
+    else if (e.c < p) {
+      for (k = 0; k < q; k++) r (p + k, e.c) += V[k](e.r - p) * e.v;
+    }
+    else {
+      for (k = 0; k < q; k++) {
+	nr_double_t a = V[k](e.r - p) * e.v;
+	if (a == 0) continue;
+	for (l = 0; l < q; l++) r (p + k, p + l) += a * V[l](e.c - p);
+      }
+    }
+  }
+  return r;
+}
+
+/* Computes the port admittance matrix of a model with p ports using
+   its first p + q unknowns at the given frequency. */
+static matrix prima_admittance (matrix & G, matrix & C, int p, int q,
+				nr_double_t f) {
+  nr_complex_t s = nr_complex_t (0, 2 * pi * f);
+  matrix ypp (p), ypq (p, q), yqp (q, p), yqq (q);
+  int r, c;
+  for (r = 0; r < p + q; r++) {
+    for (c = 0; c < p + q; c++) {
+      nr_complex_t y = G (r, c) + s * C (r, c);
+      if (r < p && c < p) ypp (r, c) = y;
+      else if (r < p) ypq (r, c - p) = y;
+      else if (c < p) yqp (r - p, c) = y;
+      else yqq (r - p, c - p) = y;
+    }
+  }
+  if (q == 0) return ypp;
+  return ypp - ypq * inverse (yqq) * yqp;
+}
+
+/* Checks whether the given circuit is a linear R, L or C element with
+   constant values which can be part of a reduced subnetwork. */
+bool prima::isCandidate (circuit * c) {
+  switch (c->getType ()) {
+  case CIR_RESISTOR:
+    return !c->hasProperty ("Controlled") &&
+      prima_constant (c, "R") && prima_constant (c, "Temp") &&
+      prima_constant (c, "Tc1") && prima_constant (c, "Tc2") &&
+      prima_constant (c, "Tnom") && prima_resistance (c) != 0.0;
+  case CIR_CAPACITOR:
+    return !c->hasProperty ("Controlled") &&
+      prima_constant (c, "C") && !c->isPropertyGiven ("V");
+  case CIR_INDUCTOR:
+    return prima_constant (c, "L") && !c->isPropertyGiven ("I") &&
+      c->getPropertyDouble ("L") != 0.0;
+  }
+  return false;
+}
+
+/* The function looks for connected subnetworks of linear RLC
+   elements and replaces each of them by a reduced order model.  It
+   returns the number of reduced subnetworks. */
+int prima::reduce (void) {
+  circuit * root = subnet->getRoot ();
+  std::unordered_set<circuit *> visited;
+  std::vector< std::vector<circuit *> > clusters;
+
+  // index the circuits by their node names
+  nodes.clear ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    for (int i = 0; i < c->getSize (); i++)
+      nodes[c->getNode(i)->getName ()].push_back (c);
+  }
+
+  // nodes with a nodeset must be kept
+  fixed.clear ();
+  for (nodeset * n = subnet->getNodeset (); n; n = n->getNext ())
+    fixed.insert (n->getName ());
+
+  // collect the connected subnetworks
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    if (visited.count (c) || !isCandidate (c)) continue;
+    std::vector<circuit *> cluster, stack;
+    stack.push_back (c);
+    visited.insert (c);
+    while (!stack.empty ()) {
+      circuit * x = stack.back ();
+      stack.pop_back ();
+      cluster.push_back (x);
+      for (int i = 0; i < x->getSize (); i++) {
+	const char * n = x->getNode(i)->getName ();
+	if (!strcmp (n, "gnd")) continue;
+	for (circuit * y : nodes[n]) {
+	  if (!visited.count (y) && isCandidate (y)) {
+	    visited.insert (y);
+	    stack.push_back (y);
+	  }
+	}
+      }
+    }
+    clusters.push_back (cluster);
+  }
+
+  for (auto & cluster : clusters) reduceCluster (cluster);
+  nodes.clear ();
+  fixed.clear ();
+  return count;
+}
+
+/* This function reduces a single subnetwork.  The unknowns are the
+   port voltages, the internal node voltages and the inductor currents.
+   Using the formulation (G + sC) x = B u with
+     G = | Gn   A |   C = | Cn  0 |
+         | -A'  0 |       | 0   L |
+   both G + G' and C are positive semi-definite, thus the congruence
+   transformation preserves passivity. */
+void prima::reduceCluster (std::vector<circuit *> & cluster) {
+  std::unordered_set<circuit *> members (cluster.begin (), cluster.end ());
+  std::unordered_map<std::string, int> index;
+  std::vector<std::string> pnames;
+  int p = 0, ni = 0, nl = 0, n, i, k;
+
+  // enumerate the ports (nodes connected outside) first
+  for (circuit * c : cluster) {
+    for (i = 0; i < c->getSize (); i++) {
+      std::string name = c->getNode(i)->getName ();
+      if (name == "gnd" || index.count (name)) continue;
+      bool port = fixed.count (name) > 0;
+      for (circuit * y : nodes[name]) if (!members.count (y)) port = true;
+      if (port) {
+	index[name] = p++;
+	pnames.push_back (name);
+      }
+    }
+  }
+  // then the internal nodes and the inductor currents
+  for (circuit * c : cluster) {
+    for (i = 0; i < c->getSize (); i++) {
+      std::string name = c->getNode(i)->getName ();
+      if (name == "gnd" || index.count (name)) continue;
+      index[name] = p + ni++;
+    }
+    if (c->getType () == CIR_INDUCTOR) nl++;
+  }
+  n = ni + nl;
+
+  // nothing to gain ?
+  if (p == 0 || n <= 2 * p * moments) return;
+  if (n > PRIMA_MAXSIZE) {
+    logprint (LOG_STATUS, "NOTIFY: skipping reduction of linear subcircuit "
+	      "with %d unknowns (maximum is %d)\n", n, PRIMA_MAXSIZE);
+    return;
+  }
+  // create the sparse G, C and noise current correlation matrices
+  prima_matrix G, C, N;
+  int l = p + ni;
+  for (circuit * c : cluster) {
+    std::string n1 = c->getNode(NODE_1)->getName ();
+    std::string n2 = c->getNode(NODE_2)->getName ();
+    int a = (n1 == "gnd") ? -1 : index[n1];
+    int b = (n2 == "gnd") ? -1 : index[n2];
+    switch (c->getType ()) {
+    case CIR_RESISTOR: {
+      nr_double_t r = prima_resistance (c);
+      nr_double_t T = c->getPropertyDouble ("Temp");
+      prima_stamp (G, a, b, 1 / r);
+      prima_stamp (N, a, b, celsius2kelvin (T) / T0 * 4.0 / r);
+      break;
+    }
+    case CIR_CAPACITOR:
+      prima_stamp (C, a, b, c->getPropertyDouble ("C"));
+      break;
+    case CIR_INDUCTOR:
+      if (a >= 0) { G.push_back ({ a, l, +1 }); G.push_back ({ l, a, -1 }); }
+      if (b >= 0) { G.push_back ({ b, l, -1 }); G.push_back ({ l, b, +1 }); }
+      C.push_back ({ l, l, c->getPropertyDouble ("L") });
+      l++;
+      break;
+    }
+  }
+
+  // decompose the internal part of G (expansion at DC)
+  tmatrix<nr_double_t> K (n);
+  tvector<nr_double_t> x (n), z (n);
+  for (auto & e : G) {
+    if (e.r >= p && e.c >= p) K (e.r - p, e.c - p) += e.v;
+  }
+  for (i = 0; i < ni; i++) K (i, i) += PRIMA_GMIN;
+  eqnsys<nr_double_t> eqns;
+  eqns.setAlgo (ALGO_LU_FACTORIZATION_CROUT);
+  eqns.passEquationSys (&K, &x, &z);
+  eqns.solve ();
+  eqns.setAlgo (ALGO_LU_SUBSTITUTION_CROUT);
+
+  // the starting block spans the responses to the port voltages
+  prima_basis V;
+  int q0 = 0, q1;
+  for (k = 0; k < p; k++) {
+    tvector<nr_double_t> zg (n), zc (n);
+    for (auto & e : G) if (e.c == k && e.r >= p) zg (e.r - p) -= e.v;
+    for (auto & e : C) if (e.c == k && e.r >= p) zc (e.r - p) -= e.v;
+    eqns.passEquationSys (NULL, &x, &zg); eqns.solve ();
+    prima_append (V, x);
+    eqns.passEquationSys (NULL, &x, &zc); eqns.solve ();
+    prima_append (V, x);
+  }
+
+  // each further block matches the next moment
+  q1 = V.size ();
+  for (int m = 1; m < moments; m++) {
+    int q2 = V.size ();
+    for (k = q0; k < q2; k++) {
+      tvector<nr_double_t> zc (n);
+      for (auto & e : C) {
+	if (e.r >= p && e.c >= p) zc (e.r - p) -= e.v * V[k](e.c - p);
+      }
+      eqns.passEquationSys (NULL, &x, &zc); eqns.solve ();
+      prima_append (V, x);
+    }
+    q0 = q1 = q2;
+    if ((int) V.size () == q2) break;
+  }
+  int q = V.size ();
+
+  // project the matrices
+  matrix Gr = prima_project (G, V, p, q);
+  matrix Cr = prima_project (C, V, p, q);
+  matrix Nr = prima_project (N, V, p, q);
+
+  // estimate the error by the contribution of the last block
+  matrix y1 = prima_admittance (Gr, Cr, p, q, PRIMA_FREQ);
+  matrix y2 = prima_admittance (Gr, Cr, p, q1, PRIMA_FREQ);
+  nr_double_t d = 0, s = 0;
+  for (i = 0; i < p; i++) {
+    for (k = 0; k < p; k++) {
+      d += norm (y1 (i, k) - y2 (i, k));
+      s += norm (y1 (i, k));
+    }
+  }
+  nr_double_t err = s > 0 ? std::sqrt (d / s) : 0;
+
+  // create the reduced order model and put it into the netlist
+  char name[32];
+  sprintf (name, "_ROM%d", ++count);
+  rom * r = new rom (p + q);
+  r->setName (name);
+  for (k = 0; k < p; k++) r->setNode (k, pnames[k]);
+  for (k = 0; k < q; k++) {
+    subnet->insertedNode (r->getNode (p + k));
+    r->setNode (p + k, std::string (r->getNode(p + k)->getName ()), 1);
+  }
+  r->setModel (Gr, Cr, Nr);
+  for (circuit * c : cluster) {
+    c->setOriginal (0);
+    subnet->removeCircuit (c);
+  }
+  subnet->insertCircuit (r);
+
+  logprint (LOG_STATUS, "NOTIFY: %s: reduced linear subcircuit of %d "
+	    "circuits with %d unknowns to %d ports and %d states, estimated "
+	    "error %g at %g Hz\n", name, (int) cluster.size (), n, p, q,
+	    (double) err, (double) PRIMA_FREQ);
+  logprint (LOG_ERROR, "WARNING: %s: voltages of the %d internal nodes of "
+	    "the reduced subcircuit are not saved\n", name, ni);
+}
+
+} // namespace qucs
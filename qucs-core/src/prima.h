@@ -0,0 +1,64 @@
+/*
+ * prima.h - model order reduction class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __PRIMA_H__
+#define __PRIMA_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace qucs {
+
+class net;
+class circuit;
+
+/* The class replaces linear RLC subnetworks of a netlist by reduced
+   order models.  Each subnetwork is projected onto a block Krylov
+   subspace (PRIMA) while its ports, i.e. the nodes connected to the
+   rest of the netlist, are preserved.  The congruence transformation
+   keeps the reduced models passive. */
+class prima
+{
+ public:
+  prima (net *);
+  ~prima ();
+  int  reduce (void);
+  void setMoments (int m) { moments = m; }
+  int  getMoments (void) { return moments; }
+
+ private:
+  bool isCandidate (circuit *);
+  void reduceCluster (std::vector<circuit *> &);
+
+ private:
+  net * subnet;
+  int moments;
+  int count;
+  std::unordered_map<std::string, std::vector<circuit *> > nodes;
+  std::unordered_set<std::string> fixed;
+};
+
+} // namespace qucs
+
+#endif /* __PRIMA_H__ */
@@ -47,6 +47,7 @@ property::property () :
 {
   type = PROPERTY_UNKNOWN;
   value = 0.0;
+  factor = 1.0;
   var = NULL;
   def = false;
 }
@@ -96,15 +97,16 @@ const char * property::getReference (void) const {
   return str.c_str();
 }
 
-// Returns the property's value as double.
+/* Returns the property's value as double.  The value is scaled by the
+   factor, which is used to vary it without replacing the property. */
 nr_double_t property::getDouble (void) const {
   if (var != NULL) {
     if (var->getType () == VAR_CONSTANT)
-      return D (var->getConstant ());
+      return D (var->getConstant ()) * factor;
     else if (var->getType () == VAR_REFERENCE)
-      return D (var->getReference()->getResult ());
+      return D (var->getReference()->getResult ()) * factor;
   }
-  return value;
+  return value * factor;
 }
 
 // Returns the property's value as integer.
@@ -58,14 +58,18 @@ class property
   void set (const std::string &);
   void set (variable *);
   std::string toString (void) const;
+  int getType (void) const { return type; }
   bool isDefault (void) const { return def; }
   void setDefault (bool d) { def = d; }
+  nr_double_t getFactor (void) const { return factor; }
+  void setFactor (nr_double_t f) { factor = f; }
 
  private:
   bool def;
   int type;
   std::string str;
   nr_double_t value;
+  nr_double_t factor;
   variable * var;
 };
 
@@ -0,0 +1,342 @@
+/*
+ * senssolver.cpp - DC sensitivity analysis class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+/* The sensitivity analysis computes the derivatives of DC output
+   quantities (node voltages 'node.V' or currents through voltage
+   sources 'name.I') with respect to all real valued component
+   properties.  At the operating point x the MNA equations F(x,p) = 0
+   give
+
+     dx/dp = - A^-1 * dF/dp
+
+   with A being the Jacobian.  For an output o = e^T x the derivative
+   therefore is do/dp = - y^T dF/dp, where y solves the adjoint system
+   A^T y = e.  A is decomposed once, each output then costs a single
+   adjoint solve using the transposed LU factors and each property a
+   scalar product per output.
+
+   The components do not provide analytic parameter derivatives, thus
+   dF/dp is obtained by central differences of the MNA entries of the
+   circuit owning the property (and its internal helper circuits) at
+   the fixed operating point.  No equation system is solved for that.
+   Properties which are zero or given by a variable are skipped. */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "logging.h"
+#include "object.h"
+#include "complex.h"
+#include "circuit.h"
+#include "net.h"
+#include "netdefs.h"
+#include "analysis.h"
+#include "nasolver.h"
+#include "dcsolver.h"
+#include "senssolver.h"
+
+// Relative step used for the central differences.
+#define SENS_STEP 1e-6
+
+namespace qucs {
+
+// Constructor creates an unnamed instance of the senssolver class.
+senssolver::senssolver () : dcsolver () {
+  type = ANALYSIS_SENSITIVITY;
+  setDescription ("sensitivity");
+}
+
+// Constructor creates a named instance of the senssolver class.
+senssolver::senssolver (char * n) : dcsolver (n) {
+  type = ANALYSIS_SENSITIVITY;
+  setDescription ("sensitivity");
+}
+
+// Destructor deletes the senssolver class object.
+senssolver::~senssolver () {
+}
+
+/* The copy constructor creates a new instance of the senssolver class
+   based on the given senssolver object. */
+senssolver::senssolver (senssolver & o) : dcsolver (o) {
+}
+
+/* This is the sensitivity analysis solver.  It finds the operating
+   point, solves the adjoint system of each output and saves the
+   derivatives as 'analysis.circuit.property' variables.  If several
+   outputs are given (separated by semicolons) the variables are named
+   'analysis.output.circuit.property'. */
+int senssolver::solve (void) {
+  int error = 0;
+
+  // find the operating point
+  if (solveOperatingPoint ()) {
+    logprint (LOG_ERROR, "ERROR: %s: no operating point found, "
+	      "sensitivities not available\n", getName ());
+    solve_post ();
+    return -1;
+  }
+
+  // find the outputs in the solution vector
+  std::vector<std::string> names;
+  std::vector<int> outs;
+  std::string list = getPropertyString ("Output");
+  size_t pos = 0;
+  while (pos != std::string::npos) {
+    size_t end = list.find (';', pos);
+    std::string name = list.substr (pos, end == std::string::npos ?
+				    end : end - pos);
+    pos = end == std::string::npos ? end : end + 1;
+    size_t b = name.find_first_not_of (" \t");
+    if (b == std::string::npos) continue;
+    name = name.substr (b, name.find_last_not_of (" \t") - b + 1);
+    int out = findOutput (name);
+    if (out < 0) {
+      logprint (LOG_ERROR, "ERROR: %s: no such output `%s'\n", getName (),
+		name.c_str ());
+      solve_post ();
+      return -1;
+    }
+    names.push_back (name);
+    outs.push_back (out);
+  }
+  if (outs.empty ()) {
+    logprint (LOG_ERROR, "ERROR: %s: no output given\n", getName ());
+    solve_post ();
+    return -1;
+  }
+  int N = countNodes ();
+  int M = countVoltageSources ();
+  tvector<nr_double_t> xop = *x;
+
+  // create the Jacobian at the operating point and LU decompose it
+  restart ();
+  calculate ();
+  convHelper = CONV_None;
+  updateMatrix = 1;
+  createMatrix ();
+  eqnAlgo = ALGO_LU_FACTORIZATION_CROUT;
+  try_running () {
+    runMNA ();
+  }
+  catch_exception () {
+  default:
+    estack.print ();
+    error++;
+    break;
+  }
+  if (error) {
+    solve_post ();
+    return -1;
+  }
+
+  // solve the adjoint system of each output using the same factors
+  int k, outputs = outs.size ();
+  std::vector< tvector<nr_double_t> > y (outputs);
+  updateMatrix = 0;
+  eqnAlgo = ALGO_LU_SUBSTITUTION_CROUT_TRANSPOSED;
+  for (k = 0; k < outputs; k++) {
+    z->set (0);
+    z->set (outs[k], 1);
+    runMNA ();
+    y[k] = *x;
+  }
+  *x = xop;
+
+  // compute the derivatives with respect to each property
+  bool relative = !strcmp (getPropertyString ("Relative"), "yes");
+  tvector<nr_double_t> dF (N + M);
+  circuit * root = subnet->getRoot ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    // helper circuits of devices are handled with their parents
+    if (c->hasProperty ("Controlled")) continue;
+    for (auto & it : c->getProperties ()) {
+      property * p = &it.second;
+      if (p->getType () != PROPERTY_DOUBLE) continue;
+      // skip values derived by the circuit itself
+      if (it.first.compare (0, 7, "Scaled:") == 0) continue;
+      nr_double_t v = p->getDouble ();
+      if (v == 0.0) continue;
+      if (derivative (c, p, dF) == 0.0) {
+	logprint (LOG_ERROR, "WARNING: %s: cannot differentiate `%s.%s'\n",
+		  getName (), c->getName (), it.first.c_str ());
+	continue;
+      }
+      for (k = 0; k < outputs; k++) {
+	nr_double_t o = xop.get (outs[k]);
+	nr_double_t s = -scalar (y[k], dF);
+	if (relative) s = (o != 0.0) ? s * v / o : 0.0;
+	std::string n = std::string (getName ()) + ".";
+	if (outputs > 1) n += names[k] + ".";
+	saveVariable (n + c->getName () + "." + it.first, s, NULL);
+      }
+    }
+  }
+
+  // save the operating point of the circuits as well
+  saveOperatingPoints ();
+  solve_post ();
+  return 0;
+}
+
+/* Returns the index of the given output in the solution vector or -1
+   if there is no such node voltage or branch current. */
+int senssolver::findOutput (const std::string & name) {
+  size_t dot = name.rfind ('.');
+  if (dot == std::string::npos) return -1;
+  std::string base = name.substr (0, dot);
+  std::string what = name.substr (dot + 1);
+  if (what == "V") {
+    int n = getNodeNr (base);
+    return n > 0 ? n - 1 : -1;
+  }
+  if (what == "I") {
+    circuit * root = subnet->getRoot ();
+    for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+      if (base == c->getName () && c->getVoltageSources () > 0)
+	return countNodes () + c->getVoltageSource ();
+    }
+  }
+  return -1;
+}
+
+/* Recomputes the MNA entries of the given circuit at the present
+   operating point. */
+void senssolver::evaluate (circuit * c) {
+  c->initDC ();
+  // the initialization may have cleared the node voltages
+  saveSolution ();
+  if (c->isNonLinear ()) c->restartDC ();
+  c->calcDC ();
+}
+
+/* Computes the contribution of the given circuit and its helper
+   circuits to the residual A * x - z of the MNA equations into the
+   vector f. */
+void senssolver::residual (circuit * c, tvector<nr_double_t> & f) {
+  int N = countNodes ();
+  f.set (0);
+  circuit * root = subnet->getRoot ();
+  for (circuit * h = root; h != NULL; h = (circuit *) h->getNext ()) {
+    if (h != c && !(h->hasProperty ("Controlled") &&
+		    !strcmp (h->getPropertyString ("Controlled"),
+			     c->getName ())))
+      continue;
+
+    // node voltages at the ports of the circuit
+    int s = h->getSize ();
+    int v0 = h->getVoltageSource ();
+    int vs = h->getVoltageSources ();
+    std::vector<int> rows (s);
+    std::vector<nr_double_t> u (s);
+    for (int i = 0; i < s; i++) {
+      rows[i] = findAssignedNode (h, i);
+      u[i] = rows[i] < 0 ? 0.0 : x->get (rows[i]);
+    }
+
+    // node equations
+    for (int i = 0; i < s; i++) {
+      if (rows[i] < 0) continue;
+      nr_double_t val = 0.0;
+      for (int j = 0; j < s; j++)
+	val += real (h->getY (i, j)) * u[j];
+      for (int j = 0; j < vs; j++)
+	val += real (h->getB (i, v0 + j)) * x->get (N + v0 + j);
+      if (h->isISource () || h->isNonLinear ())
+	val -= real (h->getI (i));
+      f.set (rows[i], f.get (rows[i]) + val);
+    }
+
+    // voltage source equations
+    for (int r = 0; r < vs; r++) {
+      nr_double_t val = 0.0;
+      for (int j = 0; j < s; j++)
+	val += real (h->getC (v0 + r, j)) * u[j];
+      for (int j = 0; j < vs; j++)
+	val += real (h->getD (v0 + r, v0 + j)) * x->get (N + v0 + j);
+      val -= real (h->getE (v0 + r));
+      f.set (N + v0 + r, f.get (N + v0 + r) + val);
+    }
+  }
+}
+
+/* Computes the derivative of the MNA residual with respect to the
+   given property of the given circuit into dF.  Returns the step
+   size used or zero if the circuit changed its structure. */
+nr_double_t senssolver::derivative (circuit * c, property * p,
+				    tvector<nr_double_t> & dF) {
+  property nominal = *p;
+  nr_double_t v = nominal.getDouble ();
+  nr_double_t h = SENS_STEP * std::fabs (v);
+  int vs = c->getVoltageSources ();
+  int ok = 1;
+
+  // the residuals are subtracted before scaling in order to keep the
+  // cancellation error small for tiny property values
+  tvector<nr_double_t> f[2] = { dF, dF };
+  for (int k = 0; k < 2 && ok; k++) {
+    property s;
+    s.set (k ? v + h : v - h);
+    *p = s;
+    evaluate (c);
+    if (c->getVoltageSources () != vs)
+      ok = 0;
+    else
+      residual (c, f[k]);
+  }
+  if (ok) dF = (f[1] - f[0]) * (1 / (2 * h));
+
+  // back to the nominal value
+  *p = nominal;
+  evaluate (c);
+  return ok ? h : 0.0;
+}
+
+// properties
+PROP_REQ [] = {
+  { "Output", PROP_STR, { PROP_NO_VAL, "out.V" }, PROP_NO_RANGE },
+  PROP_NO_PROP };
+PROP_OPT [] = {
+  { "Relative", PROP_STR, { PROP_NO_VAL, "no" }, PROP_RNG_YESNO },
+  { "MaxIter", PROP_INT, { 150, PROP_NO_STR }, PROP_RNGII (2, 10000) },
+  { "abstol", PROP_REAL, { 1e-12, PROP_NO_STR }, PROP_RNG_X01I },
+  { "vntol", PROP_REAL, { 1e-6, PROP_NO_STR }, PROP_RNG_X01I },
+  { "reltol", PROP_REAL, { 1e-3, PROP_NO_STR }, PROP_RNG_X01I },
+  { "Temp", PROP_REAL, { 26.85, PROP_NO_STR }, PROP_MIN_VAL (K) },
+  { "convHelper", PROP_STR, { PROP_NO_VAL, "none" },
+    PROP_RNG_STR6 ("none", "SourceStepping", "gMinStepping",
+		   "LineSearch", "Attenuation", "SteepestDescent") },
+  { "Solver", PROP_STR, { PROP_NO_VAL, "CroutLU" }, PROP_RNG_SOL },
+  { "sweepSeed", PROP_STR, { PROP_NO_VAL, "constant" },
+    PROP_RNG_STR4 ("none", "constant", "linear", "quadratic") },
+  PROP_NO_PROP };
+struct define_t senssolver::anadef =
+  { "SENS", 0, PROP_ACTION, PROP_NO_SUBSTRATE, PROP_LINEAR, PROP_DEF };
+
+} // namespace qucs
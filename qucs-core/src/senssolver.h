@@ -0,0 +1,50 @@
+/*
+ * senssolver.h - DC sensitivity analysis class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __SENSSOLVER_H__
+#define __SENSSOLVER_H__
+
+#include "dcsolver.h"
+
+namespace qucs {
+
+class circuit;
+
+class senssolver : public dcsolver
+{
+ public:
+  ACREATOR (senssolver);
+  senssolver (char *);
+  senssolver (senssolver &);
+  ~senssolver ();
+  int  solve (void);
+
+ private:
+  int  findOutput (const std::string &);
+  void evaluate (circuit *);
+  void residual (circuit *, tvector<nr_double_t> &);
+  nr_double_t derivative (circuit *, property *, tvector<nr_double_t> &);
+};
+
+} // namespace qucs
+
+#endif /* __SENSSOLVER_H__ */
@@ -0,0 +1,434 @@
+/*
+ * server.cpp - simulation server class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+/* In server mode (qucsator --server) the simulator reads commands
+   from stdin and answers on stdout, log messages go to stderr.  The
+   netlist stays parsed, checked and set up between the simulations,
+   and dynamic modules are loaded only once.  Commands are single
+   lines, the answers are single lines as well:
+
+     netlist N      load the netlist given by the following N bytes
+     load FILE      load the netlist from the given file
+     set VAR VALUE  change an equation variable, e.g. from 'x=5'
+     alter INST KEY VALUE
+                    change a property of a circuit instance
+     add TYPE INST NODE... [KEY=VALUE]...
+                    insert a new circuit instance
+     remove INST    delete a circuit instance
+     rewire INST PORT NODE
+                    connect a port (counted from zero) to another node
+     run            solve the netlist and evaluate the equations
+     dataset [FILE] write the results into the file, or send them
+     get VECTOR     send the given result vector
+     quit           leave the server
+
+   Each command is answered with 'ok' or 'error MESSAGE'.  Sending the
+   dataset is answered with 'dataset N' followed by N bytes of the
+   usual textual dataset.  Sending a vector is answered with
+   'vector N real' or 'vector N complex' followed by the N values as
+   native double precision numbers, the complex ones with real and
+   imaginary part in turn. */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#include <string>
+#include <vector>
+
+#include "logging.h"
+#include "complex.h"
+#include "object.h"
+#include "vector.h"
+#include "dataset.h"
+#include "circuit.h"
+#include "component.h"
+#include "components.h"
+#include "net.h"
+#include "input.h"
+#include "equation.h"
+#include "environment.h"
+#include "exceptionstack.h"
+#include "check_netlist.h"
+#include "server.h"
+
+namespace qucs {
+
+// Maximum length of a command line.
+#define SERVER_LINE 4096
+
+// Constructor creates a server reading from and answering to the
+// given streams.
+server::server (FILE * i, FILE * o) {
+  in = i;
+  out = o;
+  subnet = NULL;
+  inp = NULL;
+  data = NULL;
+  root = NULL;
+}
+
+// Destructor deletes the server and the netlist kept by it.
+server::~server () {
+  release ();
+}
+
+/* Deletes the currently loaded netlist and its results. */
+void server::release (void) {
+  if (root && data) root->dropDataset ();
+  delete data;
+  delete subnet;
+  delete inp;
+  delete root;
+  data = NULL;
+  subnet = NULL;
+  inp = NULL;
+  root = NULL;
+  netlist_destroy_env ();
+}
+
+/* Loads the netlist from the given stream which is closed afterwards.
+   Returns zero on success. */
+int server::load (FILE * f) {
+  release ();
+
+  // create root environment, netlist object and input
+  root = new environment (std::string ("root"));
+  subnet = new net ("subnet");
+  inp = new input ();
+  inp->setFile (f);
+  subnet->setEnv (root);
+  inp->setEnv (root);
+
+  // get input netlist
+  if (inp->netlist (subnet) != 0) {
+    netlist_destroy ();
+    release ();
+    return -1;
+  }
+
+  // attach a ground to the netlist
+  circuit * gnd = new ground ();
+  gnd->setNode (0, "gnd");
+  gnd->setName ("GND");
+  subnet->insertCircuit (gnd);
+  return 0;
+}
+
+// Sends a single line answer.
+void server::reply (const char * format, ...) {
+  va_list args;
+  va_start (args, format);
+  vfprintf (out, format, args);
+  va_end (args);
+  fputc ('\n', out);
+  fflush (out);
+}
+
+/* Reads a netlist of the given size from the command stream. */
+int server::cmdNetlist (char * arg) {
+  long n = arg ? strtol (arg, NULL, 10) : -1;
+  if (n < 0) {
+    reply ("error invalid netlist size");
+    return 0;
+  }
+  FILE * f = tmpfile ();
+  if (f == NULL) {
+    reply ("error cannot create temporary file: %s", strerror (errno));
+    return 0;
+  }
+  char buf[SERVER_LINE];
+  while (n > 0) {
+    size_t len = fread (buf, 1, n < SERVER_LINE ? n : SERVER_LINE, in);
+    if (len == 0) break;
+    fwrite (buf, 1, len, f);
+    n -= len;
+  }
+  if (n > 0) {
+    fclose (f);
+    reply ("error unexpected end of netlist");
+    return -1;
+  }
+  rewind (f);
+  if (load (f) != 0)
+    reply ("error netlist check failed");
+  else
+    reply ("ok");
+  return 0;
+}
+
+/* Loads the netlist from the given file. */
+int server::cmdLoad (char * arg) {
+  FILE * f = arg ? fopen (arg, "r") : NULL;
+  if (f == NULL) {
+    reply ("error cannot open file `%s'", arg ? arg : "");
+    return 0;
+  }
+  if (load (f) != 0)
+    reply ("error netlist check failed");
+  else
+    reply ("ok");
+  return 0;
+}
+
+/* Changes the value of an equation variable. */
+int server::cmdSet (char * arg) {
+  char * name = arg ? strtok (arg, " \t") : NULL;
+  char * val = name ? strtok (NULL, " \t") : NULL;
+  char * end = NULL;
+  if (root == NULL) {
+    reply ("error no netlist loaded");
+    return 0;
+  }
+  nr_double_t v = val ? strtod (val, &end) : 0;
+  if (name == NULL || val == NULL || *end != '\0') {
+    reply ("error usage: set VAR VALUE");
+    return 0;
+  }
+  if (!root->getChecker()->containsVariable (name)) {
+    reply ("error no such variable `%s'", name);
+    return 0;
+  }
+  root->setDoubleConstant (name, v);
+  root->setDouble (name, v);
+  reply ("ok");
+  return 0;
+}
+
+/* Changes a property of a circuit instance. */
+int server::cmdAlter (char * arg) {
+  char * name = arg ? strtok (arg, " \t") : NULL;
+  char * key = name ? strtok (NULL, " \t") : NULL;
+  char * val = key ? strtok (NULL, " \t") : NULL;
+  if (inp == NULL) {
+    reply ("error no netlist loaded");
+    return 0;
+  }
+  if (val == NULL) {
+    reply ("error usage: alter INST KEY VALUE");
+    return 0;
+  }
+  if (inp->changeInstance (name, key, val) != 0)
+    reply ("error cannot change `%s' of `%s'", key, name);
+  else
+    reply ("ok");
+  return 0;
+}
+
+/* Inserts a new circuit instance into the netlist. */
+int server::cmdAdd (char * arg) {
+  char * type = arg ? strtok (arg, " \t") : NULL;
+  char * name = type ? strtok (NULL, " \t") : NULL;
+  if (inp == NULL) {
+    reply ("error no netlist loaded");
+    return 0;
+  }
+  if (name == NULL) {
+    reply ("error usage: add TYPE INST NODE... [KEY=VALUE]...");
+    return 0;
+  }
+  std::vector<std::string> nodes, props;
+  for (char * t = strtok (NULL, " \t"); t != NULL; t = strtok (NULL, " \t")) {
+    if (strchr (t, '='))
+      props.push_back (t);
+    else
+      nodes.push_back (t);
+  }
+  if (inp->addInstance (type, name, nodes, props) != 0)
+    reply ("error cannot add `%s:%s'", type, name);
+  else
+    reply ("ok");
+  return 0;
+}
+
+/* Deletes a circuit instance from the netlist. */
+int server::cmdRemove (char * arg) {
+  if (subnet == NULL) {
+    reply ("error no netlist loaded");
+    return 0;
+  }
+  if (arg == NULL || subnet->removeInstance (arg) != 0)
+    reply ("error cannot remove `%s'", arg ? arg : "");
+  else
+    reply ("ok");
+  return 0;
+}
+
+/* Connects a port of a circuit instance to another node. */
+int server::cmdRewire (char * arg) {
+  char * name = arg ? strtok (arg, " \t") : NULL;
+  char * port = name ? strtok (NULL, " \t") : NULL;
+  char * to = port ? strtok (NULL, " \t") : NULL;
+  if (subnet == NULL) {
+    reply ("error no netlist loaded");
+    return 0;
+  }
+  if (to == NULL) {
+    reply ("error usage: rewire INST PORT NODE");
+    return 0;
+  }
+  if (subnet->rewireInstance (name, atoi (port), to) != 0)
+    reply ("error cannot rewire `%s'", name);
+  else
+    reply ("ok");
+  return 0;
+}
+
+/* Solves the netlist once more and evaluates the equations. */
+int server::cmdRun (char *) {
+  if (subnet == NULL) {
+    reply ("error no netlist loaded");
+    return 0;
+  }
+  // results of the previous run are dropped
+  if (data) {
+    root->dropDataset ();
+    delete data;
+  }
+  int err = 0;
+  data = subnet->runAnalysis (err);
+  err |= root->equationSolver (data);
+  estack.print ("uncaught");
+  if (err)
+    reply ("error simulation failed");
+  else
+    reply ("ok");
+  return 0;
+}
+
+/* Writes the results into the given file or sends them. */
+int server::cmdDataset (char * arg) {
+  if (data == NULL) {
+    reply ("error no results available");
+    return 0;
+  }
+  if (arg) {
+    data->setFile (arg);
+    data->print ();
+    data->setFile (NULL);
+    reply ("ok");
+    return 0;
+  }
+  FILE * f = tmpfile ();
+  if (f == NULL) {
+    reply ("error cannot create temporary file: %s", strerror (errno));
+    return 0;
+  }
+  data->print (f);
+  long n = ftell (f);
+  rewind (f);
+  reply ("dataset %ld", n);
+  char buf[SERVER_LINE];
+  size_t len;
+  while ((len = fread (buf, 1, SERVER_LINE, f)) > 0)
+    fwrite (buf, 1, len, out);
+  fflush (out);
+  fclose (f);
+  return 0;
+}
+
+/* Sends a single result vector in binary form. */
+int server::cmdGet (char * arg) {
+  qucs::vector * v = NULL;
+  if (data && arg) {
+    if ((v = data->findVariable (arg)) == NULL)
+      v = data->findDependency (arg);
+  }
+  if (v == NULL) {
+    reply ("error no such vector `%s'", arg ? arg : "");
+    return 0;
+  }
+  int n = v->getSize ();
+  bool cplx = false;
+  for (int i = 0; i < n && !cplx; i++)
+    if (imag (v->get (i)) != 0.0) cplx = true;
+  reply ("vector %d %s", n, cplx ? "complex" : "real");
+  for (int i = 0; i < n; i++) {
+    double d[2] = { (double) real (v->get (i)), (double) imag (v->get (i)) };
+    fwrite (d, sizeof (double), cplx ? 2 : 1, out);
+  }
+  fflush (out);
+  return 0;
+}
+
+/* Executes a single command line.  Returns non-zero if the server
+   should be left. */
+int server::command (char * line) {
+  // strip line ending
+  size_t len = strlen (line);
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+    line[--len] = '\0';
+
+  // split command and argument
+  char * arg = strchr (line, ' ');
+  if (arg) {
+    *arg++ = '\0';
+    while (*arg == ' ') arg++;
+    if (*arg == '\0') arg = NULL;
+  }
+
+  if (!strcmp (line, "netlist"))
+    return cmdNetlist (arg);
+  else if (!strcmp (line, "load"))
+    return cmdLoad (arg);
+  else if (!strcmp (line, "set"))
+    return cmdSet (arg);
+  else if (!strcmp (line, "alter"))
+    return cmdAlter (arg);
+  else if (!strcmp (line, "add"))
+    return cmdAdd (arg);
+  else if (!strcmp (line, "remove"))
+    return cmdRemove (arg);
+  else if (!strcmp (line, "rewire"))
+    return cmdRewire (arg);
+  else if (!strcmp (line, "run"))
+    return cmdRun (arg);
+  else if (!strcmp (line, "dataset"))
+    return cmdDataset (arg);
+  else if (!strcmp (line, "get"))
+    return cmdGet (arg);
+  else if (!strcmp (line, "quit")) {
+    reply ("ok");
+    return 1;
+  }
+  else if (*line != '\0')
+    reply ("error unknown command `%s'", line);
+  return 0;
+}
+
+/* Runs the server until the command stream ends or the 'quit'
+   command is received. */
+int server::run (void) {
+  char line[SERVER_LINE];
+  while (fgets (line, sizeof (line), in) != NULL) {
+    if (command (line)) break;
+  }
+  return 0;
+}
+
+} // namespace qucs
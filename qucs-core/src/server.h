@@ -0,0 +1,71 @@
+/*
+ * server.h - simulation server class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <stdio.h>
+
+namespace qucs {
+
+class net;
+class input;
+class dataset;
+class environment;
+
+/* The simulation server keeps a netlist loaded and solves it again
+   on request, see server.cpp for the protocol. */
+class server
+{
+ public:
+  server (FILE *, FILE *);
+  ~server ();
+  int run (void);
+  int load (FILE *);
+
+ private:
+  void release (void);
+  void reply (const char *, ...);
+  int  command (char *);
+  int  cmdNetlist (char *);
+  int  cmdLoad (char *);
+  int  cmdSet (char *);
+  int  cmdAlter (char *);
+  int  cmdAdd (char *);
+  int  cmdRemove (char *);
+  int  cmdRewire (char *);
+  int  cmdRun (char *);
+  int  cmdDataset (char *);
+  int  cmdGet (char *);
+
+ private:
+  FILE * in;
+  FILE * out;
+  net * subnet;
+  input * inp;
+  dataset * data;
+  environment * root;
+};
+
+} // namespace qucs
+
+#endif /* __SERVER_H__ */
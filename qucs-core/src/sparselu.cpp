@@ -0,0 +1,281 @@
+/*
+ * sparselu.cpp - sparse LU decomposition class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <cmath>
+#include <set>
+
+#include "complex.h"
+#include "precision.h"
+#include "sparselu.h"
+
+/* Decomposition parameters. */
+#define SPARSELU_THRESHOLD 0.01 // smallest pivot relative to its column
+#define SPARSELU_COLUMNS   4    // number of columns searched for a pivot
+#define SPARSELU_GROWTH    1e4  // largest multiplier of a previous pivot
+
+namespace qucs {
+
+// Constructor creates an empty sparse matrix.
+sparselu::sparselu () {
+  n = 0;
+}
+
+// Destructor deletes the sparselu class object.
+sparselu::~sparselu () {
+}
+
+/* Sets the matrix to a zero matrix of the given size.  The pivot order
+   of the last decomposition is kept if the size does not change. */
+void sparselu::clear (int size) {
+  if (size != n) {
+    prow.clear ();
+    pcol.clear ();
+  }
+  n = size;
+  rows.assign (n, row_t ());
+}
+
+// Adds the given value to the matrix entry at (r, c).
+void sparselu::add (int r, int c, nr_complex_t v) {
+  if (v != 0.0) rows[r][c] += v;
+}
+
+// Returns the number of (structurally) non-zero matrix entries.
+int sparselu::getEntries (void) {
+  int entries = 0;
+  for (int r = 0; r < n; r++) entries += rows[r].size ();
+  return entries;
+}
+
+// Returns the largest magnitude of the active entries in a column.
+static nr_double_t sparselu_colmax (std::vector< std::map<int, nr_complex_t> > & R,
+				    std::set<int> & col, int c) {
+  nr_double_t m = 0;
+  for (int r : col) m = std::max (m, std::abs (R[r][c]));
+  return m;
+}
+
+/* Looks for the entry with the least Markowitz count in the given
+   columns which passes the threshold test.  The row and column of the
+   pivot are left untouched if there is none. */
+static void sparselu_pivot (std::vector< std::map<int, nr_complex_t> > & R,
+			    std::vector< std::set<int> > & C,
+			    std::vector<int> & cols, int & pr, int & pc) {
+  long best = -1;
+  for (int c : cols) {
+    nr_double_t m = sparselu_colmax (R, C[c], c);
+    if (m <= 0) continue;
+    for (int r : C[c]) {
+      if (std::abs (R[r][c]) < SPARSELU_THRESHOLD * m) continue;
+      long cost = (long) (R[r].size () - 1) * (long) (C[c].size () - 1);
+      if (best < 0 || cost < best) {
+	best = cost; pr = r; pc = c;
+      }
+    }
+  }
+}
+
+/* The function decomposes the matrix.  The pivot order and the
+   structure of the factors of the previous decomposition are used if
+   the matrix fits them and the pivots are still good, otherwise a new
+   pivot order is searched.  Zero pivots are replaced by a tiny value
+   and the function returns the number of such replacements. */
+int sparselu::factorize (void) {
+  if ((int) prow.size () == n && refactorize ()) return 0;
+  return decompose ();
+}
+
+/* Decomposes the matrix along the previous pivot order.  Each row is
+   eliminated by the pivot rows of the steps which eliminated it the
+   last time, using a dense work row.  The function returns false if an
+   entry of the matrix is not covered by the structure of the factors
+   or if a pivot became too small (zero or giving a large multiplier). */
+bool sparselu::refactorize (void) {
+  std::vector<nr_complex_t> w (n, 0.0);
+  std::vector<int> mark (n, -1);
+  int k;
+  for (k = 0; k < n; k++) {
+    int r = prow[k];
+    mark[pcol[k]] = k;
+    for (auto & e : U[k]) mark[e.first] = k;
+    for (auto & s : steps[r]) mark[pcol[s.first]] = k;
+    for (auto & e : rows[r]) {
+      if (mark[e.first] != k) return false;
+      w[e.first] = e.second;
+    }
+    // eliminate the columns of the previous pivots
+    for (auto & s : steps[r]) {
+      int j = s.first, c = pcol[j];
+      nr_complex_t l = w[c] / pivots[j];
+      w[c] = 0.0;
+      if (std::abs (l) > SPARSELU_GROWTH) return false;
+      L[j][s.second].second = l;
+      for (auto & e : U[j]) w[e.first] -= l * e.second;
+    }
+    // save the pivot row
+    pivots[k] = w[pcol[k]];
+    w[pcol[k]] = 0.0;
+    if (pivots[k] == 0.0) return false;
+    for (auto & e : U[k]) {
+      e.second = w[e.first];
+      w[e.first] = 0.0;
+    }
+  }
+  return true;
+}
+
+/* The function decomposes the matrix searching a new pivot order.  At
+   each step the pivot is the entry with the least Markowitz count
+   (rows - 1) * (columns - 1) which is not smaller than a fraction of
+   the largest entry in its column, the candidates are taken from the
+   sparsest columns. */
+int sparselu::decompose (void) {
+  std::vector<row_t> R = rows;
+  std::vector< std::set<int> > C (n);
+  std::vector<int> active (n), where (n);
+  std::vector<bool> done (n, false);
+  int k, r, c, singular = 0;
+
+  for (r = 0; r < n; r++) {
+    for (auto & e : R[r]) C[e.first].insert (r);
+    active[r] = where[r] = r;
+  }
+  L.assign (n, factor_t ());
+  U.assign (n, factor_t ());
+  pivots.assign (n, 0.0);
+  prow.assign (n, -1);
+  pcol.assign (n, -1);
+  steps.assign (n, std::vector< std::pair<int, int> > ());
+
+  for (k = 0; k < n; k++) {
+    int pr = -1, pc = -1;
+
+    // search the sparsest columns for the best pivot, all of them if
+    // these have no usable entry
+    std::vector<int> cand;
+    for (int a : active) {
+      if (cand.size () < SPARSELU_COLUMNS) {
+	cand.push_back (a);
+      } else {
+	int w = 0;
+	for (int i = 1; i < SPARSELU_COLUMNS; i++)
+	  if (C[cand[i]].size () > C[cand[w]].size ()) w = i;
+	if (C[a].size () < C[cand[w]].size ()) cand[w] = a;
+      }
+    }
+    sparselu_pivot (R, C, cand, pr, pc);
+    if (pr < 0) sparselu_pivot (R, C, active, pr, pc);
+
+    // no non-zero pivot left: the matrix is singular
+    if (pr < 0) {
+      pc = active[0];
+      if (!C[pc].empty ()) {
+	pr = *C[pc].begin ();
+      } else {
+	for (pr = 0; done[pr]; pr++) ;
+	C[pc].insert (pr);
+      }
+      R[pr][pc] = NR_TINY;
+      singular++;
+    }
+
+    // eliminate the pivot column from the other rows
+    nr_complex_t p = R[pr][pc];
+    row_t & prow_k = R[pr];
+    for (int i : C[pc]) {
+      if (i == pr) continue;
+      nr_complex_t l = R[i][pc] / p;
+      R[i].erase (pc);
+      steps[i].push_back (std::make_pair (k, (int) L[k].size ()));
+      L[k].push_back (std::make_pair (i, l));
+      for (auto & e : prow_k) {
+	if (e.first == pc) continue;
+	auto ins = R[i].insert (std::make_pair (e.first, nr_complex_t (0.0)));
+	if (ins.second) C[e.first].insert (i);
+	ins.first->second -= l * e.second;
+      }
+    }
+
+    // save the pivot row and remove it from the active matrix
+    for (auto & e : prow_k) {
+      C[e.first].erase (pr);
+      if (e.first != pc) U[k].push_back (e);
+    }
+    pivots[k] = p;
+    prow[k] = pr;
+    pcol[k] = pc;
+    done[pr] = true;
+    prow_k.clear ();
+    C[pc].clear ();
+    c = where[pc];
+    active[c] = active.back ();
+    where[active[c]] = c;
+    active.pop_back ();
+    where[pc] = -1;
+  }
+  return singular;
+}
+
+/* Solves the equation system A x = b using the LU factors, b is
+   indexed by the rows and x by the columns of the matrix. */
+void sparselu::solve (tvector<nr_complex_t> & x,
+		      const tvector<nr_complex_t> & b) {
+  tvector<nr_complex_t> y = b;
+  int k;
+  for (k = 0; k < n; k++) {
+    nr_complex_t v = y (prow[k]);
+    if (v == 0.0) continue;
+    for (auto & e : L[k]) y (e.first) -= e.second * v;
+  }
+  x = tvector<nr_complex_t> (n);
+  for (k = n - 1; k >= 0; k--) {
+    nr_complex_t v = y (prow[k]);
+    for (auto & e : U[k]) v -= e.second * x (e.first);
+    x (pcol[k]) = v / pivots[k];
+  }
+}
+
+/* Solves the transposed equation system A^T x = b using the same LU
+   factors, b is indexed by the columns and x by the rows of A. */
+void sparselu::solveTransposed (tvector<nr_complex_t> & x,
+				const tvector<nr_complex_t> & b) {
+  tvector<nr_complex_t> y = b;
+  int k;
+  x = tvector<nr_complex_t> (n);
+  for (k = 0; k < n; k++) {
+    nr_complex_t v = y (pcol[k]) / pivots[k];
+    x (prow[k]) = v;
+    if (v == 0.0) continue;
+    for (auto & e : U[k]) y (e.first) -= v * e.second;
+  }
+  for (k = n - 1; k >= 0; k--) {
+    nr_complex_t v = 0.0;
+    for (auto & e : L[k]) v += e.second * x (e.first);
+    x (prow[k]) -= v;
+  }
+}
+
+} // namespace qucs
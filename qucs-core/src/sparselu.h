@@ -0,0 +1,74 @@
+/*
+ * sparselu.h - sparse LU decomposition class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __SPARSELU_H__
+#define __SPARSELU_H__
+
+#include <map>
+#include <vector>
+
+#include "tvector.h"
+
+namespace qucs {
+
+/* The class holds a sparse complex square matrix and decomposes it
+   into sparse LU factors.  The pivots are chosen by the Markowitz
+   criterion (least fill-in) among the entries passing a threshold
+   test for numerical stability.  The pivot order and the structure of
+   the factors found by a decomposition are used by the next one, thus
+   matrices of the same structure (e.g. the MNA matrix at different
+   frequencies) are decomposed without searching again. */
+class sparselu
+{
+ public:
+  sparselu ();
+  ~sparselu ();
+  void clear (int);
+  void add (int, int, nr_complex_t);
+  int  factorize (void);
+  void solve (tvector<nr_complex_t> &, const tvector<nr_complex_t> &);
+  void solveTransposed (tvector<nr_complex_t> &,
+			const tvector<nr_complex_t> &);
+  int  getSize (void) { return n; }
+  int  getEntries (void);
+
+ private:
+  typedef std::map<int, nr_complex_t> row_t;
+  typedef std::vector< std::pair<int, nr_complex_t> > factor_t;
+
+  bool refactorize (void);
+  int  decompose (void);
+
+  int n;
+  std::vector<row_t> rows;   // the matrix entries by row
+  std::vector<int> prow;     // pivot row of each step
+  std::vector<int> pcol;     // pivot column of each step
+  std::vector<nr_complex_t> pivots;
+  std::vector<factor_t> L;   // row multipliers of each step
+  std::vector<factor_t> U;   // pivot row of each step (pivot excluded)
+  std::vector< std::vector< std::pair<int, int> > > steps;
+                             // steps (and index in L) eliminating a row
+};
+
+} // namespace qucs
+
+#endif /* __SPARSELU_H__ */
@@ -0,0 +1,225 @@
+/*
+ * spmnasolver.cpp - MNA based S-parameter solver class implementation
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <cmath>
+
+#include "object.h"
+#include "complex.h"
+#include "circuit.h"
+#include "net.h"
+#include "netdefs.h"
+#include "analysis.h"
+#include "nasolver.h"
+#include "nodelist.h"
+#include "logging.h"
+#include "spmnasolver.h"
+
+namespace qucs {
+
+// Constructor creates an instance of the MNA based S-parameter solver.
+spmnasolver::spmnasolver (net * n, int nois) : nasolver<nr_complex_t> () {
+  setNet (n);
+  setDescription ("SP");
+  noise = nois;
+  freq = 0;
+}
+
+// Destructor deletes the spmnasolver class object.
+spmnasolver::~spmnasolver () {
+}
+
+/* Goes through the list of circuit objects and runs its calcAC()
+   function.  The noise of the S-parameter ports is not part of the
+   network and therefore not computed. */
+void spmnasolver::calc (spmnasolver * self) {
+  circuit * root = self->getNet()->getRoot ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    c->calcAC (self->freq);
+    if (self->noise && !c->getPort ()) c->calcNoiseAC (self->freq);
+  }
+}
+
+/* The function initializes the circuits for the AC analysis, numbers
+   the nodes and voltage sources of the MNA equation system and
+   collects the S-parameter ports.  Unlike the other nodal analyses
+   the solver does not create the dense MNA matrix. */
+void spmnasolver::init (void) {
+  circuit * root = subnet->getRoot ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    if (c->isNonLinear ()) c->calcOperatingPoints ();
+    c->initAC ();
+    if (noise) c->initNoiseAC ();
+  }
+  setCalculation ((calculate_func_t) &calc);
+
+  // enumerate the nodes, the ground node gets a zero
+  nlist = new nodelist (subnet);
+  nlist->assignNodes ();
+  assignVoltageSources ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    for (int i = 0; i < c->getSize (); i++) c->getNode(i)->setNode (0);
+  }
+  for (int r = 0; r < countNodes (); r++) {
+    for (auto & n : *nlist->getNode (r)) n->setNode (r + 1);
+  }
+
+  // create an excitation vector for each port: a unit current flowing
+  // into the positive and out of the negative port node
+  int size = countNodes () + countVoltageSources ();
+  ports.clear (); zref.clear (); excite.clear ();
+  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+    if (!c->getPort ()) continue;
+    tvector<nr_complex_t> e (size);
+    int np = c->getNode(NODE_1)->getNode ();
+    int nn = c->getNode(NODE_2)->getNode ();
+    if (np > 0) e.set (np - 1, +1.0);
+    if (nn > 0) e.set (nn - 1, -1.0);
+    ports.push_back (c);
+    zref.push_back (c->getPropertyDouble ("Z"));
+    excite.push_back (e);
+  }
+  S = tmatrix<nr_complex_t> (getPorts ());
+  N = tmatrix<nr_complex_t> (getPorts ());
+}
+
+/* Puts the MNA matrix entries of all circuits into the sparse matrix,
+   see nasolver::createMatrix() for the structure of the matrix. */
+void spmnasolver::stampMatrix (void) {
+  int N = countNodes ();
+  lu.clear (N + countVoltageSources ());
+  circuit * root = subnet->getRoot ();
+  for (circuit * cir = root; cir != NULL; cir = (circuit *) cir->getNext ()) {
+    int s = cir->getSize (), v = cir->getVoltageSources ();
+    int vs = cir->getVoltageSource ();
+    int r, c, nr, nc;
+
+    // G-matrix entries
+    for (r = 0; r < s; r++) {
+      if ((nr = cir->getNode(r)->getNode () - 1) < 0) continue;
+      for (c = 0; c < s; c++) {
+	if ((nc = cir->getNode(c)->getNode () - 1) < 0) continue;
+	lu.add (nr, nc, cir->getY (r, c));
+      }
+    }
+    // B-, C- and D-matrix entries of the built in voltage sources
+    for (r = 0; r < v; r++) {
+      for (c = 0; c < s; c++) {
+	if ((nc = cir->getNode(c)->getNode () - 1) < 0) continue;
+	lu.add (nc, N + vs + r, cir->getB (c, vs + r));
+	lu.add (N + vs + r, nc, cir->getC (vs + r, c));
+      }
+      for (c = 0; c < v; c++) {
+	lu.add (N + vs + r, N + vs + c, cir->getD (vs + r, vs + c));
+      }
+    }
+  }
+}
+
+/* Collects the non-zero entries of the noise current correlation
+   matrix, see nasolver::createNoiseMatrix().  The S-parameter ports
+   are not part of the network and left out. */
+void spmnasolver::stampNoiseMatrix (void) {
+  int N = countNodes ();
+  Cy.clear ();
+  circuit * root = subnet->getRoot ();
+  for (circuit * cir = root; cir != NULL; cir = (circuit *) cir->getNext ()) {
+    if (cir->getPort ()) continue;
+    int s = cir->getSize (), v = cir->getVoltageSources ();
+    int vs = cir->getVoltageSource ();
+    int r, c, nr, nc;
+    nr_complex_t n;
+
+    for (r = 0; r < s + v; r++) {
+      if (r < s) {
+	if ((nr = cir->getNode(r)->getNode () - 1) < 0) continue;
+      } else {
+	nr = N + vs + r - s;
+      }
+      for (c = 0; c < s + v; c++) {
+	if (c < s) {
+	  if ((nc = cir->getNode(c)->getNode () - 1) < 0) continue;
+	} else {
+	  nc = N + vs + c - s;
+	}
+	if ((n = cir->getN (r, c)) != 0.0) Cy.push_back ({ nr, nc, n });
+      }
+    }
+  }
+}
+
+/* This function computes the S-parameters (and the noise wave
+   correlation matrix if requested) for the given frequency.  Each
+   port is terminated by its reference impedance and excited by a unit
+   current, thus the port voltages form the transimpedance matrix Zt
+   of the terminated network and S = 2 * Zt / sqrt (Zi * Zj) - E.  The
+   noise voltages at the ports are obtained by solving the adjoint
+   system with the very same LU decomposition. */
+void spmnasolver::calcSP (nr_double_t f) {
+  int r, c, n = getPorts ();
+  freq = f;
+
+  // create the MNA matrix and decompose it once
+  calculate ();
+  stampMatrix ();
+  if (lu.factorize () > 0) {
+    logprint (LOG_ERROR, "WARNING: %s: singular MNA matrix at %g Hz\n",
+	      desc.c_str (), f);
+  }
+
+  // solve for each port excitation
+  tvector<nr_complex_t> x;
+  for (c = 0; c < n; c++) {
+    lu.solve (x, excite[c]);
+    for (r = 0; r < n; r++) {
+      nr_complex_t v = scalar (excite[r], x);
+      S (r, c) = 2.0 * v / std::sqrt (zref[r] * zref[c]);
+      if (r == c) S (r, c) -= 1.0;
+    }
+  }
+
+  // compute the noise wave correlation matrix
+  if (noise) {
+    std::vector< tvector<nr_complex_t> > t (n);
+    stampNoiseMatrix ();
+    for (r = 0; r < n; r++) {
+      lu.solveTransposed (t[r], excite[r]); // transimpedances to the port
+    }
+    for (r = 0; r < n; r++) {
+      for (c = 0; c < n; c++) {
+	nr_complex_t v = 0.0;
+	for (auto & e : Cy) v += t[r] (e.r) * e.v * conj (t[c] (e.c));
+	N (r, c) = v / std::sqrt (zref[r] * zref[c]);
+      }
+    }
+  }
+}
+
+// The function releases the MNA equation system.
+void spmnasolver::finish (void) {
+  solve_post ();
+}
+
+} // namespace qucs
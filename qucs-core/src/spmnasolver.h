@@ -0,0 +1,77 @@
+/*
+ * spmnasolver.h - MNA based S-parameter solver class definitions
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef __SPMNASOLVER_H__
+#define __SPMNASOLVER_H__
+
+#include <vector>
+
+#include "nasolver.h"
+#include "sparselu.h"
+
+namespace qucs {
+
+class circuit;
+class net;
+
+/* The class computes the S-parameters and the noise wave correlation
+   matrix of a netlist at its AC power sources (the S-parameter ports)
+   using a single sparse factorization of the MNA matrix per
+   frequency. */
+class spmnasolver : public nasolver<nr_complex_t>
+{
+ public:
+  spmnasolver (net *, int);
+  ~spmnasolver ();
+  void init (void);
+  void calcSP (nr_double_t);
+  void finish (void);
+  static void calc (spmnasolver *);
+  int  getPorts (void) { return (int) ports.size (); }
+  circuit * getPort (int p) { return ports[p]; }
+  nr_complex_t getS (int r, int c) { return S (r, c); }
+  nr_complex_t getN (int r, int c) { return N (r, c); }
+
+ private:
+  void stampMatrix (void);
+  void stampNoiseMatrix (void);
+
+  // a single entry of the noise current correlation matrix
+  struct entry_t {
+    int r, c;
+    nr_complex_t v;
+  };
+
+  int noise;
+  nr_double_t freq;
+  std::vector<circuit *> ports;
+  std::vector<nr_double_t> zref;
+  std::vector< tvector<nr_complex_t> > excite;
+  sparselu lu;
+  std::vector<entry_t> Cy;
+  tmatrix<nr_complex_t> S;
+  tmatrix<nr_complex_t> N;
+};
+
+} // namespace qucs
+
+#endif /* __SPMNASOLVER_H__ */
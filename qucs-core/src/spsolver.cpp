@@ -46,6 +46,7 @@
 #include "netdefs.h"
 #include "characteristic.h"
 #include "spsolver.h"
+#include "spmnasolver.h"
 #include "constants.h"
 #include "components/component_id.h"
 #include "components/tee.h"
@@ -58,6 +59,7 @@
 #define USE_GROUNDS 1   // use extra grounds ?
 #define USE_CROSSES 1   // use additional cross connectors ?
 #define SORTED_LIST 1   // use sorted node list?
+#define MNA_NODES   256 // use the MNA engine for larger netlists
 
 #define TINYS (NR_TINY * 1.235) // 'tiny' value for singularities
 
@@ -72,6 +74,7 @@ spsolver::spsolver () : analysis () {
   nlist = NULL;
   tees = crosses = opens = grounds = 0;
   gnd = NULL;
+  mna = NULL;
 }
 
 // Constructor creates a named instance of the spsolver class.
@@ -83,6 +86,7 @@ spsolver::spsolver (char * n) : analysis (n) {
   nlist = NULL;
   tees = crosses = opens = grounds = 0;
   gnd = NULL;
+  mna = NULL;
 }
 
 // Destructor deletes the spsolver class object.
@@ -103,18 +107,23 @@ spsolver::spsolver (spsolver & n) : analysis (n) {
   swp = n.swp ? new sweep (*n.swp) : NULL;
   nlist = n.nlist ? new nodelist (*n.nlist) : NULL;
   gnd = n.gnd;
+  mna = NULL;
 }
 
 /* This function joins two nodes of a single circuit (interconnected
-   nodes) and returns the resulting circuit. */
-circuit * spsolver::interconnectJoin (node * n1, node * n2) {
+   nodes) and returns the resulting circuit.  If given the result is
+   stored in the circuit of a previous frequency. */
+circuit * spsolver::interconnectJoin (node * n1, node * n2,
+				      circuit * result) {
 
   circuit * s = n1->getCircuit ();
-  circuit * result = new circuit (s->getSize () - 2);
   nr_complex_t p;
 
   // allocate S-parameter and noise corellation matrices
-  result->initSP (); if (noise) result->initNoiseSP ();
+  if (result == NULL) {
+    result = new circuit (s->getSize () - 2);
+    result->initSP (); if (noise) result->initNoiseSP ();
+  }
 
   // interconnected port numbers
   int k = n1->getPort (), l = n2->getPort ();
@@ -168,16 +177,19 @@ circuit * spsolver::interconnectJoin (node * n1, node * n2) {
 }
 
 /* This function joins two nodes of two different circuits (connected
-   nodes) and returns the resulting circuit. */
-circuit * spsolver::connectedJoin (node * n1, node * n2) {
+   nodes) and returns the resulting circuit.  If given the result is
+   stored in the circuit of a previous frequency. */
+circuit * spsolver::connectedJoin (node * n1, node * n2, circuit * result) {
 
   circuit * s = n1->getCircuit ();
   circuit * t = n2->getCircuit ();
-  circuit * result = new circuit (s->getSize () + t->getSize () - 2);
   nr_complex_t p;
 
   // allocate S-parameter and noise corellation matrices
-  result->initSP (); if (noise) result->initNoiseSP ();
+  if (result == NULL) {
+    result = new circuit (s->getSize () + t->getSize () - 2);
+    result->initSP (); if (noise) result->initNoiseSP ();
+  }
 
   // connected port numbers
   int k = n1->getPort (), l = n2->getPort ();
@@ -461,19 +473,19 @@ void spsolver::reduce (void) {
 
 #if SORTED_LIST
   node * n1, * n2;
-  circuit * result, * cand1, * cand2;
+  circuit * cand1, * cand2;
 
   nlist->sortedNodes (&n1, &n2);
   cand1 = n1->getCircuit ();
   cand2 = n2->getCircuit ();
 #else /* !SORTED_LIST */
   node * n1, * n2, * cand;
-  circuit * result, * c1, * c2, * cand1, * cand2;
+  circuit * c1, * c2, * cand1, * cand2;
   int ports;
   circuit * root = subnet->getRoot ();
 
   // initialize local variables
-  result = c1 = c2 = cand1 = cand2 = NULL;
+  c1 = c2 = cand1 = cand2 = NULL;
   n1 = n2 = cand = NULL;
   ports = 10000; // huge
 
@@ -512,45 +524,101 @@ void spsolver::reduce (void) {
 
   // found a connection ?
   if (cand1 != NULL && cand2 != NULL) {
-    // connected
-    if (cand1 != cand2) {
+    // record the join in the reduction plan
+    spsolver_join j;
+    std::unordered_map<circuit *, int>::iterator it;
+    j.k = n1->getPort ();
+    j.l = n2->getPort ();
+    it = producer.find (cand1);
+    j.r1 = (it != producer.end ()) ? it->second : -1;
+    j.c1 = (j.r1 < 0) ? cand1 : NULL;
+    it = producer.find (cand2);
+    j.r2 = (it != producer.end ()) ? it->second : -1;
+    j.c2 = (j.r2 < 0) ? cand2 : NULL;
+    plan.push_back (j);
+    join (n1, n2, plan.size () - 1, 1);
+  }
+}
+
+/* This function joins the given nodes and replaces the circuits
+   involved by the resulting circuit.  If requested the sorted node
+   list is updated as well.  The resulting circuits are allocated for
+   the first frequency and reused for all further ones.  They stay
+   marked as original ones, thus the netlist does not delete them. */
+void spsolver::join (node * n1, node * n2, unsigned int n, int sorted) {
+  circuit * result, * cand1, * cand2;
+  cand1 = n1->getCircuit ();
+  cand2 = n2->getCircuit ();
+  circuit * reuse = (n < results.size ()) ? results[n] : NULL;
+  int drop1 = plan[n].r1 < 0, drop2 = plan[n].r2 < 0;
+
+  // connected
+  if (cand1 != cand2) {
 #if DEBUG && 0
-      logprint (LOG_STATUS, "DEBUG: connected node (%s): %s - %s\n",
-		n1->getName (), cand1->getName (), cand2->getName ());
+    logprint (LOG_STATUS, "DEBUG: connected node (%s): %s - %s\n",
+	      n1->getName (), cand1->getName (), cand2->getName ());
 #endif /* DEBUG */
-      result = connectedJoin (n1, n2);
-      if (noise) noiseConnect (result, n1, n2);
-      subnet->reducedCircuit (result);
+    result = connectedJoin (n1, n2, reuse);
+    if (noise) noiseConnect (result, n1, n2);
+    subnet->reducedCircuit (result);
 #if SORTED_LIST
+    if (sorted) {
       nlist->remove (cand1);
       nlist->remove (cand2);
       nlist->insert (result);
-#endif /* SORTED_LIST */
-      subnet->removeCircuit (cand1);
-      subnet->removeCircuit (cand2);
-      subnet->insertCircuit (result);
-      result->setOriginal (0);
     }
-    // interconnect
-    else {
+#endif /* SORTED_LIST */
+    subnet->removeCircuit (cand1, drop1);
+    subnet->removeCircuit (cand2, drop2);
+    subnet->insertCircuit (result);
+  }
+  // interconnect
+  else {
 #if DEBUG && 0
-      logprint (LOG_STATUS, "DEBUG: interconnected node (%s): %s\n",
-		n1->getName (), cand1->getName ());
+    logprint (LOG_STATUS, "DEBUG: interconnected node (%s): %s\n",
+	      n1->getName (), cand1->getName ());
 #endif
-      result = interconnectJoin (n1, n2);
-      if (noise) noiseInterconnect (result, n1, n2);
-      subnet->reducedCircuit (result);
+    result = interconnectJoin (n1, n2, reuse);
+    if (noise) noiseInterconnect (result, n1, n2);
+    subnet->reducedCircuit (result);
 #if SORTED_LIST
+    if (sorted) {
       nlist->remove (cand1);
       nlist->insert (result);
+    }
 #endif /* SORTED_LIST */
-      subnet->removeCircuit (cand1);
-      subnet->insertCircuit (result);
-      result->setOriginal (0);
+    subnet->removeCircuit (cand1, drop1);
+    subnet->insertCircuit (result);
+  }
+  if (sorted) producer[result] = n;
+  if (reuse == NULL) results.push_back (result);
+}
+
+/* The function takes the resulting circuits of the network reduction
+   out of the netlist and the given node list. */
+void spsolver::dropResults (nodelist * nodes) {
+  for (unsigned int i = 0; i < results.size (); i++) {
+    circuit * c = results[i];
+    if (c->isEnabled ()) {
+      if (nodes) nodes->remove (c);
+      subnet->removeCircuit (c, 0);
     }
   }
 }
 
+/* The function reduces the network by performing the joins recorded
+   in the reduction plan.  The topology is the same for each frequency,
+   thus the search for the best connection is done for the first
+   frequency only. */
+void spsolver::replay (void) {
+  for (unsigned int i = 0; i < plan.size (); i++) {
+    spsolver_join & j = plan[i];
+    circuit * s = (j.r1 >= 0) ? results[j.r1] : j.c1;
+    circuit * t = (j.r2 >= 0) ? results[j.r2] : j.c2;
+    join (s->getNode (j.k), t->getNode (j.l), i, 0);
+  }
+}
+
 /* Goes through the list of circuit objects and runs initializing
    functions if necessary. */
 void spsolver::init (void) {
@@ -581,9 +649,19 @@ int spsolver::solve (void) {
     swp = createSweep ("frequency");
   }
 
+  // solve large netlists using the (sparse) MNA engine
+  const char * engine = getPropertyString ("Engine");
+  if (!strcmp (engine, "MNA") ||
+      (!strcmp (engine, "auto") && subnet->countNodes () > MNA_NODES)) {
+    return solve_mna ();
+  }
+
   init ();
   insertConnections ();
 
+  // index the circuit nodes by name for the network reduction
+  subnet->buildNodeIndex ();
+
 #if SORTED_LIST
 #if DEBUG
   logprint (LOG_STATUS, "NOTIFY: %s: creating sorted nodelist for "
@@ -597,10 +675,15 @@ int spsolver::solve (void) {
   logprint (LOG_STATUS, "NOTIFY: %s: solving SP netlist\n", getName ());
 #endif
 
+  // the reduction plan is created for the first frequency
+  plan.clear ();
+  producer.clear ();
+  results.clear ();
+
   swp->reset ();
   for (int i = 0; i < swp->getSize (); i++) {
     freq = swp->next ();
-    if (progress) logprogressbar (i, swp->getSize (), 40);
+    reportProgress (i, swp->getSize ());
 
     ports = subnet->countNodes ();
     subnet->setReduced (0);
@@ -611,17 +694,28 @@ int spsolver::solve (void) {
 	      getName (), (double) freq);
 #endif
 
-    while (ports > subnet->getPorts ()) {
-      reduce ();
-      ports -= 2;
+    if (i == 0) {
+      while (ports > subnet->getPorts ()) {
+	reduce ();
+	ports -= 2;
+      }
+      producer.clear ();
+    }
+    else {
+      replay ();
     }
 
     saveResults (freq);
-    subnet->getDroppedCircuits (nlist);
-    subnet->deleteUnusedCircuits (nlist);
+    dropResults (i == 0 ? nlist : NULL);
+    subnet->getDroppedCircuits (i == 0 ? nlist : NULL);
+    subnet->deleteUnusedCircuits (i == 0 ? nlist : NULL);
     if (saveCVs & SAVE_CVS) saveCharacteristics (freq);
   }
   if (progress) logprogressclear (40);
+  subnet->dropNodeIndex ();
+  plan.clear ();
+  for (unsigned int i = 0; i < results.size (); i++) delete results[i];
+  results.clear ();
   dropConnections ();
 #if SORTED_LIST
   delete nlist; nlist = NULL;
@@ -629,6 +723,34 @@ int spsolver::solve (void) {
   return 0;
 }
 
+/* This is the alternative netlist solver.  Instead of reducing the
+   network it computes the S-parameters by a nodal analysis of the
+   whole netlist for each requested frequency. */
+int spsolver::solve_mna (void) {
+  nr_double_t freq;
+
+#if DEBUG
+  logprint (LOG_STATUS, "NOTIFY: %s: solving SP netlist using MNA\n",
+	    getName ());
+#endif
+
+  mna = new spmnasolver (subnet, noise);
+  mna->init ();
+
+  swp->reset ();
+  for (int i = 0; i < swp->getSize (); i++) {
+    freq = swp->next ();
+    reportProgress (i, swp->getSize ());
+    mna->calcSP (freq);
+    saveResults (freq);
+    if (saveCVs & SAVE_CVS) saveCharacteristics (freq);
+  }
+  if (progress) logprogressclear (40);
+  mna->finish ();
+  delete mna; mna = NULL;
+  return 0;
+}
+
 /* The function goes through the list of circuit objects and creates
    tee and cross circuits if necessary.  It looks for nodes in the
    circuit list connected to the given node. */
@@ -971,8 +1093,6 @@ void spsolver::saveResults (nr_double_t freq) {
 
   vector * f;
   node * sig_i, * sig_j;
-  char * n;
-  int res_i, res_j;
   circuit * root = subnet->getRoot ();
 
   // temporary noise matrices and input port impedance
@@ -986,41 +1106,27 @@ void spsolver::saveResults (nr_double_t freq) {
   }
   if (runs == 1) f->add (freq);
 
+  // results of the MNA engine
+  if (mna != NULL) {
+    for (int i = 0; i < mna->getPorts (); i++) {
+      for (int j = 0; j < mna->getPorts (); j++) {
+	saveParameter (mna->getPort (i), mna->getPort (j), mna->getS (i, j),
+		       noise ? mna->getN (i, j) : 0.0, f, noise_s, noise_c, z0);
+      }
+    }
+  }
   // go through the list of remaining circuits
-  for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
+  else for (circuit * c = root; c != NULL; c = (circuit *) c->getNext ()) {
     // skip signals
     if (!c->getPort ()) {
       // handle each s-parameter
       for (int i = 0; i < c->getSize (); i++) {
 	for (int j = 0; j < c->getSize (); j++) {
-
-	  // generate the appropriate variable name
 	  sig_i = subnet->findConnectedNode (c->getNode (i));
 	  sig_j = subnet->findConnectedNode (c->getNode (j));
-	  res_i = sig_i->getCircuit()->getPropertyInteger ("Num");
-	  res_j = sig_j->getCircuit()->getPropertyInteger ("Num");
-	  n = createSP (res_i, res_j);
-
-	  // add variable data item to dataset
-	  saveVariable (n, c->getS (i, j), f);
-
-	  // if noise analysis is requested
-	  if (noise) {
-	    int ro, co;
-	    int ni = getPropertyInteger ("NoiseIP");
-	    int no = getPropertyInteger ("NoiseOP");
-	    if ((res_i == ni || res_i == no) && (res_j == ni || res_j == no)) {
-	      if (ni == res_i) {
-		// assign input port impedance
-		z0 = sig_i->getCircuit()->getPropertyDouble ("Z");
-	      }
-	      ro = (res_i == ni) ? 0 : 1;
-	      co = (res_j == ni) ? 0 : 1;
-	      // save results in temporary data items
-	      noise_c[co + ro * 2] = c->getN (i, j);
-	      noise_s[co + ro * 2] = c->getS (i, j);
-	    }
-	  }
+	  saveParameter (sig_i->getCircuit (), sig_j->getCircuit (),
+			 c->getS (i, j), noise ? c->getN (i, j) : 0.0,
+			 f, noise_s, noise_c, z0);
 	}
       }
     }
@@ -1032,6 +1138,40 @@ void spsolver::saveResults (nr_double_t freq) {
   }
 }
 
+/* The function saves the s-parameter between the given ports into the
+   output dataset and collects the noise wave correlation values of
+   the noise input and output ports. */
+void spsolver::saveParameter (circuit * port_i, circuit * port_j,
+			      nr_complex_t s, nr_complex_t n, vector * f,
+			      nr_complex_t noise_s[4], nr_complex_t noise_c[4],
+			      nr_double_t & z0) {
+
+  // generate the appropriate variable name
+  int res_i = port_i->getPropertyInteger ("Num");
+  int res_j = port_j->getPropertyInteger ("Num");
+
+  // add variable data item to dataset
+  saveVariable (createSP (res_i, res_j), s, f);
+
+  // if noise analysis is requested
+  if (noise) {
+    int ro, co;
+    int ni = getPropertyInteger ("NoiseIP");
+    int no = getPropertyInteger ("NoiseOP");
+    if ((res_i == ni || res_i == no) && (res_j == ni || res_j == no)) {
+      if (ni == res_i) {
+	// assign input port impedance
+	z0 = port_i->getPropertyDouble ("Z");
+      }
+      ro = (res_i == ni) ? 0 : 1;
+      co = (res_j == ni) ? 0 : 1;
+      // save results in temporary data items
+      noise_c[co + ro * 2] = n;
+      noise_s[co + ro * 2] = s;
+    }
+  }
+}
+
 /* This function takes the s-parameter matrix and noise wave
    correlation matrix and computes the noise parameters based upon
    these values.  Then it save the results into the dataset. */
@@ -1115,6 +1255,8 @@ PROP_OPT [] = {
   { "Values", PROP_LIST, { 10, PROP_NO_STR }, PROP_POS_RANGE },
   { "saveCVs", PROP_STR, { PROP_NO_VAL, "no" }, PROP_RNG_YESNO },
   { "saveAll", PROP_STR, { PROP_NO_VAL, "no" }, PROP_RNG_YESNO },
+  { "Engine", PROP_STR, { PROP_NO_VAL, "auto" },
+    PROP_RNG_STR3 ("auto", "reduction", "MNA") },
   PROP_NO_PROP };
 struct define_t spsolver::anadef =
   { "SP", 0, PROP_ACTION, PROP_NO_SUBSTRATE, PROP_LINEAR, PROP_DEF };
@@ -26,6 +26,8 @@
 #define __SPSOLVER_H__
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 namespace qucs {
 
@@ -35,6 +37,16 @@ class node;
 class vector;
 class sweep;
 class nodelist;
+class spmnasolver;
+
+/* A single join of the network reduction.  Each operand is either an
+   original circuit or the result of a previous join given by its
+   index in the reduction plan. */
+struct spsolver_join {
+  circuit * c1, * c2; // original circuits (or NULL)
+  int r1, r2;         // indices of producing joins (or -1)
+  int k, l;           // port numbers of the joined nodes
+};
 
 class spsolver : public analysis
 {
@@ -46,7 +58,11 @@ class spsolver : public analysis
   void calc (nr_double_t);
   void init (void);
   void reduce (void);
+  void join (node *, node *, unsigned int, int);
+  void replay (void);
+  void dropResults (nodelist * nodes = NULL);
   int  solve (void);
+  int  solve_mna (void);
   void insertConnections (void);
   void insertDifferentialPorts (void);
   void insertTee (node **, const char *);
@@ -54,11 +70,14 @@ class spsolver : public analysis
   void insertConnectors (node *);
   void insertOpen (node *);
   void insertGround (node *);
-  circuit * interconnectJoin (node *, node *);
-  circuit * connectedJoin (node *, node *);
+  circuit * interconnectJoin (node *, node *, circuit * result = NULL);
+  circuit * connectedJoin (node *, node *, circuit * result = NULL);
   void noiseConnect (circuit *, node *, node *);
   void noiseInterconnect (circuit *, node *, node *);
   void saveResults (nr_double_t);
+  void saveParameter (circuit *, circuit *, nr_complex_t, nr_complex_t,
+		      vector *, nr_complex_t[4], nr_complex_t[4],
+		      nr_double_t &);
   void saveNoiseResults (nr_complex_t[4], nr_complex_t[4],
 			 nr_double_t, vector *);
   char * createSP (int, int);
@@ -78,6 +97,10 @@ class spsolver : public analysis
   sweep * swp;
   nodelist * nlist;
   circuit * gnd;
+  spmnasolver * mna;
+  std::vector<spsolver_join> plan;
+  std::vector<circuit *> results;
+  std::unordered_map<circuit *, int> producer;
 };
 
 } // namespace qucs
@@ -34,6 +34,20 @@
 
 namespace qucs {
 
+// Allocates a zeroed string list entry from the memory pool.
+static struct strlist_t * newEntry (void) {
+  struct strlist_t * s;
+  s = (struct strlist_t *) mempool::alloc (sizeof (struct strlist_t));
+  s->str = NULL;
+  s->next = NULL;
+  return s;
+}
+
+// Returns a string list entry to the memory pool.
+static void freeEntry (struct strlist_t * s) {
+  mempool::free (s, sizeof (struct strlist_t));
+}
+
 // Constructor creates an instance of the strlist class.
 strlist::strlist () {
   root = NULL;
@@ -55,7 +69,7 @@ strlist::~strlist () {
   while (root) {
     next = root->next;
     free (root->str);
-    free (root);
+    freeEntry (root);
     root = next;
   }
   free (txt);
@@ -64,7 +78,7 @@ strlist::~strlist () {
 // This function adds a string to the list.
 void strlist::add (const char * const str) {
   struct strlist_t * s;
-  s = (struct strlist_t *) calloc (sizeof (struct strlist_t), 1);
+  s = newEntry ();
   s->next = root;
   s->str = str ? strdup (str) : NULL;
   root = s;
@@ -86,7 +100,7 @@ void strlist::append (const strlist * const lst) {
 // This function append a string to the list.
 void strlist::append (const char * const str) {
   struct strlist_t * s;
-  s = (struct strlist_t *) calloc (sizeof (struct strlist_t), 1);
+  s = newEntry ();
   s->next = NULL;
   s->str = str ? strdup (str) : NULL;
   if (root) {
@@ -160,7 +174,7 @@ void strlist::del (strlist * cand) {
     next = root->next;
     if (cand->contains (root->str) == 0) res->append (root->str);
     free (root->str);
-    free (root);
+    freeEntry (root);
     root = next;
   }
   *this = *res;
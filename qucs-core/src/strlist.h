@@ -25,6 +25,8 @@
 #ifndef __STRLIST_H__
 #define __STRLIST_H__
 
+#include "mempool.h"
+
 namespace qucs {
 
 /* String list entry. */
@@ -42,6 +44,7 @@ class strlist
   strlist ();
   strlist (const strlist &);
   ~strlist ();
+  MEMPOOL_OPERATORS
   void add (const char * const);
   void add (const strlist * const);
   void append (const char * const);
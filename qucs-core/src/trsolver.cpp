@@ -131,6 +131,14 @@ int trsolver::dcAnalysis (void)
     solve_pre ();
     applyNodeset ();
 
+    // Start at the solution of the previous sweep point if available.
+    if (sweepSeed ())
+    {
+        recallSolution ();
+        if (xprev != NULL) *xprev = *x;
+        saveSolution ();
+    }
+
     // Run the DC solver once.
     try_running ()
     {
@@ -156,6 +164,7 @@ int trsolver::dcAnalysis (void)
     }
 
     // Save the DC solution.
+    if (!error) storeSweepPoint ();
     storeSolution ();
 
     // Cleanup nodal analysis solver.
@@ -237,7 +246,7 @@ int trsolver::solve (void)
     for (int i = 0; i < swp->getSize (); i++)
     {
         time = swp->next ();
-        if (progress) logprogressbar (i, swp->getSize (), 40);
+        reportProgress (i, swp->getSize ());
 
 #if DEBUG && 0
         logprint (LOG_STATUS, "NOTIFY: %s: solving netlist for t = %e\n",
@@ -971,6 +980,8 @@ PROP_OPT [] =
     { "Solver", PROP_STR, { PROP_NO_VAL, "CroutLU" }, PROP_RNG_SOL },
     { "relaxTSR", PROP_STR, { PROP_NO_VAL, "no" }, PROP_RNG_YESNO },
     { "initialDC", PROP_STR, { PROP_NO_VAL, "yes" }, PROP_RNG_YESNO },
+    { "sweepSeed", PROP_STR, { PROP_NO_VAL, "constant" },
+      PROP_RNG_STR4 ("none", "constant", "linear", "quadratic") },
     PROP_NO_PROP
 };
 struct define_t trsolver::anadef =
@@ -47,6 +47,11 @@
 #include "exceptionstack.h"
 #include "check_netlist.h"
 #include "module.h"
+#include "datacache.h"
+#include "prima.h"
+#include "dcsolver.h"
+#include "analysis.h"
+#include "server.h"
 
 #if HAVE_UNISTD_H
 #include <unistd.h>
@@ -68,6 +73,8 @@ int main (int argc, char ** argv) {
   int listing = 0;
   int ret = 0;
   int dynamicLoad = 0;
+  int reduce = 0;
+  int serve = 0;
 
   std::list<std::string> vamodules;
 
@@ -102,7 +109,13 @@ int main (int argc, char ** argv) {
 	"  -o FILENAME    use file as output dataset (default stdout)\n"
 	"  -b, --bar      enable textual progress bar\n"
 	"  -g, --gui      special progress bar used by gui\n"
+	"  -S, --status   machine readable progress lines and partial results\n"
 	"  -c, --check    check the input netlist and exit\n"
+	"  -r, --reduce   reduce linear RLC subcircuits before the analyses,\n"
+	"                 their internal node voltages are not saved\n"
+	"  -s, --server   keep the netlist loaded and serve commands on stdin\n"
+	"  -d, --dccache DIRECTORY\n"
+	"                 cache DC operating points in directory\n"
 #if DEBUG
     "  -l, --listing  emit C-code for available definitions\n"
 #endif
@@ -116,7 +129,6 @@ int main (int argc, char ** argv) {
     }
     else if (!strcmp (argv[i], "-o")) {
       outfile = argv[++i];
-      redirect_status_to_stdout();
     }
     else if (!strcmp (argv[i], "-b") || !strcmp (argv[i], "--bar")) {
       progressbar_enable = 1;
@@ -124,9 +136,21 @@ int main (int argc, char ** argv) {
     else if (!strcmp (argv[i], "-g") || !strcmp (argv[i], "--gui")) {
       progressbar_gui = 1;
     }
+    else if (!strcmp (argv[i], "-S") || !strcmp (argv[i], "--status")) {
+      analysis_status = 1;
+    }
     else if (!strcmp (argv[i], "-c") || !strcmp (argv[i], "--check")) {
       netlist_check = 1;
     }
+    else if (!strcmp (argv[i], "-r") || !strcmp (argv[i], "--reduce")) {
+      reduce = 1;
+    }
+    else if (!strcmp (argv[i], "-s") || !strcmp (argv[i], "--server")) {
+      serve = 1;
+    }
+    else if (!strcmp (argv[i], "-d") || !strcmp (argv[i], "--dccache")) {
+      dcsolver::cacheDir = argv[++i];
+    }
     else if (!strcmp (argv[i], "-l") || !strcmp (argv[i], "--listing")) {
       listing = 1;
     }
@@ -144,6 +168,25 @@ int main (int argc, char ** argv) {
     }
   }
 
+  // stdout carries the answers of the server, results are requested
+  // by commands and the netlist changes between the simulations
+  if (serve && outfile) {
+    logprint (LOG_ERROR, "option -o cannot be used with --server, use "
+	      "the `dataset FILE' command instead\n");
+    return -1;
+  }
+  if (serve && reduce) {
+    logprint (LOG_ERROR, "option --reduce cannot be used with --server, "
+	      "reduced models do not follow changed values\n");
+    return -1;
+  }
+
+  // status messages go to stdout if the dataset does not
+  if (outfile) redirect_status_to_stdout ();
+
+  // write partial results into the output dataset
+  if (analysis_status) analysis_partial = outfile;
+
   // create static modules
   module::registerModules ();
 
@@ -161,7 +204,7 @@ int main (int argc, char ** argv) {
     module::registerDynamicModules (projPath, vamodules);
   }
 
-  else { //no argument, look into netlist
+  else if (infile || !serve) { //no argument, look into netlist
 
     std::string sLine = "";
     std::ifstream file;
@@ -216,6 +259,27 @@ int main (int argc, char ** argv) {
     file.close();
   }
 
+  // serve commands on stdin, the netlist is kept between simulations
+  if (serve) {
+    server * srv = new server (stdin, stdout);
+    FILE * f = infile ? fopen (infile, "r") : NULL;
+    if (infile && f == NULL) {
+      logprint (LOG_ERROR, "cannot open file `%s'\n", infile);
+      ret = -1;
+    }
+    else if (f == NULL || srv->load (f) == 0) {
+      srv->run ();
+    }
+    else {
+      ret = -1;
+    }
+    delete srv;
+    module::unregisterModules ();
+    module::closeDynamicLibs ();
+    datacache::clear ();
+    mempool::release ();
+    return ret;
+  }
 
   // create root environment
   root = new environment (std::string("root"));
@@ -246,6 +310,12 @@ int main (int argc, char ** argv) {
   gnd->setName ("GND");
   subnet->insertCircuit (gnd);
 
+  // replace linear subcircuits by reduced order models if requested
+  if (reduce) {
+    prima mor (subnet);
+    mor.reduce ();
+  }
+
   // analyse the netlist
   int err = 0;
   out = subnet->runAnalysis (err);
@@ -270,5 +340,9 @@ int main (int argc, char ** argv) {
   module::closeDynamicLibs();
 
   netlist_destroy_env ();
+
+  // drop shared data files and give pooled memory back at once
+  datacache::clear ();
+  mempool::release ();
   return ret;
 }
@@ -0,0 +1,253 @@
+/*
+ * Dataset.cpp - Unit test for dataset loading
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <utime.h>
+#include <cmath>
+#include <string>
+
+#include "qucs_typedefs.h"
+#include "object.h"
+#include "complex.h"
+#include "strlist.h"
+#include "vector.h"
+#include "dataset.h"
+#include "datacache.h"
+
+#include "gtest/gtest.h"  // Google Test
+
+static void write_file (const char * file, const char * text) {
+  FILE * f = fopen (file, "w");
+  ASSERT_TRUE (f != NULL);
+  fputs (text, f);
+  fclose (f);
+}
+
+TEST (dataset, load_fast) {
+  const char * file = "dataset_load_fast.dat";
+  write_file (file,
+    "<Qucs Dataset 0.0.19>\n"
+    "# values in all the accepted notations\n"
+    "<indep freq 3>\n"
+    "  +1.00000000000000000000e+09\n"
+    "  2e9 # trailing comment\n"
+    "  .3e10\n"
+    "</indep>\n"
+    "<dep S[1,1] freq>\n"
+    "  +5.0e-01-j2.5e-01\n"
+    "  -j0.125 1\n"
+    "</dep>\n");
+
+  qucs::dataset * data = qucs::dataset::load_fast (file);
+  ASSERT_TRUE (data != NULL);
+
+  qucs::vector * freq = data->findDependency ("freq");
+  ASSERT_TRUE (freq != NULL);
+  EXPECT_EQ (3, freq->getSize ());
+  EXPECT_EQ (3, freq->getRequested ());
+  EXPECT_EQ (1e9, real (freq->get (0)));
+  EXPECT_EQ (2e9, real (freq->get (1)));
+  EXPECT_EQ (3e9, real (freq->get (2)));
+
+  qucs::vector * s = data->findVariable ("S[1,1]");
+  ASSERT_TRUE (s != NULL);
+  EXPECT_EQ (3, s->getSize ());
+  EXPECT_STREQ ("freq", s->getDependencies ()->get (0));
+  EXPECT_EQ (nr_complex_t (0.5, -0.25), s->get (0));
+  EXPECT_EQ (nr_complex_t (0.0, -0.125), s->get (1));
+  EXPECT_EQ (nr_complex_t (1.0, 0.0), s->get (2));
+
+  delete data;
+  remove (file);
+}
+
+TEST (dataset, load_fast_fallback) {
+  const char * file = "dataset_load_fallback.dat";
+  // line continuations are left to the grammar based parser
+  write_file (file,
+    "<Qucs Dataset 0.0.19>\n"
+    "<indep x 2>\n"
+    "  1 \\\n"
+    "  2\n"
+    "</indep>\n");
+  EXPECT_TRUE (qucs::dataset::load_fast (file) == NULL);
+  remove (file);
+}
+
+// Compares two datasets including names, dependencies and all values.
+static void expect_equal (qucs::dataset * a, qucs::dataset * b) {
+  qucs::vector * u, * v;
+  EXPECT_EQ (a->countDependencies (), b->countDependencies ());
+  EXPECT_EQ (a->countVariables (), b->countVariables ());
+  for (u = a->getDependencies (), v = b->getDependencies (); u && v;
+       u = (qucs::vector *) u->getNext (), v = (qucs::vector *) v->getNext ()) {
+    EXPECT_STREQ (u->getName (), v->getName ());
+    EXPECT_EQ (u->getRequested (), v->getRequested ());
+    ASSERT_EQ (u->getSize (), v->getSize ());
+    for (int i = 0; i < u->getSize (); i++)
+      ASSERT_EQ (u->get (i), v->get (i)) << u->getName () << "[" << i << "]";
+  }
+  for (u = a->getVariables (), v = b->getVariables (); u && v;
+       u = (qucs::vector *) u->getNext (), v = (qucs::vector *) v->getNext ()) {
+    EXPECT_STREQ (u->getName (), v->getName ());
+    ASSERT_EQ (u->getDependencies ()->length (),
+	       v->getDependencies ()->length ());
+    for (int i = 0; i < u->getDependencies ()->length (); i++)
+      EXPECT_STREQ (u->getDependencies ()->get (i),
+		    v->getDependencies ()->get (i));
+    ASSERT_EQ (u->getSize (), v->getSize ());
+    for (int i = 0; i < u->getSize (); i++)
+      ASSERT_EQ (u->get (i), v->get (i)) << u->getName () << "[" << i << "]";
+  }
+}
+
+TEST (dataset, load_fast_large) {
+  const char * file = "dataset_load_large.dat";
+  const int n = 20000;
+  char buf[128];
+  unsigned int seed = 1;
+  std::string text ("<Qucs Dataset 0.0.19>\n");
+
+  // a file above the size converted on several threads
+  text += "<indep time 20000>\n";
+  for (int i = 0; i < n; i++) {
+    snprintf (buf, sizeof (buf), "  %+.20e\n", i * 1e-9 / 3);
+    text += buf;
+  }
+  text += "</indep>\n";
+  text += "<dep V.out_1 time>\r\n";
+  for (int i = 0; i < n; i++) {
+    seed = seed * 1103515245 + 12345;
+    double x = ((int) (seed >> 8) - (1 << 22)) / 65536.0;
+    switch (i % 5) {
+    case 0: snprintf (buf, sizeof (buf), "%.17g\r\n", x); break;
+    case 1: snprintf (buf, sizeof (buf), "%g\r\n", x * 1e-30); break;
+    case 2: snprintf (buf, sizeof (buf), "%d\r\n", (int) x); break;
+    case 3: snprintf (buf, sizeof (buf), "%.3E # note\r\n", x); break;
+    case 4: snprintf (buf, sizeof (buf), "  %.25f\r\n", x); break;
+    }
+    text += buf;
+  }
+  text += "</dep>\n";
+  text += "<dep S[2,1] time>\n";
+  for (int i = 0; i < n; i++) {
+    seed = seed * 1103515245 + 12345;
+    double x = ((int) (seed >> 8) - (1 << 22)) / 1024.0;
+    if (i % 3 == 0)
+      snprintf (buf, sizeof (buf), "  %+.20e%cj%.20e\n", x, i % 2 ? '+' : '-',
+		std::fabs (x / 7));
+    else if (i % 3 == 1)
+      snprintf (buf, sizeof (buf), "  -j%.12f\n", std::fabs (x));
+    else
+      snprintf (buf, sizeof (buf), "  %.15e+j%.15e\n", x, std::fabs (x * 3));
+    text += buf;
+  }
+  text += "</dep>\n";
+  ASSERT_GT (text.size (), (size_t) (1 << 20));
+  write_file (file, text.c_str ());
+
+  qucs::dataset * fast = qucs::dataset::load_fast (file);
+  qucs::dataset * data = qucs::dataset::load_grammar (file);
+  ASSERT_TRUE (fast != NULL);
+  ASSERT_TRUE (data != NULL);
+  EXPECT_EQ (n, fast->getVariables ()->getSize ());
+  expect_equal (fast, data);
+
+  delete fast;
+  delete data;
+  remove (file);
+}
+
+TEST (dataset, load_fast_strict) {
+  const char * file = "dataset_load_strict.dat";
+  // each of these is rejected by the grammar based parser
+  static const char * texts[] = {
+    "<Qucs Dataset foo>\n<indep x 1>\n1\n</indep>\n",
+    "<Qucs Dataset 0.0.19> # note\n<indep x 1>\n1\n</indep>\n",
+    "<Qucs Dataset 0.0.19>\n<indep 1x 1>\n1\n</indep>\n",
+    "<Qucs Dataset 0.0.19>\n<indep x. 1>\n1\n</indep>\n",
+    "<Qucs Dataset 0.0.19>\n<indep x.1[2] 1>\n1\n</indep>\n",
+    "<Qucs Dataset 0.0.19>\n<indep x 1>\n1\n</indep>\n<dep y dep>\n1\n"
+    "</dep>\n",
+    "<Qucs Dataset 0.0.19>\n<indep x 1>\n1\r</indep>\n",
+    "<Qucs Dataset 0.0.19>\n<indep x 1.5>\n1\n</indep>\n",
+    NULL
+  };
+  for (int i = 0; texts[i] != NULL; i++) {
+    write_file (file, texts[i]);
+    EXPECT_TRUE (qucs::dataset::load_fast (file) == NULL) << texts[i];
+  }
+  remove (file);
+}
+
+// number of existing counted tables
+static int tables = 0;
+
+class counted_table : public qucs::datacache_table
+{
+ public:
+  counted_table () { tables++; }
+  ~counted_table () { tables--; }
+};
+
+// loader creating an empty dataset for any file
+static qucs::dataset * load_empty (const char *) {
+  return new qucs::dataset ();
+}
+
+TEST (datacache, tables) {
+  const char * file = "datacache_tables.dat";
+  write_file (file, "data\n");
+
+  // the table is shared by all users of the dataset
+  qucs::dataset * d1 = qucs::datacache::load (file, load_empty);
+  ASSERT_TRUE (d1 != NULL);
+  EXPECT_TRUE (qucs::datacache::getTable (d1, "t") == NULL);
+  counted_table * t = new counted_table ();
+  qucs::datacache::setTable (d1, "t", t);
+  qucs::dataset * d2 = qucs::datacache::load (file, load_empty);
+  EXPECT_EQ (d1, d2);
+  EXPECT_EQ (t, qucs::datacache::getTable (d2, "t"));
+  EXPECT_TRUE (qucs::datacache::getTable (d2, "u") == NULL);
+  qucs::datacache::release (d1);
+  qucs::datacache::release (d2);
+  EXPECT_EQ (1, tables);
+
+  // a modified file drops the unused dataset and its tables
+  struct stat st;
+  ASSERT_EQ (0, stat (file, &st));
+  struct utimbuf times;
+  times.actime = st.st_atime;
+  times.modtime = st.st_mtime + 10;
+  ASSERT_EQ (0, utime (file, &times));
+  qucs::dataset * d3 = qucs::datacache::load (file, load_empty);
+  ASSERT_TRUE (d3 != NULL);
+  EXPECT_EQ (0, tables);
+  EXPECT_TRUE (qucs::datacache::getTable (d3, "t") == NULL);
+
+  // clearing the cache drops all tables
+  qucs::datacache::setTable (d3, "t", new counted_table ());
+  EXPECT_EQ (1, tables);
+  qucs::datacache::release (d3);
+  qucs::datacache::clear ();
+  EXPECT_EQ (0, tables);
+  remove (file);
+}
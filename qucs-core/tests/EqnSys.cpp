@@ -0,0 +1,114 @@
+/*
+ * EqnSys.cpp - Unit test for the equation system solver
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "qucs_typedefs.h"
+#include "complex.h"
+#include "tvector.h"
+#include "tmatrix.h"
+#include "eqnsys.h"
+#include "sparselu.h"
+
+#include "testDefine.h"   // constants used on tests
+#include "gtest/gtest.h"  // Google Test
+
+// non-symmetric matrix which requires row exchanges
+static nr_complex_t ta[3][3] = {
+  { nr_complex_t (0.0, 1.0), 2.0, 1.0 },
+  { 4.0, nr_complex_t (1.0, -1.0), 0.0 },
+  { 1.0, 3.0, nr_complex_t (5.0, 2.0) }
+};
+
+TEST (eqnsys, lu_crout_transposed) {
+  qucs::tmatrix<nr_complex_t> A (3), T (3);
+  qucs::tvector<nr_complex_t> x (3), b (3);
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      A.set (r, c, ta[r][c]);
+      T.set (c, r, ta[r][c]);
+    }
+  }
+  b.set (0, 1.0); b.set (1, nr_complex_t (0.0, -2.0)); b.set (2, 3.0);
+
+  // decompose the matrix once
+  qucs::eqnsys<nr_complex_t> eqns;
+  eqns.setAlgo (ALGO_LU_FACTORIZATION_CROUT);
+  eqns.passEquationSys (&A, &x, &b);
+  eqns.solve ();
+
+  // solve the transposed system using the decomposition
+  eqns.setAlgo (ALGO_LU_SUBSTITUTION_CROUT_TRANSPOSED);
+  eqns.passEquationSys (NULL, &x, &b);
+  eqns.solve ();
+
+  // check the residual of the transposed system
+  qucs::tvector<nr_complex_t> r = T * x;
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR (real (b.get (i)), real (r.get (i)), tol);
+    EXPECT_NEAR (imag (b.get (i)), imag (r.get (i)), tol);
+  }
+}
+
+// checks the residual of A x = b (or of A^T x = b)
+static void check_residual (nr_complex_t a[3][3], qucs::tvector<nr_complex_t> & x,
+			    qucs::tvector<nr_complex_t> & b, bool transposed) {
+  for (int r = 0; r < 3; r++) {
+    nr_complex_t v = 0.0;
+    for (int c = 0; c < 3; c++) v += (transposed ? a[c][r] : a[r][c]) * x (c);
+    EXPECT_NEAR (real (b (r)), real (v), tol);
+    EXPECT_NEAR (imag (b (r)), imag (v), tol);
+  }
+}
+
+TEST (sparselu, solve) {
+  // sparse matrix with a zero on the diagonal
+  nr_complex_t a[3][3] = {
+    { 0.0, 2.0, 1.0 },
+    { 4.0, nr_complex_t (1.0, -1.0), 0.0 },
+    { 1.0, 0.0, nr_complex_t (5.0, 2.0) }
+  };
+  qucs::tvector<nr_complex_t> x, b (3);
+  b.set (0, 1.0); b.set (1, nr_complex_t (0.0, -2.0)); b.set (2, 3.0);
+
+  qucs::sparselu lu;
+  for (int pass = 0; pass < 3; pass++) {
+    // same structure, other values: the pivot order is reused
+    if (pass > 0) {
+      a[0][1] *= 10.0;
+      a[2][2] = nr_complex_t (-1.0, pass);
+    }
+    // the last pass makes the previous first pivot vanish
+    if (pass == 2) a[1][0] = 1e-9;
+    lu.clear (3);
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++) lu.add (r, c, a[r][c]);
+    EXPECT_EQ (lu.getEntries (), 6);
+    EXPECT_EQ (lu.factorize (), 0);
+    lu.solve (x, b);
+    check_residual (a, x, b, false);
+    lu.solveTransposed (x, b);
+    check_residual (a, x, b, true);
+  }
+
+  // singular matrices get a tiny pivot
+  lu.clear (3);
+  lu.add (0, 0, 1.0);
+  lu.add (1, 1, 1.0);
+  EXPECT_EQ (lu.factorize (), 1);
+}
@@ -0,0 +1,121 @@
+/*
+ * Interface.cpp - Unit test for the external transient solver interface
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <cmath>
+
+#include "qucs_interface.h"
+
+#include "gtest/gtest.h"  // Google Test
+
+/* A voltage divider with probes and a second divider driven by an
+   externally controlled voltage source. */
+static const char * etr_netlist =
+  "Vdc:V1 in gnd U=\"1 V\"\n"
+  "R:R1 in out R=\"100 Ohm\"\n"
+  "R:R2 out mid R=\"100 Ohm\"\n"
+  "IProbe:Pr1 mid gnd\n"
+  "VProbe:Pr2 out gnd\n"
+  "ECVS:E1 e gnd U=\"0.2\" Interpolator=\"hold\"\n"
+  "R:R3 e eo R=\"100 Ohm\"\n"
+  "R:R4 eo gnd R=\"100 Ohm\"\n"
+  ".ETR:ETR1 IntegrationMethod=\"Trapezoidal\" Order=\"2\"\n";
+
+TEST (trsolver_interface, handles) {
+  char file[] = "interface_handles.net";
+  FILE * f = fopen (file, "w");
+  ASSERT_TRUE (f != NULL);
+  fputs (etr_netlist, f);
+  fclose (f);
+
+  qucs::trsolver_interface etr (file);
+  remove (file);
+  ASSERT_TRUE (etr.getIsInitialised ());
+  ASSERT_EQ (0, etr.init (0, 1e-9, qucs::ETR_MODE_SYNC));
+
+  // node voltages by name, the reference node reads as zero
+  double v;
+  char in[] = "in", out[] = "out", gnd[] = "gnd", none[] = "none";
+  ASSERT_EQ (0, etr.getNodeV (in, v));
+  EXPECT_NEAR (1.0, v, 1e-9);
+  ASSERT_EQ (0, etr.getNodeV (out, v));
+  EXPECT_NEAR (0.5, v, 1e-9);
+  ASSERT_EQ (0, etr.getNodeV (gnd, v));
+  EXPECT_EQ (0.0, v);
+  EXPECT_EQ (-1, etr.getNodeV (none, v));
+
+  // the same quantities by handles
+  char pr1[] = "Pr1", pr2[] = "Pr2", e1[] = "E1";
+  int h[6];
+  h[0] = etr.getHandle (qucs::ETR_HANDLE_NODE, in);
+  h[1] = etr.getHandle (qucs::ETR_HANDLE_NODE, out);
+  h[2] = etr.getHandle (qucs::ETR_HANDLE_NODE, gnd);
+  h[3] = etr.getHandle (qucs::ETR_HANDLE_IPROBE, pr1);
+  h[4] = etr.getHandle (qucs::ETR_HANDLE_VPROBE, pr2);
+  h[5] = etr.getHandle (qucs::ETR_HANDLE_ECVS, e1);
+  for (int i = 0; i < 6; i++) ASSERT_GE (h[i], 0);
+  EXPECT_EQ (h[1], etr.getHandle (qucs::ETR_HANDLE_NODE, out));
+  EXPECT_EQ (-1, etr.getHandle (qucs::ETR_HANDLE_NODE, none));
+  EXPECT_EQ (-1, etr.getHandle (qucs::ETR_HANDLE_IPROBE, pr2));
+
+  double values[6];
+  ASSERT_EQ (0, etr.getValues (6, h, values));
+  EXPECT_NEAR (1.0, values[0], 1e-9);
+  EXPECT_NEAR (0.5, values[1], 1e-9);
+  EXPECT_EQ (0.0, values[2]);
+  ASSERT_EQ (0, etr.getIProbeI (pr1, v));
+  EXPECT_EQ (v, values[3]);
+  EXPECT_NEAR (5e-3, std::abs (values[3]), 1e-12);
+  ASSERT_EQ (0, etr.getVProbeV (pr2, v));
+  EXPECT_EQ (v, values[4]);
+  EXPECT_NEAR (0.5, values[4], 1e-9);
+  EXPECT_EQ (0.2, values[5]);
+  int bad = 99;
+  EXPECT_EQ (-1, etr.getValues (1, &bad, values));
+
+  // the solution view holds the node voltages followed by the
+  // branch currents, the same values as the copied solution
+  const double * x = etr.getSolutionData ();
+  ASSERT_TRUE (x != NULL);
+  int n = etr.getN (), m = etr.getM ();
+  double sol[64];
+  ASSERT_LE (n + m, 64);
+  etr.getsolution (sol);
+  int found = 0;
+  for (int i = 0; i < n + m; i++) {
+    EXPECT_EQ (sol[i], x[i]);
+    if (i < n && x[i] == values[1]) found |= 1;
+    if (i >= n && x[i] == values[3]) found |= 2;
+  }
+  EXPECT_EQ (3, found);
+
+  // only ecvs handles can be set, either all or none of them
+  double u[2] = { 0.6, 0.7 };
+  int hs[2] = { h[5], h[1] };
+  EXPECT_EQ (-1, etr.setValues (2, hs, u));
+  ASSERT_EQ (0, etr.getValues (1, &h[5], &v));
+  EXPECT_EQ (0.2, v);
+  ASSERT_EQ (0, etr.setValues (1, &h[5], u));
+  ASSERT_EQ (0, etr.getValues (1, &h[5], &v));
+  EXPECT_EQ (0.6, v);
+  ASSERT_EQ (0, etr.setECVSVoltage (e1, 0.4));
+  ASSERT_EQ (0, etr.getValues (1, &h[5], &v));
+  EXPECT_EQ (0.4, v);
+}
@@ -0,0 +1,87 @@
+/*
+ * Interpolator.cpp - Unit test for the interpolator class
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "qucs_typedefs.h"
+#include "object.h"
+#include "vector.h"
+#include "poly.h"
+#include "spline.h"
+#include "interpolator.h"
+
+#include "testDefine.h"   // constants used on tests
+#include "gtest/gtest.h"  // Google Test
+
+// sample and hold data with a duplicated x-value
+static nr_double_t tx[] = { 0.0, 1.0, 2.0, 2.0, 3.0, 5.0, 8.0, 13.0 };
+static nr_double_t ty[] = { 0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0 };
+static const int tn = sizeof (tx) / sizeof (tx[0]);
+
+// reference: index of the last x-value less than or equal to x
+static int refIndex (nr_double_t x) {
+  int idx = 0;
+  for (int i = 0; i < tn; i++) if (x >= tx[i]) idx = i;
+  return idx;
+}
+
+TEST (interpolator, hunt_hold) {
+  qucs::interpolator inter;
+  inter.vectors (ty, tx, tn);
+  inter.prepare (INTERPOL_HOLD, REPEAT_NO);
+
+  // advancing, receding and jumping lookups
+  nr_double_t xs[] = { -1.0, 0.0, 0.5, 1.0, 2.0, 2.5, 4.0, 12.9, 13.0,
+		       20.0, 7.0, 2.0, 1.5, -3.0, 9.0, 0.2, 5.0 };
+  for (unsigned int i = 0; i < sizeof (xs) / sizeof (xs[0]); i++) {
+    EXPECT_EQ (ty[refIndex (xs[i])], inter.rinterpolate (xs[i]));
+  }
+}
+
+TEST (interpolator, hunt_linear) {
+  qucs::interpolator inter;
+  inter.vectors (ty, tx, tn);
+  inter.prepare (INTERPOL_LINEAR, REPEAT_NO);
+
+  // monotonic sweep across the whole scope
+  for (nr_double_t x = 0.0; x <= 13.0; x += 0.125) {
+    int i = refIndex (x);
+    nr_double_t y;
+    if (x == tx[i]) y = ty[i];
+    else y = ty[i] + (x - tx[i]) * (ty[i+1] - ty[i]) / (tx[i+1] - tx[i]);
+    EXPECT_NEAR (y, inter.rinterpolate (x), tol);
+  }
+}
+
+TEST (interpolator, locate_shared) {
+  nr_complex_t cy[tn];
+  for (int i = 0; i < tn; i++) cy[i] = nr_complex_t (ty[i], -ty[i]);
+  qucs::interpolator a, b;
+  a.vectors (ty, tx, tn);
+  a.prepare (INTERPOL_LINEAR, REPEAT_NO);
+  b.vectors (cy, tx, tn);
+  b.prepare (INTERPOL_LINEAR, REPEAT_NO);
+
+  // one lookup serves both interpolators
+  for (nr_double_t x = 12.0; x >= 0.0; x -= 0.75) {
+    int idx = a.locate (x);
+    EXPECT_EQ (refIndex (x), idx);
+    EXPECT_NEAR (a.rinterpolate (x), real (b.cinterpolate (x, idx)), tol);
+    EXPECT_NEAR (-a.rinterpolate (x, idx), imag (b.cinterpolate (x)), tol);
+  }
+}
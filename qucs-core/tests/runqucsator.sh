@@ -28,6 +28,11 @@ simuldir=`
 		 }
 		 s/.*/./; q'`
 simulfile=`basename $dst`
+# netlists named '...+reduce.net' are simulated with reduced models
+case "$simulfile" in
+  *+reduce.net) options="--reduce" ;;
+  *) options="" ;;
+esac
 cd "$simuldir"
-echo $qucsator
-"$qucsator" -i "$simulfile"
+echo $qucsator $options
+"$qucsator" $options -i "$simulfile"
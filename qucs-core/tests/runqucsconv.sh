@@ -0,0 +1,27 @@
+#!/bin/sh
+# run a qucsconv conversion, the lines (except comments) of the given
+# file are the options, the output is compared to the file with the
+# same name ending in .ref; the version line of datasets is ignored
+
+qucsconv="$1"
+conversion="$2"
+
+cd "`dirname "$conversion"`" || exit 1
+conversion=`basename "$conversion"`
+reference=`basename "$conversion" .cnv`.ref
+
+# the output goes into a scratch directory, the source tree may be
+# read-only
+tmp=`mktemp -d "${TMPDIR:-/tmp}/runqucsconv.XXXXXX"` || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+options=`grep -v '^#' "$conversion"`
+"$qucsconv" $options -o "$tmp/conv.out"
+ret=$?
+if [ $ret -eq 0 ]; then
+  grep -v '^<Qucs Dataset ' "$reference" > "$tmp/conv.exp"
+  grep -v '^<Qucs Dataset ' "$tmp/conv.out" > "$tmp/conv.res"
+  diff -u "$tmp/conv.exp" "$tmp/conv.res"
+  ret=$?
+fi
+exit $ret
@@ -0,0 +1,24 @@
+#!/bin/sh
+# run a qucsator server session, lines starting with "> " are sent to
+# the server, the other lines (except comments) are the expected answers
+
+qucsator="$1"
+session="$2"
+
+cd "`dirname "$session"`" || exit 1
+session=`basename "$session"`
+
+# the commands and answers go into a scratch directory, the source
+# tree may be read-only
+tmp=`mktemp -d "${TMPDIR:-/tmp}/runserver.XXXXXX"` || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+sed -n 's/^> //p' "$session" > "$tmp/session.in"
+grep -v '^> \|^#' "$session" > "$tmp/session.exp"
+"$qucsator" --server < "$tmp/session.in" > "$tmp/session.out"
+ret=$?
+if [ $ret -eq 0 ]; then
+  diff -u "$tmp/session.exp" "$tmp/session.out"
+  ret=$?
+fi
+exit $ret
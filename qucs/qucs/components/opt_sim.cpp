@@ -16,6 +16,7 @@
  ***************************************************************************/
 #include <QDir>
 #include <QFile>
+#include <QMap>
 #include <QTextStream>
 #include <QRegExp>
 #include <QString>
@@ -62,19 +63,129 @@ Element* Optimize_Sim::info(QString& Name, char* &BitmapFile, bool getNewOne)
 }
 
 // -------------------------------------------------------
+// Differential evolution strategies of the "DE" property, numbered as
+// in ASCO.
+static const char *Methods[] = {
+  "DE/best/1/exp", "DE/rand/1/exp", "DE/rand-to-best/1/exp",
+  "DE/best/2/exp", "DE/rand/2/exp", "DE/best/1/bin", "DE/rand/1/bin",
+  "DE/rand-to-best/1/bin", "DE/best/2/bin", "DE/rand/2/bin" };
+
+// -------------------------------------------------------
+// Returns true if the optimization is to be run by ASCO instead of
+// qucsator (eleventh field of the "DE" property).
+bool Optimize_Sim::useASCO()
+{
+  return Props.at(1)->Value.section('|',10,10) == "asco";
+}
+
+// -------------------------------------------------------
+// The optimization is run by qucsator. The variables and goals are
+// given as properties of the analysis, inactive variables keep their
+// initial values by an equation. For ASCO just its configuration
+// files are created.
 QString Optimize_Sim::netlist()
 {
-  QString s = "#\n";
-  if (createASCOFiles()) {
-    s += "# ASCO configuration file(s) created\n";
-  } else {
-    s += "# Failed to create ASCO configuration file(s)\n";
+  if(useASCO()) {
+    QString s = "#\n";
+    if (createASCOFiles()) {
+      s += "# ASCO configuration file(s) created\n";
+    } else {
+      s += "# Failed to create ASCO configuration file(s)\n";
+    }
+    s += "#\n\n";
+    return s;
   }
-  s += "#\n\n";
+
+  Property *pp = Props.at(1);
+  QString DE = pp->Value;
+  int Method = DE.section('|',0,0).toInt();
+  if(Method < 1 || Method > 10)  Method = 7;
+  double Obj = DE.section('|',8,8).toDouble();
+  double Con = DE.section('|',9,9).toDouble();
+
+  QString s = ".OPT:" + Name + " Sim=\"" + Props.at(0)->Value + "\"";
+  s += " Method=\"" + QString(Methods[Method-1]) + "\"";
+  s += " Iterations=\"" + DE.section('|',1,1) + "\"";
+  s += " Population=\"" + DE.section('|',3,3) + "\"";
+  s += " F=\"" + DE.section('|',4,4) + "\"";
+  s += " CR=\"" + DE.section('|',5,5) + "\"";
+  s += " Seed=\"" + DE.section('|',6,6) + "\"";
+  s += " Tolerance=\"" + DE.section('|',7,7) + "\"";
+  s += " Penalty=\"" + QString::number(Obj > 0.0 ? Con/Obj : Con) + "\"";
+
+  QString Fixed;
+  for(pp = Props.at(2); pp != 0; pp = Props.next()) {
+    if(pp->Name == "Var") {
+      QString Var = pp->Value.section('|',0,0);
+      if(pp->Value.section('|',1,1) != "yes") {
+        Fixed += " " + Var + "=\"" + pp->Value.section('|',2,2) + "\"";
+        continue;
+      }
+      s += " " + Var + ".Init=\"" + pp->Value.section('|',2,2) + "\"";
+      s += " " + Var + ".Min=\"" + pp->Value.section('|',3,3) + "\"";
+      s += " " + Var + ".Max=\"" + pp->Value.section('|',4,4) + "\"";
+      s += " " + Var + ".Type=\"" + pp->Value.section('|',5,5) + "\"";
+    }
+    else if(pp->Name == "Goal") {
+      QString Goal = pp->Value.section('|',0,0);
+      QString Type = pp->Value.section('|',1,1);
+      s += " " + Goal + ".Goal=\"" + Type + "\"";
+      if(Type != "MIN" && Type != "MAX" && Type != "MON")
+        s += " " + Goal + ".Value=\"" + pp->Value.section('|',2,2) + "\"";
+    }
+  }
+  s += "\n";
+
+  if(!Fixed.isEmpty())
+    s += "Eqn:" + Name + "Fixed" + Fixed + " Export=\"no\"\n";
   return s;
 }
 
- 
+// -----------------------------------------------------------
+// Takes the optimized values saved in the dataset as new initial
+// values of the variables. Returns true if one of them changed.
+bool Optimize_Sim::loadResults(const QString& DataSet)
+{
+  Property *pp;
+  QMap<QString, QString> Values;   // last value of each variable
+  for(pp = Props.at(2); pp != 0; pp = Props.next())
+    if(pp->Name == "Var")
+      Values.insert(Name + "." + pp->Value.section('|',0,0), QString());
+
+  QFile infile(DataSet);
+  if(!infile.open(QIODevice::ReadOnly)) return false;
+  QTextStream instream(&infile);
+  QString Line, Vector;
+  while(!instream.atEnd()) {
+    Line = instream.readLine().trimmed();
+    if(Line.startsWith("<indep ") || Line.startsWith("<dep ")) {
+      Vector = Line.section(' ',1,1);
+      if(Vector.endsWith('>'))  Vector.chop(1);
+      if(!Values.contains(Vector))  Vector.clear();
+    }
+    else if(Line.startsWith("</"))
+      Vector.clear();
+    else if(!Vector.isEmpty())
+      Values[Vector] = Line;
+  }
+  infile.close();
+
+  bool changed = false;
+  for(pp = Props.at(2); pp != 0; pp = Props.next()) {
+    if(pp->Name != "Var")  continue;
+    QStringList Fields = pp->Value.split('|');
+    QString Value = Values.value(Name + "." + Fields.at(0));
+    if(Value.isEmpty() || Fields.size() < 3)  continue;
+    Fields[2] = QString::number(Value.toDouble(), 'g', 10);
+    Value = Fields.join("|");
+    if(Value != pp->Value) {
+      pp->Value = Value;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
 // -----------------------------------------------------------
 bool Optimize_Sim::createASCOFiles()
 {
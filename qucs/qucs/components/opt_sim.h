@@ -27,9 +27,11 @@ public:
  ~Optimize_Sim();
   Component* newOne();
   static Element* info(QString&, char* &, bool getNewOne=false);
+  bool useASCO();
   bool createASCOFiles();
   bool createASCOnetlist();
   bool loadASCOout();
+  bool loadResults(const QString&);
 
 protected:
   QString netlist();
@@ -95,7 +95,7 @@ OptimizeDialog::OptimizeDialog(Optimize_Sim *c_, Schematic *d_)
 				       "DE/rand/1/exp;"
 				       "DE/rand-to-best/1/exp;"
 				       "DE/best/2/exp;"
-				       "DE/rand/1/exp;"
+				       "DE/rand/2/exp;"
 				       "DE/best/1/bin;"
 				       "DE/rand/1/bin;"
 				       "DE/rand-to-best/1/bin;"
@@ -159,6 +159,9 @@ OptimizeDialog::OptimizeDialog(Optimize_Sim *c_, Schematic *d_)
   gp2->addWidget(new QLabel(tr("Cost constraints:")), 9,0);
   gp2->addWidget(CostConEdit,9,1);
 
+  AscoCheck = new QCheckBox(tr("run by ASCO instead of qucsator"));
+  gp2->addWidget(AscoCheck, 10,0,1,2);
+
   t->addTab(Tab2, tr("Algorithm"));
 
   // ...........................................................
@@ -375,6 +378,7 @@ OptimizeDialog::OptimizeDialog(Optimize_Sim *c_, Schematic *d_)
     CostVarEdit->setText(pp->Value.section('|',7,7));
     CostObjEdit->setText(pp->Value.section('|',8,8));
     CostConEdit->setText(pp->Value.section('|',9,9));
+    AscoCheck->setChecked(pp->Value.section('|',10,10) == "asco");
   }
 
   NameEdit->setText(Comp->Name);
@@ -750,6 +754,8 @@ void OptimizeDialog::slotApply()
     CostVarEdit->text() + "|" +
     CostObjEdit->text() + "|" +
     CostConEdit->text();
+  if(AscoCheck->isChecked())
+    Prop += "|asco";
   if(Prop != Comp->Props.at(1)->Value) {
     Comp->Props.at(1)->Value = Prop;
     changed = true;
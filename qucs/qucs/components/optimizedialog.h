@@ -62,7 +62,6 @@ private slots:
   void slotSetPrecision(const QPoint&);
 
 private:
-  void createASCOFiles();
 
 public:
   Optimize_Sim *Comp;
@@ -76,7 +75,7 @@ public:
             *IterEdit, *RefreshEdit, *ParentsEdit, *ConstEdit, *CrossEdit,
             *SeedEdit, *CostVarEdit, *CostObjEdit, *CostConEdit,
             *GoalNameEdit, *GoalNumEdit;
-  QCheckBox *VarActiveCheck;
+  QCheckBox *VarActiveCheck, *AscoCheck;
   QComboBox *SimEdit, *GoalTypeCombo, *MethodCombo, *VarTypeCombo;
   QTableWidget *VarTable, *GoalTable;
 
@@ -29,6 +29,7 @@
 #endif
 #include <stdlib.h>
 #include <cmath>
+#include <algorithm>
 #include <float.h>
 #if HAVE_IEEEFP_H
 # include <ieeefp.h>
@@ -41,6 +42,7 @@
 #include "schematic.h"
 
 #include "rect3ddiagram.h"
+#include "graphloader.h"
 #include "misc.h"
 
 #include <QTextStream>
@@ -84,6 +86,7 @@ Diagram::Diagram(int _cx, int _cy)
 
 Diagram::~Diagram()
 {
+  GraphLoader::cancel(this);
 }
 
 /*!
@@ -485,6 +488,74 @@ void Diagram::clip(Graph::iterator &p) const
 }
 
 
+// ------------------------------------------------------------
+// Decimation mode for a graph, LOD_NONE if it is not drawn as a line.
+lodmode_t Diagram::graphLodMode(Graph const *g) const
+{
+  if(g->Style < GRAPHSTYLE_SOLID || g->Style > GRAPHSTYLE_LONGDASH)
+    return LOD_NONE;
+  if(g->yAxisNo == 0)  return lodMode(&yAxis);
+  return lodMode(&zAxis);
+}
+
+/*!
+   Select the points of bucket "b" on level "level" of the decimation
+   pyramid of branch "branch" that need to be drawn, appending their
+   indices to "Index" in ascending order. Buckets not extending more than
+   one pixel in some direction are drawn by their first, last and
+   extreme points, which covers the same pixels as all of their points
+   do. Buckets completely outside the diagram are drawn by their first
+   and last point if the graph gets clipped. Other buckets are split.
+   This way the number of selected points depends on the diagram size
+   but hardly on the number of data points.
+*/
+void Diagram::lodSelect(Graph const *g, int branch, int level, int b,
+			Axis const *pa, bool clipped, std::vector<int>& Index) const
+{
+  int n = g->axis(0)->count;
+  int first = b * (LOD_BUCKET << level);
+  int last = std::min(first + (LOD_BUCKET << level), n) - 1;
+  double const *px = g->axis(0)->Points;
+  double const *pz = g->cPointsY + 2*size_t(branch)*n;
+  double Dummy = 0.0;  // not used
+  Graph::LodBucket const& B = g->lodBucket(branch, level, b);
+
+  float x, y, xmin, xmax, ymin, ymax;
+  calcCoordinate(px+B.ext[0], pz+2*B.ext[0], &Dummy, &x, &y, pa);
+  xmin = xmax = x;  ymin = ymax = y;
+  for(int j=1; j<4; j++) {
+    calcCoordinate(px+B.ext[j], pz+2*B.ext[j], &Dummy, &x, &y, pa);
+    xmin = std::min(xmin, x);  xmax = std::max(xmax, x);
+    ymin = std::min(ymin, y);  ymax = std::max(ymax, y);
+  }
+
+  if(clipped)
+    if(xmax < 0.0 || xmin > float(x2) || ymax < 0.0 || ymin > float(y2)) {
+      Index.push_back(first);
+      if(last > first)  Index.push_back(last);
+      return;
+    }
+
+  if(xmax - xmin <= 1.0 || ymax - ymin <= 1.0) {
+    int k[6] = { first, B.ext[0], B.ext[1], B.ext[2], B.ext[3], last };
+    std::sort(k, k+6);
+    for(int j=0; j<6; j++)
+      if(j == 0 || k[j] != k[j-1])
+	Index.push_back(k[j]);
+    return;
+  }
+
+  if(level == 0) {
+    for(int z=first; z<=last; z++)
+      Index.push_back(z);
+    return;
+  }
+
+  lodSelect(g, branch, level-1, 2*b, pa, clipped, Index);
+  if(last >= (2*b+1) * (LOD_BUCKET << (level-1)))
+    lodSelect(g, branch, level-1, 2*b+1, pa, clipped, Index);
+}
+
 // ------------------------------------------------------------
 // g->Points must already be empty!!!
 // is this a Graph Member?
@@ -504,6 +575,20 @@ void Diagram::calcData(Graph *g)
   double Dummy = 0.0;  // not used
   double *py = &Dummy;
 
+  Axis *pa;
+  if(g->yAxisNo == 0)  pa = &yAxis;
+  else  pa = &zAxis;
+
+  // huge line graphs: draw the points selected from the pyramid only
+  lodmode_t lod = LOD_NONE;
+  std::vector<int> Index;
+  if(g->count(0) > LOD_MIN_POINTS)
+    lod = graphLodMode(g);
+  if(lod != LOD_NONE) {
+    g->buildLod(lod);   // once per loaded data
+    Size = (8*(x2+y2) + 1) * g->countY + 10;
+  }
+
   g->resizeScrPoints(Size);
   auto p = g->begin();
   auto p_end = g->begin();
@@ -512,30 +597,29 @@ void Diagram::calcData(Graph *g)
   ++p;
   assert(p!=g->end());
 
-  Axis *pa;
-  if(g->yAxisNo == 0)  pa = &yAxis;
-  else  pa = &zAxis;
-
   switch(g->Style) {
     case GRAPHSTYLE_SOLID: // ***** solid line ****************************
     case GRAPHSTYLE_DASH:
     case GRAPHSTYLE_DOT:
     case GRAPHSTYLE_LONGDASH:
 
-      for(i=g->countY; i>0; i--) {  // every branch of curves
+      for(i=0; i<g->countY; i++) {  // every branch of curves
 	px = g->axis(0)->Points;
-	calcCoordinateP(px, pz, py, p, pa);
-	++px;
-	pz += 2;
-	++p;
-	for(z=g->axis(0)->count-1; z>0; z--) {  // every point
+	pz = g->cPointsY + 2*size_t(i)*g->axis(0)->count;
+	int count = g->axis(0)->count;
+	if(lod != LOD_NONE) {
+	  Index.clear();
+	  lodSelect(g, i, g->lodLevels()-1, 0, pa, Counter >= 2, Index);
+	  count = Index.size();
+	}
+	for(z=0; z<count; z++) {  // every point
+	  int k = (lod != LOD_NONE) ? Index[z] : z;
 	  FIT_MEMORY_SIZE;  // need to enlarge memory block ?
-	  calcCoordinateP(px, pz, py, p, pa);
-	  ++px;
-	  pz += 2;
+	  calcCoordinateP(px+k, pz+2*k, py, p, pa);
 	  ++p;
-	  if(Counter >= 2)   // clipping only if an axis is manual
-	    clip(p);
+	  if(z > 0)
+	    if(Counter >= 2)   // clipping only if an axis is manual
+	      clip(p);
 	}
 	if((p-3)->isStrokeEnd() && !(p-3)->isBranchEnd())
 	  p -= 3;  // no single point after "no stroke"
@@ -685,31 +769,33 @@ void Diagram::getAxisLimits(Graph *pg)
 // --------------------------------------------------------------------------
 void Diagram::loadGraphData(const QString& defaultDataSet)
 {
-  int yNum = yAxis.numGraphs;
-  int zNum = zAxis.numGraphs;
-  yAxis.numGraphs = zAxis.numGraphs = 0;
-
-  double xmin = xAxis.min, ymin = yAxis.min, zmin = zAxis.min;
-  double xmax = xAxis.max, ymax = yAxis.max, zmax = zAxis.max;
-  yAxis.min = zAxis.min = xAxis.min =  DBL_MAX;
-  yAxis.max = zAxis.max = xAxis.max = -DBL_MAX;
+  GraphLoader::cancel(this);  // a pending background load is outdated
 
   int No=0;
   foreach(Graph *pg, Graphs) {
     qDebug() << "load GraphData load" << defaultDataSet << pg->Var;
-    if(pg->loadDatFile(defaultDataSet) != 1)   // load data, determine max/min values
+    if(pg->loadDatFile(defaultDataSet) != 1)   // load data
       No++;
-    getAxisLimits(pg);
   }
 
-  if(No <= 0) {   // All dataset files unchanged ?
-    yAxis.numGraphs = yNum;  // rebuild scrollbar position
-    zAxis.numGraphs = zNum;
+  if(No <= 0)    // All dataset files unchanged ?
+    return;      // -> no update neccessary
 
-    xAxis.min = xmin; yAxis.min = ymin; zAxis.min = zmin;
-    xAxis.max = xmax; yAxis.max = ymax; zAxis.max = zmax;
-    return;    // -> no update neccessary
-  }
+  loadedGraphData();
+}
+
+/*!
+   Determines the axis limits and calculates the diagram once new data
+   was loaded into its graphs.
+*/
+void Diagram::loadedGraphData()
+{
+  yAxis.numGraphs = zAxis.numGraphs = 0;
+  yAxis.min = zAxis.min = xAxis.min =  DBL_MAX;
+  yAxis.max = zAxis.max = xAxis.max = -DBL_MAX;
+
+  foreach(Graph *pg, Graphs)
+    getAxisLimits(pg);   // determine max/min values
 
   if(xAxis.min > xAxis.max)
     xAxis.min = xAxis.max = 0.0;
@@ -790,6 +876,19 @@ void Diagram::updateGraphData()
  * FIXME: must invalidate markers.
  */
 int Graph::loadDatFile(const QString& fileName)
+{
+  /* WORK-AROUND: A bug in SCIM (libscim) which Qt is linked to causes
+     to change the locale to the default. */
+  setlocale (LC_NUMERIC, "C");
+
+  return readDatFile(fileName);
+}
+
+/*!
+ * The part of loadDatFile() that may run in a worker thread, the
+ * numeric locale must already be "C". Gives up if "canceled" is set.
+ */
+int Graph::readDatFile(const QString& fileName, QAtomicInt const* canceled)
 {
   Graph* g = this;
   QFile file;
@@ -801,10 +900,6 @@ int Graph::loadDatFile(const QString& fileName)
 //    if(pos > g->Var.indexOf('['))
 //      pos = -1;
 
-  /* WORK-AROUND: A bug in SCIM (libscim) which Qt is linked to causes
-     to change the locale to the default. */
-  setlocale (LC_NUMERIC, "C");
-
   if(pos <= 0) {
     file.setFileName(fileName);
     Variable = g->Var;
@@ -821,6 +916,7 @@ int Graph::loadDatFile(const QString& fileName)
 
   g->countY = 0;
   g->mutable_axes().clear(); // HACK
+  g->clearLod();
   if(g->cPointsY) { delete[] g->cPointsY;  g->cPointsY = 0; }
   if(Variable.isEmpty()) return 0;
 
@@ -924,6 +1020,7 @@ int Graph::loadDatFile(const QString& fileName)
 #endif
       counting = loadIndepVarData(pD->Var, FileString, mutable_axis(ii));
       if(counting <= 0)  return 0;
+      if(canceled && *canceled)  return 0;
 
       g->countY *= counting;
     }
@@ -949,6 +1046,7 @@ int Graph::loadDatFile(const QString& fileName)
 if(Variable.right(3) != ".X ") { // not "digital"
 
   for(int z=counting; z>0; z--) {
+    if((z & 0xffff) == 0)  if(canceled && *canceled)  return 0;
     pEnd = 0;
     while((*pPos) && (*pPos <= ' '))  pPos++; // find start of next number
     x = strtod(pPos, &pEnd);  // real part
@@ -1036,10 +1134,6 @@ int Graph::loadIndepVarData(const QString& Variable,
   bool isIndep = false;
   QString Line, tmp;
 
-  /* WORK-AROUND: A bug in SCIM (libscim) which Qt is linked to causes
-     to change the locale to the default. */
-  setlocale (LC_NUMERIC, "C");
-
   Line = "dep "+Variable+" ";
   // "pFile" is used through-out the whole function and must NOT used
   // for other purposes!
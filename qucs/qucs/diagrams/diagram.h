@@ -67,6 +67,8 @@ public:
                (const double*, const double*, const double*, float*, float*, Axis const*) const {};
   void calcCoordinateP (const double*x, const double*y, const double*z, Graph::iterator& p, Axis const* A) const;
   virtual void finishMarkerCoordinates(float&, float&) const;
+  virtual lodmode_t lodMode(Axis const*) const { return LOD_NONE; }
+  lodmode_t graphLodMode(Graph const*) const;
   virtual void calcLimits() {};
   virtual QString extraMarkerText(Marker const*) const {return "";}
   
@@ -85,6 +87,7 @@ public:
   void getAxisLimits(Graph*);
   void updateGraphData();
   void loadGraphData(const QString&);
+  void loadedGraphData();
   void recalcGraphData();
   bool sameDependencies(Graph const*, Graph const*) const;
   int  checkColumnWidth(const QString&, const QFontMetrics&, int, int, int);
@@ -124,6 +127,8 @@ protected:
   void rectClip(Graph::iterator &) const;
 
   virtual void calcData(Graph*);
+  void lodSelect(Graph const*, int, int, int, Axis const*, bool,
+                 std::vector<int>&) const;
 
 private:
   int Bounding_x1, Bounding_x2, Bounding_y1, Bounding_y2;
@@ -18,16 +18,21 @@
 
 #include <stdlib.h>
 #include <iostream>
+#include <algorithm>
 
 #include <QPainter>
 #include <QDebug>
 
 class Diagram;
 
+unsigned Graph::Serials = 0;
+
 Graph::Graph(Diagram const* d, const QString& _Line) :
   Element(),
   Style(GRAPHSTYLE_SOLID),
-  diagram(d)
+  diagram(d),
+  LodMode(LOD_NONE),
+  LodData(0)
 {
   Type = isGraph;
 
@@ -40,6 +45,7 @@ Graph::Graph(Diagram const* d, const QString& _Line) :
   yAxisNo = 0;   // left y axis
 
   cPointsY = 0;
+  Serial = ++Serials;
 }
 
 Graph::~Graph()
@@ -289,6 +295,122 @@ std::pair<double,double> Graph::findSample(std::vector<double>& VarPos) const
   return std::pair<double,double>(cPointsY[2*n], cPointsY[2*n+1]);
 }
 
+// ---------------------------------------------------------------------
+// the two plot coordinates of point "i" of branch "branch", monotonic in
+// the screen coordinates the diagrams compute from them
+void Graph::lodValues(int branch, int i, double& a, double& b) const
+{
+  double const* pz = cPointsY + 2*(size_t(branch)*count(0) + i);
+  switch(LodMode) {
+    case LOD_RECT:
+      a = axis(0)->Points[i];
+      b = pz[0];
+      if(fabs(pz[1]) > 1e-250)  // same as RectDiagram::calcCoordinate
+        b = sqrt(pz[0]*pz[0] + pz[1]*pz[1]);
+      break;
+    case LOD_RECTLOG:
+      a = axis(0)->Points[i];
+      b = sqrt(pz[0]*pz[0] + pz[1]*pz[1]);
+      break;
+    default:
+      a = pz[0];
+      b = pz[1];
+  }
+}
+
+// ---------------------------------------------------------------------
+// NaN never wins against a number
+static inline bool lodLess(double x, double y)
+{
+  return x < y || (std::isnan(y) && !std::isnan(x));
+}
+
+/*!
+ * Build the min/max decimation pyramid of all branches. Nothing is done
+ * if it already exists for the current data and the given mode.
+ * The finest level is built from the data, every other one by merging
+ * two buckets of the level below, so the cost is about one pass over
+ * the data.
+ */
+void Graph::buildLod(lodmode_t mode)
+{
+  if(LodMode == mode && LodData == cPointsY && !Lod.empty())
+    return;
+
+  clearLod();
+  DataX const* pD = axis(0);
+  if(!pD || !cPointsY || mode == LOD_NONE || pD->count < 1)
+    return;
+  LodMode = mode;
+  LodData = cPointsY;
+
+  int n = pD->count;
+  double a, b, v[4];
+  Lod.resize(countY);
+  for(int i=0; i<countY; i++) {   // every branch of curves
+    std::vector<std::vector<LodBucket> >& levels = Lod[i];
+
+    std::vector<LodBucket> level((n + LOD_BUCKET - 1) / LOD_BUCKET);
+    for(int k=0; k<(int)level.size(); k++) {
+      LodBucket& B = level[k];
+      int z = k * LOD_BUCKET;
+      int end = std::min(z + LOD_BUCKET, n);
+      lodValues(i, z, a, b);
+      v[0] = v[1] = a;  v[2] = v[3] = b;
+      B.ext[0] = B.ext[1] = B.ext[2] = B.ext[3] = z;
+      for(z++; z<end; z++) {
+        lodValues(i, z, a, b);
+        if(lodLess(a, v[0])) { v[0] = a; B.ext[0] = z; }
+        if(lodLess(-a, -v[1])) { v[1] = a; B.ext[1] = z; }
+        if(lodLess(b, v[2])) { v[2] = b; B.ext[2] = z; }
+        if(lodLess(-b, -v[3])) { v[3] = b; B.ext[3] = z; }
+      }
+    }
+    levels.push_back(level);
+
+    while(levels.back().size() > 1) {   // merge pairs of buckets
+      std::vector<LodBucket> const& fine = levels.back();
+      level.resize((fine.size() + 1) / 2);
+      for(int k=0; k<(int)level.size(); k++) {
+        level[k] = fine[2*k];
+        if(2*k+1 >= (int)fine.size())  continue;
+        LodBucket const& B = fine[2*k+1];
+        for(int j=0; j<4; j++) {
+          double w[2], u[2];
+          lodValues(i, level[k].ext[j], w[0], w[1]);
+          lodValues(i, B.ext[j], u[0], u[1]);
+          a = w[j>>1];  b = u[j>>1];
+          if(j & 1) { a = -a;  b = -b; }  // maximum
+          if(lodLess(b, a))  level[k].ext[j] = B.ext[j];
+        }
+      }
+      levels.push_back(level);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------
+void Graph::clearLod()
+{
+  Lod.clear();
+  LodMode = LOD_NONE;
+  LodData = 0;
+}
+
+// ---------------------------------------------------------------------
+// Exchanges the loaded data and its decimation pyramid with another
+// graph, e.g. one that was loaded in the background.
+void Graph::swapData(Graph& g)
+{
+  std::swap(cPointsX, g.cPointsX);
+  std::swap(cPointsY, g.cPointsY);
+  std::swap(countY, g.countY);
+  std::swap(lastLoaded, g.lastLoaded);
+  std::swap(Lod, g.Lod);
+  std::swap(LodMode, g.LodMode);
+  std::swap(LodData, g.LodData);
+}
+
 // -----------------------------------------------------------------------
 // meaning of the values in a graph "Points" list
 #define STROKEEND   -2
@@ -26,7 +26,9 @@
 #include <QColor>
 #include <Q3PtrList>
 #include <QDateTime>
+#include <QAtomicInt>
 
+#include <vector>
 #include <assert.h>
 
 typedef enum{
@@ -41,6 +43,17 @@ typedef enum{
   GRAPHSTYLE_COUNT,
 } graphstyle_t;
 
+// which plot coordinates the decimation pyramid of a graph tracks
+typedef enum{
+  LOD_NONE = 0,  // no decimation
+  LOD_RECT,      // x value and real part (or magnitude if complex)
+  LOD_RECTLOG,   // x value and magnitude
+  LOD_COMPLEX,   // real and imaginary part
+} lodmode_t;
+
+#define LOD_BUCKET  8   // points per bucket of the finest pyramid level
+#define LOD_MIN_POINTS  8192  // graphs with more points are decimated
+
 inline graphstyle_t toGraphStyle(int x){
   if (x<0){
     return GRAPHSTYLE_INVALID;
@@ -123,6 +136,7 @@ public:
   typedef container::const_iterator const_iterator;
 
   int loadDatFile(const QString& filename);
+  int readDatFile(const QString& filename, QAtomicInt const* canceled=0);
   int loadIndepVarData(const QString&, char* datfilecontent, DataX* where);
 
   void    paint(ViewPainter*, int, int);
@@ -149,6 +163,18 @@ public:
   const_iterator begin() const{return ScrPoints.begin();}
   const_iterator end() const{return ScrPoints.end();}
 
+  // level of detail. every level holds min/max indices of consecutive
+  // buckets of LOD_BUCKET<<level points, the top level a single bucket.
+  struct LodBucket{
+    int ext[4]; // points with min/max first and min/max second coordinate
+  };
+  void buildLod(lodmode_t);
+  void clearLod();
+  void swapData(Graph&);
+  int  lodLevels() const { return Lod.empty() ? 0 : Lod[0].size(); }
+  LodBucket const& lodBucket(int branch, int level, int b) const
+    { return Lod[branch][level][b]; }
+
   QDateTime lastLoaded;  // when it was loaded into memory
   int     yAxisNo;       // which y axis is used
   double *cPointsY;
@@ -172,10 +198,19 @@ public: // marker related
   void createMarkerText() const;
   std::pair<double,double> findSample(std::vector<double>&) const;
   Diagram const* parentDiagram() const{return diagram;}
+  unsigned serial() const{return Serial;}
 private:
   QVector<DataX*>  cPointsX;
   std::vector<ScrPt> ScrPoints; // data in screen coordinates
   Diagram const* diagram;
+
+  void lodValues(int, int, double&, double&) const;
+  std::vector<std::vector<std::vector<LodBucket> > > Lod; // branch, level
+  lodmode_t LodMode;      // mode the pyramid was built for
+  double const* LodData;  // data it was built from
+
+  unsigned Serial;         // unique, unlike the address never reused
+  static unsigned Serials; // last one given
 };
 
 #endif
@@ -0,0 +1,191 @@
+/*
+ * graphloader.cpp - loading of diagram data in the background
+ *
+ * This file is part of Qucs
+ *
+ * Qucs is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qucs.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphloader.h"
+#include "diagram.h"
+
+#include <locale.h>
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
+
+// ---------------------------------------------------------------------
+// One graph to be loaded by a worker thread.
+struct GraphLoad {
+  Graph *copy;             // private graph the data is read into
+  lodmode_t lod;           // decimation mode of the graph
+  int result;              // result of Graph::readDatFile()
+  QString const *DataSet;
+  QAtomicInt const *canceled;
+};
+
+// All graphs of a diagram.
+struct GraphLoader::Job {
+  Diagram *diagram;        // zero once canceled
+  QString DataSet;
+  QList<Graph*> Graphs;    // graphs of the diagram ...
+  QList<unsigned> Serials; // ... their serial numbers ...
+  QList<GraphLoad> Loads;  // ... and what is loaded for them
+  QAtomicInt canceled;
+  bool again;              // dataset changed meanwhile, load once more
+  QFutureWatcher<void> *Watcher;
+};
+
+GraphLoader *GraphLoader::Loader = 0;
+
+// ---------------------------------------------------------------------
+// Runs in a worker thread, touches nothing but the private graph.
+static void loadGraph(GraphLoad& l)
+{
+  if(*l.canceled)  return;
+  l.result = l.copy->readDatFile(*l.DataSet, l.canceled);
+  if(l.result == 2)  if(!*l.canceled)
+    if(l.lod != LOD_NONE && l.copy->count(0) > LOD_MIN_POINTS)
+      l.copy->buildLod(l.lod);
+}
+
+// ---------------------------------------------------------------------
+GraphLoader::GraphLoader(QObject *parent) : QObject(parent)
+{
+}
+
+// Waits for the workers, they use the jobs.
+GraphLoader::~GraphLoader()
+{
+  foreach(Job *job, Jobs) {
+    job->canceled = 1;
+    job->Watcher->cancel();
+  }
+  foreach(Job *job, Jobs) {
+    job->Watcher->waitForFinished();
+    foreach(GraphLoad l, job->Loads)
+      delete l.copy;
+    delete job->Watcher;
+    delete job;
+  }
+  Loader = 0;
+}
+
+// ---------------------------------------------------------------------
+GraphLoader* GraphLoader::instance()
+{
+  if(!Loader)
+    Loader = new GraphLoader(QCoreApplication::instance());
+  return Loader;
+}
+
+// ---------------------------------------------------------------------
+// Starts loading the graphs of diagram "pd" from dataset "DataSet". A
+// pending load of the same dataset is repeated when done, so frequent
+// updates (e.g. partial results) do not restart it over and over. Any
+// other pending load of the diagram is canceled.
+void GraphLoader::load(Diagram *pd, const QString& DataSet)
+{
+  foreach(Job *job, Jobs)
+    if(job->diagram == pd && job->DataSet == DataSet) {
+      job->again = true;
+      return;
+    }
+  cancel(pd);
+  if(pd->Graphs.isEmpty())  return;
+
+  /* WORK-AROUND: A bug in SCIM (libscim) which Qt is linked to causes
+     to change the locale to the default. Not thread-safe, so here. */
+  setlocale (LC_NUMERIC, "C");
+
+  Job *job = new Job;
+  job->diagram = pd;
+  job->DataSet = DataSet;
+  job->canceled = 0;
+  job->again = false;
+  foreach(Graph *pg, pd->Graphs) {
+    GraphLoad l;
+    l.copy = new Graph(pd, pg->Var);
+    l.copy->lastLoaded = pg->lastLoaded;  // to skip unchanged data
+    l.lod = pd->graphLodMode(pg);
+    l.result = 0;
+    l.DataSet = &job->DataSet;
+    l.canceled = &job->canceled;
+    job->Graphs.append(pg);
+    job->Serials.append(pg->serial());
+    job->Loads.append(l);
+  }
+  Jobs.append(job);
+
+  job->Watcher = new QFutureWatcher<void>(this);
+  connect(job->Watcher, SIGNAL(finished()), SLOT(slotFinished()));
+  job->Watcher->setFuture(QtConcurrent::map(job->Loads, loadGraph));
+}
+
+// ---------------------------------------------------------------------
+// Cancels loading the data of diagram "pd", e.g. if it gets deleted.
+// The workers give up as soon as possible, the job is deleted once
+// they are done.
+void GraphLoader::cancel(Diagram *pd)
+{
+  if(!Loader)  return;
+  foreach(Job *job, Loader->Jobs)
+    if(job->diagram == pd) {
+      job->diagram = 0;
+      job->canceled = 1;
+      job->Watcher->cancel();
+    }
+}
+
+// ---------------------------------------------------------------------
+// All graphs of a job are loaded. Hands the new data to the diagram and
+// calculates it, as Diagram::loadGraphData() does.
+void GraphLoader::slotFinished()
+{
+  Job *job = 0;
+  foreach(Job *j, Jobs)
+    if(j->Watcher == sender())  job = j;
+  if(!job)  return;
+  Jobs.removeAll(job);
+
+  Diagram *pd = job->diagram;
+  if(pd && !job->canceled) {
+    int No = 0;
+    for(int i=0; i<job->Graphs.size(); i++) {
+      // The graph may have been removed meanwhile and another one been
+      // created at its address, or its variable may have been changed.
+      Graph *pg = job->Graphs.at(i);
+      if(!pd->Graphs.contains(pg))  continue;
+      if(pg->serial() != job->Serials.at(i))  continue;
+      if(pg->Var != job->Loads.at(i).copy->Var)  continue;
+      if(job->Loads.at(i).result == 1)  continue;  // dataset unchanged
+      pg->swapData(*job->Loads.at(i).copy);
+      No++;
+    }
+    if(No > 0) {
+      pd->loadedGraphData();
+      emit loaded(pd);
+    }
+  }
+
+  foreach(GraphLoad l, job->Loads)
+    delete l.copy;   // now holds the old data
+  job->Watcher->deleteLater();
+  if(pd && job->again)
+    load(pd, job->DataSet);
+  delete job;
+}
@@ -0,0 +1,61 @@
+/*
+ * graphloader.h - loading of diagram data in the background
+ *
+ * This file is part of Qucs
+ *
+ * Qucs is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qucs.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHLOADER_H
+#define GRAPHLOADER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+
+class Diagram;
+
+/*!
+ * Loads the data of diagrams in the global thread pool. Every graph is
+ * read into a private copy by a worker thread, which also builds its
+ * decimation pyramid. Once all graphs of a diagram are done, the data
+ * is handed to the diagram in the GUI thread and loaded() is emitted.
+ * The diagrams of a schematic thus load in parallel while the editor
+ * stays responsive.
+ */
+class GraphLoader : public QObject {
+  Q_OBJECT
+public:
+  static GraphLoader* instance();
+  static void cancel(Diagram*);
+
+  void load(Diagram*, const QString&);
+
+signals:
+  void loaded(Diagram*);
+
+private slots:
+  void slotFinished();
+
+private:
+  GraphLoader(QObject *parent);
+ ~GraphLoader();
+
+  struct Job;
+  QList<Job*> Jobs;
+  static GraphLoader *Loader;
+};
+
+#endif
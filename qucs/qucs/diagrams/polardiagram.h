@@ -32,6 +32,7 @@ public:
   int  calcDiagram();
   void calcLimits();
   void calcCoordinate(const double*, const double*, const double*, float*, float*, Axis const*) const;
+  lodmode_t lodMode(Axis const*) const { return LOD_COMPLEX; }
 };
 
 #endif
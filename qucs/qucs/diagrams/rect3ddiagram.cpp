@@ -29,6 +29,7 @@
 #include <cmath>
 #include <float.h>
 #include <limits.h>
+#include <algorithm>
 #if HAVE_IEEEFP_H
 # include <ieeefp.h>
 #endif
@@ -45,8 +46,6 @@ Rect3DDiagram::Rect3DDiagram(int _cx, int _cy) : Diagram(_cx, _cy)
   y2 = 200;
   x3 = 207;    // with some distance for right axes text
 
-  Mem = pMem = 0;  // auxiliary buffer for hidden lines
-
   Name = "Rect3D"; // BUG
   // symbolic diagram painting
   Lines.append(new Line(0, 0, cx,  0, QPen(Qt::black,0)));
@@ -196,8 +195,9 @@ void Rect3DDiagram::finishMarkerCoordinates(float& fCX, float& fCY) const
 }
 
 // ------------------------------------------------------------
+// Calculates screen position and depth of a grid point.
 void Rect3DDiagram::calcCoordinate3D(double x, double y, double zr, double zi,
-					tPoint3D *p, tPointZ *pz)
+                                     tPoint3D *p) const
 {
   if(zAxis.log) {
     zr = sqrt(zr*zr + zi*zi);
@@ -232,396 +232,448 @@ void Rect3DDiagram::calcCoordinate3D(double x, double y, double zr, double zi,
   else
     y = (y - yAxis.low) / (yAxis.up - yAxis.low);
 
-  p->x  = int(calcX_2D(x, y, zr) + 0.5 + xorig);
-  p->y  = int(calcY_2D(x, y, zr) + 0.5 + yorig);
-  p->No = pz->No = p-Mem;
+  double xD = calcX_2D(x, y, zr) + xorig;
+  double yD = calcY_2D(x, y, zr) + yorig;
+  double zD = calcZ_2D(x, y, zr);
+  if(!std::isfinite(xD) || !std::isfinite(yD) || !std::isfinite(zD)) {
+    xD = xorig;   // invalid data, as in "calcCoordinate"
+    yD = yorig;
+    zD = 0.0;
+  }
+  p->x = int(xD + 0.5);
+  p->y = int(yD + 0.5);
+  p->z = float(zD);
   p->done = 0;
-  pz->z = float(calcZ_2D(x, y, zr));
-}
-
-// --------------------------------------------------------------
-bool Rect3DDiagram::isHidden(int x, int y, tBound *Bounds, char *zBuffer)
-{
-  // remember the boundings of the polygon
-  if( (Bounds+x)->max < y )  (Bounds+x)->max = y;
-  if( (Bounds+x)->min > y )  (Bounds+x)->min = y;
-
-  // diagram area already used ?
-  return ( *(zBuffer + (y>>3) + x * ((y2+7)>>3)) & (1 << (y & 7)) ) != 0;
 }
 
 // --------------------------------------------------------------
-// Enlarge memory block if neccessary.
-void Rect3DDiagram::enlargeMemoryBlock(tPoint3D* &MemEnd)
+// Is the pixel already covered by a polygon nearer to the viewer ?
+// The border of the covered area stays visible, so lines meeting
+// there (e.g. in grid points) are not cut.
+bool Rect3DDiagram::isHidden(int x, int y) const
 {
-  if(pMem >= MemEnd) {
-    int Size = MemEnd - Mem + 256;
-    MemEnd = Mem;
-    Mem  = (tPoint3D*)realloc(Mem, Size*sizeof(tPoint3D));
-    pMem += Mem - MemEnd;
-    MemEnd = Mem + Size - 5;
+  if(x < 0 || x > x2)  return false;
+  std::vector<tBound> const& c = Covered[x];
+
+  // binary search for the first range not above "y"
+  int lo = 0, hi = c.size();
+  while(lo < hi) {
+    int mid = (lo + hi) >> 1;
+    if(c[mid].max < y)  lo = mid + 1;
+    else  hi = mid;
   }
+  if(lo >= int(c.size()))  return false;
+  return (c[lo].min < y) && (y < c[lo].max);
 }
 
 // --------------------------------------------------------------
-// Calculate all 2D points of the line between point "p" and "p+1".
-// Parameters:   p        - pointer on 3D coordinate of line start point
-//                          (p+1 points onto line end point)
-//               MemEnd   - pointer where memory block ends
-//               Bounds   - memory block for occupied polygon area
-//               zBuffer  - memory block for occupied diagram area
-void Rect3DDiagram::calcLine(tPoint3D* &p, tPoint3D* &MemEnd,
-				tBound *Bounds, char *zBuffer)
+// Marks the pixels "ymin" to "ymax" of column "x" as covered. Every
+// column holds a sorted list of disjunct y ranges, so the memory grows
+// with the complexity of the silhouette, not with the diagram area.
+void Rect3DDiagram::cover(int x, int ymin, int ymax)
 {
-  int Pos_;
-  int x1_ = p->x, y1_ = p->y;
-  int x2_ = (p+1)->x, y2_ = (p+1)->y;
-
-  bool wasHidden = isHidden(x1_, y1_, Bounds, zBuffer);
-  if(wasHidden)
-    if((p->done & 1) == 0)
-      p->done |= 4;   // mark as hidden
+  std::vector<tBound>& c = Covered[x];
 
-  int ax_ = 0, ay_ = 0;
-  int ix_, iy_, dx_, dy_, of_;
-
-  if(x2_ >= x1_) {
-    dx_ = x2_ - x1_;
-    ix_ = 1;
+  int first = 0, hi = c.size();
+  while(first < hi) {   // first range touching "ymin" or above
+    int mid = (first + hi) >> 1;
+    if(c[mid].max < ymin-1)  first = mid + 1;
+    else  hi = mid;
   }
-  else {
-    dx_ = x1_ - x2_;
-    ix_ = -1;
+
+  int last = first;     // merge all ranges touching the new one
+  while(last < int(c.size()) && c[last].min <= ymax+1) {
+    if(c[last].min < ymin)  ymin = c[last].min;
+    if(c[last].max > ymax)  ymax = c[last].max;
+    last++;
   }
 
-  if(y2_ >= y1_) {
-    dy_ = y2_ - y1_;
-    iy_ = 1;
+  if(first == last) {
+    tBound b = {ymin, ymax};
+    c.insert(c.begin()+first, b);
   }
   else {
-    dy_ = y1_ - y2_;
-    iy_ = -1;
+    c[first].min = ymin;
+    c[first].max = ymax;
+    c.erase(c.begin()+first+1, c.begin()+last);
   }
+}
 
-  if(dx_ < dy_) {
-    of_ = dx_;   // exchange dx and dy
-    dx_ = dy_;
-    dy_ = of_;
-
-    ax_ = iy_;
-    ay_ = ix_;
-    ix_ = iy_ = 0;
-  }
+// --------------------------------------------------------------
+// Collects the visible pixels of a line into pieces. A line end point
+// is as visible as its neighbour pixel, so lines reaching the grid
+// point of a nearer polygon get no gap.
+struct tPieces3D {
+  tPieces3D(std::vector<tLine3D> *p) : Pieces(p), inPiece(false) {};
+
+  void pixel(int x, int y, bool visible) {
+    if(visible) {
+      if(!inPiece) {
+        inPiece = true;
+        Line.x1 = x;
+        Line.y1 = y;
+      }
+      Line.x2 = x;
+      Line.y2 = y;
+    }
+    else  finish();
+  };
+  void finish() {
+    if(inPiece)  Pieces->push_back(Line);
+    inPiece = false;
+  };
+
+  std::vector<tLine3D> *Pieces;
+  tLine3D Line;
+  bool inPiece;
+};
 
-  of_ = dx_ >> 1;
-  for(int i=dx_; i>1; i--) {   // calculate each point of the line
-    x1_ += ix_;
-    y1_ += ax_;
-    of_ += dy_;
-    if(of_ > dx_) {
-      of_ -= dx_;
-      x1_ += ay_;
-      y1_ += iy_;
+// --------------------------------------------------------------
+// Calculates all 2D points of the line from "p1" to "p2" (Bresenham),
+// enlarges the bounding of the current polygon ("Bounds") and appends
+// the visible parts of the line to "Pieces" (if not null).
+void Rect3DDiagram::calcLine(tPoint3D const& p1, tPoint3D const& p2,
+                             std::vector<tLine3D> *Pieces)
+{
+  int x = p1.x, y = p1.y;
+  int dx = abs(p2.x - x), dy = abs(p2.y - y);
+  int ix = (p2.x >= x) ? 1 : -1;
+  int iy = (p2.y >= y) ? 1 : -1;
+  int err = dx - dy, e2;
+
+  tPieces3D Run(Pieces);
+  int xPrev = 0, yPrev = 0, No = 0;
+  bool wasVisible = false, visible;
+  for(;;) {
+    if(x >= 0 && x <= x2) {   // bounding of the polygon
+      tBound& b = Bounds[x];
+      if(b.min > y)  b.min = y;
+      if(b.max < y)  b.max = y;
+      if(BoundMin > x)  BoundMin = x;
+      if(BoundMax < x)  BoundMax = x;
     }
 
-    // This section has significant impact to the hiding algorithm
-    //   be aware isHidden() modifies (Bounds+x)->min/max
-    // if isHidden() is replaced by  false  nearly all segments are drawn,
-    //   nothing set hidden by this section ... though few segments are hidden
-    // if isHidden() is replaced by true  most segments are not drawn
-    //   and many line-ends are outside the diagram-are (mem/malloc-issue?)
-    if( isHidden(x1_, y1_, Bounds, zBuffer) != wasHidden )
-      if((p->done & 1) == 0) {
-        wasHidden = !wasHidden;
-        pMem->x  = x1_;
-        pMem->y  = y1_;
-        pMem->No = p->No;
-        pMem->done = 0;
-        if(wasHidden) pMem->done = 4;   // mark as hidden
-        pMem++;
-
-        Pos_ = p - Mem;
-        // Enlarge memory block if neccessary.
-        enlargeMemoryBlock(MemEnd);   // this may make "p" invalid (realloc)
-        p = Mem + Pos_;  // rebuild "p"
+    bool isLast = (x == p2.x) && (y == p2.y);
+    if(Pieces) {
+      // decide about the previous pixel, the first one like the second
+      visible = !isHidden(x, y);
+      if(No > 0)
+        Run.pixel(xPrev, yPrev, wasVisible || (visible && No == 1));
+      if(isLast)
+        Run.pixel(x, y, visible || (wasVisible && No > 0));
+      wasVisible = visible;
+      xPrev = x;
+      yPrev = y;
+      No++;
     }
-  }
+    if(isLast)  break;
 
-  // extra treatment for last point (create no further point)
-  // OLD: implementation hides most of the segmets
-  // NEW: unhide missing segments
-  if(!isHidden((p+1)->x, (p+1)->y, Bounds, zBuffer))
-  {
-    if(!isHidden((p)->x, (p)->y, Bounds, zBuffer))
-    {
-      (p+1)->done &= ~4;
+    e2 = err << 1;
+    if(e2 > -dy) {
+      err -= dy;
+      x += ix;
     }
-    else
-    {
-      (p)->done &= ~4;
+    if(e2 < dx) {
+      err += dx;
+      y += iy;
     }
   }
 
-  // If this assignment is commented-out all inner segments are not drawn.
-  // Just the surrounding boundary (all segments) of the mesh is drawn
-  p->done |= 1;   // mark as already worked on
+  if(Pieces)  Run.finish();
 }
 
 // --------------------------------------------------------------
-// Compare functions for GNU qsort routine.
-int Rect3DDiagram::comparePoint3D(const void *Point1, const void *Point2)
-{
-  return ((tPoint3D*)Point1)->No - ((tPoint3D*)Point2)->No;
-}
-int Rect3DDiagram::comparePointZ(const void *Point1, const void *Point2)
+// A graph as mesh of grid lines: "countY/dy" planes, each with "dy"
+// lines along x (with "dx" points) and "dx" cross lines along y.
+struct tMesh3D {
+  Graph *g;
+  int dx, dy;
+  int Point;     // index of its first point
+  int Segment;   // index of its first segment
+  int xSegment(int Line, int j) const {
+    return Segment + Line*(dx-1) + j;
+  };
+  int ySegment(int Plane, int j, int r) const {
+    return Segment + g->countY*(dx-1) + (Plane*dx + j)*(dy-1) + r;
+  };
+};
+
+// visible parts of a line segment, "first" is -1 if not yet calculated
+struct tSegment3D {
+  int first, count;
+};
+
+// polygon between four grid points, "No" is its lower left corner
+struct tPolygon3D {
+  float z;   // sum of depth of corners
+  int Mesh, No;
+};
+
+static bool comparePolygon3D(tPolygon3D const& p1, tPolygon3D const& p2)
 {
-  if((((tPointZ*)Point2)->z - ((tPointZ*)Point1)->z) < 0.0f)
-    return -1;
-  return 1;
+  return p1.z > p2.z;
 }
 
 // --------------------------------------------------------------
-// Removes the invisible parts of the graph.
-void Rect3DDiagram::removeHiddenLines(char *zBuffer, tBound *Bounds)
+// Appends a grid line (or its visible parts) to the screen points "v".
+// Parameters:   p        - pointer on its first point
+//               Step     - distance to next point in the line
+//               Count    - number of points
+//               Seg      - its first segment
+static void appendLine(std::vector<Graph::ScrPt>& v, tPoint3D const *p,
+                       int Step, int Count, tSegment3D const *Seg,
+                       std::vector<tLine3D> const& Pieces)
 {
-  double Dummy = 0.0;  // number for 1-dimensional data in 3D cartesian
-  double *px, *py, *pz;
-
-  tPoint3D *p;
-  int i, j, z, dx, dy, Size=0;
-  // pre-calculate buffer size to avoid reallocations in the first step
-  foreach(Graph *g, Graphs)
-    if(g->cPointsY)
-      Size += g->axis(0)->count * g->countY;
-
-  // "Mem" should be the last malloc to simplify realloc
-  // multiplicator 'malloc_8xsize' added
-  // 'malloc_8xsize' increases the requested size in the 2 malloc lines below
-  // this comment section.
-  // And it is added to the calculation of 'MemEnd'.
-  // Main reason are the segments drawn to points outside the diagram.
-  // It is assumed to be a memory issue.
-  // Note: As of today the memory calculation is still not 100% clean.
-  int malloc_8xsize=8;
-  tPointZ *zMem = (tPointZ*)malloc( malloc_8xsize*(Size+2)*sizeof(tPointZ) );
-  Mem  = (tPoint3D*)malloc( malloc_8xsize*2*(Size+2)*sizeof(tPoint3D) );
-
-  pMem = Mem;
-  tPointZ *zp = zMem, *zp_tmp;
-
-  // ...............................................................
-  foreach(Graph *g, Graphs) {
-
-    pz = g->cPointsY;
-    if(!pz) continue;
-    if(g->numAxes() < 1) continue;
-
-    py = &Dummy;
-    if(g->countY > 1)  py = g->axis(1)->Points;
+  Graph::ScrPt s;
+  bool isOpen = false;
+  int x = 0, y = 0;
 
-    p = pMem;  // save status for cross grid
-    zp_tmp = zp;
-    // ..........................................
-    // calculate coordinates of all lines
-    dx = g->axis(0)->count;
-    if(g->countY > 1)  dy = g->axis(1)->count;
-    else  dy = 0;
-    for(i=g->countY-1; i>=0; i--) {   // y coordinates
-      px = g->axis(0)->Points;
-    
-      for(j=dx; j>0; j--) { // x coordinates
-        calcCoordinate3D(*(px++), *py, *pz, *(pz+1), pMem++, zp++);
-        pz += 2;
-      }
-
-      (pMem-1)->done |= 8;  // mark as "last in line"
-      py++;
-      if(dy > 0) if((i % dy) == 0)
-        py = g->axis(1)->Points;
-    }
-    (pMem-1)->done |= 512;  // mark as "last point before grid"
+  if(Count == 1)  if(p->done != 2) {
+    s.setScr(p->x, p->y);
+    v.push_back(s);
+  }
 
-    // ..........................................
-    // copy points for cross lines ("dx", "dy" still unchanged ! )
-    if(g->countY > 1) {
-      zp = zp_tmp;
-      for(j=g->countY/dy; j>0; j--) { // every plane
-        for(i=dx; i>0; i--) {  // every branch
-          for(z=dy; z>0; z--) {  // every point
-            pMem->x  = p->x;
-            pMem->y  = p->y;
-            pMem->No = pMem-Mem;
-            pMem->done = 0;
-            zp->NoCross = pMem-Mem; // position of its cross grid
-            pMem++;
-            p += dx;  // next coordinate
-            zp += dx;
-          }
-          (pMem-1)->done |= 8;  // mark as "last in line"
-          p  -= dx*dy - 1;  // next z coordinate
-          zp -= dx*dy - 1;
-        }
-        p  += dx*(dy-1);
-        zp += dx*(dy-1);
-      }
+  for(int i=Count-1; i>0; i--) {
+    tLine3D Whole = { p->x, p->y, (p+Step)->x, (p+Step)->y };
+    tLine3D const *pl = &Whole, *pl_end = pl+1;
+    if(Seg->first >= 0) {
+      pl = Pieces.data() + Seg->first;
+      pl_end = pl + Seg->count;
     }
-    (pMem-1)->done |= 256;  // mark as "very last point"
 
-
-    if(hideLines) {
-    // ..........................................
-    // Calculate the z-coordinate of all polygons by building the
-    // sum of the z-coordinates of all of its 4 corners.
-    // After this, each point represents one polygon. The unneccessary
-    // points are filled with "-FLTMAX".
-    zp = zp_tmp;
-    // "dx" and "dy" are still unchanged !
-    for(i=g->countY-1; i>=0; i--) {   // all branches
-      if(dy > 0) if(i % dy) {
-        for(j=dx-1; j>0; j--) {   // x coordinates
-          zp->z += (zp+1)->z + (zp+dx)->z + (zp+dx+1)->z;
-          zp++;
+    for( ; pl < pl_end; pl++) {
+      if(!isOpen || pl->x1 != x || pl->y1 != y) {  // not continued ?
+        if(isOpen) {
+          s.setStrokeEnd();
+          v.push_back(s);
         }
-        zp->z = -FLT_MAX;  // last one not needed
-        zp++;
-        continue;
-      }
-
-      // last line not needed
-      for(j=dx; j>0; j--) {   // x coordinates
-        zp->z = -FLT_MAX;  // last one not needed
-        zp++;
+        s.setScr(pl->x1, pl->y1);
+        v.push_back(s);
       }
+      s.setScr(pl->x2, pl->y2);
+      v.push_back(s);
+      x = pl->x2;
+      y = pl->y2;
+      isOpen = true;
     }
-    }  // of "if(hideLines)"
+    p += Step;
+    Seg++;
+  }
 
-  }  // of "for(Graphs)"
+  s.setBranchEnd();
+  v.push_back(s);
+}
 
+// --------------------------------------------------------------
+// Graphs taking part in the hidden line algorithm.
+static bool isMesh(Graph const *g)
+{
+  if(!g->cPointsY)  return false;
+  return g->count(0) > 0;
+}
 
-  if(!hideLines) {  // do not hide invisible lines
-    free(zMem);
-    return;
+// --------------------------------------------------------------
+// Checks whether rotation, size, axis limits or graph data changed
+// since the last hidden line removal.
+bool Rect3DDiagram::viewChanged()
+{
+  std::vector<double> v;
+  v.push_back(rotX);  v.push_back(rotY);  v.push_back(rotZ);
+  v.push_back(x2);    v.push_back(y2);    v.push_back(hideLines);
+  Axis const *pa[3] = { &xAxis, &yAxis, &zAxis };
+  for(int i=0; i<3; i++) {
+    v.push_back(pa[i]->low);
+    v.push_back(pa[i]->up);
+    v.push_back(pa[i]->log);
   }
 
-#if 0
-  qDebug("##########################################");
-  qDebug("Size 1b: Size=%d, %d, %d", Size, pMem-Mem, zp-zMem);
-  for(tPoint3D *p=Mem; p<pMem; p++)
-    qDebug("xyPoints:  %d/%d - %d - %d", p->x, p->y, p->No, p->done);
-  qDebug("------------------------------------------");
-  for(tPointZ *p=zMem; p-zMem<Size; p++)
-    qDebug("zPoints:   %g - %d", p->z, p->No);
-#endif
-
-
-  // ..........................................
-  // Sort z-coordinates (greatest first).
-  // After this the polygons that have the smallest distance to the
-  // viewer are on top of the list and thus, will be processed first.
-  qsort(zMem, Size, sizeof(tPointZ), comparePointZ);
-
-#if 0
-  qDebug("--------------------------- z sorting");
-  for(tPointZ *p=zMem; p-zMem<Size; p++)
-    qDebug("zPoints:   %g - %d", p->z, p->No);
-#endif
+  bool changed = (v != View);
+  unsigned n = 0;
+  foreach(Graph *g, Graphs) {
+    if(!isMesh(g))  continue;
+    if(n >= Visible.size())  changed = true;
+    else if(Visible[n].g != g || Visible[n].Data != g->cPointsY
+            || Visible[n].Loaded != g->lastLoaded)
+      changed = true;
+    n++;
+  }
+  if(n != Visible.size())  changed = true;
 
+  View.swap(v);
+  return changed;
+}
 
-  // ..........................................
-  char *pc;
-  // malloc_8xsize added (see comment before malloc_8xsize declaration)
-  tPoint3D *MemEnd = Mem + malloc_8xsize*2*Size - 5;   // limit of buffer
+// --------------------------------------------------------------
+// Removes the invisible parts of the graphs (painter's algorithm). The
+// polygons of all meshes are sorted by depth and worked on, beginning
+// with the one nearest to the viewer. Each line segment is calculated
+// only once, by the first polygon it belongs to. Then the polygon area
+// is added to "Covered". Thus, time and memory grow (nearly) linear
+// with the number of data points and the diagram size.
+void Rect3DDiagram::removeHiddenLines()
+{
+  double Dummy = 0.0;  // number for 1-dimensional data in 3D cartesian
+  int i, j, nPoints = 0, nSegments = 0, nPolygons = 0;
 
-  zp = zMem;
+  std::vector<tMesh3D> Meshes;
   foreach(Graph *g, Graphs) {
-    if(!g->cPointsY) continue;
-    dx = g->axis(0)->count;
-    if(g->countY > 1)  dy = g->axis(1)->count;
-    else  dy = 1;
-
-    // look for hidden lines ...
-    for(int No = g->countY/dy * (dx-1)*(dy-1); No>0; No--) {
+    if(!isMesh(g))  continue;
+    tMesh3D m;
+    m.g  = g;
+    m.dx = g->count(0);
+    m.dy = 1;
+    if(g->countY > 1)  if(g->count(1) > 0)
+      m.dy = g->count(1);
+    m.Point   = nPoints;
+    m.Segment = nSegments;
+    nPoints   += m.dx * g->countY;
+    nSegments += g->countY*(m.dx-1) + g->countY/m.dy * m.dx*(m.dy-1);
+    nPolygons += g->countY/m.dy * (m.dx-1)*(m.dy-1);
+    Meshes.push_back(m);
+  }
 
-      // reset the polygon bounding buffer
-      for(i=x2; i>=0; i--) {
-        (Bounds+i)->max = INT_MIN;
-        (Bounds+i)->min = INT_MAX;
+  // ..........................................
+  // calculate coordinates of all points
+  std::vector<tPoint3D> Points(nPoints);
+  for(unsigned n=0; n<Meshes.size(); n++) {
+    tMesh3D const& m = Meshes[n];
+    double const *px, *py = &Dummy, *pz = m.g->cPointsY;
+    tPoint3D *p = Points.data() + m.Point;
+    for(i=0; i<m.g->countY; i++) {   // y coordinates
+      if(m.dy > 1)  py = m.g->axis(1)->Points + i % m.dy;
+      px = m.g->axis(0)->Points;
+      for(j=m.dx; j>0; j--) {   // x coordinates
+        calcCoordinate3D(*(px++), *py, *pz, *(pz+1), p++);
+        pz += 2;
       }
+    }
+  }
 
-      // work on all 4 lines of polygon
-      p = Mem + zp->No;  // polygon corner coordinates
-      calcLine(p, MemEnd, Bounds, zBuffer);
-
-      p += dx;
-      calcLine(p, MemEnd, Bounds, zBuffer);
-
-      p = Mem + zp->NoCross;  // cross grid
-      calcLine(p, MemEnd, Bounds, zBuffer);
+  tSegment3D Unknown = { -1, 0 };
+  std::vector<tSegment3D> Segments(nSegments, Unknown);
+  std::vector<tLine3D> Pieces;
 
-      p += dy;
-      calcLine(p, MemEnd, Bounds, zBuffer);
+  tBound Empty = { INT_MAX, INT_MIN };
+  Bounds.assign(x2+1, Empty);
+  Covered.assign(x2+1, std::vector<tBound>());
+  BoundMin = INT_MAX;
+  BoundMax = INT_MIN;
 
-      // mark the area of the polygon (stored in "*Bounds") as used
-      for(i=x2-1; i>=0; i--)  // all x coordinates
-        if( (Bounds+i)->max > INT_MIN) {
-          pc = zBuffer + i * ((y2+7)>>3);
-          for(j=(Bounds+i)->min; j<=(Bounds+i)->max; j++) // all y coordinates
-            *(pc + (j>>3)) |= (1 << (j & 7));
+  if(hideLines) {
+    // ..........................................
+    // Calculate the z-coordinate of all polygons by building the sum
+    // of the z-coordinates of all of its 4 corners. Sort them (greatest
+    // first), so the polygons nearest to the viewer come first.
+    std::vector<tPolygon3D> Polygons;
+    Polygons.reserve(nPolygons);
+    for(unsigned n=0; n<Meshes.size(); n++) {
+      tMesh3D const& m = Meshes[n];
+      for(i=0; i<m.g->countY; i++) {   // all branches
+        if((i+1) % m.dy == 0)  continue;   // last line of plane
+        for(j=0; j<m.dx-1; j++) {   // x coordinates
+          tPoint3D const *p = Points.data() + m.Point + i*m.dx + j;
+          tPolygon3D pp;
+          pp.z = p->z + (p+1)->z + (p+m.dx)->z + (p+m.dx+1)->z;
+          pp.Mesh = n;
+          pp.No = i*m.dx + j;
+          Polygons.push_back(pp);
         }
-
-      zp++;   // next polygon
+      }
     }
+    std::sort(Polygons.begin(), Polygons.end(), comparePolygon3D);
 
-  }  // of "for(Graphs)"
+    // ..........................................
+    // look for hidden lines ...
+    for(unsigned n=0; n<Polygons.size(); n++) {
+      tPolygon3D const& pp = Polygons[n];
+      tMesh3D const& m = Meshes[pp.Mesh];
+      int Line = pp.No / m.dx, Col = pp.No % m.dx;
+      int Plane = Line / m.dy, Row = Line % m.dy;
+      tPoint3D *p[4] = { Points.data() + m.Point + pp.No, p[0]+1,
+                         p[0]+m.dx, p[0]+m.dx+1 };
+
+      for(i=0; i<4; i++)   // corners are tested for symbols
+        if(p[i]->done == 0)
+          p[i]->done = isHidden(p[i]->x, p[i]->y) ? 2 : 1;
 
-#if 0
-  qDebug("--------------------------- hidden lines %d", pMem-Mem);
-  for(tPoint3D *p=Mem; p<pMem; p++)
-    qDebug("xyPoints:  %d/%d - %d - %d", p->x, p->y, p->No, p->done);
-#endif
+      // work on all 4 lines of polygon
+      tSegment3D *s[4] = {
+        &Segments[m.xSegment(Line, Col)], &Segments[m.xSegment(Line+1, Col)],
+        &Segments[m.ySegment(Plane, Col, Row)],
+        &Segments[m.ySegment(Plane, Col+1, Row)] };
+      int From[4] = { 0, 2, 0, 1 };
+      int To[4]   = { 1, 3, 2, 3 };
+      for(i=0; i<4; i++) {
+        if(s[i]->first >= 0) {  // already worked on, only the area counts
+          calcLine(*p[From[i]], *p[To[i]], 0);
+          continue;
+        }
+        s[i]->first = Pieces.size();
+        calcLine(*p[From[i]], *p[To[i]], &Pieces);
+        s[i]->count = Pieces.size() - s[i]->first;
+      }
 
-  free(zMem);
+      // mark the area of the polygon (stored in "Bounds") as used
+      for(i=BoundMin; i<=BoundMax; i++) {
+        cover(i, Bounds[i].min, Bounds[i].max);
+        Bounds[i] = Empty;
+      }
+      BoundMin = INT_MAX;
+      BoundMax = INT_MIN;
+    }
+  }
 
-  // sort "No" (least one first)
-  qsort(Mem, pMem - Mem, sizeof(tPoint3D), comparePoint3D);
+  // ..........................................
+  // create screen points of the visible lines
+  Visible.clear();
+  Visible.resize(Meshes.size());
+  for(unsigned n=0; n<Meshes.size(); n++) {
+    tMesh3D const& m = Meshes[n];
+    tGraph3D& v = Visible[n];
+    v.g = m.g;
+    v.Data = m.g->cPointsY;
+    v.Loaded = m.g->lastLoaded;
+
+    Graph::ScrPt s;
+    s.setStrokeEnd();
+    v.Lines.push_back(s);
+    v.Symbols.push_back(s);
+
+    tPoint3D const *p = Points.data() + m.Point;
+    for(i=0; i<m.g->countY; i++) {   // lines along x
+      appendLine(v.Lines, p, 1, m.dx, &Segments[m.xSegment(i, 0)], Pieces);
+      for(j=m.dx; j>0; j--) {
+        if(p->done != 2) {
+          s.setScr(p->x, p->y);
+          v.Symbols.push_back(s);
+        }
+        p++;
+      }
+      s.setBranchEnd();
+      v.Symbols.push_back(s);
+    }
 
-#if 0
-  qDebug("--------------------------- last sorting %d", pMem-Mem);
-  for(tPoint3D *p=Mem; p<pMem; p++)
-    qDebug("xyPoints:  %d/%d - %d - %d", p->x, p->y, p->No, p->done);
-  qDebug("\n");
-#endif
+    if(m.dy > 1)   // cross grid
+      for(i=0; i<m.g->countY/m.dy; i++)   // every plane
+        for(j=0; j<m.dx; j++)   // every branch
+          appendLine(v.Lines, Points.data() + m.Point + i*m.dy*m.dx + j,
+                     m.dx, m.dy, &Segments[m.ySegment(i, j, 0)], Pieces);
+  }
 }
 
 // --------------------------------------------------------------
 // Removes the invisible parts of the coordinate cross.
-void Rect3DDiagram::removeHiddenCross(int x1_, int y1_, int x2_, int y2_,
-                                      char *zBuffer, tBound *Bounds)
+void Rect3DDiagram::removeHiddenCross(int x1_, int y1_, int x2_, int y2_)
 {
-  pMem = Mem;
-
-  pMem->x  = x1_;
-  pMem->y  = y1_;
-  pMem->No = 0;
-  pMem->done = 0;
-  pMem++;
-
-  pMem->x  = x2_;
-  pMem->y  = y2_;
-  pMem->No = 1;
-  pMem->done = 0;
-  pMem++;
-
-  tPoint3D *p = Mem+6;
-  calcLine(Mem, p, Bounds, zBuffer);
-  *pMem = *(Mem+1);
-  *(Mem+1) = *Mem;
-  p = Mem+2;
-  do {
-    if(((p-1)->done & 4) == 0)
-      Lines.append(new Line((p-1)->x, (p-1)->y, p->x, p->y, QPen(Qt::black,0)));
-    p++;
-  } while(p <= pMem);
+  if(!hideLines) {
+    tLine3D Whole = { x1_, y1_, x2_, y2_ };
+    Cross.push_back(Whole);
+    return;
+  }
+
+  tPoint3D p1 = { x1_, y1_, 0.0f, 0 };
+  tPoint3D p2 = { x2_, y2_, 0.0f, 0 };
+  calcLine(p1, p2, &Cross);
 }
 
 // --------------------------------------------------------------
@@ -835,9 +887,6 @@ int Rect3DDiagram::calcDiagram()
   x3 = x2 + 7;
   int z, z2, o, w;
 
-  char *zBuffer=0;   // hidden line algorithm
-  tBound *Bounds=0;
-
 
   // =====  give "step" the right sign  ==================================
   xAxis.step = fabs(xAxis.step);
@@ -925,42 +974,23 @@ int Rect3DDiagram::calcDiagram()
   createAxis(&zAxis, true, X[z], Y[z], X[z2], Y[z2]);
 
 
-  if(hideLines) {
-    w = (x2+1) * (y2/8 + 1);
-    // To store the pixel coordinates that are already used (hidden).
-    // Use one bit per pixel.
-    zBuffer = (char*)malloc(w);
-    memset(zBuffer, 0, w);
-
-    // To store the boundings of the current polygon.
-    Bounds = (tBound*)malloc((x2+1) * sizeof(tBound));
-  }
-
-  // hide invisible parts of graphs
-  removeHiddenLines(zBuffer, Bounds);
-
-  if(hideLines) {
-    // now hide invisible part of coordinate cross
-    tPoint3D *MemTmp = Mem;
-    Mem = (tPoint3D*)malloc( 10*sizeof(tPoint3D) );
-    
-    removeHiddenCross(X[o^1], Y[o^1], X[o], Y[o], zBuffer, Bounds); // x axis
-    removeHiddenCross(X[o^2], Y[o^2], X[o], Y[o], zBuffer, Bounds); // y axis
-    removeHiddenCross(X[o^4], Y[o^4], X[o], Y[o], zBuffer, Bounds); // z axis
-  
-    free(Mem);
-    Mem = MemTmp;  // write back values
+  // hide invisible parts of graphs and coordinate cross, this is
+  // only necessary if something changed
+  if(viewChanged()) {
+    Cross.clear();
+    removeHiddenLines();
+    removeHiddenCross(X[o^1], Y[o^1], X[o], Y[o]); // x axis
+    removeHiddenCross(X[o^2], Y[o^2], X[o], Y[o]); // y axis
+    removeHiddenCross(X[o^4], Y[o^4], X[o], Y[o]); // z axis
 
-    free(Bounds);
-    free(zBuffer);
-  }
-  else {
-    Lines.append(new Line(X[o], Y[o], X[o^1], Y[o^1], QPen(Qt::black,0)));
-    Lines.append(new Line(X[o], Y[o], X[o^2], Y[o^2], QPen(Qt::black,0)));
-    Lines.append(new Line(X[o], Y[o], X[o^4], Y[o^4], QPen(Qt::black,0)));
+    Covered.clear();   // release memory
+    Bounds.clear();
   }
 
-  pMem = Mem;
+  for(unsigned i=0; i<Cross.size(); i++)
+    Lines.append(new Line(Cross[i].x1, Cross[i].y1, Cross[i].x2, Cross[i].y2,
+                          QPen(Qt::black,0)));
+
   return 3;
 
 
@@ -974,87 +1004,37 @@ Frame:   // jump here if error occurred (e.g. impossible log boundings)
 
 // ------------------------------------------------------------
 // g->Points must already be empty!!!
+// The screen points were created by "removeHiddenLines".
 void Rect3DDiagram::calcData(Graph *g)
 {
-  if(!pMem)  return;
-  if(!g->cPointsY) return;
-
-  int Size = ((2*(g->axis(0)->count) + 1) * g->countY) + 10;
-  Size *= 2;  // memory for cross grid lines
-
-  g->resizeScrPoints(Size);
-  auto p = g->begin();
-  auto p_end = g->begin();
-  p_end += Size - 9;   // limit of buffer
+  tGraph3D const *v = 0;
+  for(unsigned i=0; i<Visible.size(); i++)
+    if(Visible[i].g == g)  v = &Visible[i];
+  if(!v)  return;
+  if(v->Data != g->cPointsY)  return;
 
-
-  p->setStrokeEnd();
-  ++p;
+  std::vector<Graph::ScrPt> const *pv;
   switch(g->Style) {
     case GRAPHSTYLE_SOLID:
     case GRAPHSTYLE_DASH:
     case GRAPHSTYLE_DOT:
     case GRAPHSTYLE_LONGDASH:
-      do {
-
-        while(1) {
-          if(pMem->done & 11)    // is grid point ?
-            if(pMem->done & 4) { // is hidden
-              if(pMem > Mem) {
-                if((pMem-1)->done & 12)
-                  break;
-              }
-              else  break;
-	    }
-          FIT_MEMORY_SIZE;  // need to enlarge memory block ?
-	  (p++)->setScr(pMem->x, pMem->y);
-          break;
-        }
-
-        FIT_MEMORY_SIZE;  // need to enlarge memory block ?
-        if(pMem->done & 8)  (p++)->setBranchEnd();
-
-        if(pMem->done & 4)   // point invisible ?
-          if((p-1)->isPt())
-            (p++)->setStrokeEnd();
-
-      } while(((pMem++)->done & 256) == 0);
-      p->setGraphEnd();
+      pv = &v->Lines;
       break;
 
-    default:  // symbol (e.g. star) at each point **********************
-      do {
-        while(1) {
-          if(pMem->done & 11)    // is grid point ?
-            if(pMem->done & 4) { // is hidden
-              if(pMem > Mem) {
-                if((pMem-1)->done & 12)
-                  break;
-              }
-              else  break;
-	    }
-
-          (p++)->setScr(pMem->x, pMem->y);
-          break;
-        }
-
-        if(pMem->done & 8)
-          (p++)->setBranchEnd();
-      } while(((pMem++)->done & 512) == 0);
-      p->setGraphEnd();
+    default:  // symbol (e.g. star) at each point
+      pv = &v->Symbols;
   }
 
-  return;
+  g->resizeScrPoints(pv->size() + 1);
+  auto p = std::copy(pv->begin(), pv->end(), g->begin());
+  p->setGraphEnd();
 }
 
 // ------------------------------------------------------------
-// The labels are created during "calcDiagram", but the memory
-// for the coordinates is released here.
+// The labels are created during "calcDiagram".
 void Rect3DDiagram::createAxisLabels()
 {
-  if(Mem)  free (Mem);
-  Mem  = 0;
-  pMem = 0;
 }
 
 // ------------------------------------------------------------
@@ -20,21 +20,33 @@
 
 #include "diagram.h"
 
+#include <vector>
 
+
+// screen position and depth of a grid point
 struct tPoint3D {
   int   x, y;
-  int   No, done;
-};
-
-struct tPointZ {
   float z;
-  int   No, NoCross;
+  int   done;   // 0 = not yet tested, 1 = visible, 2 = hidden
 };
 
 struct tBound {
   int min, max;
 };
 
+// visible part of a line
+struct tLine3D {
+  int x1, y1, x2, y2;
+};
+
+// visible lines of a graph, screen points ready for Graph::ScrPoints
+struct tGraph3D {
+  Graph const *g;
+  double const *Data;   // data and ...
+  QDateTime Loaded;     // ... time of loading they were calculated from
+  std::vector<Graph::ScrPt> Lines, Symbols;
+};
+
 
 class Rect3DDiagram : public Diagram  {
 public:
@@ -52,10 +64,6 @@ public:
   void createAxisLabels();
   bool insideDiagram(float, float) const;
 
-  tPoint3D *Mem;   // memory for all points during hidden line algorithm
-  tPoint3D *pMem;  // current position in "Mem"
-
-
 protected:
   void calcData(Graph*);
 
@@ -69,14 +77,23 @@ private:
   double calcY_2D(double, double, double) const;
   double calcZ_2D(double, double, double) const;
 
-  static int comparePoint3D(const void*, const void*);
-  static int comparePointZ(const void*, const void*);
-  bool isHidden(int, int, tBound*, char*);
-  void enlargeMemoryBlock(tPoint3D* &);
-  void calcLine(tPoint3D* &, tPoint3D* &, tBound*, char*);
-  void calcCoordinate3D(double, double, double, double, tPoint3D*, tPointZ*);
-  void removeHiddenLines(char*, tBound*);
-  void removeHiddenCross(int, int, int, int, char*, tBound*);
+  bool isHidden(int, int) const;
+  void cover(int, int, int);
+  void calcLine(tPoint3D const&, tPoint3D const&, std::vector<tLine3D>*);
+  void calcCoordinate3D(double, double, double, double, tPoint3D*) const;
+  bool viewChanged();
+  void removeHiddenLines();
+  void removeHiddenCross(int, int, int, int);
+
+  // hidden line algorithm
+  std::vector<std::vector<tBound> > Covered; // per column: y ranges in use
+  std::vector<tBound> Bounds;   // per column: y range of current polygon
+  int BoundMin, BoundMax;       // columns touched in "Bounds"
+
+  // its results, kept until the view or the data changes
+  std::vector<double>   View;
+  std::vector<tGraph3D> Visible;  // graph lines
+  std::vector<tLine3D>  Cross;    // coordinate cross
 
   float  xorig, yorig; // where is the 3D origin with respect to cx/cy
   double cxx, cxy, cxz, cyx, cyy, cyz, czx, czy, czz; // coefficients 3D -> 2D
@@ -529,8 +529,11 @@ void SimMessage::startSimulator()
           }
       } // vaComponents not empty
 
-      if((SimOpt = findOptimization((Schematic*)DocWidget))) {
-	    ((Optimize_Sim*)SimOpt)->createASCOnetlist();
+      // an optimization is run by qucsator as well unless ASCO is
+      // chosen, its results are taken over afterwards
+      SimOpt = findOptimization((Schematic*)DocWidget);
+      if(SimOpt && ((Optimize_Sim*)SimOpt)->useASCO()) {
+        ((Optimize_Sim*)SimOpt)->createASCOnetlist();
 
         Program = QucsSettings.AscoBinDir.canonicalPath();
         Program = QDir::toNativeSeparators(Program+"/"+"asco"+QString(executableSuffix));
@@ -539,7 +542,7 @@ void SimMessage::startSimulator()
       }
       else {
         Program = QucsSettings.Qucsator;
-        Arguments << "-b" << "-g" << "-i"
+        Arguments << "-S" << "-i"
                   << QucsSettings.QucsHomeDir.filePath("netlist.txt")
                   << "-o" << DataSet;
       }
@@ -620,8 +623,27 @@ Component * SimMessage::findOptimization(Schematic *Doc) {
  */
 void SimMessage::slotDisplayMsg()
 {
-  int i;
+  int i, j;
   ProgressText += QString(SimProcess.readAllStandardOutput());
+
+  // take out the status lines of the simulator (starting with '@')
+  i = 0;
+  while((i = ProgressText.indexOf('@', i)) >= 0) {
+    if(i > 0 && ProgressText.at(i-1) != '\n') {
+      i++;
+      continue;
+    }
+    j = ProgressText.indexOf('\n', i);
+    if(j < 0) {  // incomplete line, wait for the rest
+      QString tmps = ProgressText.left(i).trimmed();
+      if(!tmps.isEmpty())
+        ProgText->appendPlainText(tmps);
+      ProgressText.remove(0, i);
+      return;
+    }
+    parseStatus(ProgressText.mid(i+1, j-i-1));
+    ProgressText.remove(i, j-i+1);
+  }
   if(wasLF) {
     i = ProgressText.lastIndexOf('\r');
     if(i > 1) {
@@ -663,6 +685,50 @@ void SimMessage::slotDisplayMsg()
   wasLF = false;
 }
 
+/*!
+ * \brief Handles a status line of the simulator.
+ *
+ *  The lines consist of a keyword followed by "key=value" pairs, e.g.
+ *  "progress name=TR1 index=12 count=200 eta=4.1 newton=3 top=1" or
+ *  "partial vars=n1.Vt,n2.Vt".  The progress bar follows the top
+ *  level analyses, nested ones are shown in its tooltip.  Partial
+ *  results are passed on to the main window.
+ */
+void SimMessage::parseStatus(const QString& Line)
+{
+  QStringList Fields = Line.split(' ', QString::SkipEmptyParts);
+  if(Fields.isEmpty())  return;
+  QString Kind = Fields.takeFirst();
+  QMap<QString, QString> Values;
+  foreach(QString Field, Fields) {
+    int i = Field.indexOf('=');
+    if(i > 0)  Values[Field.left(i)] = Field.mid(i+1);
+  }
+
+  if(Kind == "progress") {
+    int index = Values["index"].toInt();
+    int count = Values["count"].toInt();
+    double eta = Values["eta"].toDouble();
+    QString Name = Values["name"];
+    if(Values["top"] == "1") {
+      SimProgress->setMaximum(count > 0 ? count : 100);
+      SimProgress->setValue(index);
+      if(eta >= 0.0)
+        SimProgress->setFormat(tr("%1: %p% (%2 s left)")
+                               .arg(Name).arg(eta, 0, 'f', 0));
+      else
+        SimProgress->setFormat(Name + ": %p%");
+    }
+    SimProgress->setToolTip(tr("%1: point %2 of %3, %4 Newton iterations")
+                            .arg(Name).arg(index+1).arg(count)
+                            .arg(Values["newton"]));
+  }
+  else if(Kind == "partial") {
+    emit partialResults(this, Values["vars"].split(',',
+                        QString::SkipEmptyParts));
+  }
+}
+
 #ifdef SPEEDUP_PROGRESSBAR
 // ------------------------------------------------------------------------
 void SimMessage::slotUpdateProgressBar()
@@ -772,6 +838,8 @@ void SimMessage::FinishSimulation(int Status)
 {
   Abort->setText(tr("Close window"));
   Display->setDisabled(false);
+  SimProgress->setMaximum(100);
+  SimProgress->setFormat("%p%");
   SimProgress->setValue(100);  // progress bar to 100%
 
   QDate d = QDate::currentDate();   // get date of today
@@ -804,7 +872,8 @@ void SimMessage::FinishSimulation(int Status)
   }
 
   if(Status == 0) {
-    if(SimOpt) { // save optimization data
+    if(SimOpt && ((Optimize_Sim*)SimOpt)->useASCO()) {
+      // save optimization data
       QFile ifile(QucsSettings.QucsHomeDir.filePath("asco_out.dat"));
       QFile ofile(DataSet);
       if(ifile.open(QIODevice::ReadOnly)) {
@@ -815,8 +884,16 @@ void SimMessage::FinishSimulation(int Status)
 	}
 	ifile.close();
       }
-      if(((Optimize_Sim*)SimOpt)->loadASCOout())
+      if(((Optimize_Sim*)SimOpt)->loadASCOout()) {
+	((Schematic*)DocWidget)->indexElement(SimOpt);
 	((Schematic*)DocWidget)->setChanged(true,true);
+      }
+    }
+    else if(SimOpt) { // take over the optimized values
+      if(((Optimize_Sim*)SimOpt)->loadResults(DataSet)) {
+	((Schematic*)DocWidget)->indexElement(SimOpt);
+	((Schematic*)DocWidget)->setChanged(true,true);
+      }
     }
   }
 
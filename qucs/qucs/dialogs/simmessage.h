@@ -49,6 +49,7 @@ public:
 signals:
   void SimulationEnded(int, SimMessage*);
   void displayDataPage(QString&, QString&);
+  void partialResults(SimMessage*, const QStringList&);
 
 public slots:
   void slotClose();
@@ -76,6 +77,7 @@ private:
 private:
   void FinishSimulation(int);
   void nextSPICE();
+  void parseStatus(const QString&);
   void startSimulator();
   Component * findOptimization(Schematic *);
 
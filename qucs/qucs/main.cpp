@@ -341,7 +341,7 @@ int doPrint(QString schematic, QString printFile,
   sch->Diagrams = &(sch->DocDiags);
   sch->Paintings = &(sch->DocPaints);
   sch->Components = &(sch->DocComps);
-  sch->reloadGraphs();
+  sch->reloadGraphs(false);  // printed right away
 
   qDebug() << "*** try to print file  :" << printFile;
 
@@ -624,7 +624,7 @@ void createListComponentEntry(){
       }
 
       // skip Subcircuit, segfault, there is nothing to netlist
-      if (c->Model == "Sub" or c->Model == ".Opt") {
+      if (c->Model == "Sub") {
         fprintf(stdout, "WARNING, qucsator netlist not generated for %s\n\n", c->Model.toAscii().data());
         continue;
       }
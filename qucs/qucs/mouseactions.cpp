@@ -199,9 +199,11 @@ void MouseActions::endElementMoving(Schematic *Doc, Q3PtrList<Element> *movEleme
 	break;
       case isDiagram:
 	Doc->Diagrams->append((Diagram*)pe);
+	Doc->touchElement(pe);
 	break;
       case isPainting:
 	Doc->Paintings->append((Painting*)pe);
+	Doc->touchElement(pe);
 	break;
       case isComponent:
       case isAnalogComponent:
@@ -213,15 +215,21 @@ void MouseActions::endElementMoving(Schematic *Doc, Q3PtrList<Element> *movEleme
       case isVMovingLabel:
 	Doc->insertNodeLabel((WireLabel*)pe);
 	break;
+      case isHWireLabel:
+      case isVWireLabel:
+      case isNodeLabel:
+	Doc->touchElement(((WireLabel*)pe)->pOwner);  // moved at its owner
+	break;
       case isMarker:
 	assert(dynamic_cast<Marker*>(pe));
+	Doc->touchElement((Diagram*)((Marker*)pe)->diag());
 	break;
     }
   }
 
   movElements->clear();
   if((MAx3 != 0) || (MAy3 != 0))  // moved or put at the same place ?
-    Doc->setChanged(true, true);
+    Doc->recordChanges();
 
   // enlarge viewarea if components lie outside the view
   Doc->sizeOfAll(Doc->UsedX1, Doc->UsedY1, Doc->UsedX2, Doc->UsedY2);
@@ -1135,11 +1143,12 @@ void MouseActions::MPressMirrorX(Schematic *Doc, QMouseEvent*, float fX, float f
     Painting *p = Doc->selectedPainting(fX, fY);
     if(p == 0) return;
     p->mirrorX();
+    Doc->touchElement(p);
   }
 
   Doc->viewport()->update();
   drawn = false;
-  Doc->setChanged(true, true);
+  Doc->recordChanges();
 }
 
 // -----------------------------------------------------------
@@ -1156,11 +1165,12 @@ void MouseActions::MPressMirrorY(Schematic *Doc, QMouseEvent*, float fX, float f
     Painting *p = Doc->selectedPainting(fX, fY);
     if(p == 0) return;
     p->mirrorY();
+    Doc->touchElement(p);
   }
 
   Doc->viewport()->update();
   drawn = false;
-  Doc->setChanged(true, true);
+  Doc->recordChanges();
 }
 
 // -----------------------------------------------------------
@@ -1205,6 +1215,7 @@ void MouseActions::MPressRotate(Schematic *Doc, QMouseEvent*, float fX, float fY
 
     case isPainting:
       ((Painting*)e)->rotate();
+      Doc->touchElement(e);
       // enlarge viewarea if component lies outside the view
       ((Painting*)e)->Bounding(x1,y1,x2,y2);
       Doc->enlargeView(x1, y1, x2, y2);
@@ -1215,7 +1226,7 @@ void MouseActions::MPressRotate(Schematic *Doc, QMouseEvent*, float fX, float fY
   }
   Doc->viewport()->update();
   drawn = false;
-  Doc->setChanged(true, true);
+  Doc->recordChanges();
 }
 
 // -----------------------------------------------------------
@@ -1243,6 +1254,7 @@ void MouseActions::MPressElement(Schematic *Doc, QMouseEvent *Event, float, floa
 	Doc->insertComponent(Comp);
 	Comp->textSize(x2, y2);
 	if(Comp->tx < Comp->x1) Comp->tx -= x2 - x1;
+	Doc->indexElement(Comp);
 
     // Note: insertCopmponents does increment  name1 -> name2
 //    qDebug() << "  +-+ got to insert:" << Comp->Name;
@@ -1253,7 +1265,7 @@ void MouseActions::MPressElement(Schematic *Doc, QMouseEvent *Event, float, floa
 
 	drawn = false;
 	Doc->viewport()->update();
-	Doc->setChanged(true, true);
+	Doc->recordChanges();
 	rot = Comp->rotated;
 
     // handle static and dynamic components
@@ -1303,8 +1315,9 @@ void MouseActions::MPressElement(Schematic *Doc, QMouseEvent *Event, float, floa
     }
 
     Doc->Diagrams->append(Diag);
+    Doc->touchElement(Diag);
     Doc->enlargeView(Diag->cx, Diag->cy-Diag->y2, Diag->cx+Diag->x2, Diag->cy);
-    Doc->setChanged(true, true);   // document has been changed
+    Doc->recordChanges();   // document has been changed
 
     Doc->viewport()->repaint();
     Diag = Diag->newOne(); // the component is used, so create a new one
@@ -1317,12 +1330,13 @@ void MouseActions::MPressElement(Schematic *Doc, QMouseEvent *Event, float, floa
   // ***********  it is a painting !!!
   if(((Painting*)selElem)->MousePressing()) {
     Doc->Paintings->append((Painting*)selElem);
+    Doc->touchElement(selElem);
     ((Painting*)selElem)->Bounding(x1,y1,x2,y2);
     //Doc->enlargeView(x1, y1, x2, y2);
     selElem = ((Painting*)selElem)->newOne();
 
     Doc->viewport()->update();
-    Doc->setChanged(true, true);
+    Doc->recordChanges();
 
     MMoveElement(Doc, Event);  // needed before next mouse pressing
     drawn = false;
@@ -1414,7 +1428,7 @@ void MouseActions::MPressWire2(Schematic *Doc, QMouseEvent *Event, float fX, flo
 	//Doc->viewport()->update();
 
 	drawn = false;
-    if(set1 | set2) Doc->setChanged(true, true);
+    if(set1 | set2) Doc->recordChanges();
     MAx3 = MAx2;
     MAy3 = MAy2;
     break;
@@ -1842,9 +1856,10 @@ void MouseActions::MReleaseMoveText(Schematic *Doc, QMouseEvent *Event)
 
   ((Component*)focusElement)->tx = MAx1 - ((Component*)focusElement)->cx;
   ((Component*)focusElement)->ty = MAy1 - ((Component*)focusElement)->cy;
+  Doc->indexElement(focusElement);
   Doc->viewport()->update();
   drawn = false;
-  Doc->setChanged(true, true);
+  Doc->recordChanges();
 }
 
 // -----------------------------------------------------------
@@ -1935,7 +1950,8 @@ void MouseActions::editElement(Schematic *Doc, QMouseEvent *Event)
            Doc->Components->append(c);
          }
 
-         Doc->setChanged(true, true);
+         Doc->indexElement(c);  // text may have changed
+         Doc->recordChanges();
          c->entireBounds(x1,y1,x2,y2, Doc->textCorr());
          Doc->enlargeView(x1,y1,x2,y2);
          break;
@@ -42,6 +42,7 @@
 #include <QSettings>
 #include <QVariant>
 #include <QDebug>
+#include <QTimer>
 
 #include "main.h"
 #include "qucs.h"
@@ -166,6 +167,12 @@ QucsApp::QucsApp()
   // instance of small text search dialog
   SearchDia = new SearchDialog(this);
 
+  // graphs are updated with partial results at most every 250ms
+  PartialTimer = new QTimer(this);
+  PartialTimer->setSingleShot(true);
+  PartialTimer->setInterval(250);
+  connect(PartialTimer, SIGNAL(timeout()), SLOT(slotReloadPartial()));
+
   // creates a document called "untitled"
   Schematic *d = new Schematic(this, "");
   int i = DocumentTab->addTab(d, QPixmap(empty_xpm), QObject::tr("untitled"));
@@ -2077,6 +2084,8 @@ void QucsApp::slotSimulate()
 		SLOT(slotAfterSimulation(int, SimMessage*)));
   connect(sim, SIGNAL(displayDataPage(QString&, QString&)),
 		this, SLOT(slotChangePage(QString&, QString&)));
+  connect(sim, SIGNAL(partialResults(SimMessage*, const QStringList&)),
+		this, SLOT(slotPartialResults(SimMessage*, const QStringList&)));
 
   sim->show();
   if(!sim->startProcess()) return;
@@ -2137,6 +2146,40 @@ void QucsApp::slotAfterSimulation(int Status, SimMessage *sim)
 
 }
 
+// ------------------------------------------------------------------------
+// Is called when the simulator has written partial results.  The
+// changed variables are collected and the graphs are updated by a
+// timer, so the simulator may report more often than we repaint.
+void QucsApp::slotPartialResults(SimMessage *sim, const QStringList& Vars)
+{
+  if(PartialSim != sim)  PartialVars.clear();
+  PartialSim = sim;
+  foreach(QString Var, Vars)
+    if(!PartialVars.contains(Var))  PartialVars.append(Var);
+  if(!PartialTimer->isActive())
+    PartialTimer->start();
+}
+
+// ------------------------------------------------------------------------
+// Updates the graphs showing the variables changed by partial results.
+void QucsApp::slotReloadPartial()
+{
+  if(!PartialSim || PartialVars.isEmpty())  return;
+  if(PartialSim->DocWidget == 0 || isTextDocument(PartialSim->DocWidget))
+    return;
+
+  int i=0;
+  QWidget *w;  // search, if page is still open
+  while((w=DocumentTab->widget(i++)) != 0)
+    if(w == PartialSim->DocWidget)  break;
+  if(w == 0)  return;
+
+  Schematic *Doc = (Schematic*)w;
+  if(Doc->reloadGraphs(PartialVars))
+    Doc->viewport()->update();
+  PartialVars.clear();
+}
+
 // ------------------------------------------------------------------------
 void QucsApp::slotDCbias()
 {
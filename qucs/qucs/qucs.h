@@ -22,6 +22,8 @@
 #include <QString>
 #include <QHash>
 #include <QStack>
+#include <QStringList>
+#include <QPointer>
 
 class QucsDoc;
 class Schematic;
@@ -52,6 +54,7 @@ class QListView;
 class QFileSystemModel;
 class QModelIndex;
 class QPushButton;
+class QTimer;
 
 typedef bool (Schematic::*pToggleFunc) ();
 typedef void (MouseActions::*pMouseFunc) (Schematic*, QMouseEvent*);
@@ -149,6 +152,8 @@ private slots:
   void slotChangeView(QWidget*);
   void slotSimulate();
   void slotAfterSimulation(int, SimMessage*);
+  void slotPartialResults(SimMessage*, const QStringList&);
+  void slotReloadPartial();
   void slotDCbias();
   void slotChangePage(QString&, QString&);
   void slotHideEdit();
@@ -199,6 +204,9 @@ private:
   QFileSystemModel *m_homeDirModel;
   QFileSystemModel *m_projModel;
   int ccCurIdx; // CompChooser current index (used during search)
+  QTimer *PartialTimer;  // limits graph updates during simulations
+  QPointer<SimMessage> PartialSim;
+  QStringList PartialVars;  // variables changed since last update
 
 // ********** Methods ***************************************************
   void initView();
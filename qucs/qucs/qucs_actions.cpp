@@ -1106,7 +1106,8 @@ void QucsApp::slotApplyCompText()
               break;  // found component with the same name ?
           if(!pc2) {
             pc->Name = editText->text();
-            Doc->setChanged(true, true);  // only one undo state
+            Doc->indexElement(pc);
+            Doc->recordChanges();  // only one undo state
           }
         }
     }
@@ -1114,7 +1115,7 @@ void QucsApp::slotApplyCompText()
       if(pp->Value != editText->text()) {
         pp->Value = editText->text();
         Doc->recreateComponent(pc);  // because of "Num" and schematic symbol
-        Doc->setChanged(true, true); // only one undo state
+        Doc->recordChanges(); // only one undo state
       }
     }
 
@@ -49,6 +49,7 @@
 #include "viewpainter.h"
 #include "mouseactions.h"
 #include "diagrams/diagrams.h"
+#include "diagrams/graphloader.h"
 #include "paintings/paintings.h"
 #include "components/vhdlfile.h"
 #include "components/verilogfile.h"
@@ -78,6 +79,9 @@ Schematic::Schematic(QucsApp *App_, const QString& Name_)
   tmpUsedX2 = tmpUsedY2 = tmpViewX2 = tmpViewY2 =  200;
   tmpScale = 1.0;
 
+  IndexValid = false;
+  IndexWires = 0;
+
   DocComps.setAutoDelete(true);
   DocWires.setAutoDelete(true);
   DocNodes.setAutoDelete(true);
@@ -85,12 +89,6 @@ Schematic::Schematic(QucsApp *App_, const QString& Name_)
   DocPaints.setAutoDelete(true);
   SymbolPaints.setAutoDelete(true);
 
-  // The 'i' means state for being unchanged.
-  undoActionIdx = 0;
-  undoAction.append(new QString(" i\n</>\n</>\n</>\n</>\n"));
-  undoSymbolIdx = 0;
-  undoSymbol.append(new QString(" i\n</>\n</>\n</>\n</>\n"));
-
   isVerilog = false;
   creatingLib = false;
 
@@ -106,6 +104,10 @@ Schematic::Schematic(QucsApp *App_, const QString& Name_)
   viewport()->setMouseTracking(true);
   viewport()->setAcceptDrops(true);  // enable drag'n drop
 
+  // repaint diagrams whose data was loaded in the background
+  connect(GraphLoader::instance(), SIGNAL(loaded(Diagram*)),
+      SLOT(slotGraphsLoaded(Diagram*)));
+
   // to repair some strange  scrolling artefacts
   connect(this, SIGNAL(horizontalSliderReleased()),
       viewport(), SLOT(update()));
@@ -208,8 +210,8 @@ void Schematic::becomeCurrent(bool update)
       setChanged(true, true);
     }
 
-    emit signalUndoState(undoSymbolIdx != 0);
-    emit signalRedoState(undoSymbolIdx != undoSymbol.size()-1);
+    emit signalUndoState(undoSymbol.canUndo());
+    emit signalRedoState(undoSymbol.canRedo());
   }
   else {
     Nodes = &DocNodes;
@@ -218,8 +220,8 @@ void Schematic::becomeCurrent(bool update)
     Paintings = &DocPaints;
     Components = &DocComps;
 
-    emit signalUndoState(undoActionIdx != 0);
-    emit signalRedoState(undoActionIdx != undoAction.size()-1);
+    emit signalUndoState(undoAction.canUndo());
+    emit signalRedoState(undoAction.canRedo());
     if(update)
       reloadGraphs();   // load recent simulation data
   }
@@ -258,52 +260,44 @@ void Schematic::setChanged(bool c, bool fillStack, char Op)
 
   // ................................................
   if(symbolMode) {  // for symbol edit mode
-    while(undoSymbol.size() > undoSymbolIdx + 1) {
-      delete undoSymbol.last();
-      undoSymbol.pop_back();
-    }
+    recordSymbolUndoState();
+    undoSymbol.push(Op, QucsSettings.maxUndo);
 
-    undoSymbol.append(new QString(createSymbolUndoString(Op)));
-    undoSymbolIdx++;
-
-    emit signalUndoState(true);
+    emit signalUndoState(undoSymbol.canUndo());
     emit signalRedoState(false);
-
-    while(static_cast<unsigned int>(undoSymbol.size()) > QucsSettings.maxUndo) { // "while..." because
-      delete undoSymbol.first();
-      undoSymbol.pop_front();
-      undoSymbolIdx--;
-    }
     return;
   }
 
   // ................................................
-  // for schematic edit mode
-  while(undoAction.size() > undoActionIdx + 1) {
-    delete undoAction.last();
-    undoAction.pop_back();
-  }
+  // for schematic edit mode, only one step for move marker ('m')
+  recordUndoState();
+  undoAction.push(Op, QucsSettings.maxUndo);
 
-  if(Op == 'm') {   // only one for move marker
-    if (undoAction.at(undoActionIdx)->at(0) == Op) {
-      delete undoAction.last();
-      undoAction.pop_back();
-      undoActionIdx--;
-    }
+  emit signalUndoState(undoAction.canUndo());
+  emit signalRedoState(false);
+  return;
+}
+
+// ---------------------------------------------------
+// Same as "setChanged(true, true, Op)", but the undo step just consists
+// of the elements touched or dropped since the last step, instead of
+// comparing the whole document. To be used by edits that report every
+// element they change: nodes, wires and components do so themselves via
+// the spatial index, diagrams and paintings by calling "touchElement()"
+// and "dropElement()".
+void Schematic::recordChanges(char Op)
+{
+  if(symbolMode) {
+    setChanged(true, true, Op);
+    return;
   }
+  setChanged(true);
 
-  undoAction.append(new QString(createUndoString(Op)));
-  undoActionIdx++;
+  recordTouched();
+  undoAction.push(Op, QucsSettings.maxUndo);
 
-  emit signalUndoState(true);
+  emit signalUndoState(undoAction.canUndo());
   emit signalRedoState(false);
-
-  while(static_cast<unsigned int>(undoAction.size()) > QucsSettings.maxUndo) { // "while..." because
-    delete undoAction.first(); // "maxUndo" could be decreased meanwhile
-    undoAction.pop_front();
-    undoActionIdx--;
-  }
-  return;
 }
 
 // -----------------------------------------------------------
@@ -405,21 +399,35 @@ void Schematic::drawContents(QPainter *p, int, int, int, int)
   if(!symbolMode)
     paintFrame(&Painter);
 
-  for(Component *pc = Components->first(); pc != 0; pc = Components->next())
-    pc->paint(&Painter);
-
-  for(Wire *pw = Wires->first(); pw != 0; pw = Wires->next()) {
-    pw->paint(&Painter);
+  // only draw the components, wires and nodes within the visible area
+  // (with some margin for line width and text metrics)
+  int d = 10 + int(10.0 / Scale);
+  int x1 = ViewX1 + int(float(contentsX()) / Scale) - d;
+  int y1 = ViewY1 + int(float(contentsY()) / Scale) - d;
+  int x2 = ViewX1 + int(float(contentsX()+visibleWidth()) / Scale) + d;
+  int y2 = ViewY1 + int(float(contentsY()+visibleHeight()) / Scale) + d;
+  QList<Element*> Visible;
+  elementIndex().query(x1, y1, x2, y2, Visible);
+
+  foreach(Element *pe, Visible)
+    if(pe->Type & isComponent)
+      ((Component*)pe)->paint(&Painter);
+
+  foreach(Element *pe, Visible)
+    if(pe->Type == isWire)
+      ((Wire*)pe)->paint(&Painter);
+  for(Wire *pw = Wires->first(); pw != 0; pw = Wires->next())
     if(pw->Label)
       pw->Label->paint(&Painter);  // separate because of paintSelected
-  }
+
+  foreach(Element *pe, Visible)
+    if(pe->Type == isNode)
+      ((Node*)pe)->paint(&Painter);
 
   Node *pn;
-  for(pn = Nodes->first(); pn != 0; pn = Nodes->next()) {
-    pn->paint(&Painter);
+  for(pn = Nodes->first(); pn != 0; pn = Nodes->next())
     if(pn->Label)
       pn->Label->paint(&Painter);  // separate because of paintSelected
-  }
 
   // FIXME disable here, issue with select box goes away
   // also, instead of red, line turns blue
@@ -1261,12 +1269,47 @@ bool Schematic::mirrorYComponents()
 }
 
 // ---------------------------------------------------
-// Updates the graph data of all diagrams (load from data files).
-void Schematic::reloadGraphs()
+// Updates the graph data of all diagrams (load from data files). The
+// data is loaded by worker threads unless "inBackground" is false, the
+// diagrams are repainted once ready (see slotGraphsLoaded()).
+void Schematic::reloadGraphs(bool inBackground)
 {
   QFileInfo Info(DocName);
   for(Diagram *pd = Diagrams->first(); pd != 0; pd = Diagrams->next())
-    pd->loadGraphData(Info.path()+QDir::separator()+DataSet);
+    if(inBackground)
+      GraphLoader::instance()->load(pd, Info.path()+QDir::separator()+DataSet);
+    else
+      pd->loadGraphData(Info.path()+QDir::separator()+DataSet);
+}
+
+// ---------------------------------------------------
+// Is called when the data of a diagram was loaded in the background.
+void Schematic::slotGraphsLoaded(Diagram *pd)
+{
+  if(DocDiags.containsRef(pd))
+    viewport()->update();
+}
+
+// ---------------------------------------------------
+// Updates only the diagrams showing one of the given variables, e.g.
+// when partial results of a running simulation arrive.  Returns true
+// if a diagram gets updated.
+bool Schematic::reloadGraphs(const QStringList& Vars)
+{
+  bool changed = false;
+  QFileInfo Info(DocName);
+  for(Diagram *pd = Diagrams->first(); pd != 0; pd = Diagrams->next()) {
+    foreach(Graph *pg, pd->Graphs) {
+      QString Var = pg->Var.section(':', -1);  // without dataset name
+      if(Vars.contains(Var)) {
+        GraphLoader::instance()->load(pd,
+                        Info.path()+QDir::separator()+DataSet);
+        changed = true;
+        break;
+      }
+    }
+  }
+  return changed;
 }
 
 // Copy function, 
@@ -1299,6 +1342,7 @@ bool Schematic::paste(QTextStream *stream, Q3PtrList<Element> *pe)
 // Loads this Qucs document.
 bool Schematic::load()
 {
+  invalidateIndex();
   DocComps.clear();
   DocWires.clear();
   DocNodes.clear();
@@ -1309,23 +1353,14 @@ bool Schematic::load()
   if(!loadDocument()) return false;
   lastSaved = QDateTime::currentDateTime();
 
-  while(!undoAction.isEmpty()) {
-    delete undoAction.last();
-    undoAction.pop_back();
-  }
-  undoActionIdx = 0;
-  while(!undoSymbol.isEmpty()) {
-    delete undoSymbol.last();
-    undoSymbol.pop_back();
-  }
-  symbolMode = true;
-  setChanged(false, true); // "not changed" state, but put on undo stack
-  undoSymbolIdx = 0;
-  undoSymbol.at(undoSymbolIdx)->replace(1, 1, 'i');
-  symbolMode = false;
-  setChanged(false, true); // "not changed" state, but put on undo stack
-  undoActionIdx = 0;
-  undoAction.at(undoActionIdx)->replace(1, 1, 'i');
+  // "not changed" state, the bottom of the undo stacks
+  undoSymbol.clear();
+  recordSymbolUndoState();
+  undoSymbol.setBottom();
+  undoAction.clear();
+  recordUndoState();
+  undoAction.setBottom();
+  setChanged(false);
 
   // The undo stack of the circuit symbol is initialized when first
   // entering its edit mode.
@@ -1358,18 +1393,9 @@ int Schematic::save()
   if(result >= 0) {
     setChanged(false);
 
-    QVector<QString *>::iterator it;
-    for (it = undoAction.begin(); it != undoAction.end(); it++) {
-      (*it)->replace(1, 1, ' '); //at(1) = ' '; state of being changed
-    }
-    //(1) = 'i';   // state of being unchanged
-    undoAction.at(undoActionIdx)->replace(1, 1, 'i');
-
-    for (it = undoSymbol.begin(); it != undoSymbol.end(); it++) {
-      (*it)->replace(1, 1, ' '); //at(1) = ' '; state of being changed
-    }
-    //at(1) = 'i';   // state of being unchanged
-    undoSymbol.at(undoSymbolIdx)->replace(1, 1, 'i');
+    // current states are the unchanged ones
+    undoAction.setSaved();
+    undoSymbol.setSaved();
   }
   // update the subcircuit file lookup hashes
   QucsMain->updateSchNameHash();
@@ -1620,46 +1646,28 @@ int Schematic::adjustPortNumbers()
 bool Schematic::undo()
 {
   if(symbolMode) {
-    if (undoSymbolIdx == 0) { return false; }
+    if(!undoSymbol.canUndo()) { return false; }
 
-    rebuildSymbol(undoSymbol.at(--undoSymbolIdx));
+    restoreUndoState(undoSymbol, undoSymbol.undo(), false);
     adjustPortNumbers();  // set port names
 
-    emit signalUndoState(undoSymbolIdx != 0);
-    emit signalRedoState(undoSymbolIdx != undoSymbol.size()-1);
-
-    if(undoSymbol.at(undoSymbolIdx)->at(1) == 'i' && 
-        undoAction.at(undoActionIdx)->at(1) == 'i') {
-      setChanged(false, false);
-      return true;
-    }
+    emit signalUndoState(undoSymbol.canUndo());
+    emit signalRedoState(undoSymbol.canRedo());
 
-    setChanged(true, false);
+    setChanged(!(undoSymbol.isSaved() && undoAction.isSaved()), false);
     return true;
   }
 
 
   // ...... for schematic edit mode .......
-  if (undoActionIdx == 0) { return false; }
+  if(!undoAction.canUndo()) { return false; }
 
-  rebuild(undoAction.at(--undoActionIdx));
-  reloadGraphs();  // load recent simulation data
+  restoreUndoState(undoAction, undoAction.undo(), false);
 
-  emit signalUndoState(undoActionIdx != 0);
-  emit signalRedoState(undoActionIdx != undoAction.size()-1);
-
-  if(undoAction.at(undoActionIdx)->at(1) == 'i') {
-    if(undoSymbol.isEmpty()) {
-      setChanged(false, false);
-      return true;
-    }
-    else if(undoSymbol.at(undoSymbolIdx)->at(1) == 'i') {
-      setChanged(false, false);
-      return true;
-    }
-  }
+  emit signalUndoState(undoAction.canUndo());
+  emit signalRedoState(undoAction.canRedo());
 
-  setChanged(true, false);
+  setChanged(!(undoAction.isSaved() && undoSymbol.isSaved()), false);
   return true;
 }
 
@@ -1667,48 +1675,28 @@ bool Schematic::undo()
 bool Schematic::redo()
 {
   if(symbolMode) {
-    if (undoSymbolIdx == undoSymbol.size() - 1) { return false; }
+    if(!undoSymbol.canRedo()) { return false; }
 
-    rebuildSymbol(undoSymbol.at(++undoSymbolIdx));
+    restoreUndoState(undoSymbol, undoSymbol.redo(), true);
     adjustPortNumbers();  // set port names
 
-    emit signalUndoState(undoSymbolIdx != 0);
-    emit signalRedoState(undoSymbolIdx != undoSymbol.size()-1);
-
-    if(undoSymbol.at(undoSymbolIdx)->at(1) == 'i'
-        && undoAction.at(undoActionIdx)->at(1) == 'i') {
-      setChanged(false, false);
-      return true;
-    }
+    emit signalUndoState(undoSymbol.canUndo());
+    emit signalRedoState(undoSymbol.canRedo());
 
-    setChanged(true, false);
+    setChanged(!(undoSymbol.isSaved() && undoAction.isSaved()), false);
     return true;
   }
 
 
-  //
   // ...... for schematic edit mode .......
-  if (undoActionIdx == undoAction.size()-1) { return false; }
-
-  rebuild(undoAction.at(++undoActionIdx));
-  reloadGraphs();  // load recent simulation data
+  if(!undoAction.canRedo()) { return false; }
 
-  emit signalUndoState(undoActionIdx != 0);
-  emit signalRedoState(undoActionIdx != undoAction.size()-1);
+  restoreUndoState(undoAction, undoAction.redo(), true);
 
-  if (undoAction.at(undoActionIdx)->at(1) == 'i') {
-    if(undoSymbol.isEmpty()) {
-      setChanged(false, false);
-      return true;
-    }
-    else if(undoSymbol.at(undoSymbolIdx)->at(1) == 'i') {
-      setChanged(false, false);
-      return true;
-    }
-    
-  }
+  emit signalUndoState(undoAction.canUndo());
+  emit signalRedoState(undoAction.canRedo());
 
-  setChanged(true, false);
+  setChanged(!(undoAction.isSaved() && undoSymbol.isSaved()), false);
   return true;
 }
 
@@ -31,6 +31,8 @@
 #include "node.h"
 #include "qucsdoc.h"
 #include "viewpainter.h"
+#include "spatialindex.h"
+#include "undostack.h"
 #include "diagrams/diagram.h"
 #include "paintings/painting.h"
 #include "components/component.h"
@@ -83,6 +85,7 @@ public:
 
   void setName(const QString&);
   void setChanged(bool, bool fillStack=false, char Op='*');
+  void recordChanges(char Op='*');
   void paintGrid(ViewPainter*, int, int, int, int);
   void print(QPrinter*, QPainter*, bool, bool);
 
@@ -106,7 +109,8 @@ public:
   void  enlargeView(int, int, int, int);
   void  switchPaintMode();
   int   adjustPortNumbers();
-  void  reloadGraphs();
+  void  reloadGraphs(bool inBackground=true);
+  bool  reloadGraphs(const QStringList&);
   bool  createSubcircuitSymbol();
 
   void    cut();
@@ -152,10 +156,8 @@ public:
   int tmpViewX1, tmpViewY1, tmpViewX2, tmpViewY2;
   int tmpUsedX1, tmpUsedY1, tmpUsedX2, tmpUsedY2;
 
-  int undoActionIdx;
-  QVector<QString *> undoAction;
-  int undoSymbolIdx;
-  QVector<QString *> undoSymbol;    // undo stack for circuit symbol
+  UndoStack undoAction;
+  UndoStack undoSymbol;    // undo stack for circuit symbol
 
   /*! \brief Get (schematic) file reference */
   QFileInfo getFileInfo (void) { return FileInfo; }
@@ -184,6 +186,7 @@ protected:
   void contentsDragMoveEvent(QDragMoveEvent*);
 
 protected slots:
+  void slotGraphsLoaded(Diagram*);
   void slotScrollUp();
   void slotScrollDown();
   void slotScrollLeft();
@@ -202,6 +205,11 @@ private:
    ******************************************************************** */
 
 public:
+  SpatialIndex& elementIndex();
+  void  indexElement(Element*);
+  void  unindexElement(Element*);
+  void  invalidateIndex() { IndexValid = false; }
+
   Node* insertNode(int, int, Element*);
   Node* selectedNode(int, int);
 
@@ -264,6 +272,12 @@ private:
   bool copyComps2WiresPaints(int&, int&, int&, int&, QList<Element *> *);
   int  copyElements(int&, int&, int&, int&, QList<Element *> *);
 
+  // nodes, wires and components of the current lists by location
+  SpatialIndex Index;
+  bool  IndexValid;
+  float IndexCorr;              // text correction the index was built for
+  Q3PtrList<Wire> *IndexWires;  // lists the index was built for
+
 
 /* ********************************************************************
    *****  The following methods are in the file                   *****
@@ -273,6 +287,8 @@ private:
 
 public:
   static int testFile(const QString &);
+  void touchElement(Element*);
+  void dropElement(Element*);
   bool createLibNetlist(QTextStream*, QPlainTextEdit*, int);
   bool createSubNetlist(QTextStream *, int&, QStringList&, QPlainTextEdit*, int);
   void createSubNetlistPlain(QTextStream*, QPlainTextEdit*, int);
@@ -285,6 +301,7 @@ private:
   int  saveDocument();
 
   bool loadProperties(QTextStream*);
+  Node* findDocNode(int, int);
   void simpleInsertComponent(Component*);
   bool loadComponents(QTextStream*, Q3PtrList<Component> *List=0);
   void simpleInsertWire(Wire*);
@@ -296,10 +313,20 @@ private:
   QString createClipboardFile();
   bool    pasteFromClipboard(QTextStream *, Q3PtrList<Element>*);
 
-  QString createUndoString(char);
-  bool    rebuild(QString *);
-  QString createSymbolUndoString(char);
-  bool    rebuildSymbol(QString *);
+  static void recordElement(UndoStack&, Element*, int);
+  void     recordTouched();
+  void     recordUndoState();
+  void     recordSymbolUndoState();
+  void     undoPositions(QHash<Element*, int>&);
+  void     restoreUndoState(UndoStack&, const UndoChanges&, bool);
+  bool     insertUndoChanges(UndoStack&, const UndoChanges&, bool, bool&);
+  bool     rebuildUndoState(UndoStack&, const UndoChanges&, bool&);
+  void     removeUndoElement(int, Element*);
+  Element* insertUndoElement(int, const QString&, int, bool&);
+  void     releaseNode(Node*, Element*);
+
+  // elements changed since the last undo step, true if still existing
+  QHash<Element*, bool> Touched;
 
   static void createNodeSet(QStringList&, int&, Conductor*, Node*);
   void throughAllNodes(bool, QStringList&, int&);
@@ -22,6 +22,77 @@
 #include <QDebug>
 
 
+/* *******************************************************************
+   *****                                                         *****
+   *****          Actions handling the spatial index             *****
+   *****                                                         *****
+   ******************************************************************* */
+
+// Returns the index of the nodes, wires and components of the current
+// lists. It is built anew after the lists were switched (symbol mode),
+// the text size changed (zoom) or the document was loaded. Every place
+// changing the extent of an element updates the index itself.
+SpatialIndex& Schematic::elementIndex()
+{
+    float Corr = textCorr();
+    if(IndexValid) if(IndexWires == Wires) if(IndexCorr == Corr)
+        return Index;
+
+    Index.clear();
+    IndexValid = true;
+    IndexWires = Wires;
+    IndexCorr  = Corr;
+
+    // iterators do not disturb the current item of the lists
+    for(Q3PtrListIterator<Component> it(*Components); it.current(); ++it)
+        indexElement(it.current());
+    for(Q3PtrListIterator<Wire> it(*Wires); it.current(); ++it)
+        indexElement(it.current());
+    for(Q3PtrListIterator<Node> it(*Nodes); it.current(); ++it)
+        indexElement(it.current());
+    return Index;
+}
+
+// ---------------------------------------------------
+// Inserts element 'pe' into the index or updates its location. Must be
+// called whenever an element is appended to the lists or changes its
+// geometry. The undo stack learns about the change, too.
+void Schematic::indexElement(Element *pe)
+{
+    touchElement(pe);
+    if(!IndexValid) return;
+    if(IndexWires != Wires) return;  // index of other lists
+
+    int x1, y1, x2, y2;
+    if(pe->Type == isNode)
+    {
+        x1 = pe->cx-5;  y1 = pe->cy-5;   // as in Node::getSelected()
+        x2 = pe->cx+5;  y2 = pe->cy+5;
+    }
+    else if(pe->Type == isWire)
+    {
+        x1 = pe->x1-5;  y1 = pe->y1-5;   // as in Wire::getSelected()
+        x2 = pe->x2+5;  y2 = pe->y2+5;
+    }
+    else if(pe->Type & isComponent)
+        ((Component*)pe)->entireBounds(x1, y1, x2, y2, IndexCorr);
+    else return;
+
+    Index.insert(pe, x1, y1, x2, y2);
+}
+
+// ---------------------------------------------------
+// Removes element 'pe' from the index. Must be called before it is
+// removed from the lists.
+void Schematic::unindexElement(Element *pe)
+{
+    dropElement(pe);
+    if(!IndexValid) return;
+    if(IndexWires != Wires) return;
+    Index.remove(pe);
+}
+
+
 /* *******************************************************************
    *****                                                         *****
    *****              Actions handling the nodes                 *****
@@ -32,26 +103,31 @@
 // the coordinates are identical. The node is returned.
 Node* Schematic::insertNode(int x, int y, Element *e)
 {
-    Node *pn;
+    Node *pn = 0;
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+
     // check if new node lies upon existing node
-    for(pn = Nodes->first(); pn != 0; pn = Nodes->next())  // check every node
-        if(pn->cx == x) if(pn->cy == y)
-            {
-                pn->Connections.append(e);
-                break;
-            }
+    foreach(Element *pe, Found)
+        if(pe->Type == isNode)
+            if(pe->cx == x) if(pe->cy == y)
+                {
+                    pn = (Node*)pe;
+                    pn->Connections.append(e);
+                    return pn;   // return, if node is not new
+                }
 
-    if(pn == 0)   // create new node, if no existing one lies at this position
-    {
-        pn = new Node(x, y);
-        Nodes->append(pn);
-        pn->Connections.append(e);  // connect schematic node to component node
-    }
-    else return pn;   // return, if node is not new
+    // create new node, if no existing one lies at this position
+    pn = new Node(x, y);
+    Nodes->append(pn);
+    indexElement(pn);
+    pn->Connections.append(e);  // connect schematic node to component node
 
     // check if the new node lies upon an existing wire
-    for(Wire *pw = Wires->first(); pw != 0; pw = Wires->next())
+    foreach(Element *pe, Found)
     {
+        if(pe->Type != isWire) continue;
+        Wire *pw = (Wire*)pe;
         if(pw->x1 == x)
         {
             if(pw->y1 > y) continue;
@@ -75,9 +151,12 @@ Node* Schematic::insertNode(int x, int y, Element *e)
 // ---------------------------------------------------
 Node* Schematic::selectedNode(int x, int y)
 {
-    for(Node *pn = Nodes->first(); pn != 0; pn = Nodes->next()) // test nodes
-        if(pn->getSelected(x, y))
-            return pn;
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+    foreach(Element *pe, Found)   // test nodes in list order
+        if(pe->Type == isNode)
+            if(((Node*)pe)->getSelected(x, y))
+                return (Node*)pe;
 
     return 0;
 }
@@ -95,22 +174,27 @@ Node* Schematic::selectedNode(int x, int y)
 int Schematic::insertWireNode1(Wire *w)
 {
     Node *pn;
-    // check if new node lies upon an existing node
-    for(pn = Nodes->first(); pn != 0; pn = Nodes->next()) // check every node
-        if(pn->cx == w->x1) if(pn->cy == w->y1) break;
+    QList<Element*> Found;
+    elementIndex().query(w->x1, w->y1, w->x1, w->y1, Found);
 
-    if(pn != 0)
-    {
-        pn->Connections.append(w);
-        w->Port1 = pn;
-        return 2;   // node is not new
-    }
+    // check if new node lies upon an existing node
+    foreach(Element *pe, Found)
+        if(pe->Type == isNode)
+            if(pe->cx == w->x1) if(pe->cy == w->y1)
+                {
+                    pn = (Node*)pe;
+                    pn->Connections.append(w);
+                    w->Port1 = pn;
+                    return 2;   // node is not new
+                }
 
 
 
     // check if the new node lies upon an existing wire
-    for(Wire *ptr2 = Wires->first(); ptr2 != 0; ptr2 = Wires->next())
+    foreach(Element *pe, Found)
     {
+        if(pe->Type != isWire) continue;
+        Wire *ptr2 = (Wire*)pe;
         if(ptr2->x1 == w->x1)
         {
             if(ptr2->y1 > w->y1) continue;
@@ -138,7 +222,9 @@ int Schematic::insertWireNode1(Wire *w)
                         }
                         ptr2->Port1->Connections.removeRef(ptr2);  // two -> one wire
                         ptr2->Port1->Connections.append(w);
+                        unindexElement(ptr2->Port2);
                         Nodes->removeRef(ptr2->Port2);
+                        unindexElement(ptr2);
                         Wires->removeRef(ptr2);
                         return 2;
                     }
@@ -179,7 +265,9 @@ int Schematic::insertWireNode1(Wire *w)
                         }
                         ptr2->Port1->Connections.removeRef(ptr2); // two -> one wire
                         ptr2->Port1->Connections.append(w);
+                        unindexElement(ptr2->Port2);
                         Nodes->removeRef(ptr2->Port2);
+                        unindexElement(ptr2);
                         Wires->removeRef(ptr2);
                         return 2;
                     }
@@ -197,6 +285,7 @@ int Schematic::insertWireNode1(Wire *w)
 
         pn = new Node(w->x1, w->y1);   // create new node
         Nodes->append(pn);
+        indexElement(pn);
         pn->Connections.append(w);  // connect schematic node to the new wire
         w->Port1 = pn;
 
@@ -207,6 +296,7 @@ int Schematic::insertWireNode1(Wire *w)
 
     pn = new Node(w->x1, w->y1);   // create new node
     Nodes->append(pn);
+    indexElement(pn);
     pn->Connections.append(w);  // connect schematic node to the new wire
     w->Port1 = pn;
     return 1;
@@ -240,9 +330,11 @@ bool Schematic::connectHWires1(Wire *w)
             }
             w->x1 = pw->x1;
             w->Port1 = pw->Port1;      // new wire lengthens an existing one
+            unindexElement(n);
             Nodes->removeRef(n);
             w->Port1->Connections.removeRef(pw);
             w->Port1->Connections.append(w);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -261,7 +353,9 @@ bool Schematic::connectHWires1(Wire *w)
                 w->Label->pOwner = w;
             }
             pw->Port1->Connections.removeRef(pw);
+            unindexElement(pw->Port2);
             Nodes->removeRef(pw->Port2);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -303,9 +397,11 @@ bool Schematic::connectVWires1(Wire *w)
             }
             w->y1 = pw->y1;
             w->Port1 = pw->Port1;         // new wire lengthens an existing one
+            unindexElement(n);
             Nodes->removeRef(n);
             w->Port1->Connections.removeRef(pw);
             w->Port1->Connections.append(w);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -324,7 +420,9 @@ bool Schematic::connectVWires1(Wire *w)
                 w->Label->pOwner = w;
             }
             pw->Port1->Connections.removeRef(pw);
+            unindexElement(pw->Port2);
             Nodes->removeRef(pw->Port2);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -345,22 +443,27 @@ bool Schematic::connectVWires1(Wire *w)
 int Schematic::insertWireNode2(Wire *w)
 {
     Node *pn;
-    // check if new node lies upon an existing node
-    for(pn = Nodes->first(); pn != 0; pn = Nodes->next())  // check every node
-        if(pn->cx == w->x2) if(pn->cy == w->y2) break;
+    QList<Element*> Found;
+    elementIndex().query(w->x2, w->y2, w->x2, w->y2, Found);
 
-    if(pn != 0)
-    {
-        pn->Connections.append(w);
-        w->Port2 = pn;
-        return 2;   // node is not new
-    }
+    // check if new node lies upon an existing node
+    foreach(Element *pe, Found)
+        if(pe->Type == isNode)
+            if(pe->cx == w->x2) if(pe->cy == w->y2)
+                {
+                    pn = (Node*)pe;
+                    pn->Connections.append(w);
+                    w->Port2 = pn;
+                    return 2;   // node is not new
+                }
 
 
 
     // check if the new node lies upon an existing wire
-    for(Wire *ptr2 = Wires->first(); ptr2 != 0; ptr2 = Wires->next())
+    foreach(Element *pe, Found)
     {
+        if(pe->Type != isWire) continue;
+        Wire *ptr2 = (Wire*)pe;
         if(ptr2->x1 == w->x2)
         {
             if(ptr2->y1 > w->y2) continue;
@@ -382,7 +485,9 @@ int Schematic::insertWireNode2(Wire *w)
                     w->Port2 = ptr2->Port2;
                     ptr2->Port2->Connections.removeRef(ptr2);  // two -> one wire
                     ptr2->Port2->Connections.append(w);
+                    unindexElement(ptr2->Port1);
                     Nodes->removeRef(ptr2->Port1);
+                    unindexElement(ptr2);
                     Wires->removeRef(ptr2);
                     return 2;
                 }
@@ -416,7 +521,9 @@ int Schematic::insertWireNode2(Wire *w)
                     w->Port2 = ptr2->Port2;
                     ptr2->Port2->Connections.removeRef(ptr2);  // two -> one wire
                     ptr2->Port2->Connections.append(w);
+                    unindexElement(ptr2->Port1);
                     Nodes->removeRef(ptr2->Port1);
+                    unindexElement(ptr2);
                     Wires->removeRef(ptr2);
                     return 2;
                 }
@@ -433,6 +540,7 @@ int Schematic::insertWireNode2(Wire *w)
 
         pn = new Node(w->x2, w->y2);   // create new node
         Nodes->append(pn);
+        indexElement(pn);
         pn->Connections.append(w);  // connect schematic node to the new wire
         w->Port2 = pn;
 
@@ -443,6 +551,7 @@ int Schematic::insertWireNode2(Wire *w)
 
     pn = new Node(w->x2, w->y2);   // create new node
     Nodes->append(pn);
+    indexElement(pn);
     pn->Connections.append(w);  // connect schematic node to the new wire
     w->Port2 = pn;
     return 1;
@@ -470,9 +579,11 @@ bool Schematic::connectHWires2(Wire *w)
             }
             w->x2 = pw->x2;
             w->Port2 = pw->Port2;      // new wire lengthens an existing one
+            unindexElement(n);
             Nodes->removeRef(n);
             w->Port2->Connections.removeRef(pw);
             w->Port2->Connections.append(w);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -488,7 +599,9 @@ bool Schematic::connectHWires2(Wire *w)
                 w->Label->pOwner = w;
             }
             pw->Port2->Connections.removeRef(pw);
+            unindexElement(pw->Port1);
             Nodes->removeRef(pw->Port1);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -524,9 +637,11 @@ bool Schematic::connectVWires2(Wire *w)
             }
             w->y2 = pw->y2;
             w->Port2 = pw->Port2;     // new wire lengthens an existing one
+            unindexElement(n);
             Nodes->removeRef(n);
             w->Port2->Connections.removeRef(pw);
             w->Port2->Connections.append(w);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -542,7 +657,9 @@ bool Schematic::connectVWires2(Wire *w)
                 w->Label->pOwner = w;
             }
             pw->Port2->Connections.removeRef(pw);
+            unindexElement(pw->Port1);
             Nodes->removeRef(pw->Port1);
+            unindexElement(pw);
             Wires->removeRef(pw);
             return true;
         }
@@ -608,6 +725,7 @@ int Schematic::insertWire(Wire *w)
     if(con > 255) con = ((con >> 1) & 1) | ((con << 1) & 2);
 
     Wires->append(w);    // add wire to the schematic
+    indexElement(w);
 
 
 
@@ -616,43 +734,32 @@ int Schematic::insertWire(Wire *w)
     Wire *pw, *nw;
     Node *pn, *pn2;
     Element *pe;
+    QList<Element*> Found;
+    SpatialIndex& Idx = elementIndex();
     // ................................................................
     // Check if the new line covers existing nodes.
     // In order to also check new appearing wires -> use "for"-loop
     for(pw = Wires->current(); pw != 0; pw = Wires->next())
-        for(pn = Nodes->first(); pn != 0; )    // check every node
+    {
+        Found.clear();
+        Idx.query(pw->x1, pw->y1, pw->x2, pw->y2, Found);
+        foreach(Element *pf, Found)    // check every node near the wire
         {
+            if(!Idx.contains(pf)) continue;   // deleted meanwhile
+            if(pf->Type != isNode) continue;
+            pn = (Node*)pf;
+
             if(pn->cx == pw->x1)
             {
-                if(pn->cy <= pw->y1)
-                {
-                    pn = Nodes->next();
-                    continue;
-                }
-                if(pn->cy >= pw->y2)
-                {
-                    pn = Nodes->next();
-                    continue;
-                }
+                if(pn->cy <= pw->y1) continue;
+                if(pn->cy >= pw->y2) continue;
             }
             else if(pn->cy == pw->y1)
             {
-                if(pn->cx <= pw->x1)
-                {
-                    pn = Nodes->next();
-                    continue;
-                }
-                if(pn->cx >= pw->x2)
-                {
-                    pn = Nodes->next();
-                    continue;
-                }
-            }
-            else
-            {
-                pn = Nodes->next();
-                continue;
+                if(pn->cx <= pw->x1) continue;
+                if(pn->cx >= pw->x2) continue;
             }
+            else continue;
 
             n1 = 2;
             n2 = 3;
@@ -671,6 +778,7 @@ int Schematic::insertWire(Wire *w)
                 n2  = pn2->Connections.count();
                 if(n1 == 1)
                 {
+                    unindexElement(pn);
                     Nodes->removeRef(pn);     // delete node 1 if open
                     pn2->Connections.removeRef(nw);   // remove connection
                     pn = pn2;
@@ -679,6 +787,7 @@ int Schematic::insertWire(Wire *w)
                 if(n2 == 1)
                 {
                     pn->Connections.removeRef(nw);   // remove connection
+                    unindexElement(pn2);
                     Nodes->removeRef(pn2);     // delete node 2 if open
                     pn2 = pn;
                 }
@@ -690,6 +799,7 @@ int Schematic::insertWire(Wire *w)
                         pw->Label = nw->Label;
                         pw->Label->pOwner = pw;
                     }
+                    unindexElement(nw);
                     Wires->removeRef(nw);    // delete wire
                     Wires->findRef(pw);      // set back to current wire
                 }
@@ -703,6 +813,7 @@ int Schematic::insertWire(Wire *w)
                 nw = new Wire(pw->x1, pw->y1, pn->cx, pn->cy, pw->Port1, pn);
                 pn->Connections.append(nw);
                 Wires->append(nw);
+                indexElement(nw);
                 Wires->findRef(pw);
                 pw->Port1->Connections.append(nw);
             }
@@ -711,9 +822,9 @@ int Schematic::insertWire(Wire *w)
             pw->y1 = pn2->cy;
             pw->Port1 = pn2;
             pn2->Connections.append(pw);
-
-            pn = Nodes->next();
+            indexElement(pw);
         }
+    }
 
     if (Wires->containsRef (w))  // if two wire lines with different labels ...
         oneLabel(w->Port1);       // ... are connected, delete one label
@@ -743,9 +854,12 @@ void Schematic::selectWireLine(Element *pe, Node *pn, bool ctrl)
 // ---------------------------------------------------
 Wire* Schematic::selectedWire(int x, int y)
 {
-    for(Wire *pw = Wires->first(); pw != 0; pw = Wires->next())
-        if(pw->getSelected(x, y))
-            return pw;
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+    foreach(Element *pe, Found)
+        if(pe->Type == isWire)
+            if(((Wire*)pe)->getSelected(x, y))
+                return (Wire*)pe;
 
     return 0;
 }
@@ -760,12 +874,14 @@ Wire* Schematic::splitWire(Wire *pw, Node *pn)
     pw->x2 = pn->cx;
     pw->y2 = pn->cy;
     pw->Port2 = pn;
+    indexElement(pw);
 
     newWire->Port2->Connections.prepend(newWire);
     pn->Connections.prepend(pw);
     pn->Connections.prepend(newWire);
     newWire->Port2->Connections.removeRef(pw);
     Wires->append(newWire);
+    indexElement(newWire);
 
     if(pw->Label)
         if((pw->Label->cx > pn->cx) || (pw->Label->cy > pn->cy))
@@ -813,9 +929,12 @@ bool Schematic::oneTwoWires(Node *n)
                 e1->x2 = e2->x2;
                 e1->y2 = e2->y2;
                 e1->Port2 = e2->Port2;
+                indexElement(e1);
+                unindexElement(n);
                 Nodes->removeRef(n);    // delete node (is auto delete)
                 e1->Port2->Connections.removeRef(e2);
                 e1->Port2->Connections.append(e1);
+                unindexElement(e2);
                 Wires->removeRef(e2);
                 return true;
             }
@@ -829,6 +948,7 @@ void Schematic::deleteWire(Wire *w)
     if(w->Port1->Connections.count() == 1)
     {
         if(w->Port1->Label) delete w->Port1->Label;
+        unindexElement(w->Port1);
         Nodes->removeRef(w->Port1);     // delete node 1 if open
     }
     else
@@ -841,6 +961,7 @@ void Schematic::deleteWire(Wire *w)
     if(w->Port2->Connections.count() == 1)
     {
         if(w->Port2->Label) delete w->Port2->Label;
+        unindexElement(w->Port2);
         Nodes->removeRef(w->Port2);     // delete node 2 if open
     }
     else
@@ -855,6 +976,7 @@ void Schematic::deleteWire(Wire *w)
         delete w->Label;
         w->Label = 0;
     }
+    unindexElement(w);
     Wires->removeRef(w);
 }
 
@@ -924,7 +1046,8 @@ Marker* Schematic::setMarker(int x, int y)
   // only diagrams ...
   for(Diagram *pd = Diagrams->last(); pd != 0; pd = Diagrams->prev()){
     if(Marker* m=pd->setMarker(x,y)){
-      setChanged(true, true);
+      touchElement(pd);
+      recordChanges();
       return m;
     }
   }
@@ -940,10 +1063,13 @@ void Schematic::markerLeftRight(bool left, Q3PtrList<Element> *Elements)
         Marker* pm = prechecked_cast<Marker*>(i);
         assert(pm);
         if(pm->moveLeftRight(left))
+        {
+            touchElement((Diagram*)pm->diag());
             acted = true;
+        }
     }
 
-    if(acted)  setChanged(true, true, 'm');
+    if(acted)  recordChanges('m');
 }
 
 // ---------------------------------------------------
@@ -955,10 +1081,13 @@ void Schematic::markerUpDown(bool up, Q3PtrList<Element> *Elements)
     for(pm = (Marker*)Elements->first(); pm!=0; pm = (Marker*)Elements->next())
     {
         if(pm->moveUpDown(up))
+        {
+            touchElement((Diagram*)pm->diag());
             acted = true;
+        }
     }
 
-    if(acted)  setChanged(true, true, 'm');
+    if(acted)  recordChanges('m');
 }
 
 
@@ -985,23 +1114,29 @@ Element* Schematic::selectElement(float fX, float fY, bool flag, int *index)
     WireLabel *pl = 0;
     float Corr = textCorr(); // for selecting text
 
-    // test all nodes and their labels
-    for(Node *pn = Nodes->last(); pn != 0; pn = Nodes->prev())
+    // nodes, wires and components lying at x/y in list order
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+
+    if(!flag)
     {
-        if(!flag)
+        // The element cannot be deselected
+        if(index)
         {
-            // The element cannot be deselected
-            if(index)
-            {
-                // 'index' is only true if called from MouseActions::MPressSelect()
-                if(pn->getSelected(x, y))
-                {
-                    // Return the node pointer, as the selection cannot change
-                    return pn;
-                }
-            }
+            // 'index' is only true if called from MouseActions::MPressSelect()
+            for(n = Found.size()-1; n >= 0; n--)
+                if(Found.at(n)->Type == isNode)
+                    if(((Node*)Found.at(n))->getSelected(x, y))
+                    {
+                        // Return the node pointer, as the selection cannot change
+                        return Found.at(n);
+                    }
         }
+    }
 
+    // test all node labels
+    for(Node *pn = Nodes->last(); pn != 0; pn = Nodes->prev())
+    {
         pl = pn->Label; // Get any wire label associated with the Node
         if(pl)
         {
@@ -1039,9 +1174,11 @@ Element* Schematic::selectElement(float fX, float fY, bool flag, int *index)
         }
     }
 
-    // test all wires and wire labels
-    for(Wire *pw = Wires->last(); pw != 0; pw = Wires->prev())
+    // test all wires
+    for(n = Found.size()-1; n >= 0; n--)
     {
+        if(Found.at(n)->Type != isWire) continue;
+        Wire *pw = (Wire*)Found.at(n);
         if(pw->getSelected(x, y))
         {
             if(flag)
@@ -1064,6 +1201,11 @@ Element* Schematic::selectElement(float fX, float fY, bool flag, int *index)
                 pe_sel = pw;
             }
         }
+    }
+
+    // test all wire labels (few, and their size is not known in advance)
+    for(Wire *pw = Wires->last(); pw != 0; pw = Wires->prev())
+    {
         pl = pw->Label; // test any label associated with the wire
         if(pl)
         {
@@ -1093,9 +1235,11 @@ Element* Schematic::selectElement(float fX, float fY, bool flag, int *index)
         }
     }
 
-    // test all components
-    for(Component *pc = Components->last(); pc != 0; pc = Components->prev())
+    // test all components (their text included)
+    for(int i = Found.size()-1; i >= 0; i--)
     {
+        if(!(Found.at(i)->Type & isComponent)) continue;
+        Component *pc = (Component*)Found.at(i);
         if(pc->getSelected(x, y))
         {
             if(flag)
@@ -1663,6 +1807,7 @@ void Schematic::newMovingWires(Q3PtrList<Element> *p, Node *pn, int pos)
         pw->Port1->State |= 16+4;
         pw->Port2->Connections.removeRef(pw);   // remove connection 2
         pw->Port2->State |= 16+4;
+        unindexElement(pw);
         Wires->take(Wires->findRef(pw));
 
         if(pw->isHorizontal()) mask = 2;
@@ -1711,6 +1856,7 @@ void Schematic::newMovingWires(Q3PtrList<Element> *p, Node *pn, int pos)
         pw2->Port1->State |= 16+4;
         pw2->Port2->Connections.removeRef(pw2);   // remove connection 2
         pw2->Port2->State |= 16+4;
+        unindexElement(pw2);
         Wires->take(Wires->findRef(pw2));
 
         if(pw2->Port1 != pn2)
@@ -1765,6 +1911,7 @@ int Schematic::copySelectedElements(Q3PtrList<Element> *p)
                 pp->Connection->State = 4;
             }
 
+            unindexElement(pc);
             Components->take();   // take component out of the document
             pc = Components->current();
         }
@@ -1784,6 +1931,7 @@ int Schematic::copySelectedElements(Q3PtrList<Element> *p)
             pw->Port1->State = 4;
             pw->Port2->Connections.removeRef(pw);   // remove connection 2
             pw->Port2->State = 4;
+            unindexElement(pw);
             Wires->take();
             pw = Wires->current();
         }
@@ -1841,6 +1989,7 @@ int Schematic::copySelectedElements(Q3PtrList<Element> *p)
                 else if(pn->State & 2) pn->Label->Type = isVMovingLabel;
                 p->append(pn->Label);    // do not forget the node labels
             }
+            unindexElement(pn);
             Nodes->remove();
             pn = Nodes->current();
             continue;
@@ -1988,6 +2137,7 @@ bool Schematic::deleteElements()
             {
                 delete pw->Label;
                 pw->Label = 0;
+                touchElement(pw);
                 sel = true;
             }
 
@@ -2007,6 +2157,7 @@ bool Schematic::deleteElements()
             {
                 delete pn->Label;
                 pn->Label = 0;
+                touchElement(pn);
                 sel = true;
             }
 
@@ -2014,6 +2165,7 @@ bool Schematic::deleteElements()
     while(pd != 0)      // test all diagrams
         if(pd->isSelected)
         {
+            dropElement(pd);
             Diagrams->remove();
             pd = Diagrams->current();
             sel = true;
@@ -2038,6 +2190,7 @@ bool Schematic::deleteElements()
                     if(pm->isSelected)
                     {
                         im.remove();
+                        touchElement(pd);
                         sel = true;
                     }
                 }
@@ -2045,6 +2198,7 @@ bool Schematic::deleteElements()
                 if(pg->isSelected)
                 {
                     ig.remove();
+                    touchElement(pd);
                     sel = wasGraphDeleted = true;
                 }
             }
@@ -2062,6 +2216,7 @@ bool Schematic::deleteElements()
             if(pp->Name.at(0) != '.')    // do not delete "PortSym", "ID_text"
             {
                 sel = true;
+                dropElement(pp);
                 Paintings->remove();
                 pp = Paintings->current();
                 continue;
@@ -2072,7 +2227,7 @@ bool Schematic::deleteElements()
     if(sel)
     {
         sizeOfAll(UsedX1, UsedY1, UsedX2, UsedY2);   // set new document size
-        setChanged(sel, true);
+        recordChanges();
     }
     return sel;
 }
@@ -2523,6 +2678,7 @@ void Schematic::insertRawComponent(Component *c, bool noOptimize)
     // connect every node of component to corresponding schematic node
     insertComponentNodes(c, noOptimize);
     Components->append(c);
+    indexElement(c);
 
     // a ground symbol erases an existing label on the wire line
     if(c->Model == "GND")
@@ -2533,6 +2689,7 @@ void Schematic::insertRawComponent(Component *c, bool noOptimize)
             {
                 delete ((Conductor*)pe)->Label;
                 ((Conductor*)pe)->Label = 0;
+                touchElement(pe);
             }
         c->Model = "GND";    // rebuild component model
     }
@@ -2575,6 +2732,7 @@ void Schematic::recreateComponent(Component *Comp)
         y += Comp->y2 - y2;
     Comp->tx = x;
     Comp->ty = y;
+    indexElement(Comp);
 
 
     if(PortCount > 0)
@@ -2621,6 +2779,7 @@ void Schematic::insertComponent(Component *c)
                 {
                     delete ((Conductor*)pe)->Label;
                     ((Conductor*)pe)->Label = 0;
+                    touchElement(pe);
                 }
             c->Model = "GND";    // rebuild component model
         }
@@ -2641,6 +2800,7 @@ void Schematic::insertComponent(Component *c)
 
     setComponentNumber(c); // important for power sources and subcircuit ports
     Components->append(c);
+    indexElement(c);
 }
 
 // ---------------------------------------------------
@@ -2658,9 +2818,12 @@ void Schematic::activateCompsWithinRect(int x1, int y1, int x2, int y2)
     y1 = cy1;
     y2 = cy2;
 
-
-    for(Component *pc = Components->first(); pc != 0; pc = Components->next())
+    QList<Element*> Found;
+    elementIndex().query(x1, y1, x2, y2, Found);
+    foreach(Element *pe, Found)
     {
+        if(!(pe->Type & isComponent)) continue;
+        Component *pc = (Component*)pe;
         pc->Bounding(cx1, cy1, cx2, cy2);
         if(cx1 >= x1) if(cx2 <= x2) if(cy1 >= y1) if(cy2 <= y2)
                     {
@@ -2690,8 +2853,12 @@ void Schematic::activateCompsWithinRect(int x1, int y1, int x2, int y2)
 bool Schematic::activateSpecifiedComponent(int x, int y)
 {
     int x1, y1, x2, y2, a;
-    for(Component *pc = Components->first(); pc != 0; pc = Components->next())
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+    foreach(Element *pe, Found)
     {
+        if(!(pe->Type & isComponent)) continue;
+        Component *pc = (Component*)pe;
         pc->Bounding(x1, y1, x2, y2);
         if(x >= x1) if(x <= x2) if(y >= y1) if(y <= y2)
                     {
@@ -2753,6 +2920,7 @@ void Schematic::setCompPorts(Component *pc)
 {
     WireLabel *pl;
     Q3PtrList<WireLabel> LabelCache;
+    indexElement(pc);   // was rotated or mirrored
 
     foreach(Port *pp, pc->Ports)
     {
@@ -2767,6 +2935,7 @@ void Schematic::setCompPorts(Component *pc)
                 pl->cx = pp->x + pc->cx;
                 pl->cy = pp->y + pc->cy;
             }
+            unindexElement(pp->Connection);
             Nodes->removeRef(pp->Connection);
             break;
         case 2:
@@ -2830,10 +2999,13 @@ Component* Schematic::searchSelSubcircuit()
 // ---------------------------------------------------
 Component* Schematic::selectedComponent(int x, int y)
 {
-    // test all components
-    for(Component *pc = Components->first(); pc != 0; pc = Components->next())
-        if(pc->getSelected(x, y))
-            return pc;
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+    // test all components lying there
+    foreach(Element *pe, Found)
+        if(pe->Type & isComponent)
+            if(((Component*)pe)->getSelected(x, y))
+                return (Component*)pe;
 
     return 0;
 }
@@ -2848,6 +3020,7 @@ void Schematic::deleteComp(Component *c)
         {
         case 1  :
             if(pn->Connection->Label) delete pn->Connection->Label;
+            unindexElement(pn->Connection);
             Nodes->removeRef(pn->Connection);  // delete open nodes
             pn->Connection = 0;		  //  (auto-delete)
             break;
@@ -2860,6 +3033,7 @@ void Schematic::deleteComp(Component *c)
             break;
         }
 
+    unindexElement(c);
     Components->removeRef(c);   // delete component
 }
 
@@ -2975,6 +3149,7 @@ void Schematic::oneLabel(Node *n1)
             {
                 delete pn->Label;
                 pn->Label = 0;    // erase double names
+                touchElement(pn);
             }
             else
             {
@@ -2993,6 +3168,7 @@ void Schematic::oneLabel(Node *n1)
                         named = true;
                         if(pl)
                         {
+                            touchElement(pl->pOwner);
                             pl->pOwner->Label = 0;
                             delete pl;
                         }
@@ -3016,6 +3192,7 @@ void Schematic::oneLabel(Node *n1)
                 {
                     delete pw->Label;
                     pw->Label = 0;    // erase double names
+                    touchElement(pw);
                 }
                 else
                 {
@@ -3030,13 +3207,20 @@ void Schematic::oneLabel(Node *n1)
 // ---------------------------------------------------
 int Schematic::placeNodeLabel(WireLabel *pl)
 {
-    Node *pn;
+    Node *pn = 0;
     int x = pl->cx;
     int y = pl->cy;
 
     // check if new node lies upon an existing node
-    for(pn = Nodes->first(); pn != 0; pn = Nodes->next())
-        if(pn->cx == x) if(pn->cy == y) break;
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+    foreach(Element *pf, Found)
+        if(pf->Type == isNode)
+            if(pf->cx == x) if(pf->cy == y)
+                {
+                    pn = (Node*)pf;
+                    break;
+                }
 
     if(!pn)  return -1;
 
@@ -3051,11 +3235,13 @@ int Schematic::placeNodeLabel(WireLabel *pl)
 
         delete ((Conductor*)pe)->Label;
         ((Conductor*)pe)->Label = 0;
+        touchElement(pe);
     }
 
     pn->Label = pl;   // insert node label
     pl->Type = isNodeLabel;
     pl->pOwner = pn;
+    touchElement(pn);
     return 0;
 }
 
@@ -3113,7 +3299,10 @@ void Schematic::insertNodeLabel(WireLabel *pl)
     if(pw)    // lies label on existing wire ?
     {
         if(getWireLabel(pw->Port1) == 0)  // wire not yet labeled ?
+        {
             pw->setName(pl->Name, pl->initValue, 0, pl->cx, pl->cy);
+            touchElement(pw);
+        }
 
         delete pl;
         return;
@@ -3122,6 +3311,7 @@ void Schematic::insertNodeLabel(WireLabel *pl)
 
     Node *pn = new Node(pl->cx, pl->cy);
     Nodes->append(pn);
+    indexElement(pn);
 
     pn->Label = pl;
     pl->Type  = isNodeLabel;
@@ -3157,6 +3347,7 @@ void Schematic::copyLabels(int& x1, int& y1, int& x2, int& y2,
                 if(pl->x1+pl->x2 > x2) x2 = pl->x1+pl->x2;
                 if(pl->y1 > y2) y2 = pl->y1;
                 ElementCache->append(pl);
+                touchElement(pn);
                 pl->pOwner->Label = 0;   // erase connection
                 pl->pOwner = 0;
             }
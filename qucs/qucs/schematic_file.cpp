@@ -591,6 +591,25 @@ bool Schematic::loadProperties(QTextStream *stream)
 }
 
 // ---------------------------------------------------
+// Returns the node of the document lying at x/y, if any.
+Node* Schematic::findDocNode(int x, int y)
+{
+  Node *pn;
+  if(Nodes == &DocNodes) {  // the index covers the document lists
+    QList<Element*> Found;
+    elementIndex().query(x, y, x, y, Found);
+    foreach(Element *pe, Found)
+      if(pe->Type == isNode)
+        if(pe->cx == x) if(pe->cy == y)  return (Node*)pe;
+    return 0;
+  }
+
+  for(pn = DocNodes.first(); pn != 0; pn = DocNodes.next())
+    if(pn->cx == x) if(pn->cy == y)  break;
+  return pn;
+}
+
+// -------------------------------------------------------------
 // Inserts a component without performing logic for wire optimization.
 void Schematic::simpleInsertComponent(Component *c)
 {
@@ -602,20 +621,20 @@ void Schematic::simpleInsertComponent(Component *c)
     y = pp->y+c->cy;
 
     // check if new node lies upon existing node
-    for(pn = DocNodes.first(); pn != 0; pn = DocNodes.next())
-      if(pn->cx == x) if(pn->cy == y) {
-	if (!pn->DType.isEmpty()) {
-	  pp->Type = pn->DType;
-	}
-	if (!pp->Type.isEmpty()) {
-	  pn->DType = pp->Type;
-	}
-	break;
+    pn = findDocNode(x, y);
+    if(pn) {
+      if (!pn->DType.isEmpty()) {
+        pp->Type = pn->DType;
       }
+      if (!pp->Type.isEmpty()) {
+        pn->DType = pp->Type;
+      }
+    }
 
     if(pn == 0) { // create new node, if no existing one lies at this position
       pn = new Node(x, y);
       DocNodes.append(pn);
+      if(Nodes == &DocNodes)  indexElement(pn);
     }
     pn->Connections.append(c);  // connect schematic node to component node
     if (!pp->Type.isEmpty()) {
@@ -626,6 +645,7 @@ void Schematic::simpleInsertComponent(Component *c)
   }
 
   DocComps.append(c);
+  if(Components == &DocComps)  indexElement(c);
 }
 
 // -------------------------------------------------------------
@@ -664,12 +684,12 @@ void Schematic::simpleInsertWire(Wire *pw)
 {
   Node *pn;
   // check if first wire node lies upon existing node
-  for(pn = DocNodes.first(); pn != 0; pn = DocNodes.next())
-    if(pn->cx == pw->x1) if(pn->cy == pw->y1) break;
+  pn = findDocNode(pw->x1, pw->y1);
 
   if(!pn) {   // create new node, if no existing one lies at this position
     pn = new Node(pw->x1, pw->y1);
     DocNodes.append(pn);
+    if(Nodes == &DocNodes)  indexElement(pn);
   }
 
   if(pw->x1 == pw->x2) if(pw->y1 == pw->y2) {
@@ -685,17 +705,18 @@ void Schematic::simpleInsertWire(Wire *pw)
   pw->Port1 = pn;
 
   // check if second wire node lies upon existing node
-  for(pn = DocNodes.first(); pn != 0; pn = DocNodes.next())
-    if(pn->cx == pw->x2) if(pn->cy == pw->y2) break;
+  pn = findDocNode(pw->x2, pw->y2);
 
   if(!pn) {   // create new node, if no existing one lies at this position
     pn = new Node(pw->x2, pw->y2);
     DocNodes.append(pn);
+    if(Nodes == &DocNodes)  indexElement(pn);
   }
   pn->Connections.append(pw);  // connect schematic node to component node
   pw->Port2 = pn;
 
   DocWires.append(pw);
+  if(Wires == &DocWires)  indexElement(pw);
 }
 
 // -------------------------------------------------------------
@@ -916,103 +937,400 @@ bool Schematic::loadDocument()
 }
 
 // -------------------------------------------------------------
-// Creates a Qucs file format (without document properties) in the returning
-// string. This is used to save state for undo operation.
-QString Schematic::createUndoString(char Op)
+// Notes that element "pe" of the document was inserted or changed. It
+// becomes part of the next undo step made by "recordChanges()". Nodes
+// stand for their labels. Is called by "indexElement()", so nodes, wires
+// and components report themselves.
+void Schematic::touchElement(Element *pe)
 {
-  Wire *pw;
-  Diagram *pd;
-  Painting *pp;
-  Component *pc;
-
-  // Build element document.
-  QString s = "  \n";
-  s.replace(0,1,Op);
-  for(pc = DocComps.first(); pc != 0; pc = DocComps.next())
-    s += pc->save()+"\n";
-  s += "</>\n";  // short end flag
-
-  for(pw = DocWires.first(); pw != 0; pw = DocWires.next())
-    s += pw->save()+"\n";
-  // save all labeled nodes as wires
-  for(Node *pn = DocNodes.first(); pn != 0; pn = DocNodes.next())
-    if(pn->Label) s += pn->Label->save()+"\n";
-  s += "</>\n";
+  if(Wires != &DocWires)  return;  // symbol mode, see setChanged()
+  Touched.insert(pe, true);
+}
 
-  for(pd = DocDiags.first(); pd != 0; pd = DocDiags.next())
-    s += pd->save()+"\n";
-  s += "</>\n";
+// -------------------------------------------------------------
+// Notes that element "pe" of the document is about to be deleted or
+// taken out of the lists. Is called by "unindexElement()".
+void Schematic::dropElement(Element *pe)
+{
+  if(Wires != &DocWires)  return;
+  Touched.insert(pe, false);
+}
 
-  for(pp = DocPaints.first(); pp != 0; pp = DocPaints.next())
-    s += "<"+pp->save()+">\n";
-  s += "</>\n";
+// -------------------------------------------------------------
+// Notes the current text of element "pe" in the undo stack "Stack" and
+// its position "Pos" in its list. Node labels have no position.
+void Schematic::recordElement(UndoStack& Stack, Element *pe, int Pos)
+{
+  int Type = pe->Type & isSpecialMask;  // e.g. while being resized
+  if(Type == isNode) {
+    WireLabel *pl = ((Node*)pe)->Label;
+    Stack.record(pe, UNDO_NODELABELS, pl ? pl->save() : QString(), -1);
+  }
+  else if(Type == isWire)
+    Stack.record(pe, UNDO_WIRES, ((Wire*)pe)->save(), Pos);
+  else if(Type & isComponent)
+    Stack.record(pe, UNDO_COMPONENTS, ((Component*)pe)->save(), Pos);
+  else if(Type == isDiagram)
+    Stack.record(pe, UNDO_DIAGRAMS, ((Diagram*)pe)->save(), Pos);
+  else if(Type == isPainting)
+    Stack.record(pe, UNDO_PAINTINGS, "<"+((Painting*)pe)->save()+">", Pos);
+}
 
-  return s;
+// -------------------------------------------------------------
+// Notes the elements touched or dropped since the last undo step. The
+// labels of the nodes at the ports of the touched wires and components
+// may have moved, so these nodes are looked at, too. A node not yet
+// touched is still alive, as deleting it drops it.
+void Schematic::recordTouched()
+{
+  if(Touched.isEmpty())  return;
+
+  QList<Element*> Ports;
+  QHash<Element*, bool>::const_iterator it;
+  for(it = Touched.constBegin(); it != Touched.constEnd(); ++it) {
+    if(!it.value())  continue;
+    Element *pe = it.key();
+    if(pe->Type == isWire) {
+      Ports.append(((Wire*)pe)->Port1);
+      Ports.append(((Wire*)pe)->Port2);
+    }
+    else if(pe->Type & isComponent)
+      foreach(Port *pp, ((Component*)pe)->Ports)
+        Ports.append(pp->Connection);
+  }
+  foreach(Element *pn, Ports)
+    if(pn) if(!Touched.contains(pn))  Touched.insert(pn, true);
+
+  QHash<Element*, int> Pos;
+  undoPositions(Pos);
+  for(it = Touched.constBegin(); it != Touched.constEnd(); ++it)
+    if(it.value())  recordElement(undoAction, it.key(), Pos.value(it.key(), -1));
+    else  undoAction.forget(it.key());
+  Touched.clear();
+  undoAction.setPositions(Pos);
 }
 
 // -------------------------------------------------------------
-// Same as "createUndoString(char Op)" but for symbol edit mode.
-QString Schematic::createSymbolUndoString(char Op)
+// Compares every element of the document with the text recorded last.
+// This is the fallback for edits that do not report what they touched,
+// it needs time in proportion to the size of the document.
+void Schematic::recordUndoState()
 {
-  Painting *pp;
+  Touched.clear();
+  QSet<Element*> Present;
+  int i;
 
-  // Build element document.
-  QString s = "  \n";
-  s.replace(0,1,Op);
-  s += "</>\n";  // short end flag for components
-  s += "</>\n";  // short end flag for wires
-  s += "</>\n";  // short end flag for diagrams
+  i = 0;
+  for(Component *pc = DocComps.first(); pc != 0; pc = DocComps.next()) {
+    Present.insert(pc);
+    recordElement(undoAction, pc, i++);
+  }
+  i = 0;
+  for(Wire *pw = DocWires.first(); pw != 0; pw = DocWires.next()) {
+    Present.insert(pw);
+    recordElement(undoAction, pw, i++);
+  }
+  // labeled nodes are saved as wires of length zero
+  for(Node *pn = DocNodes.first(); pn != 0; pn = DocNodes.next()) {
+    Present.insert(pn);
+    recordElement(undoAction, pn, -1);
+  }
+  i = 0;
+  for(Diagram *pd = DocDiags.first(); pd != 0; pd = DocDiags.next()) {
+    Present.insert(pd);
+    recordElement(undoAction, pd, i++);
+  }
+  i = 0;
+  for(Painting *pp = DocPaints.first(); pp != 0; pp = DocPaints.next()) {
+    Present.insert(pp);
+    recordElement(undoAction, pp, i++);
+  }
 
-  for(pp = SymbolPaints.first(); pp != 0; pp = SymbolPaints.next())
-    s += "<"+pp->save()+">\n";
-  s += "</>\n";
+  foreach(Element *pe, undoAction.elements())
+    if(!Present.contains(pe))  undoAction.forget(pe);
+}
 
-  return s;
+// -------------------------------------------------------------
+// Same as "recordUndoState()" but for symbol edit mode.
+void Schematic::recordSymbolUndoState()
+{
+  QSet<Element*> Present;
+  int i = 0;
+  for(Painting *pp = SymbolPaints.first(); pp != 0; pp = SymbolPaints.next()) {
+    Present.insert(pp);
+    recordElement(undoSymbol, pp, i++);
+  }
+
+  foreach(Element *pe, undoSymbol.elements())
+    if(!Present.contains(pe))  undoSymbol.forget(pe);
 }
 
 // -------------------------------------------------------------
-// Is quite similiar to "loadDocument()" but with less error checking.
-// Used for "undo" function.
-bool Schematic::rebuild(QString *s)
+// Puts the list position of every element of the current edit mode into
+// "Pos", nodes excepted.
+void Schematic::undoPositions(QHash<Element*, int>& Pos)
 {
-  DocWires.clear();	// delete whole document
-  DocNodes.clear();
-  DocComps.clear();
-  DocDiags.clear();
-  DocPaints.clear();
+  int i;
+  if(symbolMode) {
+    i = 0;
+    for(Q3PtrListIterator<Painting> it(SymbolPaints); it.current(); ++it)
+      Pos.insert(it.current(), i++);
+    return;
+  }
+  i = 0;
+  for(Q3PtrListIterator<Component> it(DocComps); it.current(); ++it)
+    Pos.insert(it.current(), i++);
+  i = 0;
+  for(Q3PtrListIterator<Wire> it(DocWires); it.current(); ++it)
+    Pos.insert(it.current(), i++);
+  i = 0;
+  for(Q3PtrListIterator<Diagram> it(DocDiags); it.current(); ++it)
+    Pos.insert(it.current(), i++);
+  i = 0;
+  for(Q3PtrListIterator<Painting> it(DocPaints); it.current(); ++it)
+    Pos.insert(it.current(), i++);
+}
 
-  QString Line;
-  QTextStream stream(s, QIODevice::ReadOnly);
-  Line = stream.readLine();  // skip identity byte
+// -------------------------------------------------------------
+// Gives the elements of "Changes" their old texts (or their new ones if
+// "forward" is true), the changes were taken from "Stack". Only these
+// elements are deleted and created anew, the others are left untouched.
+// If an element cannot be created, the whole document is rebuilt in the
+// state before and the step is left to be undone or redone.
+void Schematic::restoreUndoState(UndoStack& Stack, const UndoChanges& Changes,
+                                 bool forward)
+{
+  if(Changes.isEmpty())  return;
+
+  UndoChanges Snapshot = Stack.state();
+  bool newDiagrams = false;
+  bool ok = insertUndoChanges(Stack, Changes, forward, newDiagrams);
+  if(!ok) {  // e.g. a subcircuit or library was changed meanwhile
+    qDebug() << "undo step cannot be restored, going back";
+    ok = rebuildUndoState(Stack, Snapshot, newDiagrams);
+    if(forward)  Stack.undo();
+    else  Stack.redo();
+  }
+  Touched.clear();  // the stack knows them already
 
-  // read content *************************
-  if(!loadComponents(&stream))  return false;
-  if(!loadWires(&stream))  return false;
-  if(!loadDiagrams(&stream, &DocDiags))  return false;
-  if(!loadPaintings(&stream, &DocPaints)) return false;
+  if(!ok) {  // not even the state before fits the document
+    Stack.clear();
+    if(symbolMode)  recordSymbolUndoState();
+    else  recordUndoState();
+    Stack.setBottom();
+  }
+  else {
+    QHash<Element*, int> Pos;
+    undoPositions(Pos);
+    Stack.setPositions(Pos);
+  }
+  if(newDiagrams)
+    reloadGraphs();  // load recent simulation data
+}
 
-  return true;
+// -------------------------------------------------------------
+// Deletes the elements of "Changes" and creates them anew with their old
+// texts at their old positions (or the new ones if "forward" is true).
+// Returns false if an element could not be created.
+bool Schematic::insertUndoChanges(UndoStack& Stack, const UndoChanges& Changes,
+                                  bool forward, bool& newDiagrams)
+{
+  bool ok = true;
+  // delete first, so nodes and labels do not get in the way of new ones ...
+  foreach(const UndoChange& c, Changes) {
+    Element *pe = Stack.element(c.Id);
+    if(!pe)  continue;
+    removeUndoElement(c.Section, pe);
+    Stack.unbind(c.Id);
+  }
+  // ... then create them section by section, so that node labels find
+  // the nodes of their wires and components, and in the order of their
+  // positions, so that the ones before are in place already
+  for(int i=0; i<UNDO_SECTIONS; i++) {
+    QMap<int, int> Order;  // index in "Changes" by position
+    for(int k=0; k<Changes.size(); k++) {
+      const UndoChange& c = Changes.at(k);
+      if(c.Section == i)  Order.insertMulti(forward ? c.NewPos : c.OldPos, k);
+    }
+    QMap<int, int>::const_iterator it;
+    for(it = Order.constBegin(); it != Order.constEnd(); ++it) {
+      const UndoChange& c = Changes.at(it.value());
+      const QString& Text = forward ? c.New : c.Old;
+      if(Text.isEmpty())  continue;
+      Element *pe = insertUndoElement(i, Text, it.key(), newDiagrams);
+      if(pe)  Stack.bind(c.Id, pe, i, Text, it.key());
+      else  ok = false;
+    }
+  }
+  return ok;
 }
 
 // -------------------------------------------------------------
-// Same as "rebuild(QString *s)" but for symbol edit mode.
-bool Schematic::rebuildSymbol(QString *s)
+// Deletes the whole document (of the current edit mode) and creates it
+// anew from "State", see "UndoStack::state()". Returns false if an
+// element could not be created.
+bool Schematic::rebuildUndoState(UndoStack& Stack, const UndoChanges& State,
+                                 bool& newDiagrams)
 {
-  SymbolPaints.clear();	// delete whole document
+  Stack.unbindAll();
+  if(symbolMode)
+    SymbolPaints.clear();
+  else {
+    invalidateIndex();
+    DocWires.clear();	// delete whole document
+    DocNodes.clear();
+    DocComps.clear();
+    DocDiags.clear();
+    DocPaints.clear();
+  }
+  return insertUndoChanges(Stack, State, true, newDiagrams);
+}
 
-  QString Line;
-  QTextStream stream(s, QIODevice::ReadOnly);
-  Line = stream.readLine();  // skip identity byte
+// -------------------------------------------------------------
+// Disconnects element "pe" from node "pn". The node is deleted if it is
+// neither connected nor labeled anymore.
+void Schematic::releaseNode(Node *pn, Element *pe)
+{
+  if(!pn)  return;
+  pn->Connections.removeRef(pe);
+  if(pn->Connections.isEmpty()) if(!pn->Label) {
+    unindexElement(pn);
+    DocNodes.removeRef(pn);
+  }
+}
 
-  // read content *************************
-  Line = stream.readLine();  // skip components
-  Line = stream.readLine();  // skip wires
-  Line = stream.readLine();  // skip diagrams
-  if(!loadPaintings(&stream, &SymbolPaints)) return false;
+// -------------------------------------------------------------
+// Deletes element "pe" of section "Section", if it is still there.
+void Schematic::removeUndoElement(int Section, Element *pe)
+{
+  Component *pc;
+  Wire *pw;
+  Node *pn;
+  Q3PtrList<Painting> *Paints;
+
+  switch(Section) {
+    case UNDO_COMPONENTS:
+      pc = (Component*)pe;
+      if(DocComps.findRef(pc) < 0)  return;
+      foreach(Port *pp, pc->Ports)
+        releaseNode(pp->Connection, pc);
+      unindexElement(pc);
+      DocComps.remove();
+      return;
 
-  return true;
+    case UNDO_WIRES:
+      pw = (Wire*)pe;
+      if(DocWires.findRef(pw) < 0)  return;
+      releaseNode(pw->Port1, pw);
+      releaseNode(pw->Port2, pw);
+      if(pw->Label) {
+        delete pw->Label;
+        pw->Label = 0;
+      }
+      unindexElement(pw);
+      DocWires.remove();
+      return;
+
+    case UNDO_NODELABELS:
+      pn = (Node*)pe;
+      if(DocNodes.findRef(pn) < 0)  return;
+      delete pn->Label;
+      pn->Label = 0;
+      if(pn->Connections.isEmpty()) {
+        unindexElement(pn);
+        DocNodes.remove();
+      }
+      return;
+
+    case UNDO_DIAGRAMS:
+      if(DocDiags.findRef((Diagram*)pe) >= 0)  DocDiags.remove();
+      return;
+
+    case UNDO_PAINTINGS:
+      Paints = symbolMode ? &SymbolPaints : &DocPaints;
+      if(Paints->findRef((Painting*)pe) >= 0)  Paints->remove();
+      return;
+  }
+}
+
+// -------------------------------------------------------------
+// Moves the last element of "List" to position "Pos", if that is before.
+template <class T>
+static void moveLast(Q3PtrList<T>& List, int Pos)
+{
+  int n = List.count();
+  if(Pos < 0 || Pos >= n-1)  return;
+  T *p = List.take(n-1);
+  List.insert(Pos, p);
 }
 
+// -------------------------------------------------------------
+// Creates the element saved as "Line" in section "Section" at position
+// "Pos" of its list and returns it, for a node label the node. Sets
+// "newDiagrams" if a diagram was created.
+Element* Schematic::insertUndoElement(int Section, const QString& Line,
+                                      int Pos, bool& newDiagrams)
+{
+  QString s = Line;
+  Component *pc;
+  Wire *pw;
+  int x, y;
+
+  switch(Section) {
+    case UNDO_COMPONENTS:
+      pc = getComponentFromName(s, this);
+      if(!pc)  return 0;
+      simpleInsertComponent(pc);
+      moveLast(DocComps, Pos);
+      return pc;
+
+    case UNDO_WIRES:
+    case UNDO_NODELABELS:
+      // (Node*)4 =  move all ports (later on)
+      pw = new Wire(0,0,0,0, (Node*)4,(Node*)4);
+      if(!pw->load(s)) {
+        delete pw;
+        return 0;
+      }
+      x = pw->x1;
+      y = pw->y1;
+      simpleInsertWire(pw);   // wire of length zero -> node label
+      if(Section == UNDO_WIRES) {
+        moveLast(DocWires, Pos);
+        return pw;
+      }
+      return findDocNode(x, y);
+
+    case UNDO_DIAGRAMS: {
+      s += "\n</>\n";
+      QTextStream stream(&s, QIODevice::ReadOnly);
+      Q3PtrList<Diagram> List;
+      List.setAutoDelete(true);
+      if(!loadDiagrams(&stream, &List))  return 0;
+      if(List.count() != 1)  return 0;
+      Diagram *pd = List.take(0);
+      DocDiags.append(pd);
+      moveLast(DocDiags, Pos);
+      newDiagrams = true;
+      return pd;
+    }
+
+    case UNDO_PAINTINGS: {
+      s += "\n</>\n";
+      QTextStream stream(&s, QIODevice::ReadOnly);
+      Q3PtrList<Painting> List;
+      List.setAutoDelete(true);
+      if(!loadPaintings(&stream, &List))  return 0;
+      if(List.count() != 1)  return 0;
+      Painting *pp = List.take(0);
+      Q3PtrList<Painting> *Paints = symbolMode ? &SymbolPaints : &DocPaints;
+      Paints->append(pp);
+      moveLast(*Paints, Pos);
+      return pp;
+    }
+  }
+  return 0;
+}
 
 // ***************************************************************
 // *****                                                     *****
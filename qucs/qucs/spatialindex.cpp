@@ -0,0 +1,176 @@
+/*
+ * spatialindex.cpp - grid index of schematic elements
+ *
+ * This file is part of Qucs
+ *
+ * Qucs is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qucs.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "spatialindex.h"
+
+#include <QPair>
+#include <QtAlgorithms>
+
+#define CELL_SHIFT  6    // cells are 64 x 64 schematic units
+#define CELL_LARGE  256  // elements covering more cells are kept aside
+
+static inline qint64 cellKey(int cx, int cy)
+{
+  return (qint64(cx) << 32) | qint64(quint32(cy));
+}
+
+// ---------------------------------------------------------------------
+SpatialIndex::SpatialIndex()
+{
+  Counter = 0;
+}
+
+// ---------------------------------------------------------------------
+void SpatialIndex::clear()
+{
+  Entries.clear();
+  Cells.clear();
+  Large.clear();
+  Counter = 0;
+}
+
+// ---------------------------------------------------------------------
+bool SpatialIndex::isLarge(const Entry& e)
+{
+  qint64 w = qint64(e.x2 >> CELL_SHIFT) - qint64(e.x1 >> CELL_SHIFT) + 1;
+  qint64 h = qint64(e.y2 >> CELL_SHIFT) - qint64(e.y1 >> CELL_SHIFT) + 1;
+  return w*h > CELL_LARGE;
+}
+
+// ---------------------------------------------------------------------
+void SpatialIndex::addCells(Element *pe, const Entry& e)
+{
+  if(isLarge(e)) {
+    Large.append(pe);
+    return;
+  }
+  for(int cx = e.x1 >> CELL_SHIFT; cx <= (e.x2 >> CELL_SHIFT); cx++)
+    for(int cy = e.y1 >> CELL_SHIFT; cy <= (e.y2 >> CELL_SHIFT); cy++)
+      Cells[cellKey(cx, cy)].append(pe);
+}
+
+// ---------------------------------------------------------------------
+void SpatialIndex::removeCells(Element *pe, const Entry& e)
+{
+  if(isLarge(e)) {
+    Large.remove(Large.indexOf(pe));
+    return;
+  }
+  for(int cx = e.x1 >> CELL_SHIFT; cx <= (e.x2 >> CELL_SHIFT); cx++)
+    for(int cy = e.y1 >> CELL_SHIFT; cy <= (e.y2 >> CELL_SHIFT); cy++) {
+      QHash<qint64, QVector<Element*> >::iterator it =
+        Cells.find(cellKey(cx, cy));
+      if(it == Cells.end())  continue;
+      QVector<Element*>& v = it.value();
+      int i = v.indexOf(pe);
+      if(i < 0)  continue;
+      v[i] = v.last();   // order within a cell does not matter
+      v.pop_back();
+      if(v.isEmpty())  Cells.erase(it);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Inserts element "pe" with bounding rectangle x1/y1 - x2/y2. If it is
+// already in the index, only its rectangle is updated and it keeps its
+// place in the order.
+void SpatialIndex::insert(Element *pe, int x1, int y1, int x2, int y2)
+{
+  Entry e;
+  if(x1 > x2)  qSwap(x1, x2);
+  if(y1 > y2)  qSwap(y1, y2);
+  e.x1 = x1;  e.y1 = y1;
+  e.x2 = x2;  e.y2 = y2;
+
+  QHash<Element*, Entry>::iterator it = Entries.find(pe);
+  if(it != Entries.end()) {
+    Entry& old = it.value();
+    if(old.x1 == x1 && old.y1 == y1 && old.x2 == x2 && old.y2 == y2)
+      return;
+    removeCells(pe, old);
+    e.No = old.No;
+    old = e;
+  }
+  else {
+    e.No = Counter++;
+    Entries.insert(pe, e);
+  }
+  addCells(pe, e);
+}
+
+// ---------------------------------------------------------------------
+void SpatialIndex::remove(Element *pe)
+{
+  QHash<Element*, Entry>::iterator it = Entries.find(pe);
+  if(it == Entries.end())  return;
+  removeCells(pe, it.value());
+  Entries.erase(it);
+}
+
+// ---------------------------------------------------------------------
+// Appends all elements whose rectangle meets x1/y1 - x2/y2 (borders
+// included) to "List", ordered as they were inserted.
+void SpatialIndex::query(int x1, int y1, int x2, int y2,
+                         QList<Element*>& List) const
+{
+  if(x1 > x2)  qSwap(x1, x2);
+  if(y1 > y2)  qSwap(y1, y2);
+
+  QVector<QPair<unsigned, Element*> > Found;
+  qint64 cx1 = x1 >> CELL_SHIFT, cx2 = x2 >> CELL_SHIFT;
+  qint64 cy1 = y1 >> CELL_SHIFT, cy2 = y2 >> CELL_SHIFT;
+
+  if((cx2-cx1+1) * (cy2-cy1+1) > qint64(Entries.size())) {
+    // area larger than the whole content, so visit every element once
+    QHash<Element*, Entry>::const_iterator it;
+    for(it = Entries.constBegin(); it != Entries.constEnd(); ++it) {
+      const Entry& e = it.value();
+      if(e.x1 <= x2) if(e.x2 >= x1) if(e.y1 <= y2) if(e.y2 >= y1)
+        Found.append(qMakePair(e.No, it.key()));
+    }
+  }
+  else {
+    for(int cx = int(cx1); cx <= int(cx2); cx++)
+      for(int cy = int(cy1); cy <= int(cy2); cy++) {
+        QHash<qint64, QVector<Element*> >::const_iterator it =
+          Cells.constFind(cellKey(cx, cy));
+        if(it == Cells.constEnd())  continue;
+        foreach(Element *pe, it.value()) {
+          const Entry& e = Entries[pe];
+          if(e.x1 > x2 || e.x2 < x1 || e.y1 > y2 || e.y2 < y1)  continue;
+          // an element covering several cells is reported by the cell
+          // holding the upper left corner of the overlap only
+          if((qMax(e.x1, x1) >> CELL_SHIFT) != cx)  continue;
+          if((qMax(e.y1, y1) >> CELL_SHIFT) != cy)  continue;
+          Found.append(qMakePair(e.No, pe));
+        }
+      }
+
+    foreach(Element *pe, Large) {
+      const Entry& e = Entries[pe];
+      if(e.x1 <= x2) if(e.x2 >= x1) if(e.y1 <= y2) if(e.y2 >= y1)
+        Found.append(qMakePair(e.No, pe));
+    }
+  }
+
+  qSort(Found);
+  for(int i=0; i<Found.size(); i++)
+    List.append(Found.at(i).second);
+}
@@ -0,0 +1,66 @@
+/*
+ * spatialindex.h - grid index of schematic elements
+ *
+ * This file is part of Qucs
+ *
+ * Qucs is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qucs.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+class Element;
+
+/*!
+ * Finds the elements whose bounding rectangle meets a point or an area
+ * without testing all of them. The schematic plane is divided into
+ * square cells, every element is registered in the cells its rectangle
+ * covers. Elements spanning very many cells are kept aside and always
+ * tested. Queries return the elements in the order they were inserted,
+ * that is the order of the element lists, so callers may keep their
+ * "topmost first" logic.
+ */
+class SpatialIndex {
+public:
+  SpatialIndex();
+
+  void clear();
+  void insert(Element*, int, int, int, int);
+  void remove(Element*);
+  bool contains(Element *e) const { return Entries.contains(e); }
+  int  count() const { return Entries.size(); }
+  void query(int, int, int, int, QList<Element*>&) const;
+
+private:
+  struct Entry {
+    int x1, y1, x2, y2;
+    unsigned No;       // insertion number, gives the list order
+  };
+
+  void addCells(Element*, const Entry&);
+  void removeCells(Element*, const Entry&);
+  static bool isLarge(const Entry&);
+
+  QHash<Element*, Entry> Entries;
+  QHash<qint64, QVector<Element*> > Cells;
+  QVector<Element*> Large;  // elements covering too many cells
+  unsigned Counter;
+};
+
+#endif
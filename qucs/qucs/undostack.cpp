@@ -0,0 +1,293 @@
+/*
+ * undostack.cpp - undo stack storing the changed elements of a document
+ *
+ * This file is part of Qucs
+ *
+ * Qucs is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qucs.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QMap>
+#include <QPair>
+
+#include "undostack.h"
+
+// ---------------------------------------------------------------------
+UndoStack::UndoStack()
+{
+  clear();
+}
+
+// ---------------------------------------------------------------------
+// Forgets all elements and steps.
+void UndoStack::clear()
+{
+  Texts.clear();
+  Elements.clear();
+  NextId = 0;
+  setBottom();
+}
+
+// ---------------------------------------------------------------------
+// Makes the recorded elements the only state, e.g. after loading a
+// document. It counts as being saved.
+void UndoStack::setBottom()
+{
+  Step Bottom;
+  Bottom.Op = ' ';
+  Bottom.Bytes = 0;
+
+  Pending.clear();
+  Steps.clear();
+  Steps.append(Bottom);
+  Index = 0;
+  Saved = 0;
+  Bytes = 0;
+}
+
+// ---------------------------------------------------------------------
+// Notes that element "pe" of section "Section" now has the text "Text"
+// and is at position "Pos" of its list. An empty text means the element
+// does not exist (anymore).
+void UndoStack::record(Element *pe, int Section, const QString& Text,
+                       int Pos)
+{
+  QHash<Element*, Entry>::iterator it = Texts.find(pe);
+  if(it != Texts.end()) if(it->Section != Section) {
+    forget(pe);   // memory was reused by an element of another kind
+    it = Texts.end();
+  }
+
+  UndoChange c;
+  c.Section = Section;
+  c.New = Text;
+  c.OldPos = -1;
+  c.NewPos = Text.isEmpty() ? -1 : Pos;
+  if(it == Texts.end()) {
+    if(Text.isEmpty())  return;
+    Entry e;
+    e.Id = NextId++;
+    e.Section = Section;
+    e.Text = Text;
+    e.Pos = Pos;
+    Texts.insert(pe, e);
+    Elements.insert(e.Id, pe);
+    c.Id = e.Id;
+    Pending.append(c);
+    return;
+  }
+
+  if(it->Text == Text) {  // elements before it may have been deleted
+    it->Pos = Pos;
+    return;
+  }
+  c.Id = it->Id;
+  c.Old = it->Text;
+  c.OldPos = it->Pos;
+  Pending.append(c);
+  if(Text.isEmpty()) {
+    Elements.remove(it->Id);
+    Texts.erase(it);
+  }
+  else {
+    it->Text = Text;
+    it->Pos = Pos;
+  }
+}
+
+// ---------------------------------------------------------------------
+// Notes that element "pe" was deleted.
+void UndoStack::forget(Element *pe)
+{
+  QHash<Element*, Entry>::const_iterator it = Texts.constFind(pe);
+  if(it != Texts.constEnd())
+    record(pe, it->Section, QString(), -1);
+}
+
+// ---------------------------------------------------------------------
+// Takes over the list positions of the elements, which change without
+// the elements being touched if the ones before them are deleted.
+void UndoStack::setPositions(const QHash<Element*, int>& Pos)
+{
+  QHash<Element*, Entry>::iterator it;
+  for(it = Texts.begin(); it != Texts.end(); ++it)
+    it->Pos = Pos.value(it.key(), -1);
+}
+
+// ---------------------------------------------------------------------
+// Returns the recorded state as changes creating every element, ordered
+// by section and list position.
+UndoChanges UndoStack::state() const
+{
+  QMap<QPair<int, int>, UndoChange> Sorted;
+  QHash<Element*, Entry>::const_iterator it;
+  for(it = Texts.constBegin(); it != Texts.constEnd(); ++it) {
+    UndoChange c;
+    c.Section = it->Section;
+    c.Id = it->Id;
+    c.New = it->Text;
+    c.OldPos = -1;
+    c.NewPos = it->Pos;
+    Sorted.insertMulti(qMakePair(c.Section, c.NewPos), c);
+  }
+  return Sorted.values();
+}
+
+// ---------------------------------------------------------------------
+static int changesBytes(const UndoChanges& Changes)
+{
+  int n = 0;
+  foreach(const UndoChange& c, Changes)
+    n += c.Old.size() + c.New.size();
+  return n * int(sizeof(QChar));
+}
+
+// ---------------------------------------------------------------------
+// Joins the changes of the same element and removes the ones that end
+// where they started.
+void UndoStack::compact(UndoChanges& Changes)
+{
+  QHash<int, int> Pos;  // index in "Joined" of every id
+  UndoChanges Joined;
+  foreach(const UndoChange& c, Changes) {
+    QHash<int, int>::const_iterator it = Pos.constFind(c.Id);
+    if(it == Pos.constEnd()) {
+      Pos.insert(c.Id, Joined.size());
+      Joined.append(c);
+    }
+    else {
+      Joined[*it].New = c.New;
+      Joined[*it].NewPos = c.NewPos;
+    }
+  }
+
+  Changes.clear();
+  foreach(const UndoChange& c, Joined)
+    if(c.Old != c.New)  Changes.append(c);
+}
+
+// ---------------------------------------------------------------------
+// Makes a step of the changes recorded since the last one and puts it
+// after the current state, the states that could be redone get lost.
+// Consecutive steps of moving a marker (Op 'm') are merged to one. At
+// most "maxSteps" states are kept.
+void UndoStack::push(char Op, unsigned maxSteps)
+{
+  while(Steps.size() > Index+1) {
+    Bytes -= Steps.last().Bytes;
+    Steps.removeLast();
+  }
+  if(Saved > Index)  Saved = -1;
+
+  if(Op == 'm' && Index > 0 && Steps.at(Index).Op == Op) {
+    Step& st = Steps[Index];
+    st.Changes += Pending;
+    compact(st.Changes);
+    Bytes -= st.Bytes;
+    st.Bytes = changesBytes(st.Changes);
+    Bytes += st.Bytes;
+    if(Saved == Index)  Saved = -1;
+  }
+  else {
+    Step st;
+    st.Op = Op;
+    st.Changes = Pending;
+    compact(st.Changes);
+    st.Bytes = changesBytes(st.Changes);
+    Steps.append(st);
+    Index++;
+    Bytes += st.Bytes;
+  }
+  Pending.clear();
+
+  // "while..." because "maxSteps" could be decreased meanwhile
+  while(Steps.size() > 1 && unsigned(Steps.size()) > maxSteps)
+    dropFirst();
+  while(Steps.size() > 2 && Bytes > UNDO_MAX_BYTES)  // keep the last one
+    dropFirst();
+}
+
+// ---------------------------------------------------------------------
+// Forgets the oldest state, the one after becomes the bottom.
+void UndoStack::dropFirst()
+{
+  Steps.removeFirst();
+  Step& Bottom = Steps.first();
+  Bytes -= Bottom.Bytes;
+  Bottom.Bytes = 0;
+  Bottom.Changes.clear();
+
+  Index--;
+  Saved = Saved > 0 ? Saved-1 : -1;
+}
+
+// ---------------------------------------------------------------------
+// Goes one state back. Returns the changes to be reverted, i.e. every
+// element must get its "Old" text.
+const UndoChanges& UndoStack::undo()
+{
+  if(Index > 0)
+    return Steps.at(Index--).Changes;
+  return Steps.first().Changes;  // empty
+}
+
+// ---------------------------------------------------------------------
+// Goes one state forth. Returns the changes to be made again, i.e. every
+// element must get its "New" text.
+const UndoChanges& UndoStack::redo()
+{
+  if(Index < Steps.size()-1)
+    return Steps.at(++Index).Changes;
+  return Steps.first().Changes;  // empty
+}
+
+// ---------------------------------------------------------------------
+// Tells that element "Id" was created anew as "pe" with text "Text" at
+// position "Pos".
+void UndoStack::bind(int Id, Element *pe, int Section, const QString& Text,
+                     int Pos)
+{
+  unbind(Id);
+  QHash<Element*, Entry>::const_iterator it = Texts.constFind(pe);
+  if(it != Texts.constEnd())
+    Elements.remove(it->Id);  // "pe" was left over, now it is "Id"
+
+  Entry e;
+  e.Id = Id;
+  e.Section = Section;
+  e.Text = Text;
+  e.Pos = Pos;
+  Texts.insert(pe, e);
+  Elements.insert(Id, pe);
+}
+
+// ---------------------------------------------------------------------
+// Tells that element "Id" was deleted by undo/redo.
+void UndoStack::unbind(int Id)
+{
+  Element *pe = Elements.take(Id);
+  if(!pe)  return;
+  QHash<Element*, Entry>::iterator it = Texts.find(pe);
+  if(it != Texts.end()) if(it->Id == Id)
+    Texts.erase(it);
+}
+
+// ---------------------------------------------------------------------
+// Tells that all elements were deleted, e.g. before rebuilding the whole
+// document from state(). The steps are kept.
+void UndoStack::unbindAll()
+{
+  Texts.clear();
+  Elements.clear();
+}
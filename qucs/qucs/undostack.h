@@ -0,0 +1,117 @@
+/*
+ * undostack.h - undo stack storing the changed elements of a document
+ *
+ * This file is part of Qucs
+ *
+ * Qucs is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qucs.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class Element;
+
+// sections of a document, one per element list
+typedef enum{
+  UNDO_COMPONENTS = 0,
+  UNDO_WIRES,
+  UNDO_NODELABELS,  // saved as wires of length zero
+  UNDO_DIAGRAMS,
+  UNDO_PAINTINGS,
+  UNDO_SECTIONS,
+} undosection_t;
+
+#define UNDO_MAX_BYTES  (32 << 20)  // memory the steps of a stack may use
+
+// The change of one element in Qucs file format. "Old" is empty if the
+// element was created, "New" is empty if it was deleted. The positions
+// are the indices in the element list before and after (-1 if none).
+struct UndoChange {
+  int Section;
+  int Id;           // the element, see UndoStack::element()
+  QString Old, New;
+  int OldPos, NewPos;
+};
+typedef QList<UndoChange> UndoChanges;
+
+/*!
+ * Undo stack of a document. It knows the text of every element as it was
+ * recorded last, and every step just holds the elements that changed
+ * compared to the state before. The document reports the changed
+ * elements by record() and forget(), push() then makes a step of them.
+ * Elements keep their id across undo/redo, even though they are created
+ * anew (see bind()). The stack is limited in the number of steps and in
+ * memory, the oldest steps are dropped first. The list position of every
+ * element is kept as well, so that restored elements get their old place.
+ */
+class UndoStack {
+public:
+  UndoStack();
+
+  void clear();
+  void setBottom();
+
+  void record(Element*, int, const QString&, int);
+  void forget(Element*);
+  void setPositions(const QHash<Element*, int>&);
+  QList<Element*> elements() const { return Texts.keys(); }
+  UndoChanges state() const;
+
+  void push(char, unsigned);
+  const UndoChanges& undo();
+  const UndoChanges& redo();
+
+  Element* element(int Id) const { return Elements.value(Id); }
+  void bind(int, Element*, int, const QString&, int);
+  void unbind(int);
+  void unbindAll();
+
+  bool canUndo() const { return Index > 0; }
+  bool canRedo() const { return Index < Steps.size()-1; }
+  bool isSaved() const { return Index == Saved; }
+  void setSaved() { Saved = Index; }
+
+  static void compact(UndoChanges&);
+
+private:
+  struct Entry {
+    int Id, Section;
+    QString Text;
+    int Pos;
+  };
+  struct Step {
+    char Op;        // kind of action, see Schematic::setChanged()
+    int  Bytes;     // memory used by the texts
+    UndoChanges Changes;  // from the state before to this one
+  };
+
+  void dropFirst();
+
+  QHash<Element*, Entry> Texts;   // last recorded text of every element
+  QHash<int, Element*> Elements;  // element of every id
+  UndoChanges Pending;            // recorded, but not pushed yet
+  int NextId;
+
+  QList<Step> Steps;  // the first one is the bottom and has no changes
+  int Index;
+  int Saved;          // state equal to the file, -1 if none
+  int Bytes;
+};
+
+#endif